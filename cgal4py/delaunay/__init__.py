@@ -540,7 +540,7 @@ def _get_Delaunay(ndim, periodic=False, parallel=False, bit64=False,
 
 
 def Delaunay(pts, use_double=False, periodic=False,
-             left_edge=None, right_edge=None):
+             left_edge=None, right_edge=None, fast_location=False):
     r"""Get a triangulation for a set of points with arbitrary dimensionality.
 
     Args:
@@ -558,6 +558,10 @@ def Delaunay(pts, use_double=False, periodic=False,
         right_edge (np.ndarray of float64, optional): (m,) upper limits on
             the domain. If None, this is set to np.max(pts, axis=0).
             Defaults to None.
+        fast_location (bool, optional): If True, point location queries on
+            the returned triangulation start from a Delaunay hierarchy. Only
+            supported by the non-periodic 2D and 3D triangulations. Defaults
+            to False.
 
     Returns:
         :class:`cgal4py.delaunay.Delaunay2` or
@@ -574,6 +578,8 @@ def Delaunay(pts, use_double=False, periodic=False,
             elements.
         NotImplementedError: If a periodic package could not be imported due
             to an outdated version of CGAL.
+        NotImplementedError: If `fast_location` is True for a periodic or
+            >3D triangulation.
 
     """
     if (pts.ndim != 2):
@@ -602,7 +608,14 @@ def Delaunay(pts, use_double=False, periodic=False,
     # Initialize correct tessellation
     DelaunayClass = _get_Delaunay(ndim, periodic=periodic,
                                   bit64=use_double)
-    T = DelaunayClass(*args)
+    if fast_location:
+        if periodic or (ndim > 3):
+            raise NotImplementedError("fast_location is only supported for " +
+                                      "non-periodic 2D and 3D " +
+                                      "triangulations.")
+        T = DelaunayClass(*args, fast_location=True)
+    else:
+        T = DelaunayClass(*args)
     # Insert points into tessellation
     if npts > 0:
         T.insert(pts)
@@ -12,6 +12,8 @@
 #include <algorithm>
 #include <limits>
 #include <stdint.h>
+#include "c_threads.hpp"
+#include "c_predicates.hpp"
 #ifdef READTHEDOCS
 #define VALID 1
 #include "dummy_CGAL.hpp"
@@ -23,8 +25,12 @@
 #include <CGAL/squared_distance_2.h>
 #include <CGAL/Unique_hash_map.h>
 #endif
+#include "c_hierarchy.hpp"
+#include "c_journal.hpp"
 
 typedef CGAL::Exact_predicates_inexact_constructions_kernel         K2;
+// Coarse levels of the location hierarchy
+typedef CGAL::Delaunay_triangulation_2<K2, CGAL::Triangulation_data_structure_2<CGAL::Triangulation_vertex_base_with_info_2<uint32_t, K2>>> Delaunay2_level;
 
 template <typename Info_>
 class Delaunay_with_info_2
@@ -54,6 +60,18 @@ public:
   typedef typename CGAL::Unique_hash_map<Face_handle,int>    Face_hash;
   Delaunay T;
   bool updated = false;
+  bool fast_location = false;
+  bool frozen = false;
+  bool in_transaction = false;
+  uint64_t frozen_epoch = 0;
+  uint64_t frozen_generation = 0;
+  mutable bool ids_valid = false;
+  mutable uint64_t ids_generation = 0;
+  mutable std::vector<Face_handle> id_cells;
+  mutable std::vector<Vertex_handle> id_verts;
+  mutable Handle_id_map<Face_handle> id_cell_map;
+  mutable std::vector<Vertex_handle> id_info_verts;
+  mutable Location_hierarchy<2, Delaunay2_level, Vertex_handle> hierarchy;
   Delaunay_with_info_2() {}
   Delaunay_with_info_2(double *pts, Info *val, uint32_t n) { insert(pts, val, n); }
   bool is_valid() const { return T.is_valid(); }
@@ -139,24 +157,137 @@ public:
     if (n == 0) 
       return;
     updated = true;
+    ids_valid = false;
     uint32_t i, j;
     std::vector< std::pair<Point,Info> > points;
     for (i = 0; i < n; i++) {
       j = 2*i;
       points.push_back( std::make_pair( Point(pts[j],pts[j+1]), val[i]) );
     }
+    if (in_transaction) {
+      Face_handle hint = Face_handle();
+      for (i = 0; i < n; i++)
+        hint = insert_journaled(points[i].first, points[i].second, hint)->face();
+      return;
+    }
+    if (fast_location && hierarchy.valid && (n < T.number_of_vertices())) {
+      // Batches smaller than the triangulation are inserted one at a time
+      // from the hierarchy, which is kept up to date rather than rebuilt
+      for (i = 0; i < n; i++)
+        insert_located(points[i].first, points[i].second);
+      return;
+    }
     T.insert( points.begin(),points.end() );
+    hierarchy.clear();
+  }
+  Vertex_handle insert_located(const Point& p, const Info& info) {
+    std::size_t nv = T.number_of_vertices();
+    Vertex_handle v = T.insert(p, location_hint(p));
+    v->info() = info;
+    if (T.number_of_vertices() != nv)
+      hierarchy.insert(v);
+    return v;
+  }
+  void remove(Vertex v) { updated = true; ids_valid = false; hierarchy.clear(); T.remove(v._x); }
+  void clear() { updated = true; ids_valid = false; hierarchy.clear(); T.clear(); }
+
+  // Transactions. Between begin and commit/rollback, insert records the
+  // faces it removes from the conflict zone of each point so that rollback
+  // can put them back in time proportional to the change rather than the
+  // size of the mesh. Only insert may modify the triangulation while a
+  // transaction is open. Transactions need a 2D triangulation, as inserts
+  // that raise the dimension rebuild the whole data structure.
+  struct Insert_record : public Hole_record<2, Vertex_handle, Face_handle> {
+    Info old_info = Info();
+  };
+  std::vector<Insert_record> journal;
+
+  bool begin() {
+    if (T.dimension() < 2)
+      return false;
+    journal.clear();
+    in_transaction = true;
+    return true;
+  }
+  void commit() {
+    journal.clear();
+    in_transaction = false;
+  }
+  void rollback() {
+    updated = true;
+    ids_valid = false;
+    hierarchy.clear();
+    for (uint64_t r = journal.size(); r > 0; r--) {
+      Insert_record& rec = journal[r - 1];
+      if (rec.existing) {
+        rec.v->info() = rec.old_info;
+        continue;
+      }
+      std::vector<Face_handle> star;
+      Face_circulator fc = T.incident_faces(rec.v), done(fc);
+      do {
+        star.push_back(fc);
+      } while (++fc != done);
+      std::vector<Face_handle> made(rec.num_cells());
+      uint64_t k;
+      for (k = 0; k < made.size(); k++)
+        made[k] = T.tds().create_face(rec.verts[3*k], rec.verts[3*k+1],
+                                      rec.verts[3*k+2]);
+      rec.relink(star, made);
+      for (k = 0; k < made.size(); k++) {
+        for (int i = 0; i < 3; i++)
+          made[k]->vertex(i)->set_face(made[k]);
+      }
+      for (k = 0; k < star.size(); k++)
+        T.tds().delete_face(star[k]);
+      T.tds().delete_vertex(rec.v);
+    }
+    journal.clear();
+    in_transaction = false;
+  }
+
+  // Insert a point with the same result as T.insert, recording the
+  // conflict zone before it is replaced by the star of the new vertex
+  Vertex_handle insert_journaled(const Point& p, const Info& info,
+                                 Face_handle hint) {
+    updated = true;
+    ids_valid = false;
+    Insert_record rec;
+    Locate_type lt;
+    int li;
+    Face_handle c = T.locate(p, lt, li, hint);
+    if (lt == Delaunay::VERTEX) {
+      rec.v = c->vertex(li);
+      rec.existing = true;
+      rec.old_info = rec.v->info();
+      rec.v->info() = info;
+      journal.push_back(rec);
+      return rec.v;
+    }
+    std::vector<Face_handle> faces;
+    std::vector<Edge_handle> edges;
+    T.get_conflicts_and_boundary(p, std::back_inserter(faces),
+                                 std::back_inserter(edges), c);
+    rec.record(faces);
+    rec.v = T.star_hole(p, edges.begin(), edges.end(),
+                        faces.begin(), faces.end());
+    rec.v->info() = info;
+    hierarchy.insert(rec.v);
+    journal.push_back(rec);
+    return rec.v;
   }
-  void remove(Vertex v) { updated = true; T.remove(v._x); }
-  void clear() { updated = true; T.clear(); }
 
   Vertex move(Vertex v, double *pos) {
     updated = true;
+    ids_valid = false;
+    hierarchy.clear();
     Point p = Point(pos[0], pos[1]);
     return Vertex(T.move(v._x, p));
   }
   Vertex move_if_no_collision(Vertex v, double *pos) {
     updated = true;
+    ids_valid = false;
+    hierarchy.clear();
     Point p = Point(pos[0], pos[1]);
     return Vertex(T.move_if_no_collision(v._x, p));
   }
@@ -170,15 +301,104 @@ public:
     return Vertex(T.infinite_vertex());
   }
 
+  // Read-only mode. Once frozen, locate and nearest_vertex only read the
+  // triangulation and can be called from several threads at once along
+  // with the circulator based incidence queries and the id/metric queries.
+  // CGAL's own locate shares a random generator, so freeze builds the ids
+  // and hierarchy up front and the queries then use walks that keep their
+  // state per thread. Any mutation from C++ ends the frozen mode until
+  // freeze is called again. Below dimension 2 the walks do not apply, so
+  // freeze returns false without freezing.
+  bool freeze(int nthreads = 0) {
+    if (T.dimension() < 2)
+      return false;
+    update_ids();
+    if (fast_location && !hierarchy.valid)
+      hierarchy.build(id_verts);
+    frozen_generation = ids_generation;
+    frozen_epoch = next_walk_epoch();
+    frozen = true;
+    return true;
+  }
+  void thaw() { frozen = false; }
+  bool is_frozen() const {
+    return (frozen && ids_valid && (frozen_generation == ids_generation) &&
+            (T.dimension() == 2));
+  }
+
+  // Walk state for the calling thread, reset whenever it was last used on
+  // a different frozen triangulation.
+  struct Thread_walk {
+    uint64_t epoch = 0;
+    Face_handle hint = Face_handle();
+    Walk_state state;
+  };
+  Thread_walk& thread_walk() const {
+    static thread_local Thread_walk tw;
+    if (tw.epoch != frozen_epoch) {
+      tw.epoch = frozen_epoch;
+      tw.hint = Face_handle();
+      tw.state = Walk_state((uint64_t)(uintptr_t)(&tw));
+    }
+    return tw;
+  }
+
+  // Starting face for a walk to p. If fast_location is set, this comes
+  // from a Delaunay hierarchy over the vertices, otherwise CGAL picks the
+  // start. The hierarchy is built on first use, follows later insertions
+  // and is rebuilt on the next use after vertices are removed or moved.
+  Face_handle location_hint(const Point& p, Walk_state& st) const {
+    if (!fast_location)
+      return Face_handle();
+    // A frozen triangulation is shared between threads, so a hierarchy
+    // missing at freeze (fast_location set afterwards) is not built
+    if (!hierarchy.valid) {
+      if (is_frozen())
+        return Face_handle();
+      std::vector<Vertex_handle> verts;
+      verts.reserve(T.number_of_vertices());
+      for (Finite_vertices_iterator it = T.finite_vertices_begin();
+           it != T.finite_vertices_end(); ++it)
+        verts.push_back(it);
+      hierarchy.build(verts);
+    }
+    Vertex_handle v = hierarchy.nearest(p, st);
+    if (v == Vertex_handle())
+      return Face_handle();
+    return v->face();
+  }
+  Face_handle location_hint(const Point& p) const {
+    Walk_state st;
+    return location_hint(p, st);
+  }
+
+  // Frozen locate starting from start, or from the hierarchy/the thread's
+  // last face if start is null
+  Face_handle frozen_locate(const Point& p, Face_handle start,
+                            int& lt, int& li) const {
+    Thread_walk& tw = thread_walk();
+    int lj;
+    if (start == Face_handle())
+      start = fast_location ? location_hint(p, tw.state) : tw.hint;
+    Face_handle c = walk_locate<2>(T, p, start, tw.state);
+    lt = walk_locate_type<2>(T, p, c, li, lj);
+    tw.hint = c;
+    return c;
+  }
+
   Cell locate(double* pos, int& lt, int& li) const {
     Point p = Point(pos[0], pos[1]);
+    if (is_frozen())
+      return Cell(frozen_locate(p, Face_handle(), lt, li));
     Locate_type lt_out = Locate_type(0);
-    Cell out = Cell(T.locate(p, lt_out, li));
+    Cell out = Cell(T.locate(p, lt_out, li, location_hint(p)));
     lt = (int)lt_out;
     return out;
   }
   Cell locate(double* pos, int& lt, int& li, Cell c) const {
     Point p = Point(pos[0], pos[1]);
+    if (is_frozen())
+      return Cell(frozen_locate(p, c._x, lt, li));
     Locate_type lt_out = Locate_type(0);
     Cell out = Cell(T.locate(p, lt_out, li, c._x));
     lt = (int)lt_out;
@@ -507,7 +727,14 @@ public:
 
   Vertex nearest_vertex(double* pos) const {
     Point p = Point(pos[0], pos[1]);
-    Vertex out = Vertex(T.nearest_vertex(p));
+    if (is_frozen()) {
+      Thread_walk& tw = thread_walk();
+      Face_handle start = fast_location ? location_hint(p, tw.state) : tw.hint;
+      Vertex_handle v = walk_nearest_vertex<2>(T, p, start, tw.state);
+      tw.hint = v->face();
+      return Vertex(v);
+    }
+    Vertex out = Vertex(T.nearest_vertex(p, location_hint(p)));
     return out;
   }
 
@@ -594,21 +821,25 @@ public:
 
   bool flip(Cell x, int i) { 
     updated = true;
+    ids_valid = false;
     T.flip(x._x, i); 
     return true;
   }
   bool flip(Edge x) {
     updated = true;
+    ids_valid = false;
     T.flip(x.cell()._x, x.ind());
     return true;
   }
   // for completeness with 3D case
   void flip_flippable(Cell x, int i) { 
     updated = true;
+    ids_valid = false;
     T.flip(x._x, i); 
   }
   void flip_flippable(Edge x) { 
     updated = true;
+    ids_valid = false;
     T.flip(x.cell()._x, x.ind()); 
   }
 
@@ -659,7 +890,17 @@ public:
       return 1;
     } else {
       Point p = Point(pos[0], pos[1]);
-      return (int)T.oriented_side(f._x, p);
+      if (T.dimension() == 2)
+        return (int)T.oriented_side(f._x, p);
+      // Below dimension 2 faces are segments without an interior
+      if (T.dimension() == 1) {
+        const Point& a = f->vertex(0)->point();
+        const Point& b = f->vertex(1)->point();
+        if ((T.orientation(a, b, p) == CGAL::COLLINEAR) &&
+            ((p == a) || (p == b) || T.collinear_between(a, p, b)))
+          return (int)CGAL::ON_ORIENTED_BOUNDARY;
+      }
+      return (int)CGAL::ON_NEGATIVE_SIDE;
     }
   }
 
@@ -670,10 +911,257 @@ public:
       return 1;
     } else {
       Point p = Point(pos[0], pos[1]);
+      // Below dimension 2 there is no circumcircle
+      if (T.dimension() < 2)
+        return (int)CGAL::ON_NEGATIVE_SIDE;
       return (int)T.side_of_oriented_circle(f._x, p);
     }
   }
 
+  // Only queries of finite faces by finite points in a triangulation of
+  // full dimension can use the static filters. Below dimension 2, faces
+  // lack vertex 2.
+  bool is_finite_query(const Face_handle f, const double* pos) const {
+    return ((T.dimension() == 2) && (!T.is_infinite(f)) &&
+            (!std::isinf(pos[0])) && (!std::isinf(pos[1])));
+  }
+
+  void cell_coords(const Face_handle f, double v[3][2]) const {
+    for (int i = 0; i < 3; i++) {
+      const Point& p = f->vertex(i)->point();
+      v[i][0] = p.x(); v[i][1] = p.y();
+    }
+  }
+
+  // Same result as oriented_side, but tries a static filter before the
+  // exact predicate.
+  int8_t oriented_side_filtered(const Face_handle f, const double* pos) const {
+    if (is_finite_query(f, pos)) {
+      double v[3][2];
+      int sign, nneg = 0, npos = 0;
+      bool certain = true;
+      cell_coords(f, v);
+      for (int i = 0; i < 3; i++) {
+        const double* w[3] = {v[0], v[1], v[2]};
+        w[i] = pos;
+        if (!static_orientation_2(w[0], w[1], w[2], sign))
+          certain = false;
+        else if (sign < 0)
+          nneg++;
+        else
+          npos++;
+      }
+      if (nneg > 0)
+        return -1;
+      if (certain && (npos == 3))
+        return 1;
+    }
+    return (int8_t)oriented_side(Cell(f), pos);
+  }
+
+  // Same result as side_of_oriented_circle, but tries a static filter before
+  // the exact predicate.
+  int8_t side_of_oriented_circle_filtered(const Face_handle f,
+                                          const double* pos) const {
+    if (is_finite_query(f, pos)) {
+      double v[3][2];
+      int sign;
+      cell_coords(f, v);
+      if (static_side_of_oriented_circle_2(v[0], v[1], v[2], pos, sign))
+        return (int8_t)sign;
+    }
+    return (int8_t)side_of_oriented_circle(Cell(f), pos);
+  }
+
+  // Batch predicates. The first form tests point i against the cell with id
+  // cells[i], the second tests every point against the same cell.
+  void oriented_side_batch(uint64_t n, const Info* cells, const double* pos,
+                           int8_t* out, int nthreads = 0) const {
+    update_ids();
+    parallel_for(n, [&](uint64_t start, uint64_t stop, uint32_t) {
+        for (uint64_t i = start; i < stop; i++)
+          out[i] = oriented_side_filtered(id_cells[cells[i]], pos + 2*i);
+      }, nthreads);
+  }
+  void oriented_side_batch(const Cell c, uint64_t n, const double* pos,
+                           int8_t* out, int nthreads = 0) const {
+    parallel_for(n, [&](uint64_t start, uint64_t stop, uint32_t) {
+        for (uint64_t i = start; i < stop; i++)
+          out[i] = oriented_side_filtered(c._x, pos + 2*i);
+      }, nthreads);
+  }
+  void side_of_oriented_circle_batch(uint64_t n, const Info* cells,
+                                     const double* pos, int8_t* out,
+                                     int nthreads = 0) const {
+    update_ids();
+    parallel_for(n, [&](uint64_t start, uint64_t stop, uint32_t) {
+        for (uint64_t i = start; i < stop; i++)
+          out[i] = side_of_oriented_circle_filtered(id_cells[cells[i]], pos + 2*i);
+      }, nthreads);
+  }
+  void side_of_oriented_circle_batch(const Cell c, uint64_t n,
+                                     const double* pos, int8_t* out,
+                                     int nthreads = 0) const {
+    parallel_for(n, [&](uint64_t start, uint64_t stop, uint32_t) {
+        for (uint64_t i = start; i < stop; i++)
+          out[i] = side_of_oriented_circle_filtered(c._x, pos + 2*i);
+      }, nthreads);
+  }
+
+  // Stable integer ids. A cell id is the row of the face in the serialized
+  // cells array and a vertex id is its info, which is how the serialized cells
+  // array, vertices and edges number vertices; the infinite vertex has id
+  // std::numeric_limits<Info>::max(). id_verts holds the finite vertices in
+  // container order and id_info_verts maps each info back to its vertex.
+  // Ids are built lazily and stay valid until the next mutation.
+  void update_ids() const {
+    if (ids_valid)
+      return;
+    Vertex_handle vinf = T.infinite_vertex();
+    id_verts.clear();
+    id_cells.clear();
+    id_verts.reserve(T.number_of_vertices());
+    id_cells.reserve(T.tds().number_of_full_dim_faces());
+    for (All_vertices_iterator it = T.tds().vertices_begin(); it != T.tds().vertices_end(); ++it) {
+      if (it != vinf)
+        id_verts.push_back(it);
+    }
+    for (All_faces_iterator it = T.tds().face_iterator_base_begin();
+         it != T.tds().face_iterator_base_end(); ++it)
+      id_cells.push_back(it);
+    uint64_t nrow = 0;
+    for (uint64_t i = 0; i < id_verts.size(); i++)
+      nrow = std::max(nrow, (uint64_t)(id_verts[i]->info()) + 1);
+    id_info_verts.assign(nrow, Vertex_handle());
+    for (uint64_t i = 0; i < id_verts.size(); i++)
+      id_info_verts[id_verts[i]->info()] = id_verts[i];
+    id_cell_map.build(id_cells);
+    ids_generation++;
+    ids_valid = true;
+  }
+  Info vertex_id_handle(const Vertex_handle v) const {
+    if ((v == Vertex_handle()) || (v == T.infinite_vertex()))
+      return std::numeric_limits<Info>::max();
+    return v->info();
+  }
+  Vertex_handle vertex_handle_id(Info i) const {
+    if ((i >= (Info)id_info_verts.size()) || (id_info_verts[i] == Vertex_handle()))
+      return T.infinite_vertex();
+    return id_info_verts[i];
+  }
+  Info cell_id_handle(const Face_handle c) const {
+    return (Info)id_cell_map.find(c);
+  }
+  Info vertex_id(const Vertex v) const { update_ids(); return vertex_id_handle(v._x); }
+  Info cell_id(const Cell c) const { update_ids(); return cell_id_handle(c._x); }
+  Vertex vertex_from_id(Info i) const {
+    update_ids();
+    return Vertex(vertex_handle_id(i));
+  }
+  Cell cell_from_id(Info i) const {
+    update_ids();
+    return Cell(id_cells[i]);
+  }
+
+  // Id of the cell containing each point. Points are located in order using
+  // the previous cell as the hint so that spatially sorted queries walk a
+  // short distance, or from the hierarchy if fast_location is set.
+  void locate_ids(uint64_t n, const double* pos, Info* out) const {
+    update_ids();
+    Face_handle hint = Face_handle();
+    int lt, li;
+    for (uint64_t i = 0; i < n; i++) {
+      Point p = Point(pos[2*i], pos[2*i+1]);
+      if (is_frozen()) {
+        out[i] = cell_id_handle(frozen_locate(p, Face_handle(), lt, li));
+        continue;
+      }
+      if (fast_location)
+        hint = location_hint(p);
+      hint = T.locate(p, hint);
+      out[i] = cell_id_handle(hint);
+    }
+  }
+
+  // Vertex and neighbor ids of cells, 3 per cell in CGAL index order.
+  void cell_vertex_ids(uint64_t n, const Info* cells, Info* out,
+                       int nthreads = 0) const {
+    update_ids();
+    parallel_for(n, [&](uint64_t start, uint64_t stop, uint32_t) {
+        for (uint64_t i = start; i < stop; i++) {
+          Face_handle c = id_cells[cells[i]];
+          for (int j = 0; j < 3; j++)
+            out[3*i + j] = vertex_id_handle(c->vertex(j));
+        }
+      }, nthreads);
+  }
+  void cell_neighbor_ids(uint64_t n, const Info* cells, Info* out,
+                         int nthreads = 0) const {
+    update_ids();
+    parallel_for(n, [&](uint64_t start, uint64_t stop, uint32_t) {
+        for (uint64_t i = start; i < stop; i++) {
+          Face_handle c = id_cells[cells[i]];
+          for (int j = 0; j < 3; j++)
+            out[3*i + j] = cell_id_handle(c->neighbor(j));
+        }
+      }, nthreads);
+  }
+
+  // Ids of the cells incident to each vertex id as CSR arrays. Ids that no
+  // vertex has get an empty row.
+  void incident_cell_ids(uint64_t n, const Info* verts,
+                         std::vector<uint64_t>& indptr,
+                         std::vector<Info>& ids) const {
+    update_ids();
+    indptr.assign(1, 0);
+    ids.clear();
+    for (uint64_t i = 0; i < n; i++) {
+      Vertex_handle v = vertex_handle_id(verts[i]);
+      if (v != T.infinite_vertex()) {
+        Face_circulator fc = T.incident_faces(v), done(fc);
+        if (fc != 0) {
+          do {
+            ids.push_back(cell_id_handle(static_cast<Face_handle>(fc)));
+          } while (++fc != done);
+        }
+      }
+      indptr.push_back(ids.size());
+    }
+  }
+
+  // Per-cell metrics by id. Infinite cells, and all faces below dimension 2,
+  // get an infinite circumcenter and a minimum angle of -1.
+  void cell_circumcenters(uint64_t n, const Info* cells, double* out,
+                          int nthreads = 0) const {
+    update_ids();
+    parallel_for(n, [&](uint64_t start, uint64_t stop, uint32_t) {
+        for (uint64_t i = start; i < stop; i++) {
+          Face_handle c = id_cells[cells[i]];
+          if ((T.dimension() < 2) || T.is_infinite(c)) {
+            out[2*i + 0] = std::numeric_limits<double>::infinity();
+            out[2*i + 1] = std::numeric_limits<double>::infinity();
+          } else {
+            Point p = T.circumcenter(c);
+            out[2*i + 0] = p.x();
+            out[2*i + 1] = p.y();
+          }
+        }
+      }, nthreads);
+  }
+  void cell_minimum_angles(uint64_t n, const Info* cells, double* out,
+                           int nthreads = 0) const {
+    update_ids();
+    parallel_for(n, [&](uint64_t start, uint64_t stop, uint32_t) {
+        for (uint64_t i = start; i < stop; i++) {
+          Face_handle c = id_cells[cells[i]];
+          if ((T.dimension() < 2) || T.is_infinite(c))
+            out[i] = -1.0;
+          else
+            out[i] = Cell(c).min_angle();
+        }
+      }, nthreads);
+  }
+
   void write_to_file(const char* filename) const
   {
     std::ofstream os(filename, std::ios::binary);
@@ -760,6 +1248,8 @@ public:
   void read_from_buffer(std::ifstream &is) {
 
     updated = true;
+    ids_valid = false;
+    hierarchy.clear();
 
     if (T.number_of_vertices() != 0) 
       T.clear();
@@ -1020,6 +1510,8 @@ public:
 		   I* faces, I* neighbors, I idx_inf)
   {
     updated = true;
+    ids_valid = false;
+    hierarchy.clear();
 
     T.clear();
     if (T.number_of_vertices() != 0) 
@@ -1101,6 +1593,8 @@ public:
 			   I* faces, I* neighbors, I idx_inf)
   {
     updated = true;
+    ids_valid = false;
+    hierarchy.clear();
 
     T.clear();
     if (T.number_of_vertices() != 0) 
@@ -1228,9 +1722,13 @@ public:
     return true;
   }
 
+  // Indices of points in cells whose circumcircle intersects each box.
+  // Only cells incident to a vertex with info < max_info are tested (e.g.
+  // the original points of a leaf when only their dual cells are needed).
   std::vector<std::vector<Info>> outgoing_points(uint64_t nbox,
 						 double *left_edges, 
-						 double *right_edges) const {
+						 double *right_edges,
+						 Info max_info = std::numeric_limits<Info>::max()) const {
     std::vector<std::vector<Info>> out;
     uint64_t b;
     for (b = 0; b < nbox; b++) 
@@ -1242,6 +1740,13 @@ public:
     int i, iinf = 0;
 
     for (All_faces_iterator it = T.all_faces_begin(); it != T.all_faces_end(); it++) {
+      for (i = 0; i < 3; i++) {
+	v = it->vertex(i);
+	if ((!T.is_infinite(v)) && (v->info() < max_info))
+	  break;
+      }
+      if (i == 3)
+	continue;
       if (T.is_infinite(it) == true) {
 	// Find index of infinite vertex
 	for (i = 0; i < 3; i++) {
@@ -1271,6 +1776,66 @@ public:
     return out;
   }
 
+  // Flag the boxes that intersect the conflict region of a cell incident
+  // to a vertex with info < max_info, i.e. the boxes a point could be added
+  // from that would change the dual cells of those vertices. For infinite
+  // cells this is the half plane beyond the hull edge.
+  std::vector<bool> conflicting_boxes(uint64_t nbox, double *left_edges,
+				      double *right_edges, Info max_info) const {
+    std::vector<bool> out(nbox, false);
+    if (T.dimension() < 2) {
+      out.assign(nbox, true);
+      return out;
+    }
+    uint64_t b;
+
+    Vertex_handle v;
+    Point cc, p1, p2, corner;
+    double cr;
+    int i, c, iinf = 0;
+
+    for (All_faces_iterator it = T.all_faces_begin(); it != T.all_faces_end(); it++) {
+      for (i = 0; i < 3; i++) {
+	v = it->vertex(i);
+	if ((!T.is_infinite(v)) && (v->info() < max_info))
+	  break;
+      }
+      if (i == 3)
+	continue;
+      if (T.is_infinite(it) == true) {
+	// Find index of infinite vertex
+	for (i = 0; i < 3; i++) {
+	  v = it->vertex(i);
+	  if (T.is_infinite(v)) {
+	    iinf = i;
+	    break;
+	  }
+	}
+	p1 = it->vertex((iinf+1)%3)->point();
+	p2 = it->vertex((iinf+2)%3)->point();
+	for (b = 0; b < nbox; b++) {
+	  for (c = 0; (c < 4) && (!out[b]); c++) {
+	    corner = Point((c & 1) ? right_edges[2*b] : left_edges[2*b],
+			   (c & 2) ? right_edges[2*b+1] : left_edges[2*b+1]);
+	    if (CGAL::orientation(p1, p2, corner) != CGAL::NEGATIVE)
+	      out[b] = true;
+	  }
+	}
+      } else {
+        p1 = it->vertex(0)->point();
+        cc = T.circumcenter(it);
+        cr = std::sqrt(static_cast<double>(CGAL::squared_distance(p1, cc)));
+	for (b = 0; b < nbox; b++) {
+	  if ((!out[b]) &&
+	      intersect_sph_box(&cc, cr, left_edges + 2*b, right_edges + 2*b))
+	    out[b] = true;
+	}
+      }
+    }
+
+    return out;
+  }
+
   void boundary_points(double *left_edge, double *right_edge, bool periodic,
                        std::vector<Info>& lx, std::vector<Info>& ly,
                        std::vector<Info>& rx, std::vector<Info>& ry,
@@ -13,6 +13,8 @@
 #include <algorithm>
 #include <limits>
 #include <stdint.h>
+#include "c_threads.hpp"
+#include "c_predicates.hpp"
 #ifdef READTHEDOCS
 #define VALID 1
 #include "dummy_CGAL.hpp"
@@ -30,6 +32,8 @@
 #include <CGAL/squared_distance_3.h>
 #include <CGAL/Unique_hash_map.h>
 #endif
+#include "c_hierarchy.hpp"
+#include "c_journal.hpp"
 
 typedef CGAL::Exact_predicates_inexact_constructions_kernel            K3;
 #if (CGAL_VERSION_NR >= 1040401000)
@@ -37,6 +41,8 @@ typedef CGAL::Delaunay_triangulation_cell_base_with_circumcenter_3<K3> Cb3;
 #else
 typedef CGAL::Triangulation_cell_base_with_circumcenter_3<K3>          Cb3;
 #endif
+// Coarse levels of the location hierarchy
+typedef CGAL::Delaunay_triangulation_3<K3, CGAL::Triangulation_data_structure_3<CGAL::Triangulation_vertex_base_with_info_3<uint32_t, K3>>> Delaunay3_level;
 
 template <typename Info_>
 class Delaunay_with_info_3
@@ -69,6 +75,20 @@ class Delaunay_with_info_3
   typedef Info_ Info;
   Delaunay T;
   bool updated = false;
+  bool fast_location = false;
+  bool frozen = false;
+  bool in_transaction = false;
+  uint64_t frozen_epoch = 0;
+  uint64_t frozen_generation = 0;
+  mutable bool ids_valid = false;
+  mutable uint64_t ids_generation = 0;
+  mutable std::vector<Cell_handle> id_cells;
+  mutable std::vector<Vertex_handle> id_verts;
+  mutable Handle_id_map<Cell_handle> id_cell_map;
+  mutable std::vector<Vertex_handle> id_info_verts;
+  mutable Location_hierarchy<3, Delaunay3_level, Vertex_handle> hierarchy;
+  std::vector<uint64_t> star_indptr;
+  std::vector<Info> star_ids;
   Delaunay_with_info_3() {};
   Delaunay_with_info_3(double *pts, Info *val, uint32_t n) { insert(pts, val, n); }
   bool is_valid() const { return T.is_valid(); }
@@ -117,24 +137,132 @@ class Delaunay_with_info_3
   void insert(double *pts, Info *val, uint32_t n)
   {
     updated = true;
+    ids_valid = false;
     uint32_t i, j;
     std::vector< std::pair<Point,Info> > points;
     for (i = 0; i < n; i++) {
       j = 3*i;
       points.push_back( std::make_pair( Point(pts[j],pts[j+1],pts[j+2]), val[i]) );
     }
+    if (in_transaction) {
+      Cell_handle hint = Cell_handle();
+      for (i = 0; i < n; i++)
+        hint = insert_journaled(points[i].first, points[i].second, hint)->cell();
+      return;
+    }
+    if (fast_location && hierarchy.valid && (n < T.number_of_vertices())) {
+      // Batches smaller than the triangulation are inserted one at a time
+      // from the hierarchy, which is kept up to date rather than rebuilt
+      for (i = 0; i < n; i++)
+        insert_located(points[i].first, points[i].second);
+      return;
+    }
     T.insert( points.begin(),points.end() );
+    hierarchy.clear();
+  }
+  Vertex_handle insert_located(const Point& p, const Info& info) {
+    std::size_t nv = T.number_of_vertices();
+    Vertex_handle v = T.insert(p, location_hint(p));
+    v->info() = info;
+    if (T.number_of_vertices() != nv)
+      hierarchy.insert(v);
+    return v;
+  }
+  void remove(Vertex v) { updated = true; ids_valid = false; hierarchy.clear(); T.remove(v._x); }
+  void clear() { updated = true; ids_valid = false; hierarchy.clear(); T.clear(); }
+
+  // Transactions. Between begin and commit/rollback, insert records the
+  // cells it removes from the conflict zone of each point so that rollback
+  // can put them back in time proportional to the change rather than the
+  // size of the mesh. Only insert may modify the triangulation while a
+  // transaction is open. Transactions need a 3D triangulation, as inserts
+  // that raise the dimension rebuild the whole data structure.
+  struct Insert_record : public Hole_record<3, Vertex_handle, Cell_handle> {
+    Info old_info = Info();
+  };
+  std::vector<Insert_record> journal;
+
+  bool begin() {
+    if (T.dimension() < 3)
+      return false;
+    journal.clear();
+    in_transaction = true;
+    return true;
+  }
+  void commit() {
+    journal.clear();
+    in_transaction = false;
+  }
+  void rollback() {
+    updated = true;
+    ids_valid = false;
+    hierarchy.clear();
+    for (uint64_t r = journal.size(); r > 0; r--) {
+      Insert_record& rec = journal[r - 1];
+      if (rec.existing) {
+        rec.v->info() = rec.old_info;
+        continue;
+      }
+      std::vector<Cell_handle> star;
+      T.incident_cells(rec.v, std::back_inserter(star));
+      std::vector<Cell_handle> made(rec.num_cells());
+      uint64_t k;
+      for (k = 0; k < made.size(); k++)
+        made[k] = T.tds().create_cell(rec.verts[4*k], rec.verts[4*k+1],
+                                      rec.verts[4*k+2], rec.verts[4*k+3]);
+      rec.relink(star, made);
+      for (k = 0; k < made.size(); k++) {
+        for (int i = 0; i < 4; i++)
+          made[k]->vertex(i)->set_cell(made[k]);
+      }
+      T.tds().delete_cells(star.begin(), star.end());
+      T.tds().delete_vertex(rec.v);
+    }
+    journal.clear();
+    in_transaction = false;
+  }
+
+  // Insert a point with the same result as T.insert, recording the
+  // conflict zone before it is replaced by the star of the new vertex
+  Vertex_handle insert_journaled(const Point& p, const Info& info,
+                                 Cell_handle hint) {
+    updated = true;
+    ids_valid = false;
+    Insert_record rec;
+    Locate_type lt;
+    int li, lj;
+    Cell_handle c = T.locate(p, lt, li, lj, hint);
+    if (lt == Delaunay::VERTEX) {
+      rec.v = c->vertex(li);
+      rec.existing = true;
+      rec.old_info = rec.v->info();
+      rec.v->info() = info;
+      journal.push_back(rec);
+      return rec.v;
+    }
+    std::vector<Cell_handle> cells;
+    std::vector<Facet_handle> facets;
+    T.find_conflicts(p, c, std::back_inserter(facets), std::back_inserter(cells));
+    rec.record(cells);
+    rec.v = T.insert_in_hole(p, cells.begin(), cells.end(),
+                             facets[0].first, facets[0].second);
+    rec.v->info() = info;
+    hierarchy.insert(rec.v);
+    journal.push_back(rec);
+    return rec.v;
   }
-  void remove(Vertex v) { updated = true; T.remove(v._x); }
-  void clear() { updated = true; T.clear(); }
 
   Vertex move(Vertex v, double *pos) {
     updated = true;
+    ids_valid = false;
+    hierarchy.clear();
     Point p = Point(pos[0], pos[1], pos[2]);
     return Vertex(T.move(v._x, p));
   }
   Vertex move_if_no_collision(Vertex v, double *pos) {
     updated = true;
+    ids_valid = false;
+    hierarchy.clear();
     Point p = Point(pos[0], pos[1], pos[2]);
     return Vertex(T.move_if_no_collision(v._x, p));
   }
@@ -148,15 +276,123 @@ class Delaunay_with_info_3
     return Vertex(T.infinite_vertex());
   }
 
+  // Read-only mode. Once frozen, locate, nearest_vertex, the vertex
+  // incidence queries and the id/metric queries only read the triangulation
+  // and can be called from several threads at once. CGAL's own versions
+  // share a random generator, mark cells as visited and fill the cached
+  // circumcenters lazily, so freeze fills every cache up front (ids,
+  // hierarchy, circumcenters, the cells around each vertex) and the queries
+  // then use walks that keep their state per thread. Any mutation from C++
+  // ends the frozen mode until freeze is called again. Below dimension 3 the
+  // walks do not apply, so freeze returns false without freezing.
+  bool freeze(int nthreads = 0) {
+    if (T.dimension() < 3)
+      return false;
+    update_ids();
+    if (fast_location && !hierarchy.valid)
+      hierarchy.build(id_verts);
+    Vertex_handle vinf = T.infinite_vertex();
+    parallel_for(id_cells.size(), [&](uint64_t start, uint64_t stop, uint32_t) {
+        for (uint64_t i = start; i < stop; i++) {
+          if (!T.is_infinite(id_cells[i]))
+            id_cells[i]->circumcenter();
+        }
+      }, nthreads);
+    parallel_csr(id_cells.size(), id_info_verts.size(), 4,
+                 [&](uint64_t i, uint32_t k, uint64_t& row) {
+                   Vertex_handle v = id_cells[i]->vertex(k);
+                   if ((v == Vertex_handle()) || (v == vinf))
+                     return false;
+                   row = (uint64_t)(v->info());
+                   return true;
+                 }, star_indptr, star_ids, nthreads);
+    frozen_generation = ids_generation;
+    frozen_epoch = next_walk_epoch();
+    frozen = true;
+    return true;
+  }
+  void thaw() {
+    frozen = false;
+    star_indptr.clear();
+    star_ids.clear();
+  }
+  bool is_frozen() const {
+    return (frozen && ids_valid && (frozen_generation == ids_generation) &&
+            (T.dimension() == 3));
+  }
+
+  // Walk state for the calling thread, reset whenever it was last used on
+  // a different frozen triangulation.
+  struct Thread_walk {
+    uint64_t epoch = 0;
+    Cell_handle hint = Cell_handle();
+    Walk_state state;
+  };
+  Thread_walk& thread_walk() const {
+    static thread_local Thread_walk tw;
+    if (tw.epoch != frozen_epoch) {
+      tw.epoch = frozen_epoch;
+      tw.hint = Cell_handle();
+      tw.state = Walk_state((uint64_t)(uintptr_t)(&tw));
+    }
+    return tw;
+  }
+
+  // Starting cell for a walk to p. If fast_location is set, this comes
+  // from a Delaunay hierarchy over the vertices, otherwise CGAL picks the
+  // start. The hierarchy is built on first use, follows later insertions
+  // and is rebuilt on the next use after vertices are removed or moved.
+  Cell_handle location_hint(const Point& p, Walk_state& st) const {
+    if (!fast_location)
+      return Cell_handle();
+    // A frozen triangulation is shared between threads, so a hierarchy
+    // missing at freeze (fast_location set afterwards) is not built
+    if (!hierarchy.valid) {
+      if (is_frozen())
+        return Cell_handle();
+      std::vector<Vertex_handle> verts;
+      verts.reserve(T.number_of_vertices());
+      for (Finite_vertices_iterator it = T.finite_vertices_begin();
+           it != T.finite_vertices_end(); ++it)
+        verts.push_back(it);
+      hierarchy.build(verts);
+    }
+    Vertex_handle v = hierarchy.nearest(p, st);
+    if (v == Vertex_handle())
+      return Cell_handle();
+    return v->cell();
+  }
+  Cell_handle location_hint(const Point& p) const {
+    Walk_state st;
+    return location_hint(p, st);
+  }
+
+  // Frozen locate starting from start, or from the hierarchy/the thread's
+  // last cell if start is null
+  Cell_handle frozen_locate(const Point& p, Cell_handle start,
+                            int& lt, int& li, int& lj) const {
+    Thread_walk& tw = thread_walk();
+    if (start == Cell_handle())
+      start = fast_location ? location_hint(p, tw.state) : tw.hint;
+    Cell_handle c = walk_locate<3>(T, p, start, tw.state);
+    lt = walk_locate_type<3>(T, p, c, li, lj);
+    tw.hint = c;
+    return c;
+  }
+
   Cell locate(double* pos, int& lt, int& li, int& lj) const {
     Point p = Point(pos[0], pos[1], pos[2]);
+    if (is_frozen())
+      return Cell(frozen_locate(p, Cell_handle(), lt, li, lj));
     Locate_type lt_out = Locate_type(0);
-    Cell out = Cell(T.locate(p, lt_out, li, lj));
+    Cell out = Cell(T.locate(p, lt_out, li, lj, location_hint(p)));
     lt = (int)lt_out;
     return out;
   }
   Cell locate(double* pos, int& lt, int& li, int& lj, Cell c) const {
     Point p = Point(pos[0], pos[1], pos[2]);
+    if (is_frozen())
+      return Cell(frozen_locate(p, c._x, lt, li, lj));
     Locate_type lt_out = Locate_type(0);
     Cell out = Cell(T.locate(p, lt_out, li, lj, c._x));
     lt = (int)lt_out;
@@ -483,24 +719,87 @@ class Delaunay_with_info_3
     return T.is_cell(x1._x, x2._x, x3._x, x4._x, c._x, i1, i2, i3, i4);
   }
 
+  // Cells around a finite vertex from the table built by freeze
+  void frozen_star(Vertex_handle v, std::vector<Cell_handle>& out) const {
+    Info i = vertex_id_handle(v);
+    out.clear();
+    if (i >= (Info)id_info_verts.size())
+      return;
+    for (uint64_t j = star_indptr[i]; j < star_indptr[i + 1]; j++)
+      out.push_back(id_cells[star_ids[j]]);
+  }
+  // Edges around a vertex, each listed once, from the frozen star
+  void frozen_edges(Vertex_handle v, std::vector<Edge_handle>& out) const {
+    std::vector<Cell_handle> cells;
+    std::vector<Vertex_handle> seen;
+    frozen_star(v, cells);
+    out.clear();
+    for (uint64_t j = 0; j < cells.size(); j++) {
+      int iv = cells[j]->index(v);
+      for (int k = 0; k < 4; k++) {
+        Vertex_handle w = cells[j]->vertex(k);
+        if ((k == iv) || (std::find(seen.begin(), seen.end(), w) != seen.end()))
+          continue;
+        seen.push_back(w);
+        out.push_back(Edge_handle(cells[j], iv, k));
+      }
+    }
+  }
+
   // Parts incident to a vertex
   std::vector<Vertex> incident_vertices(Vertex x) const {
     std::vector<Vertex> out;
+    if (is_frozen() && !T.is_infinite(x._x)) {
+      std::vector<Edge_handle> edges;
+      frozen_edges(x._x, edges);
+      for (uint64_t j = 0; j < edges.size(); j++)
+        out.push_back(Vertex(edges[j].first->vertex(edges[j].third)));
+      return out;
+    }
     T.adjacent_vertices(x._x, wrap_insert_iterator<Vertex,Vertex_handle>(out));
     return out;
   }
   std::vector<Edge> incident_edges(Vertex x) const {
     std::vector<Edge> out;
+    if (is_frozen() && !T.is_infinite(x._x)) {
+      std::vector<Edge_handle> edges;
+      frozen_edges(x._x, edges);
+      for (uint64_t j = 0; j < edges.size(); j++)
+        out.push_back(Edge(edges[j]));
+      return out;
+    }
     T.incident_edges(x._x, wrap_insert_iterator<Edge,Edge_handle>(out));
     return out;
   }
   std::vector<Facet> incident_facets(Vertex x) const {
     std::vector<Facet> out;
+    if (is_frozen() && !T.is_infinite(x._x)) {
+      // Each facet through x is shared by two cells of the star and is
+      // listed from the one with the smaller id
+      std::vector<Cell_handle> cells;
+      frozen_star(x._x, cells);
+      for (uint64_t j = 0; j < cells.size(); j++) {
+        int iv = cells[j]->index(x._x);
+        for (int k = 0; k < 4; k++) {
+          if ((k != iv) &&
+              (cell_id_handle(cells[j]) < cell_id_handle(cells[j]->neighbor(k))))
+            out.push_back(Facet(Facet_handle(cells[j], k)));
+        }
+      }
+      return out;
+    }
     T.incident_facets(x._x, wrap_insert_iterator<Facet,Facet_handle>(out));
     return out;
   }
   std::vector<Cell> incident_cells(Vertex x) const {
     std::vector<Cell> out;
+    if (is_frozen() && !T.is_infinite(x._x)) {
+      std::vector<Cell_handle> cells;
+      frozen_star(x._x, cells);
+      for (uint64_t j = 0; j < cells.size(); j++)
+        out.push_back(Cell(cells[j]));
+      return out;
+    }
     T.incident_cells(x._x, wrap_insert_iterator<Cell,Cell_handle>(out));
     return out;
   }
@@ -616,7 +915,14 @@ class Delaunay_with_info_3
 
   Vertex nearest_vertex(double* pos) const {
     Point p = Point(pos[0], pos[1], pos[2]);
-    Vertex out = Vertex(T.nearest_vertex(p));
+    if (is_frozen()) {
+      Thread_walk& tw = thread_walk();
+      Cell_handle start = fast_location ? location_hint(p, tw.state) : tw.hint;
+      Vertex_handle v = walk_nearest_vertex<3>(T, p, start, tw.state);
+      tw.hint = v->cell();
+      return Vertex(v);
+    }
+    Vertex out = Vertex(T.nearest_vertex(p, location_hint(p)));
     return out;
   }
 
@@ -639,7 +945,13 @@ class Delaunay_with_info_3
 
   double dual_volume(const Vertex v) const {
     std::list<Edge_handle> edges;
-    T.incident_edges(v._x, std::back_inserter(edges));
+    if (is_frozen()) {
+      std::vector<Edge_handle> vedges;
+      frozen_edges(v._x, vedges);
+      edges.assign(vedges.begin(), vedges.end());
+    } else {
+      T.incident_edges(v._x, std::back_inserter(edges));
+    }
 
     Point orig = v._x->point();
     double vol = 0.0;
@@ -705,14 +1017,14 @@ class Delaunay_with_info_3
     return out;
   }
 
-  bool flip(Cell x, int i, int j) { updated = true; return T.flip(x._x, i, j); }
-  bool flip(Edge x) { updated = true; return T.flip(x.cell()._x, x.ind1(), x.ind2()); }
-  bool flip(Cell x, int i) { updated = true; return T.flip(x._x, i); }
-  bool flip(Facet x) { updated = true; return T.flip(x.cell()._x, x.ind()); }
-  void flip_flippable(Cell x, int i, int j) { updated = true; T.flip_flippable(x._x, i, j); }
-  void flip_flippable(Edge x) { updated = true; T.flip_flippable(x.cell()._x, x.ind1(), x.ind2()); }
-  void flip_flippable(Cell x, int i) { updated = true; T.flip_flippable(x._x, i); }
-  void flip_flippable(Facet x) { updated = true; T.flip_flippable(x.cell()._x, x.ind()); }
+  bool flip(Cell x, int i, int j) { updated = true; ids_valid = false; return T.flip(x._x, i, j); }
+  bool flip(Edge x) { updated = true; ids_valid = false; return T.flip(x.cell()._x, x.ind1(), x.ind2()); }
+  bool flip(Cell x, int i) { updated = true; ids_valid = false; return T.flip(x._x, i); }
+  bool flip(Facet x) { updated = true; ids_valid = false; return T.flip(x.cell()._x, x.ind()); }
+  void flip_flippable(Cell x, int i, int j) { updated = true; ids_valid = false; T.flip_flippable(x._x, i, j); }
+  void flip_flippable(Edge x) { updated = true; ids_valid = false; T.flip_flippable(x.cell()._x, x.ind1(), x.ind2()); }
+  void flip_flippable(Cell x, int i) { updated = true; ids_valid = false; T.flip_flippable(x._x, i); }
+  void flip_flippable(Facet x) { updated = true; ids_valid = false; T.flip_flippable(x.cell()._x, x.ind()); }
 
   std::pair<std::vector<Cell>,std::vector<Facet>>
     find_conflicts(double* pos, Cell start) const {
@@ -735,7 +1047,18 @@ class Delaunay_with_info_3
     else {
       Point p = Point(pos[0], pos[1], pos[2]);
       Locate_type lt_out = Locate_type(0);    
-      int out = -(int)T.side_of_cell(p, c._x, lt_out, li, lj);
+      int out;
+      // Below dimension 3 cells are facets or edges of the affine hull
+      if (T.dimension() == 3)
+        out = -(int)T.side_of_cell(p, c._x, lt_out, li, lj);
+      else if (T.dimension() == 2)
+        out = -(int)T.side_of_facet(p, c._x, lt_out, li, lj);
+      else if (T.dimension() == 1)
+        out = -(int)T.side_of_edge(p, c._x, lt_out, li);
+      else {
+        lt_out = Delaunay::OUTSIDE_AFFINE_HULL;
+        out = 1;
+      }
       lt = (int)lt_out;
       return out;
     }
@@ -786,13 +1109,328 @@ class Delaunay_with_info_3
       return 1;
     else {
       Point p = Point(pos[0], pos[1], pos[2]);
-      return -(int)T.side_of_sphere(c._x, p);
+      // In dimension 2 the sphere is the circumcircle of the facet and
+      // below that there is none
+      if (T.dimension() == 3)
+        return -(int)T.side_of_sphere(c._x, p);
+      else if (T.dimension() == 2)
+        return -(int)T.side_of_circle(c._x, 3, p);
+      else
+        return 1;
+    }
+  }
+
+  // Only queries of finite cells by finite points in a triangulation of
+  // full dimension can use the static filters. Below dimension 3, cells
+  // lack vertex 3.
+  bool is_finite_query(const Cell_handle c, const double* pos) const {
+    return ((T.dimension() == 3) && (!T.is_infinite(c)) &&
+            (!std::isinf(pos[0])) && (!std::isinf(pos[1])) &&
+            (!std::isinf(pos[2])));
+  }
+
+  void cell_coords(const Cell_handle c, double v[4][3]) const {
+    for (int i = 0; i < 4; i++) {
+      const Point& p = c->vertex(i)->point();
+      v[i][0] = p.x(); v[i][1] = p.y(); v[i][2] = p.z();
+    }
+  }
+
+  // Same result as side_of_sphere, but tries a static filter before the
+  // exact predicate.
+  int8_t side_of_sphere_filtered(const Cell_handle c, const double* pos) const {
+    if (is_finite_query(c, pos)) {
+      double v[4][3];
+      int sign;
+      cell_coords(c, v);
+      if (static_side_of_oriented_sphere_3(v[0], v[1], v[2], v[3], pos, sign))
+        return (int8_t)(-sign);
+    }
+    return (int8_t)side_of_sphere(Cell(c), pos);
+  }
+
+  // Same result as side_of_cell, but tries a static filter before the exact
+  // predicate.
+  int8_t side_of_cell_filtered(const Cell_handle c, const double* pos) const {
+    if (is_finite_query(c, pos)) {
+      double v[4][3];
+      int sign, nneg = 0, npos = 0;
+      bool certain = true;
+      cell_coords(c, v);
+      for (int i = 0; i < 4; i++) {
+        const double* w[4] = {v[0], v[1], v[2], v[3]};
+        w[i] = pos;
+        if (!static_orientation_3(w[0], w[1], w[2], w[3], sign))
+          certain = false;
+        else if (sign < 0)
+          nneg++;
+        else
+          npos++;
+      }
+      if (nneg > 0)
+        return 1;
+      if (certain && (npos == 4))
+        return -1;
+    }
+    int lt, li, lj;
+    return (int8_t)side_of_cell(pos, Cell(c), lt, li, lj);
+  }
+
+  // Batch predicates. The first form tests point i against the cell with id
+  // cells[i], the second tests every point against the same cell/facet/edge.
+  void side_of_sphere_batch(uint64_t n, const Info* cells, const double* pos,
+                            int8_t* out, int nthreads = 0) const {
+    update_ids();
+    parallel_for(n, [&](uint64_t start, uint64_t stop, uint32_t) {
+        for (uint64_t i = start; i < stop; i++)
+          out[i] = side_of_sphere_filtered(id_cells[cells[i]], pos + 3*i);
+      }, nthreads);
+  }
+  void side_of_sphere_batch(const Cell c, uint64_t n, const double* pos,
+                            int8_t* out, int nthreads = 0) const {
+    parallel_for(n, [&](uint64_t start, uint64_t stop, uint32_t) {
+        for (uint64_t i = start; i < stop; i++)
+          out[i] = side_of_sphere_filtered(c._x, pos + 3*i);
+      }, nthreads);
+  }
+  void side_of_cell_batch(uint64_t n, const Info* cells, const double* pos,
+                          int8_t* out, int nthreads = 0) const {
+    update_ids();
+    parallel_for(n, [&](uint64_t start, uint64_t stop, uint32_t) {
+        for (uint64_t i = start; i < stop; i++)
+          out[i] = side_of_cell_filtered(id_cells[cells[i]], pos + 3*i);
+      }, nthreads);
+  }
+  void side_of_cell_batch(const Cell c, uint64_t n, const double* pos,
+                          int8_t* out, int nthreads = 0) const {
+    parallel_for(n, [&](uint64_t start, uint64_t stop, uint32_t) {
+        for (uint64_t i = start; i < stop; i++)
+          out[i] = side_of_cell_filtered(c._x, pos + 3*i);
+      }, nthreads);
+  }
+  void side_of_facet_batch(const Facet f, uint64_t n, const double* pos,
+                           int8_t* out, int nthreads = 0) const {
+    parallel_for(n, [&](uint64_t start, uint64_t stop, uint32_t) {
+        int lt, li, lj;
+        for (uint64_t i = start; i < stop; i++)
+          out[i] = (int8_t)side_of_facet(pos + 3*i, f, lt, li, lj);
+      }, nthreads);
+  }
+  void side_of_edge_batch(const Edge e, uint64_t n, const double* pos,
+                          int8_t* out, int nthreads = 0) const {
+    parallel_for(n, [&](uint64_t start, uint64_t stop, uint32_t) {
+        int lt, li;
+        for (uint64_t i = start; i < stop; i++)
+          out[i] = (int8_t)side_of_edge(pos + 3*i, e, lt, li);
+      }, nthreads);
+  }
+
+  // Stable integer ids. A cell id is the row of the cell in the serialized
+  // cells array and a vertex id is its info, which is how the serialized cells
+  // array, vertices and edges number vertices; the infinite vertex has id
+  // std::numeric_limits<Info>::max(). id_verts holds the finite vertices in
+  // container order and id_info_verts maps each info back to its vertex.
+  // Ids are built lazily and stay valid until the next mutation.
+  void update_ids() const {
+    if (ids_valid)
+      return;
+    Vertex_handle vinf = T.infinite_vertex();
+    id_verts.clear();
+    id_cells.clear();
+    id_verts.reserve(T.number_of_vertices());
+    id_cells.reserve(T.tds().number_of_cells());
+    for (All_vertices_iterator it = T.tds().vertices_begin(); it != T.tds().vertices_end(); ++it) {
+      if (it != vinf)
+        id_verts.push_back(it);
+    }
+    for (Cell_iterator it = T.tds().cells_begin(); it != T.tds().cells_end(); ++it)
+      id_cells.push_back(it);
+    uint64_t nrow = 0;
+    for (uint64_t i = 0; i < id_verts.size(); i++)
+      nrow = std::max(nrow, (uint64_t)(id_verts[i]->info()) + 1);
+    id_info_verts.assign(nrow, Vertex_handle());
+    for (uint64_t i = 0; i < id_verts.size(); i++)
+      id_info_verts[id_verts[i]->info()] = id_verts[i];
+    id_cell_map.build(id_cells);
+    ids_generation++;
+    ids_valid = true;
+  }
+  Info vertex_id_handle(const Vertex_handle v) const {
+    if ((v == Vertex_handle()) || (v == T.infinite_vertex()))
+      return std::numeric_limits<Info>::max();
+    return v->info();
+  }
+  Vertex_handle vertex_handle_id(Info i) const {
+    if ((i >= (Info)id_info_verts.size()) || (id_info_verts[i] == Vertex_handle()))
+      return T.infinite_vertex();
+    return id_info_verts[i];
+  }
+  Info cell_id_handle(const Cell_handle c) const {
+    return (Info)id_cell_map.find(c);
+  }
+  Info vertex_id(const Vertex v) const { update_ids(); return vertex_id_handle(v._x); }
+  Info cell_id(const Cell c) const { update_ids(); return cell_id_handle(c._x); }
+  Vertex vertex_from_id(Info i) const {
+    update_ids();
+    return Vertex(vertex_handle_id(i));
+  }
+  Cell cell_from_id(Info i) const {
+    update_ids();
+    return Cell(id_cells[i]);
+  }
+
+  // Id of the cell containing each point. Points are located in order using
+  // the previous cell as the hint so that spatially sorted queries walk a
+  // short distance, or from the hierarchy if fast_location is set.
+  void locate_ids(uint64_t n, const double* pos, Info* out) const {
+    update_ids();
+    Cell_handle hint = Cell_handle();
+    int lt, li, lj;
+    for (uint64_t i = 0; i < n; i++) {
+      Point p = Point(pos[3*i], pos[3*i+1], pos[3*i+2]);
+      if (is_frozen()) {
+        out[i] = cell_id_handle(frozen_locate(p, Cell_handle(), lt, li, lj));
+        continue;
+      }
+      if (fast_location)
+        hint = location_hint(p);
+      hint = T.locate(p, hint);
+      out[i] = cell_id_handle(hint);
     }
   }
 
+  // Vertex and neighbor ids of cells, 4 per cell in CGAL index order.
+  void cell_vertex_ids(uint64_t n, const Info* cells, Info* out,
+                       int nthreads = 0) const {
+    update_ids();
+    parallel_for(n, [&](uint64_t start, uint64_t stop, uint32_t) {
+        for (uint64_t i = start; i < stop; i++) {
+          Cell_handle c = id_cells[cells[i]];
+          for (int j = 0; j < 4; j++)
+            out[4*i + j] = vertex_id_handle(c->vertex(j));
+        }
+      }, nthreads);
+  }
+  void cell_neighbor_ids(uint64_t n, const Info* cells, Info* out,
+                         int nthreads = 0) const {
+    update_ids();
+    parallel_for(n, [&](uint64_t start, uint64_t stop, uint32_t) {
+        for (uint64_t i = start; i < stop; i++) {
+          Cell_handle c = id_cells[cells[i]];
+          for (int j = 0; j < 4; j++)
+            out[4*i + j] = cell_id_handle(c->neighbor(j));
+        }
+      }, nthreads);
+  }
+
+  // Ids of the cells incident to each vertex id as CSR arrays. Ids that no
+  // vertex has get an empty row.
+  void incident_cell_ids(uint64_t n, const Info* verts,
+                         std::vector<uint64_t>& indptr,
+                         std::vector<Info>& ids) const {
+    update_ids();
+    indptr.assign(1, 0);
+    ids.clear();
+    std::vector<Cell_handle> cells;
+    for (uint64_t i = 0; i < n; i++) {
+      cells.clear();
+      Vertex_handle v = vertex_handle_id(verts[i]);
+      if (v != T.infinite_vertex()) {
+        if (is_frozen())
+          frozen_star(v, cells);
+        else
+          T.incident_cells(v, std::back_inserter(cells));
+      }
+      for (uint64_t j = 0; j < cells.size(); j++)
+        ids.push_back(cell_id_handle(cells[j]));
+      indptr.push_back(ids.size());
+    }
+  }
+
+  // Ids of the cells incident to every finite vertex as CSR arrays in info
+  // order, i.e. the cells around the vertex with info i are
+  // ids[indptr[i]:indptr[i+1]] in increasing order. This takes one sweep
+  // over the cells rather than one incident_cells call per vertex. There is
+  // a row for every info up to the largest, so infos freed by remove or
+  // never used get empty rows.
+  void vertex_star_csr(std::vector<uint64_t>& indptr,
+                       std::vector<Info>& ids, int nthreads = 0) const {
+    update_ids();
+    Vertex_handle vinf = T.infinite_vertex();
+    parallel_csr(id_cells.size(), id_info_verts.size(), 4,
+                 [&](uint64_t i, uint32_t k, uint64_t& row) {
+                   Vertex_handle v = id_cells[i]->vertex(k);
+                   if ((v == Vertex_handle()) || (v == vinf))
+                     return false;
+                   row = (uint64_t)(v->info());
+                   return true;
+                 }, indptr, ids, nthreads);
+  }
+
+  // Per-cell metrics by id. The circumcenter is constructed from the points
+  // rather than read from the cell, whose cached value is filled lazily and
+  // so can't be shared between threads. Infinite cells, and all cells below
+  // dimension 3, get an infinite circumcenter and a minimum angle of -1.
+  void cell_circumcenters(uint64_t n, const Info* cells, double* out,
+                          int nthreads = 0) const {
+    update_ids();
+    parallel_for(n, [&](uint64_t start, uint64_t stop, uint32_t) {
+        for (uint64_t i = start; i < stop; i++) {
+          Cell_handle c = id_cells[cells[i]];
+          if ((T.dimension() < 3) || T.is_infinite(c)) {
+            for (int j = 0; j < 3; j++)
+              out[3*i + j] = std::numeric_limits<double>::infinity();
+          } else {
+            Point p = CGAL::circumcenter(c->vertex(0)->point(), c->vertex(1)->point(),
+                                         c->vertex(2)->point(), c->vertex(3)->point());
+            out[3*i + 0] = p.x();
+            out[3*i + 1] = p.y();
+            out[3*i + 2] = p.z();
+          }
+        }
+      }, nthreads);
+  }
+  void cell_minimum_angles(uint64_t n, const Info* cells, double* out,
+                           int nthreads = 0) const {
+    update_ids();
+    parallel_for(n, [&](uint64_t start, uint64_t stop, uint32_t) {
+        for (uint64_t i = start; i < stop; i++) {
+          Cell_handle c = id_cells[cells[i]];
+          if ((T.dimension() < 3) || T.is_infinite(c))
+            out[i] = -1.0;
+          else
+            out[i] = Cell(c).min_angle();
+        }
+      }, nthreads);
+  }
+
   bool is_Gabriel(const Edge e) { return T.is_Gabriel(e._x); }
   bool is_Gabriel(const Facet f) { return T.is_Gabriel(f._x); }
 
+  // Gabriel flag and length for every finite edge in the same order as
+  // edge_info. Either output may be NULL to skip it.
+  void edge_gabriel_lengths(bool* gabriel, double* lengths,
+                            int nthreads = 0) const {
+    std::vector<Edge_handle> edges;
+    edges.reserve(T.number_of_finite_edges());
+    for (Finite_edges_iterator it = T.finite_edges_begin(); it != T.finite_edges_end(); it++)
+      edges.push_back(*it);
+    const Delaunay& Tc = T;
+    parallel_for(edges.size(),
+                 [&](uint64_t start, uint64_t stop, uint32_t) {
+                   for (uint64_t i = start; i < stop; i++) {
+                     const Edge_handle& e = edges[i];
+                     if (gabriel != NULL)
+                       gabriel[i] = Tc.is_Gabriel(e);
+                     if (lengths != NULL) {
+                       const Point& p1 = e.first->vertex(e.second)->point();
+                       const Point& p2 = e.first->vertex(e.third)->point();
+                       lengths[i] = std::sqrt(static_cast<double>(CGAL::squared_distance(p1, p2)));
+                     }
+                   }
+                 }, nthreads);
+  }
+
   void write_to_file(const char* filename) const
   {
     std::ofstream os(filename, std::ios::binary);
@@ -883,6 +1521,8 @@ class Delaunay_with_info_3
   void read_from_buffer(std::ifstream &is) {
     
     updated = true;
+    ids_valid = false;
+    hierarchy.clear();
     if (T.number_of_vertices() != 0)  
       T.clear();
     
@@ -1139,6 +1779,8 @@ class Delaunay_with_info_3
                    I* cells, I* neighbors, I idx_inf)
   {
     updated = true;
+    ids_valid = false;
+    hierarchy.clear();
 
     if (T.number_of_vertices() != 0)  
       T.clear();
@@ -1200,6 +1842,8 @@ class Delaunay_with_info_3
 			   I* cells, I* neighbors, I idx_inf)
   {
     updated = true;
+    ids_valid = false;
+    hierarchy.clear();
 
     if (T.number_of_vertices() != 0)  
       T.clear();
@@ -1316,9 +1960,13 @@ class Delaunay_with_info_3
     return true;
   }
 
+  // Indices of points in cells whose circumsphere intersects each box.
+  // Only cells incident to a vertex with info < max_info are tested (e.g.
+  // the original points of a leaf when only their dual cells are needed).
   std::vector<std::vector<Info>> outgoing_points(uint64_t nbox,
                                                  double *left_edges,
-                                                 double *right_edges) const {
+                                                 double *right_edges,
+                                                 Info max_info = std::numeric_limits<Info>::max()) const {
     std::vector<std::vector<Info>> out;
     uint64_t b;
     for (b = 0; b < nbox; b++)
@@ -1330,6 +1978,13 @@ class Delaunay_with_info_3
     int i, iinf = 0;
 
     for (All_cells_iterator it = T.all_cells_begin(); it != T.all_cells_end(); it++) {
+      for (i = 0; i < 4; i++) {
+        v = it->vertex(i);
+        if ((!T.is_infinite(v)) && (v->info() < max_info))
+          break;
+      }
+      if (i == 4)
+        continue;
       if (T.is_infinite(it) == true) {
         // Find index of infinite vertex
         for (i = 0; i < 4; i++) {
@@ -1359,6 +2014,72 @@ class Delaunay_with_info_3
     return out;
   }
 
+  // Flag the boxes that intersect the conflict region of a cell incident
+  // to a vertex with info < max_info, i.e. the boxes a point could be added
+  // from that would change the dual cells of those vertices. For infinite
+  // cells this is the half space beyond the hull facet.
+  std::vector<bool> conflicting_boxes(uint64_t nbox, double *left_edges,
+                                      double *right_edges, Info max_info) const {
+    std::vector<bool> out(nbox, false);
+    if (T.dimension() < 3) {
+      out.assign(nbox, true);
+      return out;
+    }
+    uint64_t b;
+
+    Vertex_handle v;
+    Point cc, p1;
+    Point q[4];
+    double cr;
+    int i, c, iinf = 0;
+
+    for (All_cells_iterator it = T.all_cells_begin(); it != T.all_cells_end(); it++) {
+      for (i = 0; i < 4; i++) {
+        v = it->vertex(i);
+        if ((!T.is_infinite(v)) && (v->info() < max_info))
+          break;
+      }
+      if (i == 4)
+        continue;
+      if (T.is_infinite(it) == true) {
+        // Find index of infinite vertex
+        for (i = 0; i < 4; i++) {
+          v = it->vertex(i);
+          if (T.is_infinite(v)) {
+            iinf = i;
+            break;
+          }
+        }
+        // A point is beyond the facet if putting it in place of the
+        // infinite vertex gives a positively oriented cell
+        for (i = 0; i < 4; i++) {
+          if (i != iinf)
+            q[i] = it->vertex(i)->point();
+        }
+        for (b = 0; b < nbox; b++) {
+          for (c = 0; (c < 8) && (!out[b]); c++) {
+            q[iinf] = Point((c & 1) ? right_edges[3*b] : left_edges[3*b],
+                            (c & 2) ? right_edges[3*b+1] : left_edges[3*b+1],
+                            (c & 4) ? right_edges[3*b+2] : left_edges[3*b+2]);
+            if (CGAL::orientation(q[0], q[1], q[2], q[3]) != CGAL::NEGATIVE)
+              out[b] = true;
+          }
+        }
+      } else {
+        p1 = it->vertex(0)->point();
+	cc = it->circumcenter();
+        cr = std::sqrt(static_cast<double>(CGAL::squared_distance(p1, cc)));
+        for (b = 0; b < nbox; b++) {
+          if ((!out[b]) &&
+              intersect_sph_box(&cc, cr, left_edges + 3*b, right_edges + 3*b))
+            out[b] = true;
+        }
+      }
+    }
+
+    return out;
+  }
+
   void boundary_points(double *left_edge, double *right_edge, bool periodic,
                        std::vector<Info>& lx, std::vector<Info>& ly, std::vector<Info>& lz,
                        std::vector<Info>& rx, std::vector<Info>& ry, std::vector<Info>& rz,
@@ -10,6 +10,7 @@
 #include <algorithm>
 #include <limits>
 #include <stdint.h>
+#include "c_threads.hpp"
 #ifdef READTHEDOCS
 #define VALID 1
 #include "dummy_CGAL.hpp"
@@ -1258,6 +1259,35 @@ public:
     }
   }
 
+  // Rows of the cells (as in serialize) incident to every finite vertex as
+  // CSR arrays in info order, i.e. the cells around the vertex with info i
+  // are ids[indptr[i]:indptr[i+1]] in increasing order. This takes one sweep
+  // over the cells rather than one incident_cells call per vertex. There is
+  // a row for every info up to the largest, so infos freed by remove or
+  // never used get empty rows.
+  void vertex_star_csr(std::vector<uint64_t>& indptr,
+                       std::vector<Info>& ids, int nthreads = 0) const {
+    uint64_t nrow = 0;
+    for (Finite_vertex_const_iterator it = T.finite_vertices_begin();
+         it != T.finite_vertices_end(); it++)
+      nrow = std::max(nrow, (uint64_t)(it->data()) + 1);
+    std::vector<Cell_const_iterator> cells;
+    cells.reserve(T.number_of_full_cells());
+    for (Cell_const_iterator it = T.full_cells_begin();
+         it != T.full_cells_end(); ++it)
+      cells.push_back(it);
+    Vertex_handle vinf = T.infinite_vertex();
+    int d = T.current_dimension();
+    parallel_csr(cells.size(), nrow, (uint32_t)(d < 0 ? 1 : d + 1),
+                 [&](uint64_t i, uint32_t k, uint64_t& row) {
+                   Vertex_handle v = cells[i]->vertex(k);
+                   if (v == vinf)
+                     return false;
+                   row = (uint64_t)(v->data());
+                   return true;
+                 }, indptr, ids, nthreads);
+  }
+
   bool intersect_sph_box(Point c, double r, double *le, double *re) const {
     for (int i = 0; i < T.current_dimension(); i++) {
       if ((double)(c[i]) < le[i]) {
@@ -1271,9 +1301,13 @@ public:
     return true;
   }
 
+  // Indices of points in cells whose circumsphere intersects each box.
+  // Only cells incident to a vertex with info < max_info are tested (e.g.
+  // the original points of a leaf when only their dual cells are needed).
   std::vector<std::vector<Info>> outgoing_points(uint64_t nbox,
                                                  double *left_edges,
-                                                 double *right_edges) const {
+                                                 double *right_edges,
+                                                 Info max_info = std::numeric_limits<Info>::max()) const {
     std::vector<std::vector<Info>> out;
     uint64_t b;
     for (b = 0; b < nbox; b++)
@@ -1286,6 +1320,13 @@ public:
     int d = T.current_dimension();
 
     for (Cell_const_iterator it = T.full_cells_begin(); it != T.full_cells_end(); it++) {
+      for (i = 0; i < (d+1); i++) {
+        v = it->vertex(i);
+        if ((!T.is_infinite(v)) && (v->data() < max_info))
+          break;
+      }
+      if (i == (d+1))
+        continue;
       if (T.is_infinite(it) == true) {
         // Find index of infinite vertex
         for (i = 0; i < (d+1); i++) {
@@ -1316,6 +1357,46 @@ public:
 
     return out;
   }
+
+  // Flag the boxes that intersect the conflict region of a cell incident
+  // to a vertex with info < max_info, i.e. the boxes a point could be added
+  // from that would change the dual cells of those vertices. Infinite cells
+  // are taken to reach every box.
+  std::vector<bool> conflicting_boxes(uint64_t nbox, double *left_edges,
+                                      double *right_edges, Info max_info) const {
+    std::vector<bool> out(nbox, false);
+    uint64_t b;
+
+    Vertex_handle v;
+    Point cc, p1;
+    double cr;
+    int i;
+    int d = T.current_dimension();
+
+    for (Cell_const_iterator it = T.full_cells_begin(); it != T.full_cells_end(); it++) {
+      for (i = 0; i < (d+1); i++) {
+        v = it->vertex(i);
+        if ((!T.is_infinite(v)) && (v->data() < max_info))
+          break;
+      }
+      if (i == (d+1))
+        continue;
+      if (T.is_infinite(it) == true) {
+        out.assign(nbox, true);
+        break;
+      } else {
+        p1 = it->vertex(0)->point();
+        cc = it->circumcenter();
+        cr = std::sqrt(static_cast<double>(T.geom_traits().squared_distance_d_object()(p1, cc)));
+        for (b = 0; b < nbox; b++) {
+          if ((!out[b]) && intersect_sph_box(cc, cr, left_edges + d*b, right_edges + d*b))
+            out[b] = true;
+        }
+      }
+    }
+
+    return out;
+  }
   
 };
 
@@ -0,0 +1,391 @@
+// Runtime Delaunay hierarchy used to find a good starting cell for point
+// location in an existing triangulation, and read-only walks that can be
+// run from several threads at once
+#ifndef CGAL4PY_C_HIERARCHY_HPP
+#define CGAL4PY_C_HIERARCHY_HPP
+
+#include <vector>
+#include <utility>
+#include <random>
+#include <algorithm>
+#include <atomic>
+#include <stdint.h>
+
+
+// Walk state owned by the caller. CGAL's locate draws from a random
+// generator shared by the triangulation and its incident queries mark cells
+// as visited, so neither is safe to call concurrently. The walks below only
+// read the triangulation and take their randomness from here.
+struct Walk_state {
+  uint64_t x;
+  Walk_state(uint64_t seed = 88172645463325252ULL) : x(seed ? seed : 1) {}
+  uint32_t next() {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return (uint32_t)(x >> 32);
+  }
+};
+
+// Read-only map from handles to integer ids. Lookups in a
+// CGAL::Unique_hash_map update its internal search state, so one can't be
+// shared between threads even when nothing is inserted. This is a table
+// sorted by address and searched by bisection instead.
+template <typename Handle>
+class Handle_id_map
+{
+public:
+  std::vector<std::pair<uintptr_t, uint64_t>> table;
+
+  void clear() { table.clear(); }
+  void build(const std::vector<Handle>& handles) {
+    table.resize(handles.size());
+    for (uint64_t i = 0; i < handles.size(); i++)
+      table[i] = std::make_pair((uintptr_t)(&*handles[i]), i);
+    std::sort(table.begin(), table.end());
+  }
+  // Id of h, or -1 if it is not in the table
+  int64_t find(Handle h) const {
+    if (h == Handle())
+      return -1;
+    uintptr_t key = (uintptr_t)(&*h);
+    typename std::vector<std::pair<uintptr_t, uint64_t>>::const_iterator it =
+      std::lower_bound(table.begin(), table.end(), std::make_pair(key, (uint64_t)0));
+    if ((it == table.end()) || (it->first != key))
+      return -1;
+    return (int64_t)(it->second);
+  }
+};
+
+// Unique stamp for each frozen state so that per-thread walk state left
+// over from another triangulation (or an earlier freeze) is never reused.
+inline uint64_t next_walk_epoch() {
+  static std::atomic<uint64_t> epoch(0);
+  return ++epoch;
+}
+
+// Designated cell/face of a vertex for 3D/2D triangulations
+template <typename V>
+auto incident_cell(V v, int) -> decltype(v->cell()) { return v->cell(); }
+template <typename V>
+auto incident_cell(V v, long) -> decltype(v->face()) { return v->face(); }
+
+// Orientation of the N-simplex with vertices w[0..N]
+template <int N> struct Simplex_orientation;
+template <> struct Simplex_orientation<2> {
+  template <typename Point>
+  static CGAL::Orientation apply(const Point* const* w) {
+    return CGAL::orientation(*w[0], *w[1], *w[2]);
+  }
+};
+template <> struct Simplex_orientation<3> {
+  template <typename Point>
+  static CGAL::Orientation apply(const Point* const* w) {
+    return CGAL::orientation(*w[0], *w[1], *w[2], *w[3]);
+  }
+};
+
+// Stochastic visibility walk from start towards p in a triangulation of
+// full dimension N. Returns the finite cell containing p, or an infinite
+// cell if p is outside the convex hull.
+template <int N, typename Tr, typename Cell_handle>
+Cell_handle walk_locate(const Tr& T, const typename Tr::Point& p,
+                        Cell_handle start, Walk_state& st) {
+  typedef typename Tr::Point Point;
+  Cell_handle c = start, prev = Cell_handle(), next;
+  if (c == Cell_handle())
+    c = incident_cell(T.infinite_vertex(), 0);
+  if (T.is_infinite(c))
+    c = c->neighbor(c->index(T.infinite_vertex()));
+  const Point* w[N + 1];
+  const Point* tmp;
+  int i, j, i0;
+  while (!T.is_infinite(c)) {
+    for (i = 0; i <= N; i++)
+      w[i] = &(c->vertex(i)->point());
+    i0 = (int)(st.next() % (N + 1));
+    next = Cell_handle();
+    for (j = 0; j <= N; j++) {
+      i = (i0 + j) % (N + 1);
+      // p is on this side of the facet that was just crossed
+      if (c->neighbor(i) == prev)
+        continue;
+      tmp = w[i];
+      w[i] = &p;
+      if (Simplex_orientation<N>::apply(w) == CGAL::NEGATIVE)
+        next = c->neighbor(i);
+      w[i] = tmp;
+      if (next != Cell_handle())
+        break;
+    }
+    if (next == Cell_handle())
+      break;
+    prev = c;
+    c = next;
+  }
+  return c;
+}
+
+// Locate type of p in a cell returned by walk_locate with li/lj as for the
+// triangulation's locate. The value matches CGAL's Locate_type: vertex 0,
+// edge 1, facet 2 (3D only), cell/face N, outside the convex hull N + 1.
+template <int N, typename Tr, typename Cell_handle>
+int walk_locate_type(const Tr& T, const typename Tr::Point& p,
+                     Cell_handle c, int& li, int& lj) {
+  typedef typename Tr::Point Point;
+  if (T.is_infinite(c)) {
+    li = c->index(T.infinite_vertex());
+    return N + 1;
+  }
+  const Point* w[N + 1];
+  const Point* tmp;
+  int zero[N + 1], other[N + 1], nzero = 0, nother = 0, i;
+  for (i = 0; i <= N; i++)
+    w[i] = &(c->vertex(i)->point());
+  for (i = 0; i <= N; i++) {
+    tmp = w[i];
+    w[i] = &p;
+    if (Simplex_orientation<N>::apply(w) == CGAL::ZERO)
+      zero[nzero++] = i;
+    else
+      other[nother++] = i;
+    w[i] = tmp;
+  }
+  if (nzero == 0)
+    return N;
+  if (nzero == N) {
+    li = other[0];
+    return 0;
+  }
+  if ((N == 3) && (nzero == 1)) {
+    li = zero[0];
+    return 2;
+  }
+  // Edge. In 3D it is given by its two vertices, in 2D by the opposite one.
+  if (N == 3) {
+    li = other[0];
+    lj = other[1];
+  } else {
+    li = zero[0];
+  }
+  return 1;
+}
+
+// Nearest finite vertex to p by greedy descent over the Delaunay graph,
+// starting from the vertices of the cell found by walk_locate. The cells
+// around a vertex are gathered in a local list rather than with CGAL's
+// visited flags.
+template <int N, typename Tr, typename Cell_handle>
+typename Tr::Vertex_handle walk_nearest_vertex(const Tr& T,
+                                               const typename Tr::Point& p,
+                                               Cell_handle start,
+                                               Walk_state& st) {
+  typedef typename Tr::Vertex_handle Vertex_handle;
+  Cell_handle c = walk_locate<N>(T, p, start, st);
+  Vertex_handle v = Vertex_handle(), vbest, w;
+  double d, dmin = 0;
+  int i;
+  for (i = 0; i <= N; i++) {
+    w = c->vertex(i);
+    if (T.is_infinite(w))
+      continue;
+    d = CGAL::to_double(CGAL::squared_distance(p, w->point()));
+    if ((v == Vertex_handle()) || (d < dmin)) {
+      v = w;
+      dmin = d;
+    }
+  }
+  std::vector<Cell_handle> star;
+  vbest = v;
+  do {
+    v = vbest;
+    star.clear();
+    star.push_back(incident_cell(v, 0));
+    for (uint64_t k = 0; k < star.size(); k++) {
+      c = star[k];
+      for (i = 0; i <= N; i++) {
+        w = c->vertex(i);
+        if (w == v)
+          continue;
+        if (!T.is_infinite(w)) {
+          d = CGAL::to_double(CGAL::squared_distance(p, w->point()));
+          if (d < dmin) {
+            vbest = w;
+            dmin = d;
+          }
+        }
+        // The neighbor opposite a vertex other than v also contains v
+        if (std::find(star.begin(), star.end(), c->neighbor(i)) == star.end())
+          star.push_back(c->neighbor(i));
+      }
+    }
+  } while (vbest != v);
+  return v;
+}
+
+
+// Coarse levels on top of a fine triangulation, in the spirit of
+// CGAL::Triangulation_hierarchy_2/3 but kept beside the fine triangulation
+// so that it keeps its type. Each fine vertex is given a random level L,
+// with L >= l for a fraction 1/ratio^l of them, and is put on the coarse
+// levels 0..L-1, so every level is a subset of the one below. A query walks
+// the (small) coarsest level of full dimension from scratch and then starts
+// the walk on each finer level from the nearest vertex found on the level
+// above. The vertex info on a coarse level is the position of the vertex on
+// that level. Vertices inserted in the fine triangulation can be added one
+// at a time, but removing or moving a fine vertex invalidates the hierarchy
+// as it may still refer to it. Queries use the read-only walks above, so a
+// built hierarchy can be shared between threads.
+template <int N, typename Coarse, typename Fine_vertex_handle>
+class Location_hierarchy
+{
+public:
+  typedef typename Coarse::Point                       Point;
+  typedef typename Coarse::Vertex_handle               Coarse_vertex_handle;
+  typedef decltype(incident_cell(std::declval<Coarse_vertex_handle>(), 0)) Coarse_cell_handle;
+  uint32_t ratio;
+  uint32_t max_levels;
+  bool valid;
+  // Fine vertex of each position on level 0
+  std::vector<Fine_vertex_handle> sample;
+  std::vector<Coarse*> levels;
+  std::vector<std::vector<Coarse_vertex_handle>> handles;
+  // Position on level l - 1 of each vertex on level l (empty for l = 0)
+  std::vector<std::vector<uint32_t>> down;
+  std::mt19937 rng;
+  Walk_state st;
+
+  Location_hierarchy(uint32_t ratio0 = 30, uint32_t max_levels0 = 5) :
+    ratio(ratio0), max_levels(max_levels0), valid(false) {}
+  // Copies start empty as the fine handles belong to the original
+  Location_hierarchy(const Location_hierarchy& other) :
+    ratio(other.ratio), max_levels(other.max_levels), valid(false) {}
+  Location_hierarchy& operator=(const Location_hierarchy& other) {
+    if (this != &other) {
+      clear();
+      ratio = other.ratio;
+      max_levels = other.max_levels;
+    }
+    return *this;
+  }
+  ~Location_hierarchy() { clear(); }
+
+  void clear() {
+    for (uint32_t l = 0; l < levels.size(); l++)
+      delete levels[l];
+    levels.clear();
+    handles.clear();
+    down.clear();
+    sample.clear();
+    valid = false;
+  }
+
+  // Rebuild the levels from the finite vertices of the fine triangulation
+  void build(const std::vector<Fine_vertex_handle>& verts) {
+    clear();
+    rng.seed(5489u);
+    st = Walk_state();
+    std::vector<std::vector<std::pair<Point, uint32_t>>> pts;
+    uint32_t l, L;
+    for (uint64_t i = 0; i < verts.size(); i++) {
+      L = draw_level();
+      if (L > pts.size()) {
+        pts.resize(L);
+        down.resize(L);
+      }
+      for (l = 0; l < L; l++) {
+        if (l == 0)
+          sample.push_back(verts[i]);
+        else
+          down[l].push_back((uint32_t)(pts[l - 1].size() - 1));
+        pts[l].push_back(std::make_pair(Point(verts[i]->point()),
+                                        (uint32_t)pts[l].size()));
+      }
+    }
+    for (l = 0; l < pts.size(); l++) {
+      Coarse* C = new Coarse();
+      C->insert(pts[l].begin(), pts[l].end());
+      std::vector<Coarse_vertex_handle> h(pts[l].size());
+      for (typename Coarse::Finite_vertices_iterator it = C->finite_vertices_begin();
+           it != C->finite_vertices_end(); ++it)
+        h[it->info()] = it;
+      levels.push_back(C);
+      handles.push_back(h);
+    }
+    valid = true;
+  }
+
+  // Add v, which was just inserted in the fine triangulation, to the levels
+  // it is drawn for. Each coarse insertion starts from the nearest vertex
+  // on that level, so this costs about as much as a query.
+  void insert(Fine_vertex_handle v) {
+    if (!valid)
+      return;
+    uint32_t L = draw_level();
+    if (L == 0)
+      return;
+    std::vector<int64_t> path(std::max((uint32_t)levels.size(), L), -1);
+    descend(Point(v->point()), st, path.data());
+    while (levels.size() < L) {
+      levels.push_back(new Coarse());
+      handles.push_back(std::vector<Coarse_vertex_handle>());
+      down.push_back(std::vector<uint32_t>());
+    }
+    Point p(v->point());
+    for (uint32_t l = 0; l < L; l++) {
+      Coarse_cell_handle hint = Coarse_cell_handle();
+      if (path[l] >= 0)
+        hint = incident_cell(handles[l][path[l]], 0);
+      Coarse_vertex_handle w = levels[l]->insert(p, hint);
+      w->info() = (uint32_t)handles[l].size();
+      handles[l].push_back(w);
+      if (l == 0)
+        sample.push_back(v);
+      else
+        down[l].push_back((uint32_t)(handles[l - 1].size() - 1));
+    }
+  }
+
+  // Fine vertex close to p to start a walk from. A default handle is
+  // returned if no coarse level has full dimension yet.
+  Fine_vertex_handle nearest(const Point& p, Walk_state& st0) const {
+    int64_t i = descend(p, st0, NULL);
+    if (i < 0)
+      return Fine_vertex_handle();
+    return sample[i];
+  }
+
+private:
+  uint32_t draw_level() {
+    uint32_t L = 0;
+    while ((L < max_levels) && ((rng() % ratio) == 0))
+      L++;
+    return L;
+  }
+
+  // Position on level 0 of the vertex nearest to p, found by walking down
+  // from the coarsest level of full dimension, or -1 if there is none. If
+  // path is not NULL, the position found on each level is stored there.
+  int64_t descend(const Point& p, Walk_state& st0, int64_t* path) const {
+    int l = (int)levels.size() - 1;
+    while ((l >= 0) && (levels[l]->dimension() < N))
+      l--;
+    if (l < 0)
+      return -1;
+    const Coarse& top = *levels[l];
+    Coarse_vertex_handle v = walk_nearest_vertex<N>(
+        top, p, incident_cell(top.infinite_vertex(), 0), st0);
+    if (path != NULL)
+      path[l] = v->info();
+    for (l--; l >= 0; l--) {
+      uint32_t i = down[l + 1][v->info()];
+      v = walk_nearest_vertex<N>(*levels[l], p,
+                                 incident_cell(handles[l][i], 0), st0);
+      if (path != NULL)
+        path[l] = v->info();
+    }
+    return (int64_t)(v->info());
+  }
+};
+
+#endif
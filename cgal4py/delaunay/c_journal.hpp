@@ -0,0 +1,98 @@
+// Records of the cells removed by an insertion so that they can be put
+// back by a transaction rollback
+#ifndef CGAL4PY_C_JOURNAL_HPP
+#define CGAL4PY_C_JOURNAL_HPP
+
+#include <vector>
+#include <array>
+#include <utility>
+#include <algorithm>
+#include <stdint.h>
+#include "c_hierarchy.hpp"
+
+
+// Cells (faces in 2D) removed by inserting v into a triangulation of full
+// dimension N, in the order they are recreated on rollback. Only vertices
+// are kept. Handles to the cells outside the hole are not, as a later
+// insertion may delete those cells and its rollback recreate them under
+// new handles. Instead, the outside cells are found again on rollback as
+// the neighbors of the star of v opposite v, matched by the vertices of
+// the shared facet.
+template <int N, typename Vertex_handle, typename Cell_handle>
+class Hole_record
+{
+public:
+  typedef std::array<uintptr_t, N> Facet_key;
+  Vertex_handle v;
+  bool existing = false;
+  // N + 1 entries per removed cell. For each facet, nbr is the position of
+  // the neighbor among the removed cells, or -1 if it is outside the hole.
+  std::vector<Vertex_handle> verts;
+  std::vector<int64_t> nbr;
+
+  void record(const std::vector<Cell_handle>& cells) {
+    Handle_id_map<Cell_handle> pos;
+    pos.build(cells);
+    verts.resize((N + 1)*cells.size());
+    nbr.resize((N + 1)*cells.size());
+    for (uint64_t k = 0; k < cells.size(); k++) {
+      for (int i = 0; i <= N; i++) {
+        verts[(N + 1)*k + i] = cells[k]->vertex(i);
+        nbr[(N + 1)*k + i] = pos.find(cells[k]->neighbor(i));
+      }
+    }
+  }
+
+  uint64_t num_cells() const { return nbr.size()/(N + 1); }
+
+  // Link the recreated cells to each other and to the cells outside the
+  // hole. made holds the new cells in recorded order and star the cells
+  // incident to v, which must still be the ones created by the insertion.
+  void relink(const std::vector<Cell_handle>& star,
+              const std::vector<Cell_handle>& made) const {
+    std::vector<std::pair<Facet_key, std::pair<Cell_handle, int>>> outside;
+    outside.reserve(star.size());
+    for (uint64_t s = 0; s < star.size(); s++) {
+      int iv = star[s]->index(v);
+      Cell_handle o = star[s]->neighbor(iv);
+      outside.push_back(std::make_pair(facet_key(star[s], iv),
+                                       std::make_pair(o, o->index(star[s]))));
+    }
+    std::sort(outside.begin(), outside.end(), key_less);
+    for (uint64_t k = 0; k < made.size(); k++) {
+      for (int i = 0; i <= N; i++) {
+        int64_t j = nbr[(N + 1)*k + i];
+        if (j >= 0) {
+          made[k]->set_neighbor(i, made[j]);
+          continue;
+        }
+        std::pair<Facet_key, std::pair<Cell_handle, int>> q;
+        q.first = facet_key(made[k], i);
+        typename std::vector<std::pair<Facet_key, std::pair<Cell_handle, int>>>::const_iterator it =
+          std::lower_bound(outside.begin(), outside.end(), q, key_less);
+        Cell_handle o = it->second.first;
+        made[k]->set_neighbor(i, o);
+        o->set_neighbor(it->second.second, made[k]);
+      }
+    }
+  }
+
+private:
+  // Sorted addresses of the vertices of the facet of c opposite i
+  static Facet_key facet_key(Cell_handle c, int i) {
+    Facet_key key;
+    int n = 0;
+    for (int j = 0; j <= N; j++) {
+      if (j != i)
+        key[n++] = (uintptr_t)(&*(c->vertex(j)));
+    }
+    std::sort(key.begin(), key.end());
+    return key;
+  }
+  static bool key_less(const std::pair<Facet_key, std::pair<Cell_handle, int>>& a,
+                       const std::pair<Facet_key, std::pair<Cell_handle, int>>& b) {
+    return a.first < b.first;
+  }
+};
+
+#endif
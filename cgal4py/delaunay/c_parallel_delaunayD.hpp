@@ -16,6 +16,11 @@
 #include "c_periodic_delaunay2.hpp"
 #include "c_periodic_delaunay3.hpp"
 #include "c_delaunayD.hpp"
+
+#define DD_KDTREE  0 // KD tree with a power of two number of leaves
+#define DD_HILBERT 1 // chunks of a Hilbert curve
+#define DD_MORTON  2 // chunks of a Morton curve
+#define DD_KDTREE_COST 3 // KD tree split with the cost policy
 #if (CGAL_VERSION_NR < 1040900900)
 #define VALID_PERIODIC_2 0
 #else
@@ -274,20 +279,21 @@ public:
 
   std::vector<std::vector<Info>> outgoing_points(uint64_t nbox,
                                                  double *left_edges,
-						 double *right_edges) const {
+						 double *right_edges,
+						 Info max_info = std::numeric_limits<Info>::max()) const {
     std::vector<std::vector<Info>> out;
     if (ndim == 2) {
       if (periodic)
-	out = ((PeriodicDelaunay2*)T)->outgoing_points(nbox, left_edges, right_edges);
+	out = ((PeriodicDelaunay2*)T)->outgoing_points(nbox, left_edges, right_edges, max_info);
       else
-	out = ((Delaunay2*)T)->outgoing_points(nbox, left_edges, right_edges);
+	out = ((Delaunay2*)T)->outgoing_points(nbox, left_edges, right_edges, max_info);
     } else if (ndim == 3) {
       if (periodic)
-	out = ((PeriodicDelaunay3*)T)->outgoing_points(nbox, left_edges, right_edges);
+	out = ((PeriodicDelaunay3*)T)->outgoing_points(nbox, left_edges, right_edges, max_info);
       else
-	out = ((Delaunay3*)T)->outgoing_points(nbox, left_edges, right_edges);
+	out = ((Delaunay3*)T)->outgoing_points(nbox, left_edges, right_edges, max_info);
     } else if (ndim == D) {
-      out = ((DelaunayD*)T)->outgoing_points(nbox, left_edges, right_edges);
+      out = ((DelaunayD*)T)->outgoing_points(nbox, left_edges, right_edges, max_info);
     } else {
       char msg[100];
       sprintf(msg, "[outgoing_points] Incorrect number of dimensions. %d", ndim);
@@ -296,6 +302,29 @@ public:
     return out;
   }
 
+  std::vector<bool> conflicting_boxes(uint64_t nbox, double *left_edges,
+				      double *right_edges, Info max_info) const {
+    std::vector<bool> out;
+    if (ndim == 2) {
+      if (periodic)
+	out = ((PeriodicDelaunay2*)T)->conflicting_boxes(nbox, left_edges, right_edges, max_info);
+      else
+	out = ((Delaunay2*)T)->conflicting_boxes(nbox, left_edges, right_edges, max_info);
+    } else if (ndim == 3) {
+      if (periodic)
+	out = ((PeriodicDelaunay3*)T)->conflicting_boxes(nbox, left_edges, right_edges, max_info);
+      else
+	out = ((Delaunay3*)T)->conflicting_boxes(nbox, left_edges, right_edges, max_info);
+    } else if (ndim == D) {
+      out = ((DelaunayD*)T)->conflicting_boxes(nbox, left_edges, right_edges, max_info);
+    } else {
+      char msg[100];
+      sprintf(msg, "[conflicting_boxes] Incorrect number of dimensions. %d", ndim);
+      my_error(msg);
+    }
+    return out;
+  }
+
   void write_to_buffer(std::ofstream &os) {
     if (ndim == 2) {
       if (periodic)
@@ -359,6 +388,182 @@ public:
 };
 
 
+// Broadcast a vector of plain values from root, resizing it elsewhere
+template <typename T>
+void bcast_vector(std::vector<T> &v, int root = 0) {
+  uint64_t n = (uint64_t)v.size();
+  MPI_Bcast(&n, 1, MPI_UNSIGNED_LONG, root, MPI_COMM_WORLD);
+  v.resize(n);
+  if (n > 0)
+    MPI_Bcast(&v[0], (int)(n*sizeof(T)), MPI_BYTE, root, MPI_COMM_WORLD);
+}
+
+// Decomposition shared by all leaves on a rank. It holds the bounds of every
+// leaf, the domain width, the periodic flags and face adjacency of every
+// leaf (KD trees only), a CSR list of the initial neighbors of each leaf and
+// the rank each leaf lives on. It is built on root, broadcast once and only
+// changed when leaf bounds grow or leaves are split, so leaves keep a
+// pointer to it rather than their own copies.
+class CDecompDescriptor
+{
+public:
+  uint32_t nleaves = 0;
+  uint32_t ndim = 0;
+  std::vector<double> leaves_le;
+  std::vector<double> leaves_re;
+  std::vector<double> domain_width;
+  LeafAdjacency adj;
+  std::vector<uint64_t> neigh_indptr;
+  std::vector<uint32_t> neigh_ids;
+  std::vector<int> leaf_rank;
+
+  CDecompDescriptor() {}
+  CDecompDescriptor(uint32_t ndim0, const std::vector<double> &le,
+		    const std::vector<double> &re, const double *domain_width0,
+		    const LeafAdjacency &adj0) {
+    ndim = ndim0;
+    nleaves = (uint32_t)(le.size()/ndim);
+    leaves_le = le;
+    leaves_re = re;
+    domain_width.assign(domain_width0, domain_width0 + ndim);
+    adj = adj0;
+    // Neighbors are the leaves sharing a face in any dimension
+    std::vector<std::pair<uint64_t, uint32_t> > pairs;
+    uint32_t i, k;
+    uint64_t j;
+    for (i = 0; i < nleaves; i++) {
+      for (k = 0; k < ndim; k++) {
+	for (j = 0; j < adj.num_left(i, k); j++)
+	  pairs.push_back(std::make_pair((uint64_t)i, adj.left(i, k)[j]));
+	for (j = 0; j < adj.num_right(i, k); j++)
+	  pairs.push_back(std::make_pair((uint64_t)i, adj.right(i, k)[j]));
+      }
+    }
+    LeafAdjacency::to_csr(nleaves, pairs, neigh_indptr, neigh_ids);
+  }
+  CDecompDescriptor(CurveDecomposition *dd) {
+    nleaves = (uint32_t)(dd->leaf_start.size() - 1);
+    ndim = dd->ndim;
+    leaves_le = dd->leaves_le;
+    leaves_re = dd->leaves_re;
+    domain_width.resize(ndim);
+    for (uint32_t k = 0; k < ndim; k++)
+      domain_width[k] = dd->domain_re[k] - dd->domain_le[k];
+    // Curve chunks are not used with periodic domains, so there are no face
+    // lists. Their boxes cover the domain but overlap, so the initial
+    // neighbors are the chunks whose boxes overlap or touch; chunks that a
+    // circumsphere reaches beyond those are found as the neighbor lists
+    // grow during the exchange, as for KD leaves.
+    LeafAdjacency::overlapping(nleaves, ndim, &leaves_le[0], &leaves_re[0],
+			       neigh_indptr, neigh_ids);
+  }
+
+  // Share the descriptor built on root with all other ranks
+  void bcast(int root = 0) {
+    uint64_t nadj = adj.nleaves;
+    MPI_Bcast(&nleaves, 1, MPI_UNSIGNED, root, MPI_COMM_WORLD);
+    MPI_Bcast(&ndim, 1, MPI_UNSIGNED, root, MPI_COMM_WORLD);
+    MPI_Bcast(&nadj, 1, MPI_UNSIGNED_LONG, root, MPI_COMM_WORLD);
+    adj.nleaves = nadj;
+    adj.ndim = ndim;
+    bcast_vector(leaves_le, root);
+    bcast_vector(leaves_re, root);
+    bcast_vector(domain_width, root);
+    bcast_vector(adj.periodic_left, root);
+    bcast_vector(adj.periodic_right, root);
+    bcast_vector(adj.left_indptr, root);
+    bcast_vector(adj.left_ids, root);
+    bcast_vector(adj.right_indptr, root);
+    bcast_vector(adj.right_ids, root);
+    bcast_vector(neigh_indptr, root);
+    bcast_vector(neigh_ids, root);
+    bcast_vector(leaf_rank, root);
+  }
+
+  // Leaf i starts on rank i % size
+  void assign_ranks(int size) {
+    leaf_rank.resize(nleaves);
+    for (uint32_t i = 0; i < nleaves; i++)
+      leaf_rank[i] = (int)(i % (uint32_t)size);
+  }
+
+  // Leaves added by split have no face lists and are never periodic
+  bool periodic_left(uint32_t leaf, uint32_t k) const {
+    return (leaf < adj.nleaves) && adj.periodic_left[ndim*leaf+k];
+  }
+  bool periodic_right(uint32_t leaf, uint32_t k) const {
+    return (leaf < adj.nleaves) && adj.periodic_right[ndim*leaf+k];
+  }
+  bool periodic_face(uint32_t leaf) const {
+    for (uint32_t k = 0; k < ndim; k++) {
+      if (periodic_left(leaf, k) || periodic_right(leaf, k))
+	return true;
+    }
+    return false;
+  }
+  // Leaf n shares the left/right face of leaf in dimension k
+  bool is_left_neighbor(uint32_t leaf, uint32_t k, uint32_t n) const {
+    if (leaf >= adj.nleaves)
+      return false;
+    return std::binary_search(adj.left(leaf, k),
+			      adj.left(leaf, k) + adj.num_left(leaf, k), n);
+  }
+  bool is_right_neighbor(uint32_t leaf, uint32_t k, uint32_t n) const {
+    if (leaf >= adj.nleaves)
+      return false;
+    return std::binary_search(adj.right(leaf, k),
+			      adj.right(leaf, k) + adj.num_right(leaf, k), n);
+  }
+
+  // Bounds of leaf n as seen from leaf, i.e. shifted by the domain width
+  // when n is reached across a periodic face of leaf
+  void neighbor_bounds(uint32_t leaf, uint32_t n,
+		       double *le_out, double *re_out) const {
+    double shift;
+    for (uint32_t k = 0; k < ndim; k++) {
+      shift = 0.0;
+      if (periodic_left(leaf, k) && is_left_neighbor(leaf, k, n))
+	shift -= domain_width[k];
+      if (periodic_right(leaf, k) && is_right_neighbor(leaf, k, n))
+	shift += domain_width[k];
+      le_out[k] = leaves_le[ndim*n+k] + shift;
+      re_out[k] = leaves_re[ndim*n+k] + shift;
+    }
+  }
+
+  // Apply growth of the leaf bounds (see CParallelLeaf::grow_bounds)
+  void grow(const double *dle, const double *dre) {
+    for (uint64_t j = 0; j < leaves_le.size(); j++) {
+      leaves_le[j] += dle[j];
+      leaves_re[j] += dre[j];
+    }
+  }
+
+  // Add a leaf covering the part of parent at or above value in dimension
+  // d and shrink parent to the part below it. The new leaf lives on the
+  // rank of parent and starts with the initial neighbors of parent plus
+  // parent itself. Returns the id of the new leaf.
+  uint32_t split(uint32_t parent, uint32_t d, double value) {
+    uint32_t child = nleaves++;
+    std::vector<double> cle(leaves_le.begin() + ndim*parent,
+			    leaves_le.begin() + ndim*(parent+1));
+    std::vector<double> cre(leaves_re.begin() + ndim*parent,
+			    leaves_re.begin() + ndim*(parent+1));
+    cle[d] = value;
+    leaves_re[ndim*parent+d] = value;
+    leaves_le.insert(leaves_le.end(), cle.begin(), cle.end());
+    leaves_re.insert(leaves_re.end(), cre.begin(), cre.end());
+    leaf_rank.push_back(leaf_rank[parent]);
+    std::vector<uint32_t> row(neigh_ids.begin() + neigh_indptr[parent],
+			      neigh_ids.begin() + neigh_indptr[parent+1]);
+    row.push_back(parent);
+    neigh_ids.insert(neigh_ids.end(), row.begin(), row.end());
+    neigh_indptr.push_back(neigh_ids.size());
+    return child;
+  }
+};
+
+
 template <typename Info_>
 class CParallelLeaf
 {
@@ -384,21 +589,26 @@ public:
   int *periodic_le = NULL;
   int *periodic_re = NULL;
   double *domain_width = NULL;
+  const CDecompDescriptor *desc;
   std::set<uint32_t> *neigh;
-  double *leaves_le;
-  double *leaves_re;
   Delaunay *T = NULL;
   std::set<uint32_t> *all_neigh;
-  std::vector<std::set<uint32_t>> *lneigh;
-  std::vector<std::set<uint32_t>> *rneigh;
+  // Volumes only: leaves heard from during the current exchange, leaves
+  // named by them, leaves asked for points and those asked this round
+  // (request_only if points were already sent to them)
+  std::set<uint32_t> *heard;
+  std::set<uint32_t> *known;
+  std::set<uint32_t> *requested;
+  std::set<uint32_t> *asking;
+  std::set<uint32_t> *request_only;
   char OutputFile[MAXLEN_FILENAME];
 
-  void begin_init(uint32_t nleaves0, uint32_t ndim0, const char *ustr) {
-    uint32_t k;
+  void begin_init(const CDecompDescriptor *desc0, const char *ustr) {
     MPI_Comm_size ( MPI_COMM_WORLD, &size);
     MPI_Comm_rank ( MPI_COMM_WORLD, &rank);
-    nleaves = nleaves0;
-    ndim = ndim0;
+    desc = desc0;
+    nleaves = desc->nleaves;
+    ndim = desc->ndim;
     std::strcpy(unique_str, ustr);
     le = (double*)my_malloc(ndim*sizeof(double));
     re = (double*)my_malloc(ndim*sizeof(double));
@@ -406,95 +616,106 @@ public:
     periodic_re = (int*)my_malloc(ndim*sizeof(int));
     domain_width = (double*)my_malloc(ndim*sizeof(double));
     neigh = new std::set<uint32_t>();
-    leaves_le = (double*)my_malloc(nleaves*ndim*sizeof(double*));
-    leaves_re = (double*)my_malloc(nleaves*ndim*sizeof(double*));
     all_neigh = new std::set<uint32_t>();
-    lneigh = new std::vector<std::set<uint32_t>>();
-    rneigh = new std::vector<std::set<uint32_t>>();
+    heard = new std::set<uint32_t>();
+    known = new std::set<uint32_t>();
+    requested = new std::set<uint32_t>();
+    asking = new std::set<uint32_t>();
+    request_only = new std::set<uint32_t>();
+  }
+
+  // Bounds, periodic flags & initial neighbors of leaf id from the
+  // shared decomposition
+  void init_from_descriptor() {
+    uint32_t k;
+    memcpy(le, &(desc->leaves_le[ndim*id]), ndim*sizeof(double));
+    memcpy(re, &(desc->leaves_re[ndim*id]), ndim*sizeof(double));
+    memcpy(domain_width, &(desc->domain_width[0]), ndim*sizeof(double));
     for (k = 0; k < ndim; k++) {
-      lneigh->push_back(std::set<uint32_t>());
-      rneigh->push_back(std::set<uint32_t>());
+      periodic_le[k] = (int)(desc->periodic_left(id, k));
+      periodic_re[k] = (int)(desc->periodic_right(id, k));
     }
-  }    
+    neigh->insert(desc->neigh_ids.begin() + desc->neigh_indptr[id],
+		  desc->neigh_ids.begin() + desc->neigh_indptr[id+1]);
+  }
 
   void end_init() {
     sprintf(OutputFile, "%s_leafoutput%u.dat", unique_str, id);
     in_memory = true;
   }
 
-  CParallelLeaf(uint32_t nleaves0, uint32_t ndim0, const char *ustr, int src) {
+  CParallelLeaf(const CDecompDescriptor *desc0, const char *ustr, int src) {
     from_node = false;
-    begin_init(nleaves0, ndim0, ustr);
+    begin_init(desc0, ustr);
     // Receive leaf info from root process
     recv(src);
+    init_from_descriptor();
     if (DEBUG > 1)
       printf("%d: Initialized from transfer on %d\n", id, rank);
     end_init();
   };
 
-  CParallelLeaf(uint32_t nleaves0, uint32_t ndim0, const char *ustr,
-		KDTree* tree, int index) {
+  // Leaf index owning positions [start, start + count) of a decomposition
+  // that sorts the points by leaf through all_idx. If sorted_pts is given it
+  // already holds all of the points in that order.
+  CParallelLeaf(const CDecompDescriptor *desc0, const char *ustr, int index,
+		uint64_t start, uint64_t count, const double *all_pts,
+		const uint64_t *all_idx, const double *sorted_pts = NULL) {
     from_node = true;
-    begin_init(nleaves0, ndim0, ustr);
-    // Transfer leaf information
-    Node* node = tree->leaves[index];
+    begin_init(desc0, ustr);
     uint64_t j;
     uint32_t k;
-    std::set<uint32_t>::iterator it;
-    id = node->leafid;
-    npts = node->children;
+    id = (uint32_t)index;
+    npts = count;
     idx = (Info*)my_malloc(npts*sizeof(Info));
     pts = (double*)my_malloc(ndim*npts*sizeof(double));
-    memcpy(le, node->left_edge, ndim*sizeof(double));
-    memcpy(re, node->right_edge, ndim*sizeof(double));
-    memcpy(domain_width, tree->domain_width, ndim*sizeof(double));
-    for (j = 0; j < npts; j++) {
-      idx[j] = (Info)(tree->left_idx + node->left_idx + j);
-      for (k = 0; k < ndim; k++) {
-    	pts[ndim*j+k] = tree->all_pts[ndim*tree->all_idx[node->left_idx+j]+k];
-      }
-    }
-    memcpy(leaves_le, tree->leaves_le, nleaves*ndim*sizeof(double));
-    memcpy(leaves_re, tree->leaves_re, nleaves*ndim*sizeof(double));
-    neigh->insert(node->all_neighbors.begin(), node->all_neighbors.end());
-    for (k = 0; k < ndim; k++) {
-      periodic_le[k] = node->periodic_left[k];
-      periodic_re[k] = node->periodic_right[k];
-    }
-    for (k = 0; k < ndim; k++) {
-      (*lneigh)[k].insert(node->left_neighbors[k].begin(),
-    			  node->left_neighbors[k].end());
-      (*rneigh)[k].insert(node->right_neighbors[k].begin(),
-    			  node->right_neighbors[k].end());
-    }
-    // Shift edges of periodic neighbors
-    for (k = 0; k < ndim; k++) {
-      if (periodic_le[k]) {
-	for (it = (*lneigh)[k].begin(); it != (*lneigh)[k].end(); it++) {
-    	  leaves_le[*it, k] -= domain_width[k];
-    	  leaves_re[*it, k] -= domain_width[k];
-    	}
-      }
-      if (periodic_re[k]) {
-	for (it = (*rneigh)[k].begin(); it != (*rneigh)[k].end(); it++) {
-    	     
-    	  leaves_le[*it, k] += domain_width[k];
-    	  leaves_re[*it, k] += domain_width[k];
-    	}
+    for (j = 0; j < npts; j++)
+      idx[j] = (Info)(start + j);
+    if (sorted_pts != NULL) {
+      // Points are already in leaf order
+      memcpy(pts, sorted_pts + ndim*start, ndim*npts*sizeof(double));
+    } else {
+      for (j = 0; j < npts; j++) {
+	for (k = 0; k < ndim; k++) {
+	  pts[ndim*j+k] = all_pts[ndim*all_idx[start+j]+k];
+	}
       }
     }
+    init_from_descriptor();
     if (DEBUG > 1)
       printf("%d: Initialized directly on %d\n", id, rank);
     end_init();
   }
 
+  // Leaf index holding a copy of count points, the first count_own of
+  // which it owns. Used for leaves split off after the decomposition, whose
+  // bounds must already be in the descriptor.
+  CParallelLeaf(const CDecompDescriptor *desc0, const char *ustr, int index,
+		uint64_t count, uint64_t count_own, const double *pts0,
+		const Info *idx0) {
+    from_node = true;
+    begin_init(desc0, ustr);
+    id = (uint32_t)index;
+    npts = count;
+    npts_orig = count_own;
+    idx = (Info*)my_malloc(npts*sizeof(Info));
+    pts = (double*)my_malloc(ndim*npts*sizeof(double));
+    memcpy(idx, idx0, npts*sizeof(Info));
+    memcpy(pts, pts0, ndim*npts*sizeof(double));
+    init_from_descriptor();
+    if (DEBUG > 1)
+      printf("%d: Initialized by split on %d\n", id, rank);
+    end_init();
+  }
+
   ~CParallelLeaf() {
     delete(neigh);
-    free(leaves_le);
-    free(leaves_re);
     delete(all_neigh);
-    delete(lneigh);
-    delete(rneigh);
+    delete(heard);
+    delete(known);
+    delete(requested);
+    delete(asking);
+    delete(request_only);
     delete(T);
     if (pts != NULL)
       free(pts);
@@ -545,9 +766,10 @@ public:
     return T->num_cells();
   }
 
+  // Only the points travel with a leaf; its bounds and neighbors come from
+  // the shared decomposition on the receiving rank
   void send(int dst) {
-    int i = 0, j;
-    uint32_t k = 0;
+    int i = 0;
     MPI_Send(&id, 1, MPI_UNSIGNED, dst, i++, MPI_COMM_WORLD);
     MPI_Send(&npts, 1, MPI_UNSIGNED_LONG, dst, i++, MPI_COMM_WORLD);
     if (sizeof(Info) == sizeof(uint32_t))
@@ -555,55 +777,12 @@ public:
     else
       MPI_Send(idx, npts, MPI_UNSIGNED_LONG, dst, i++, MPI_COMM_WORLD);
     MPI_Send(pts, ndim*npts, MPI_DOUBLE, dst, i++, MPI_COMM_WORLD);
-    MPI_Send(le, ndim, MPI_DOUBLE, dst, i++, MPI_COMM_WORLD);
-    MPI_Send(re, ndim, MPI_DOUBLE, dst, i++, MPI_COMM_WORLD);
-    MPI_Send(periodic_le, ndim, MPI_INT, dst, i++, MPI_COMM_WORLD);
-    MPI_Send(periodic_re, ndim, MPI_INT, dst, i++, MPI_COMM_WORLD);
-    MPI_Send(domain_width, ndim, MPI_DOUBLE, dst, i++, MPI_COMM_WORLD);
-    MPI_Send(leaves_le, nleaves*ndim, MPI_DOUBLE, dst, i++, MPI_COMM_WORLD);
-    MPI_Send(leaves_re, nleaves*ndim, MPI_DOUBLE, dst, i++, MPI_COMM_WORLD);
-    uint32_t *dummy = (uint32_t*)my_malloc(nleaves*sizeof(uint32_t));
-    int ndum;
-    // neighbors
-    ndum = (int)(neigh->size());
-    j = 0;
-    for (std::set<uint32_t>::iterator it = neigh->begin();
-	 it != neigh->end(); it++) {
-      dummy[j] = *it;
-      j++;
-    }
-    MPI_Send(&ndum, 1, MPI_INT, dst, i++, MPI_COMM_WORLD);
-    MPI_Send(dummy, ndum, MPI_UNSIGNED, dst, i++, MPI_COMM_WORLD);
-    for (k = 0; k < ndim; k++) {
-      // left neighbors
-      ndum = (int)((*lneigh)[k].size());
-      j = 0;
-      for (std::set<uint32_t>::iterator it = (*lneigh)[k].begin();
-    	   it != (*lneigh)[k].end(); it++) {
-    	dummy[j] = *it;
-    	j++;
-      }
-      MPI_Send(&ndum, 1, MPI_INT, dst, i++, MPI_COMM_WORLD);
-      MPI_Send(dummy, ndum, MPI_UNSIGNED, dst, i++, MPI_COMM_WORLD);
-      // right neighbors
-      ndum = (int)((*rneigh)[k].size());
-      j = 0;
-      for (std::set<uint32_t>::iterator it = (*rneigh)[k].begin();
-    	   it != (*rneigh)[k].end(); it++) {
-    	dummy[j] = *it;
-    	j++;
-      }
-      MPI_Send(&ndum, 1, MPI_INT, dst, i++, MPI_COMM_WORLD);
-      MPI_Send(dummy, ndum, MPI_UNSIGNED, dst, i++, MPI_COMM_WORLD);
-    }
-    free(dummy);
     if (DEBUG > 1)
       printf("%d: Sent to %d from %d\n", id, dst, rank);
   };
 
   void recv(int src) {
-    int i = 0, j;
-    uint32_t k = 0;
+    int i = 0;
     MPI_Recv(&id, 1, MPI_UNSIGNED, src, i++, MPI_COMM_WORLD,
     	     MPI_STATUS_IGNORE);
     MPI_Recv(&npts, 1, MPI_UNSIGNED_LONG, src, i++, MPI_COMM_WORLD,
@@ -618,54 +797,18 @@ public:
 	       MPI_STATUS_IGNORE);
     MPI_Recv(pts, ndim*npts, MPI_DOUBLE, src, i++, MPI_COMM_WORLD,
     	     MPI_STATUS_IGNORE);
-    MPI_Recv(le, ndim, MPI_DOUBLE, src, i++, MPI_COMM_WORLD,
-    	     MPI_STATUS_IGNORE);
-    MPI_Recv(re, ndim, MPI_DOUBLE, src, i++, MPI_COMM_WORLD,
-    	     MPI_STATUS_IGNORE);
-    MPI_Recv(periodic_le, ndim, MPI_INT, src, i++, MPI_COMM_WORLD,
-    	     MPI_STATUS_IGNORE);
-    MPI_Recv(periodic_re, ndim, MPI_INT, src, i++, MPI_COMM_WORLD,
-    	     MPI_STATUS_IGNORE);
-    MPI_Recv(domain_width, ndim, MPI_DOUBLE, src, i++, MPI_COMM_WORLD,
-    	     MPI_STATUS_IGNORE);
-    MPI_Recv(leaves_le, nleaves*ndim, MPI_DOUBLE, src, i++, MPI_COMM_WORLD,
-    	     MPI_STATUS_IGNORE);
-    MPI_Recv(leaves_re, nleaves*ndim, MPI_DOUBLE, src, i++, MPI_COMM_WORLD,
-    	     MPI_STATUS_IGNORE);
-    uint32_t *dummy = (uint32_t*)my_malloc(nleaves*sizeof(uint32_t));
-    int ndum;
-    MPI_Recv(&ndum, 1, MPI_INT, src, i++, MPI_COMM_WORLD,
-	     MPI_STATUS_IGNORE);
-    MPI_Recv(dummy, ndum, MPI_UNSIGNED, src, i++, MPI_COMM_WORLD,
-	     MPI_STATUS_IGNORE);
-    for (j = 0; j < ndum; j++) {
-      neigh->insert(dummy[j]);
-    }
-    // neighbors
-    for (k = 0; k < ndim; k++) {
-      // left neighbors
-      MPI_Recv(&ndum, 1, MPI_INT, src, i++, MPI_COMM_WORLD,
-    	       MPI_STATUS_IGNORE);
-      MPI_Recv(dummy, ndum, MPI_UNSIGNED, src, i++, MPI_COMM_WORLD,
-    	       MPI_STATUS_IGNORE);
-      for (j = 0; j < ndum; j++) {
-    	(*lneigh)[k].insert(dummy[j]);
-      }
-      // right neighbors
-      MPI_Recv(&ndum, 1, MPI_INT, src, i++, MPI_COMM_WORLD,
-    	       MPI_STATUS_IGNORE);
-      MPI_Recv(dummy, ndum, MPI_UNSIGNED, src, i++, MPI_COMM_WORLD,
-    	       MPI_STATUS_IGNORE);
-      for (j = 0; j < ndum; j++) {
-    	(*rneigh)[k].insert(dummy[j]);
-      }
-    }
-    free(dummy);
     if (DEBUG > 1)
       printf("%d: Received from %d on %d\n", id, src, rank);
   }
 
   void init_triangulation() {
+    npts_orig = npts;
+    build_triangulation();
+  }
+
+  // (Re)build the triangulation from every point held, keeping npts_orig
+  void build_triangulation() {
+    delete(T);
     T = new Delaunay(ndim, false);
     // Insert points using monotonic indices
     Info *idx_dum = (Info*)my_malloc(npts*sizeof(Info));
@@ -673,7 +816,6 @@ public:
       idx_dum[i] = i;
     T->insert(pts, idx_dum, npts);
     free(idx_dum);
-    npts_orig = npts;
     ncells = (uint64_t)(T->num_cells());
     if (DEBUG > 1)
       printf("%d: Triangulation of %lu points initialized on %d\n", id, npts, rank);
@@ -700,6 +842,182 @@ public:
     if (DEBUG > 1)
       printf("%d: %lu points inserted on %d\n", id, npts_new, rank);
   }
+
+  // Add points owned by this leaf, e.g. from a later insert. Owned points
+  // are the first npts_orig, so once the leaf holds points from its
+  // neighbors the new ones are moved ahead of those and the triangulation
+  // is rebuilt.
+  void insert_owned(double *pts_new, Info *idx_new, uint64_t npts_new) {
+    if (npts_new == 0)
+      return;
+    if (npts == npts_orig) {
+      insert(pts_new, idx_new, npts_new);
+      npts_orig = npts;
+      return;
+    }
+    uint64_t nrecv = npts - npts_orig;
+    idx = (Info*)my_realloc(idx, (npts+npts_new)*sizeof(Info),
+			    "idx in insert_owned");
+    pts = (double*)my_realloc(pts, ndim*(npts+npts_new)*sizeof(double),
+			      "pts in insert_owned");
+    memmove(idx+npts_orig+npts_new, idx+npts_orig, nrecv*sizeof(Info));
+    memmove(pts+ndim*(npts_orig+npts_new), pts+ndim*npts_orig,
+	    ndim*nrecv*sizeof(double));
+    memcpy(idx+npts_orig, idx_new, npts_new*sizeof(Info));
+    memcpy(pts+ndim*npts_orig, pts_new, ndim*npts_new*sizeof(double));
+    npts += npts_new;
+    npts_orig += npts_new;
+    build_triangulation();
+  }
+
+  // Dimension & value splitting the owned points in two, i.e. the median
+  // along the dimension in which they are widest. False if either half
+  // would have too few points to triangulate or the leaf has a periodic
+  // face, whose copies across the boundary rely on the face lists.
+  bool split_value(uint32_t &d, double &value) const {
+    if ((npts_orig < 2*(ndim+1)) || desc->periodic_face(id))
+      return false;
+    uint64_t j, nlow = 0;
+    uint32_t k;
+    double width = -1.0;
+    for (k = 0; k < ndim; k++) {
+      double xmin = pts[k], xmax = pts[k];
+      for (j = 1; j < npts_orig; j++) {
+	xmin = std::min(xmin, pts[ndim*j+k]);
+	xmax = std::max(xmax, pts[ndim*j+k]);
+      }
+      if ((xmax - xmin) > width) {
+	width = xmax - xmin;
+	d = k;
+      }
+    }
+    std::vector<double> x(npts_orig);
+    for (j = 0; j < npts_orig; j++)
+      x[j] = pts[ndim*j+d];
+    std::nth_element(x.begin(), x.begin() + npts_orig/2, x.end());
+    value = x[npts_orig/2];
+    for (j = 0; j < npts_orig; j++) {
+      if (pts[ndim*j+d] < value)
+	nlow++;
+    }
+    return ((nlow >= (ndim+1)) && ((npts_orig - nlow) >= (ndim+1)));
+  }
+
+  // Hand the owned points at or above value in dimension d to a new leaf
+  // child_id, whose bounds the descriptor must already hold. Both leaves
+  // keep every point this leaf held, so their halos are already complete
+  // and only ownership changes; each rebuilds its triangulation with its
+  // own points first.
+  CParallelLeaf<Info>* split(uint32_t child_id, uint32_t d, double value) {
+    uint64_t j, nlow = 0;
+    std::vector<uint64_t> order(npts);
+    for (j = 0; j < npts_orig; j++) {
+      if (pts[ndim*j+d] < value)
+	order[nlow++] = j;
+    }
+    uint64_t nhigh = nlow;
+    for (j = 0; j < npts_orig; j++) {
+      if (pts[ndim*j+d] >= value)
+	order[nhigh++] = j;
+    }
+    for (j = npts_orig; j < npts; j++)
+      order[j] = j;
+    // Child order puts the upper half first
+    std::vector<Info> cidx(npts);
+    std::vector<double> cpts(ndim*npts);
+    for (j = 0; j < npts; j++) {
+      uint64_t src = order[j];
+      if (j < npts_orig)
+	src = order[(j + nlow) % npts_orig];
+      cidx[j] = idx[src];
+      memcpy(&cpts[ndim*j], pts + ndim*src, ndim*sizeof(double));
+    }
+    CParallelLeaf<Info> *child = new CParallelLeaf<Info>(
+        desc, unique_str, (int)child_id, npts, npts_orig - nlow,
+	&cpts[0], &cidx[0]);
+    // Parent order puts the lower half first
+    for (j = 0; j < npts; j++) {
+      cidx[j] = idx[order[j]];
+      memcpy(&cpts[ndim*j], pts + ndim*order[j], ndim*sizeof(double));
+    }
+    memcpy(idx, &cidx[0], npts*sizeof(Info));
+    memcpy(pts, &cpts[0], ndim*npts*sizeof(double));
+    npts_orig = nlow;
+    memcpy(le, &(desc->leaves_le[ndim*id]), ndim*sizeof(double));
+    memcpy(re, &(desc->leaves_re[ndim*id]), ndim*sizeof(double));
+    build_triangulation();
+    child->build_triangulation();
+    // The child knows every leaf the parent knows
+    child->neigh->insert(all_neigh->begin(), all_neigh->end());
+    child->neigh->insert(neigh->begin(), neigh->end());
+    child->neigh->erase(child_id);
+    neigh->insert(child_id);
+    if (DEBUG > 1)
+      printf("%d: Split into %u on %d\n", id, child_id, rank);
+    return child;
+  }
+
+  // Leaf n is a current or past neighbor
+  bool knows(uint32_t n) const {
+    return (neigh->count(n) > 0) || (all_neigh->count(n) > 0);
+  }
+
+  // Send to every known neighbor again in the next exchange, e.g. after
+  // owned points were added or moved to another leaf
+  void resend_neighbors() {
+    neigh->insert(all_neigh->begin(), all_neigh->end());
+  }
+
+  // Forget which leaves were heard from or asked before a new exchange
+  void begin_exchange() {
+    heard->clear();
+    requested->clear();
+  }
+
+  // Volumes only: ask the known leaves that have not sent anything yet and
+  // whose boxes a point could still come from that changes the dual cell of
+  // an original point. Returns true if there are none, i.e. the dual cells
+  // of the original points are final.
+  bool update_requests() {
+    uint32_t i, n;
+    std::set<uint32_t> cand_set;
+    std::set<uint32_t>::iterator sit;
+    cand_set.insert(known->begin(), known->end());
+    cand_set.insert(all_neigh->begin(), all_neigh->end());
+    cand_set.insert(neigh->begin(), neigh->end());
+    std::vector<uint32_t> cand;
+    for (sit = cand_set.begin(); sit != cand_set.end(); sit++) {
+      if ((*sit != id) && (heard->count(*sit) == 0))
+	cand.push_back(*sit);
+    }
+    if (cand.size() == 0)
+      return true;
+    double *cand_le = (double*)my_malloc(cand.size()*ndim*sizeof(double));
+    double *cand_re = (double*)my_malloc(cand.size()*ndim*sizeof(double));
+    for (i = 0; i < cand.size(); i++)
+      desc->neighbor_bounds(id, cand[i], cand_le+ndim*i, cand_re+ndim*i);
+    std::vector<bool> reach = T->conflicting_boxes(cand.size(), cand_le,
+						   cand_re, (Info)npts_orig);
+    free(cand_le);
+    free(cand_re);
+    bool done = true;
+    for (i = 0; i < cand.size(); i++) {
+      if (!reach[i])
+	continue;
+      done = false;
+      n = cand[i];
+      if (requested->count(n) > 0)
+	continue;
+      requested->insert(n);
+      asking->insert(n);
+      if (neigh->count(n) == 0) {
+	if (all_neigh->count(n) > 0)
+	  request_only->insert(n);
+	neigh->insert(n);
+      }
+    }
+    return done;
+  }
   
   template <typename I>
   I serialize(I &n, I &m,
@@ -734,7 +1052,8 @@ public:
 		       std::vector<std::vector<uint32_t>> &nct_out,
 		       std::vector<Info*> &idx_out,
 		       std::vector<double*> &pts_out,
-		       std::vector<uint32_t*> &ngh_out) {
+		       std::vector<uint32_t*> &ngh_out,
+		       bool volumes_only = false) {
     int i, j;
     uint32_t k, n, dst, src=id;
     int task;
@@ -748,19 +1067,34 @@ public:
     double *neigh_re = (double*)my_malloc(neigh->size()*ndim*sizeof(double*));
     for (sit = neigh->begin(), i = 0; sit != neigh->end(); sit++, i++) {
       n = *sit;
-      memcpy(neigh_le+ndim*i, leaves_le+ndim*n, ndim*sizeof(double));
-      memcpy(neigh_re+ndim*i, leaves_re+ndim*n, ndim*sizeof(double));
+      desc->neighbor_bounds(id, n, neigh_le+ndim*i, neigh_re+ndim*i);
     }
-    // Get outgoing to other leaves
-    out_leaves = T->outgoing_points(neigh->size(), neigh_le, neigh_re);
+    // Get outgoing to other leaves. Only original points are ever sent, so
+    // for volumes only the cells incident to them need to be tested.
+    if (volumes_only)
+      out_leaves = T->outgoing_points(neigh->size(), neigh_le, neigh_re,
+				      (Info)npts_orig);
+    else
+      out_leaves = T->outgoing_points(neigh->size(), neigh_le, neigh_re);
+    free(neigh_le);
+    free(neigh_re);
     // Sort leaves to their host task
     uint32_t ntot = 0;
     uint32_t nold, nnew, nold_neigh, nnew_neigh;
+    std::vector<uint32_t> ngh_list;
+    for (sit = neigh->begin(); sit != neigh->end(); sit++) {
+      // With volumes only, a leaf lists itself to ask the destination for
+      // points (see update_requests)
+      if ((!volumes_only) || (*sit != id))
+	ngh_list.push_back(*sit);
+    }
     for (sit = neigh->begin(), i = 0; sit != neigh->end(); sit++, i++) {
       dst = *sit;
-      task = dst % size;
+      task = desc->leaf_rank[dst];
       src_out[task].push_back(src);
       dst_out[task].push_back(dst);
+      if (request_only->count(dst) > 0)
+	out_leaves[i].clear();
       for (it = out_leaves[i].begin(); it != out_leaves[i].end(); ) {
 	if (*it < npts_orig)
 	  it++;
@@ -772,8 +1106,10 @@ public:
       for (it32 = cnt_out[task].begin();
 	   it32 != cnt_out[task].end(); it32++)
 	nold += *it32;
-      if (nnew > 0)
-	nnew_neigh = neigh->size();
+      if (volumes_only && (asking->count(dst) > 0))
+	nnew_neigh = ngh_list.size() + 1;
+      else if (nnew > 0)
+	nnew_neigh = ngh_list.size();
       else
 	nnew_neigh = 0;
       nold_neigh = 0;
@@ -791,6 +1127,8 @@ public:
 	pts_out[task] = (double*)my_realloc(pts_out[task],
 					    ndim*(nold+nnew)*sizeof(double),
 					    "pts in leaf outgoing points");
+      }
+      if (nnew_neigh > 0) {
 	ngh_out[task] = (uint32_t*)my_realloc(ngh_out[task],
 					      (nold_neigh+nnew_neigh)*sizeof(uint32_t),
 					      "ngh in leaf outgoing points");
@@ -805,26 +1143,60 @@ public:
       }
       ntot += nnew;
       if (nnew_neigh > 0) {
-	std::set<uint32_t>::iterator sit2;
-	for (sit2 = neigh->begin(), k = 0; sit2 != neigh->end(); sit2++, k++)
-	  ngh_out[task][nold_neigh+k] = *sit2;
+	for (it32 = ngh_list.begin(), k = 0; it32 != ngh_list.end(); it32++, k++)
+	  ngh_out[task][nold_neigh+k] = *it32;
+	if (k < nnew_neigh)
+	  ngh_out[task][nold_neigh+k] = id;
       }
     }
     // Transfer neighbors to log & reset count to 0
     all_neigh->insert(neigh->begin(), neigh->end());
     neigh->clear();
+    asking->clear();
+    request_only->clear();
     if (DEBUG > 1)
       printf("%d: %lu outgoing points on %d\n", id, (uint64_t)ntot, rank);
   }
 
+  // Apply growth of the leaf bounds (dle <= 0, dre >= 0 for each leaf and
+  // dimension) after points outside the original domain were added. The
+  // shared descriptor must already hold the grown bounds. Leaves that now
+  // touch this one become new neighbors so the next exchange reaches them.
+  void grow_bounds(const double *dle, const double *dre) {
+    uint32_t i, k;
+    bool grown_self = false;
+    std::vector<double> nle(ndim), nre(ndim);
+    for (k = 0; k < ndim; k++) {
+      le[k] += dle[ndim*id+k];
+      re[k] += dre[ndim*id+k];
+      if ((dle[ndim*id+k] != 0) || (dre[ndim*id+k] != 0))
+	grown_self = true;
+    }
+    for (i = 0; i < desc->nleaves; i++) {
+      bool grown = grown_self;
+      for (k = 0; k < ndim; k++) {
+	if ((dle[ndim*i+k] != 0) || (dre[ndim*i+k] != 0))
+	  grown = true;
+      }
+      if ((!grown) || (i == id) || (all_neigh->count(i) > 0) ||
+	  (neigh->count(i) > 0))
+	continue;
+      desc->neighbor_bounds(id, i, &nle[0], &nre[0]);
+      if (boxes_touch(ndim, le, re, &nle[0], &nre[0]))
+	neigh->insert(i);
+    }
+  }
+
   void incoming_points(uint32_t src, uint32_t npts_recv,
 		       uint32_t nneigh_recv, Info *idx_recv,
-		       double *pts_recv, uint32_t *neigh_recv) {
-    if (npts_recv == 0)
-      return;
+		       double *pts_recv, uint32_t *neigh_recv,
+		       bool volumes_only = false) {
     uint64_t j;
     uint32_t k;
-    if (src == id) {
+    heard->insert(src);
+    if (npts_recv == 0) {
+      // Nothing to insert
+    } else if (src == id) {
       for (k = 0; k < ndim; k++) {
 	if (periodic_le[k] and periodic_re[k]) {
 	  for (j = 0; j < npts_recv; j++) {
@@ -839,14 +1211,14 @@ public:
       }
     } else {
       for (k = 0; k < ndim; k++) {
-	if (periodic_re[k] and ((*rneigh)[k].count(src) > 0)) {
+	if (periodic_re[k] and desc->is_right_neighbor(id, k, src)) {
 	  for (j = 0; j < npts_recv; j++) {
 	    if ((pts_recv[ndim*j+k] + domain_width[k] - re[k]) <
 		(le[k] - pts_recv[ndim*j+k]))
 	      pts_recv[ndim*j+k] += domain_width[k];
 	  }
 	}
-	if (periodic_le[k] and ((*lneigh)[k].count(src) > 0)) {
+	if (periodic_le[k] and desc->is_left_neighbor(id, k, src)) {
 	  for (j = 0; j < npts_recv; j++) {
 	    if ((le[k] - pts_recv[ndim*j+k] + domain_width[k]) <
 		(pts_recv[ndim*j+k] - re[k]))
@@ -856,12 +1228,24 @@ public:
       }
     }
     // Add points to tessellation, then arrays
-    insert(pts_recv, idx_recv, npts_recv);
-    // Add neighbors
+    if (npts_recv > 0)
+      insert(pts_recv, idx_recv, npts_recv);
+    // Add neighbors. With volumes only, the sender listing itself is a
+    // request for points & other leaves are only candidates to ask.
     uint32_t n;
     for (k = 0; k < nneigh_recv; k++) {
       n = neigh_recv[k];
-      if ((n != id) and (all_neigh->count(n) == 0) and (neigh->count(n) == 0)) {
+      if (volumes_only and (n != src)) {
+	if (n != id)
+	  known->insert(n);
+      } else if (volumes_only) {
+	// Answer even if points were already sent so the sender hears back
+	if ((src != id) and (neigh->count(src) == 0)) {
+	  if (all_neigh->count(src) > 0)
+	    request_only->insert(src);
+	  neigh->insert(src);
+	}
+      } else if ((n != id) and (all_neigh->count(n) == 0) and (neigh->count(n) == 0)) {
 	neigh->insert(n);
       }
     }
@@ -870,7 +1254,8 @@ public:
   }
 
   uint64_t voronoi_volumes(double **vols) {
-    (*vols) = (double*)my_realloc(*vols, T->num_finite_verts()*sizeof(double),
+    // Sized by npts as duplicate halo points leave gaps in the infos
+    (*vols) = (double*)my_realloc(*vols, npts*sizeof(double),
 				  "leaf voronoi volums");
     T->dual_volumes(*vols);
     return npts;
@@ -902,7 +1287,33 @@ public:
   Info *info_total = NULL;
   KDTree *tree = NULL;
   ParallelKDTree *ptree = NULL;
+  int dd_method = DD_KDTREE;
+  int dd_nleaves_per_proc = 1;
+  CurveDecomposition *curve = NULL;
+  bool leaf_order = true;
+  double *pts_sorted = NULL;
+  std::vector<uint64_t> leaf_start;
+  // Locator for the leaf bounds in decomp and the leaves without initial
+  // points, which are not given points outside every leaf (root only)
+  LeafLocator locator;
+  std::vector<bool> leaf_empty;
+  // Leaves split after the decomposition, which no longer own their slice
+  // of the sorted index array (root only)
+  std::vector<bool> leaf_split;
+  // Leaves owning more points than this after a later insert are split
+  double leaf_split_factor = 2.0;
+  uint64_t leaf_npts_limit = 0;
   // Things for each process
+  CDecompDescriptor decomp;
+  // Rank-level graph used for the point exchange
+  MPI_Comm graph_comm = MPI_COMM_NULL;
+  std::set<int> graph_dst_set;
+  std::vector<int> graph_src;
+  std::vector<int> graph_dst;
+  bool compress_exchange = false;
+  bool volumes_only = false;
+  // Bytes of exchanged points and indices sent by this rank
+  uint64_t exchange_bytes = 0;
   int nleaves;
   std::vector<CParallelLeaf<Info>*> leaves;
   std::map<int,uint32_t> map_id2idx;
@@ -937,16 +1348,154 @@ public:
     if (info_total != NULL)
       free(info_total);
     for (i = 0; i < nleaves; i++) {
-      delete(leaves.pop()); // leaves used
+      delete(leaves[i]); // leaves used
     }
     if (tree != NULL)
       delete(tree);
     if (ptree != NULL)
       delete(ptree);
+    if (curve != NULL)
+      delete(curve);
+    if (pts_sorted != NULL)
+      free(pts_sorted);
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+    if ((graph_comm != MPI_COMM_NULL) && (!finalized))
+      MPI_Comm_free(&graph_comm);
     if (DEBUG)
       printf("%d: Finishing dealloc\n", rank);
   }
 
+  // Select the domain decomposition used by the next insert into an empty
+  // triangulation. Curve decompositions use exactly
+  // size*nleaves_per_proc leaves.
+  void set_decomposition(int method, int nleaves_per_proc = 1) {
+    dd_method = method;
+    dd_nleaves_per_proc = std::max(nleaves_per_proc, 1);
+  }
+
+  // If true, the root copies the points into leaf order once after the
+  // domain decomposition so that each leaf is built from (and sent as) one
+  // contiguous slice rather than gathered point by point.
+  void set_leaf_order(bool leaf_order0) {
+    leaf_order = leaf_order0;
+  }
+
+  // If true, exchanged points are sent through the lossless exchange codec
+  // (encode_exchange) instead of as raw indices and doubles.
+  void set_compress_exchange(bool compress) {
+    compress_exchange = compress;
+  }
+
+  // If true, the exchange only resolves the dual cells of the original
+  // points of each leaf, which is all that consolidate_vols needs. Leaves
+  // then ask for points instead of being sent them by every neighbor and
+  // the exchange ends once no leaf has anything left to ask for.
+  void set_volumes_only(bool volumes_only0) {
+    volumes_only = volumes_only0;
+  }
+
+  // Leaves owning more than factor times the points of the largest initial
+  // leaf after a later insert are split in two on their rank (see
+  // split_leaves). Takes effect at the next decomposition, 0 disables it.
+  void set_leaf_split_factor(double factor) {
+    leaf_split_factor = factor;
+  }
+
+  // Start of leaf i in the sorted index array (root only)
+  uint64_t leaf_left_idx(int i) {
+    return leaf_start[i];
+  }
+
+  // Number of points originally on leaf i (root only)
+  uint64_t leaf_npts(int i) {
+    return leaf_start[i+1] - leaf_start[i];
+  }
+
+  // Positions [start, stop) of the sorted index array that only leaf i
+  // owns, empty for leaves that were split or added by a split (root only)
+  void leaf_owned_range(int i, uint64_t &start, uint64_t &stop) {
+    start = stop = 0;
+    if (leaf_split[i])
+      return;
+    start = leaf_left_idx(i);
+    stop = start + leaf_npts(i);
+  }
+
+  // Number of points owned by each leaf, by leaf id (result on root only)
+  void leaf_sizes(uint64_t *out) {
+    std::vector<uint64_t> local(nleaves_total, 0);
+    for (int i = 0; i < nleaves; i++)
+      local[leaves[i]->id] = leaves[i]->npts_orig;
+    MPI_Reduce(&local[0], out, nleaves_total, MPI_UNSIGNED_LONG, MPI_SUM, 0,
+	       MPI_COMM_WORLD);
+  }
+
+  // Indices of the points sorted by leaf (root only)
+  const uint64_t* sorted_idx_array() {
+    if (curve != NULL)
+      return curve->all_idx;
+    if (tree != NULL)
+      return tree->all_idx;
+    return idx_total;
+  }
+
+  // Original index of the point at position j in the sorted order (root only)
+  uint64_t sorted_idx(uint64_t j) {
+    return sorted_idx_array()[j];
+  }
+
+  // True if any point lies outside the domain in a periodic dimension
+  bool outside_periodic(uint64_t n, const double *pts) const {
+    uint64_t j;
+    uint32_t k;
+    for (k = 0; k < ndim; k++) {
+      if (!periodic[k])
+	continue;
+      for (j = 0; j < n; j++) {
+	if ((pts[ndim*j+k] < le[k]) || (pts[ndim*j+k] >= re[k]))
+	  return true;
+      }
+    }
+    return false;
+  }
+
+  // Wrap points back into the domain across periodic boundaries
+  void wrap_periodic(uint64_t n, double *pts) const {
+    uint64_t j;
+    uint32_t k;
+    double x;
+    for (k = 0; k < ndim; k++) {
+      if (!periodic[k])
+	continue;
+      for (j = 0; j < n; j++) {
+	x = pts[ndim*j+k];
+	if ((x >= le[k]) && (x < re[k]))
+	  continue;
+	x = le[k] + fmod(x - le[k], re[k] - le[k]);
+	if (x < le[k])
+	  x += re[k] - le[k];
+	if (x >= re[k])  // rounding of tiny negative offsets
+	  x = le[k];
+	pts[ndim*j+k] = x;
+      }
+    }
+  }
+
+  // Index the current leaf bounds for point location (root only)
+  void build_locator() {
+    locator = LeafLocator((uint64_t)nleaves_total, ndim,
+			  decomp.leaves_le.data(), decomp.leaves_re.data());
+    leaf_empty.assign(nleaves_total, false);
+    for (int i = 0; i < nleaves_total; i++)
+      leaf_empty[i] = ((!leaf_split[i]) && (leaf_npts(i) == 0));
+  }
+
+  // Non-empty leaf whose bounds are closest to a point (root only)
+  int64_t nearest_leaf(const double *pt) const {
+    return locator.nearest(pt, &leaf_empty);
+  }
+
   void insert(uint64_t npts0, double *pts0) {
     if (DEBUG)
       printf("%d: Beginning insert\n", rank);
@@ -968,46 +1517,78 @@ public:
     } else {
       Info *iidx = NULL;
       double *ipts = NULL;
+      double *pts_wrap = NULL;
+      int ngrown = 0;
+      std::vector<double> grow_le(nleaves_total*ndim, 0.0);
+      std::vector<double> grow_re(nleaves_total*ndim, 0.0);
       // Assign points to leaves based on initial domain decomp
       if (rank == 0) {
-	// Assign each point to an existing leaf
-      	std::vector<std::vector<uint64_t>> dist;
-      	for (i = 0; i < nleaves_total; i++) {
-      	  dist.push_back(std::vector<uint64_t>());
-      	  dist[i].reserve(npts0/nleaves_total+1);
-      	}
-	int cnt = 0;
-      	for (j = 0; j < npts0; j++) {
-	  Node *res = tree->search(pts0+ndim*j);
-	  if (res != NULL)
-	    dist[res->leafid].push_back(j);
-	  else
-	    cnt++;
+	// Points outside a periodic domain are wrapped back into it. The
+	// Python wrapper wraps its copy of the points the same way.
+	if (outside_periodic(npts0, pts0)) {
+	  pts_wrap = (double*)my_malloc(ndim*npts0*sizeof(double));
+	  memcpy(pts_wrap, pts0, ndim*npts0*sizeof(double));
+	  wrap_periodic(npts0, pts_wrap);
+	  pts0 = pts_wrap;
 	}
-	if (cnt > 0) {
-	    printf("%d points were not within the bounds of the original domain decomposition\n",
-		   cnt);
+	// Assign each point to an existing leaf. lle/lre track growth during
+	// this call, the locator is rebuilt once it has been shared.
+	std::vector<double> lle(decomp.leaves_le), lre(decomp.leaves_re);
+	std::vector<int64_t> leaf_ids(npts0);
+	if (npts0 > 0)
+	  locator.find_all(npts0, pts0, &leaf_ids[0]);
+	// Points still outside every leaf are given to the nearest leaf,
+	// which grows to hold them. Leaves that end up too large are split
+	// below, but stay on their rank, so the work is only rebalanced
+	// between ranks by rebuilding the decomposition.
+	double *pt;
+	int64_t res;
+	for (j = 0; j < npts0; j++) {
+	  if (leaf_ids[j] >= 0)
+	    continue;
+	  pt = pts0+ndim*j;
+	  res = nearest_leaf(pt);
+	  if (res < 0)
+	    continue;
+	  for (k = 0; k < ndim; k++) {
+	    if (pt[k] < lle[ndim*res+k]) {
+	      grow_le[ndim*res+k] += pt[k] - lle[ndim*res+k];
+	      lle[ndim*res+k] = pt[k];
+	      ngrown++;
+	    }
+	    if (pt[k] > lre[ndim*res+k]) {
+	      grow_re[ndim*res+k] += pt[k] - lre[ndim*res+k];
+	      lre[ndim*res+k] = pt[k];
+	      ngrown++;
+	    }
+	  }
+	  leaf_ids[j] = res;
 	}
+	std::vector<uint64_t> dist_indptr, dist;
+	LeafLocator::group_by_leaf(npts0, leaf_ids.data(),
+				   (uint64_t)nleaves_total, dist_indptr, dist);
+	if (ngrown > 0)
+	  printf("Leaf bounds were extended to hold points outside the original domain decomposition\n");
 	// Send new points to leaf
       	int nsend, task;
-	int iroot = 0;
+	uint32_t iroot;
       	for (i = 0; i < nleaves_total; i++) {
-      	  task = i % size;
-      	  nsend = (int)(dist[i].size());
+      	  task = decomp.leaf_rank[i];
+      	  nsend = (int)(dist_indptr[i+1] - dist_indptr[i]);
 	  iidx = (Info*)my_realloc(iidx, nsend*sizeof(Info));
 	  ipts = (double*)my_realloc(ipts, ndim*nsend*sizeof(double));
-	  for (j = 0; j < (uint64_t)nsend; j++) {
-	    iidx[j] = dist[i][j] + npts_prev;
-	    for (k = 0; k < ndim; k++) 
-	      ipts[ndim*j+k] = pts0[ndim*dist[i][j]+k];
-	  }
+	  for (j = 0; j < (uint64_t)nsend; j++)
+	    iidx[j] = dist[dist_indptr[i]+j] + npts_prev;
+	  if (nsend > 0)
+	    gather_points(ndim, (uint64_t)nsend, pts0, &dist[dist_indptr[i]],
+			  ipts);
       	  if (task == rank) {
+	    iroot = map_id2idx[i];
 	    if (limit_mem > 1)
 	      leaves[iroot]->load();
-	    leaves[iroot]->insert(ipts, iidx, nsend); // leaves used
+	    leaves[iroot]->insert_owned(ipts, iidx, nsend); // leaves used
 	    if (limit_mem > 1)
 	      leaves[iroot]->dump();
-	    iroot++;
       	  } else {
       	    MPI_Send(&nsend, 1, MPI_INT, task, 20+task, MPI_COMM_WORLD);
 	    if (sizeof(Info) == sizeof(uint32_t))
@@ -1019,8 +1600,6 @@ public:
 	    MPI_Send(ipts, ndim*nsend, MPI_DOUBLE, task, 22+task,
 		     MPI_COMM_WORLD);
       	  }
-	  free(iidx);
-	  free(ipts);
       	}
       } else {
       	int nrecv;
@@ -1039,7 +1618,7 @@ public:
 		   MPI_COMM_WORLD, MPI_STATUS_IGNORE);
 	  if (limit_mem > 0)
 	    leaves[i]->load();
-	  leaves[i]->insert(ipts, iidx, nrecv); // leaves used
+	  leaves[i]->insert_owned(ipts, iidx, nrecv); // leaves used
 	  if (limit_mem > 0)
 	    leaves[i]->dump();
       	}
@@ -1048,6 +1627,46 @@ public:
 	free(iidx);
       if (ipts != NULL)
 	free(ipts);
+      if (pts_wrap != NULL)
+	free(pts_wrap);
+      // Share any growth of the leaf bounds
+      MPI_Bcast(&ngrown, 1, MPI_INT, 0, MPI_COMM_WORLD);
+      if (ngrown > 0) {
+	MPI_Bcast(&grow_le[0], nleaves_total*ndim, MPI_DOUBLE, 0,
+		  MPI_COMM_WORLD);
+	MPI_Bcast(&grow_re[0], nleaves_total*ndim, MPI_DOUBLE, 0,
+		  MPI_COMM_WORLD);
+	decomp.grow(&grow_le[0], &grow_re[0]);
+	if (rank == 0)
+	  build_locator();
+	for (i = 0; i < nleaves; i++) {
+	  if (limit_mem > 1)
+	    leaves[i]->load();
+	  leaves[i]->grow_bounds(&grow_le[0], &grow_re[0]);
+	  if (limit_mem > 1)
+	    leaves[i]->dump();
+	}
+      }
+      // Leaves that now own too many points are split and, as owned
+      // points changed, every leaf sends to all of its known neighbors
+      // again in the exchange below
+      split_leaves();
+      for (i = 0; i < nleaves; i++)
+	leaves[i]->resend_neighbors();
+      // Extend the totals so that consolidation includes the new points.
+      // The decomposition sorted idx_total in place and keeps a pointer
+      // to it.
+      if (rank == 0) {
+	idx_total = (uint64_t*)my_realloc(idx_total,
+					  (npts_total+npts0)*sizeof(uint64_t));
+	for (j = 0; j < npts0; j++)
+	  idx_total[npts_total+j] = npts_prev + j;
+	npts_total += npts0;
+	if (curve != NULL)
+	  curve->all_idx = idx_total;
+	if (tree != NULL)
+	  tree->all_idx = idx_total;
+      }
     }
     // Exchange points
     exchange();
@@ -1056,6 +1675,91 @@ public:
       printf("%d: Finishing insert\n", rank);
   }
 
+  // Split leaves owning more than leaf_npts_limit points in two (see
+  // CParallelLeaf::split) until none do. The new leaf takes the next free
+  // id and stays on the rank of its parent, so no points move between
+  // ranks. Every leaf that knows the parent also learns of the new leaf.
+  void split_leaves() {
+    struct LeafSplit {
+      uint32_t parent;
+      uint32_t dim;
+      double value;
+    };
+    int i, nsplit = 0;
+    uint32_t d;
+    double value;
+    if (leaf_npts_limit == 0)
+      return;
+    while (true) {
+      std::vector<LeafSplit> local;
+      for (i = 0; i < nleaves; i++) {
+	if (leaves[i]->npts_orig <= leaf_npts_limit)
+	  continue;
+	if (limit_mem > 1)
+	  leaves[i]->load();
+	if (leaves[i]->split_value(d, value)) {
+	  LeafSplit x = {leaves[i]->id, d, value};
+	  local.push_back(x);
+	}
+	if (limit_mem > 1)
+	  leaves[i]->dump();
+      }
+      // Share the splits in rank order, which sets the new ids
+      int nbytes = (int)(local.size()*sizeof(LeafSplit)), nbytes_total = 0;
+      std::vector<int> count(size), offset(size);
+      MPI_Allgather(&nbytes, 1, MPI_INT, &count[0], 1, MPI_INT,
+		    MPI_COMM_WORLD);
+      for (i = 0; i < size; i++) {
+	offset[i] = nbytes_total;
+	nbytes_total += count[i];
+      }
+      if (nbytes_total == 0)
+	break;
+      std::vector<LeafSplit> all(nbytes_total/sizeof(LeafSplit));
+      if (local.empty())
+	local.resize(1);
+      MPI_Allgatherv(&local[0], nbytes, MPI_BYTE, &all[0], &count[0],
+		     &offset[0], MPI_BYTE, MPI_COMM_WORLD);
+      std::vector<uint32_t> child(all.size());
+      for (uint64_t s = 0; s < all.size(); s++)
+	child[s] = decomp.split(all[s].parent, all[s].dim, all[s].value);
+      nleaves_total = (int)decomp.nleaves;
+      if (rank == 0) {
+	leaf_split.resize(nleaves_total, true);
+	for (uint64_t s = 0; s < all.size(); s++)
+	  leaf_split[all[s].parent] = true;
+      }
+      for (uint64_t s = 0; s < all.size(); s++) {
+	if (decomp.leaf_rank[all[s].parent] != rank)
+	  continue;
+	CParallelLeaf<Info> *parent = leaves[map_id2idx[all[s].parent]];
+	if (limit_mem > 1)
+	  parent->load();
+	leaves.push_back(parent->split(child[s], all[s].dim, all[s].value));
+	map_id2idx[child[s]] = (uint32_t)nleaves;
+	if (limit_mem > 1) {
+	  parent->dump();
+	  leaves[nleaves]->dump();
+	}
+	nleaves++;
+      }
+      for (i = 0; i < nleaves; i++) {
+	for (uint64_t s = 0; s < all.size(); s++) {
+	  if ((leaves[i]->id != child[s]) && leaves[i]->knows(all[s].parent))
+	    leaves[i]->neigh->insert(child[s]);
+	}
+      }
+      nsplit += (int)(all.size());
+    }
+    if (nsplit == 0)
+      return;
+    if (rank == 0) {
+      build_locator();
+      printf("Split %d leaves that grew past %lu points\n", nsplit,
+	     leaf_npts_limit);
+    }
+  }
+
   void exchange() {
     if (DEBUG)
       printf("%d: Beginning exchange\n", rank);
@@ -1070,6 +1774,9 @@ public:
     double *pts_recv = NULL;
     uint32_t *ngh_recv = NULL;
     int count_exch = 0;
+    int nwait, nwait_total;
+    for (int i = 0; i < nleaves; i++)
+      leaves[i]->begin_exchange();
     while (nrecv_total != 0) {
       nexch = outgoing_points(&src_recv, &dst_recv, &cnt_recv, &nct_recv,
 			      &idx_recv, &pts_recv, &ngh_recv);
@@ -1082,8 +1789,24 @@ public:
       // free(idx_recv);  // Memory moved to leaf
       // free(pts_recv);  // Memory moved to leaf
       free(ngh_recv);
-      MPI_Allreduce(&nrecv, &nrecv_total, 1, MPI_UNSIGNED, MPI_SUM,
-		    MPI_COMM_WORLD);
+      if (volumes_only) {
+	// Continue while any leaf is still waiting on points
+	nwait = 0;
+	for (int i = 0; i < nleaves; i++) {
+	  if (limit_mem > 1)
+	    leaves[i]->load();
+	  if (!(leaves[i]->update_requests()))
+	    nwait++;
+	  if (limit_mem > 1)
+	    leaves[i]->dump();
+	}
+	MPI_Allreduce(&nwait, &nwait_total, 1, MPI_INT, MPI_SUM,
+		      MPI_COMM_WORLD);
+	nrecv_total = (uint64_t)nwait_total;
+      } else {
+	MPI_Allreduce(&nrecv, &nrecv_total, 1, MPI_UNSIGNED, MPI_SUM,
+		      MPI_COMM_WORLD);
+      }
       count_exch++;
     }
     if (DEBUG)
@@ -1107,11 +1830,14 @@ public:
       ipts = pts_recv + ndim*nprev_pts;
       ingh = ngh_recv + nprev_ngh;
       dst = map_id2idx[dst_recv[i]];
-      if (cnt_recv[i] > 0) {
+      // With volumes only, empty messages still tell a leaf that the
+      // sender has answered
+      if ((cnt_recv[i] > 0) || volumes_only) {
 	if (limit_mem > 1)
 	  leaves[dst]->load();
 	leaves[dst]->incoming_points(src_recv[i], cnt_recv[i], nct_recv[i],
-				     iidx, ipts, ingh); // leaves used
+				     iidx, ipts, ingh,
+				     volumes_only); // leaves used
 	if (limit_mem > 1)
 	  leaves[dst]->dump();
       }
@@ -1124,13 +1850,133 @@ public:
     return nrecv;
   }
 
+  // Grow the rank-level communication graph so that it includes every rank
+  // this rank has points for. The graph only ever grows and is rebuilt
+  // (collectively) only when some rank needs a new destination.
+  void update_graph(const std::vector<std::vector<uint32_t>> &dst_out) {
+#if MPI_VERSION >= 3
+    int i, grow = 0, grow_any = 0;
+    for (i = 0; i < size; i++) {
+      if ((!dst_out[i].empty()) && (graph_dst_set.count(i) == 0)) {
+	graph_dst_set.insert(i);
+	grow = 1;
+      }
+    }
+    if (graph_comm == MPI_COMM_NULL)
+      grow = 1;
+    MPI_Allreduce(&grow, &grow_any, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    if (grow_any == 0)
+      return;
+    if (graph_comm != MPI_COMM_NULL)
+      MPI_Comm_free(&graph_comm);
+    graph_dst_set.insert(rank);
+    std::vector<int> dst(graph_dst_set.begin(), graph_dst_set.end());
+    int src = rank, degree = (int)(dst.size());
+    MPI_Dist_graph_create(MPI_COMM_WORLD, 1, &src, &degree, &dst[0],
+			  MPI_UNWEIGHTED, MPI_INFO_NULL, 0, &graph_comm);
+    int nin, nout, weighted;
+    MPI_Dist_graph_neighbors_count(graph_comm, &nin, &nout, &weighted);
+    graph_src.assign(std::max(nin, 1), 0);
+    graph_dst.assign(std::max(nout, 1), 0);
+    MPI_Dist_graph_neighbors(graph_comm, nin, &graph_src[0], MPI_UNWEIGHTED,
+			     nout, &graph_dst[0], MPI_UNWEIGHTED);
+    graph_src.resize(nin);
+    graph_dst.resize(nout);
+    if (DEBUG)
+      printf("%d: Exchange graph has %d sources and %d destinations\n",
+	     rank, nin, nout);
+#else
+    // Without neighbourhood collectives every rank is a neighbour
+    if (graph_dst.empty()) {
+      for (int i = 0; i < size; i++) {
+	graph_src.push_back(i);
+	graph_dst.push_back(i);
+      }
+    }
+#endif
+  }
+
+  // Alltoall/Alltoallv restricted to the communication graph. Send buffers
+  // are ordered by graph_dst and receive buffers by graph_src.
+  void graph_alltoall(int *sendbuf, int *recvbuf) {
+#if MPI_VERSION >= 3
+    MPI_Neighbor_alltoall(sendbuf, 1, MPI_INT, recvbuf, 1, MPI_INT,
+			  graph_comm);
+#else
+    MPI_Alltoall(sendbuf, 1, MPI_INT, recvbuf, 1, MPI_INT, MPI_COMM_WORLD);
+#endif
+  }
+  void graph_alltoallv(void *sendbuf, int *count_send, int *offset_send,
+		       void *recvbuf, int *count_recv, int *offset_recv,
+		       MPI_Datatype type) {
+#if MPI_VERSION >= 3
+    MPI_Neighbor_alltoallv(sendbuf, count_send, offset_send, type,
+			   recvbuf, count_recv, offset_recv, type, graph_comm);
+#else
+    MPI_Alltoallv(sendbuf, count_send, offset_send, type,
+		  recvbuf, count_recv, offset_recv, type, MPI_COMM_WORLD);
+#endif
+  }
+
+  // Send the points and indices of each exchange through
+  // encode_exchange/decode_exchange as a single byte stream per rank.
+  // count_send/count_recv are the number of exchanges per graph
+  // neighbour and cnt_send/cnt_recv the number of points in each.
+  void exchange_encoded(int nout, int nin, int *count_send, int *count_recv,
+			uint32_t *cnt_send,
+			uint32_t *cnt_recv, Info *idx_send, double *pts_send,
+			Info *idx_recv, double *pts_recv) {
+    int i, j, e = 0;
+    int nbuf = std::max(std::max(nout, nin), 1);
+    uint64_t ipt = 0;
+    std::vector<uint8_t> bytes_send;
+    std::vector<int> count_byte_send(nbuf, 0), count_byte_recv(nbuf, 0);
+    std::vector<int> offset_byte_send(nbuf, 0), offset_byte_recv(nbuf, 0);
+    for (i = 0; i < nout; i++) {
+      offset_byte_send[i] = (int)(bytes_send.size());
+      for (j = 0; j < count_send[i]; j++, e++) {
+	encode_exchange(ndim, cnt_send[e], pts_send + ndim*ipt,
+			idx_send + ipt, bytes_send);
+	ipt += cnt_send[e];
+      }
+      count_byte_send[i] = (int)(bytes_send.size()) - offset_byte_send[i];
+    }
+    graph_alltoall(&count_byte_send[0], &count_byte_recv[0]);
+    exchange_bytes += bytes_send.size();
+    int nbytes_recv = 0;
+    for (i = 0; i < nin; i++) {
+      offset_byte_recv[i] = nbytes_recv;
+      nbytes_recv += count_byte_recv[i];
+    }
+    std::vector<uint8_t> bytes_recv(std::max(nbytes_recv, 1));
+    if (bytes_send.empty())
+      bytes_send.push_back(0);
+    graph_alltoallv(&bytes_send[0], &count_byte_send[0],
+		    &offset_byte_send[0], &bytes_recv[0], &count_byte_recv[0],
+		    &offset_byte_recv[0], MPI_BYTE);
+    if (DEBUG)
+      printf("%d: Exchange codec sent %d bytes for %lu points\n", rank,
+	     offset_byte_send[std::max(nout-1, 0)] +
+	     count_byte_send[std::max(nout-1, 0)], ipt);
+    e = 0;
+    ipt = 0;
+    for (i = 0; i < nin; i++) {
+      uint64_t pos = (uint64_t)offset_byte_recv[i];
+      for (j = 0; j < count_recv[i]; j++, e++) {
+	pos += decode_exchange(&bytes_recv[pos], ndim, cnt_recv[e],
+			       pts_recv + ndim*ipt, idx_recv + ipt);
+	ipt += cnt_recv[e];
+      }
+    }
+  }
+
   int outgoing_points(uint32_t **src_recv, uint32_t **dst_recv,
 		      uint32_t **cnt_recv, uint32_t **nct_recv,
 		      Info **idx_recv, double **pts_recv,
 		      uint32_t **ngh_recv) {
     if (DEBUG)
       printf("%d: Beginning outgoing_points\n", rank);
-    int i, j;
+    int i, j, t;
     // Get output from each leaf
     std::vector<std::vector<uint32_t>> src_out, dst_out, cnt_out, nct_out;
     std::vector<Info*> idx_out;
@@ -1149,25 +1995,29 @@ public:
       if (limit_mem > 1)
 	leaves[i]->load();
       leaves[i]->outgoing_points(src_out, dst_out, cnt_out, nct_out,
-				 idx_out, pts_out, ngh_out); // leaves used
+				 idx_out, pts_out, ngh_out,
+				 volumes_only); // leaves used
       if (limit_mem > 1)
 	leaves[i]->dump();
     }
+    // Only exchange with ranks in the communication graph
+    update_graph(dst_out);
+    int nout = (int)(graph_dst.size());
+    int nin = (int)(graph_src.size());
+    int nbuf = std::max(std::max(nout, nin), 1);
     // Send expected counts
-    int *count_send = (int*)my_malloc(size*sizeof(int));
-    int *count_recv = (int*)my_malloc(size*sizeof(int));
-    int *offset_send = (int*)my_malloc(size*sizeof(int));
-    int *offset_recv = (int*)my_malloc(size*sizeof(int));
-    for (i = 0; i < size; i++)
-      count_send[i] = (int)(src_out[i].size());
-    MPI_Alltoall(count_send, 1, MPI_INT,
-    		 count_recv, 1, MPI_INT,
-    		 MPI_COMM_WORLD);
+    int *count_send = (int*)my_malloc(nbuf*sizeof(int));
+    int *count_recv = (int*)my_malloc(nbuf*sizeof(int));
+    int *offset_send = (int*)my_malloc(nbuf*sizeof(int));
+    int *offset_recv = (int*)my_malloc(nbuf*sizeof(int));
+    for (i = 0; i < nout; i++)
+      count_send[i] = (int)(src_out[graph_dst[i]].size());
+    graph_alltoall(count_send, count_recv);
     int count_send_tot = 0, count_recv_tot = 0;
-    for (i = 0; i < size; i++) {
+    for (i = 0; i < nout; i++)
       count_send_tot += count_send[i];
+    for (i = 0; i < nin; i++)
       count_recv_tot += count_recv[i];
-    }
     // Send extra info about each exchange
     uint32_t *src_send = (uint32_t*)my_malloc(count_send_tot*sizeof(uint32_t));
     uint32_t *dst_send = (uint32_t*)my_malloc(count_send_tot*sizeof(uint32_t));
@@ -1178,62 +2028,55 @@ public:
     (*cnt_recv) = (uint32_t*)my_malloc(count_recv_tot*sizeof(uint32_t));
     (*nct_recv) = (uint32_t*)my_malloc(count_recv_tot*sizeof(uint32_t));
     int prev_send = 0, prev_recv = 0;
-    for (i = 0; i < size; i++) {
+    for (i = 0; i < nout; i++) {
+      t = graph_dst[i];
       offset_send[i] = prev_send;
-      offset_recv[i] = prev_recv;
       for (j = 0; j < count_send[i]; j++) {
-    	src_send[prev_send] = src_out[i][j];
-    	dst_send[prev_send] = dst_out[i][j];
-    	cnt_send[prev_send] = cnt_out[i][j];
-    	nct_send[prev_send] = nct_out[i][j];
+    	src_send[prev_send] = src_out[t][j];
+    	dst_send[prev_send] = dst_out[t][j];
+    	cnt_send[prev_send] = cnt_out[t][j];
+    	nct_send[prev_send] = nct_out[t][j];
     	prev_send++;
       }
+    }
+    for (i = 0; i < nin; i++) {
+      offset_recv[i] = prev_recv;
       prev_recv += count_recv[i];
     }
-    MPI_Alltoallv(src_send, count_send, offset_send, MPI_UNSIGNED,
-    		  *src_recv, count_recv, offset_recv, MPI_UNSIGNED,
-    		  MPI_COMM_WORLD);
-    MPI_Alltoallv(dst_send, count_send, offset_send, MPI_UNSIGNED,
-    		  *dst_recv, count_recv, offset_recv, MPI_UNSIGNED,
-    		  MPI_COMM_WORLD);
-    MPI_Alltoallv(cnt_send, count_send, offset_send, MPI_UNSIGNED,
-    		  *cnt_recv, count_recv, offset_recv, MPI_UNSIGNED,
-    		  MPI_COMM_WORLD);
-    MPI_Alltoallv(nct_send, count_send, offset_send, MPI_UNSIGNED,
-    		  *nct_recv, count_recv, offset_recv, MPI_UNSIGNED,
-    		  MPI_COMM_WORLD);
-    free(src_send);
+    graph_alltoallv(src_send, count_send, offset_send,
+		    *src_recv, count_recv, offset_recv, MPI_UNSIGNED);
+    graph_alltoallv(dst_send, count_send, offset_send,
+		    *dst_recv, count_recv, offset_recv, MPI_UNSIGNED);
+    graph_alltoallv(cnt_send, count_send, offset_send,
+		    *cnt_recv, count_recv, offset_recv, MPI_UNSIGNED);
+    graph_alltoallv(nct_send, count_send, offset_send,
+		    *nct_recv, count_recv, offset_recv, MPI_UNSIGNED);
     free(dst_send);
     free(offset_send);
     free(offset_recv);
     // Get counts/offsets for sending arrays
-    int *count_idx_send = (int*)my_malloc(size*sizeof(int));
-    int *count_idx_recv = (int*)my_malloc(size*sizeof(int));
-    int *count_pts_send = (int*)my_malloc(size*sizeof(int));
-    int *count_pts_recv = (int*)my_malloc(size*sizeof(int));
-    int *count_ngh_send = (int*)my_malloc(size*sizeof(int));
-    int *count_ngh_recv = (int*)my_malloc(size*sizeof(int));
-    int *offset_idx_send = (int*)my_malloc(size*sizeof(int));
-    int *offset_idx_recv = (int*)my_malloc(size*sizeof(int));
-    int *offset_pts_send = (int*)my_malloc(size*sizeof(int));
-    int *offset_pts_recv = (int*)my_malloc(size*sizeof(int));
-    int *offset_ngh_send = (int*)my_malloc(size*sizeof(int));
-    int *offset_ngh_recv = (int*)my_malloc(size*sizeof(int));
+    int *count_idx_send = (int*)my_malloc(nbuf*sizeof(int));
+    int *count_idx_recv = (int*)my_malloc(nbuf*sizeof(int));
+    int *count_pts_send = (int*)my_malloc(nbuf*sizeof(int));
+    int *count_pts_recv = (int*)my_malloc(nbuf*sizeof(int));
+    int *count_ngh_send = (int*)my_malloc(nbuf*sizeof(int));
+    int *count_ngh_recv = (int*)my_malloc(nbuf*sizeof(int));
+    int *offset_idx_send = (int*)my_malloc(nbuf*sizeof(int));
+    int *offset_idx_recv = (int*)my_malloc(nbuf*sizeof(int));
+    int *offset_pts_send = (int*)my_malloc(nbuf*sizeof(int));
+    int *offset_pts_recv = (int*)my_malloc(nbuf*sizeof(int));
+    int *offset_ngh_send = (int*)my_malloc(nbuf*sizeof(int));
+    int *offset_ngh_recv = (int*)my_malloc(nbuf*sizeof(int));
     prev_send = 0;
     prev_recv = 0;
     int prev_array_send = 0, prev_array_recv = 0;
     int prev_neigh_send = 0, prev_neigh_recv = 0;
-    for (i = 0; i < size; i++) {
+    for (i = 0; i < nout; i++) {
       count_idx_send[i] = 0;
-      count_idx_recv[i] = 0;
       count_ngh_send[i] = 0;
-      count_ngh_recv[i] = 0;
       offset_idx_send[i] = prev_array_send;
-      offset_idx_recv[i] = prev_array_recv;
       offset_pts_send[i] = ndim*prev_array_send;
-      offset_pts_recv[i] = ndim*prev_array_recv;
       offset_ngh_send[i] = prev_neigh_send;
-      offset_ngh_recv[i] = prev_neigh_recv;
       for (j = 0; j < count_send[i]; j++) {
     	count_idx_send[i] += cnt_send[prev_send];
     	count_ngh_send[i] += nct_send[prev_send];
@@ -1242,6 +2085,13 @@ public:
       count_pts_send[i] = ndim*count_idx_send[i];
       prev_array_send += count_idx_send[i];
       prev_neigh_send += count_ngh_send[i];
+    }
+    for (i = 0; i < nin; i++) {
+      count_idx_recv[i] = 0;
+      count_ngh_recv[i] = 0;
+      offset_idx_recv[i] = prev_array_recv;
+      offset_pts_recv[i] = ndim*prev_array_recv;
+      offset_ngh_recv[i] = prev_neigh_recv;
       for (j = 0; j < count_recv[i]; j++) {
     	count_idx_recv[i] += (*cnt_recv)[prev_recv];
     	count_ngh_recv[i] += (*nct_recv)[prev_recv];
@@ -1251,10 +2101,6 @@ public:
       prev_array_recv += count_idx_recv[i];
       prev_neigh_recv += count_ngh_recv[i];
     }
-    free(count_send);
-    free(count_recv);
-    free(cnt_send);
-    free(nct_send);
     // Allocate for arrays
     (*idx_recv) = (Info*)my_malloc(prev_array_recv*sizeof(Info));
     (*pts_recv) = (double*)my_malloc(ndim*prev_array_recv*sizeof(double));
@@ -1265,36 +2111,52 @@ public:
     Info *idx_send_curr = idx_send;
     double *pts_send_curr = pts_send;
     uint32_t *ngh_send_curr = ngh_send;
-    for (i = 0; i < size; i++) {
+    for (i = 0; i < nout; i++) {
+      t = graph_dst[i];
       if (count_idx_send[i] > 0) {
-    	memmove(idx_send_curr, idx_out[i], count_idx_send[i]*sizeof(Info));
-    	memmove(pts_send_curr, pts_out[i], count_pts_send[i]*sizeof(double));
+    	memmove(idx_send_curr, idx_out[t], count_idx_send[i]*sizeof(Info));
+    	memmove(pts_send_curr, pts_out[t], count_pts_send[i]*sizeof(double));
     	idx_send_curr += count_idx_send[i];
     	pts_send_curr += count_pts_send[i];
       }
       if (count_ngh_send[i] > 0) {
-    	memmove(ngh_send_curr, ngh_out[i], count_ngh_send[i]*sizeof(uint32_t));
+    	memmove(ngh_send_curr, ngh_out[t], count_ngh_send[i]*sizeof(uint32_t));
     	ngh_send_curr += count_ngh_send[i];
       }
+    }
+    for (i = 0; i < size; i++) {
+      free(idx_out[i]);
+      free(pts_out[i]);
+      free(ngh_out[i]);
       idx_out[i] = NULL;
       pts_out[i] = NULL;
       ngh_out[i] = NULL;
     }
     // Send arrays
-    if (sizeof(Info) == sizeof(uint32_t))
-      MPI_Alltoallv(idx_send, count_idx_send, offset_idx_send, MPI_UNSIGNED,
-		    *idx_recv, count_idx_recv, offset_idx_recv, MPI_UNSIGNED,
-		    MPI_COMM_WORLD);
-    else
-      MPI_Alltoallv(idx_send, count_idx_send, offset_idx_send, MPI_UNSIGNED_LONG,
-		    *idx_recv, count_idx_recv, offset_idx_recv, MPI_UNSIGNED_LONG,
-		    MPI_COMM_WORLD);
-    MPI_Alltoallv(pts_send, count_pts_send, offset_pts_send, MPI_DOUBLE,
-    		  *pts_recv, count_pts_recv, offset_pts_recv, MPI_DOUBLE,
-    		  MPI_COMM_WORLD);
-    MPI_Alltoallv(ngh_send, count_ngh_send, offset_ngh_send, MPI_UNSIGNED,
-    		  *ngh_recv, count_ngh_recv, offset_ngh_recv, MPI_UNSIGNED,
-    		  MPI_COMM_WORLD);
+    if (compress_exchange) {
+      exchange_encoded(nout, nin, count_send, count_recv, cnt_send,
+		       *cnt_recv, idx_send, pts_send, *idx_recv, *pts_recv);
+    } else {
+      exchange_bytes += (uint64_t)prev_array_send*(sizeof(Info) +
+						   ndim*sizeof(double));
+      if (sizeof(Info) == sizeof(uint32_t))
+	graph_alltoallv(idx_send, count_idx_send, offset_idx_send,
+			*idx_recv, count_idx_recv, offset_idx_recv,
+			MPI_UNSIGNED);
+      else
+	graph_alltoallv(idx_send, count_idx_send, offset_idx_send,
+			*idx_recv, count_idx_recv, offset_idx_recv,
+			MPI_UNSIGNED_LONG);
+      graph_alltoallv(pts_send, count_pts_send, offset_pts_send,
+		      *pts_recv, count_pts_recv, offset_pts_recv, MPI_DOUBLE);
+    }
+    graph_alltoallv(ngh_send, count_ngh_send, offset_ngh_send,
+		    *ngh_recv, count_ngh_recv, offset_ngh_recv, MPI_UNSIGNED);
+    free(count_send);
+    free(count_recv);
+    free(src_send);
+    free(cnt_send);
+    free(nct_send);
     free(count_idx_send);
     free(count_pts_send);
     free(count_ngh_send);
@@ -1315,6 +2177,13 @@ public:
     return count_recv_tot;
   }
 
+  // Leaf i of the root decomposition
+  CParallelLeaf<Info>* new_root_leaf(int i) {
+    return new CParallelLeaf<Info>(&decomp, unique_str, i, leaf_left_idx(i),
+				   leaf_npts(i), pts_total, sorted_idx_array(),
+				   pts_sorted);
+  }
+
   void domain_decomp() {
     int i;
     uint64_t j;
@@ -1323,7 +2192,64 @@ public:
     int leafsize_limit = 0;
     if (DEBUG)
       printf("%d: Beginning domain decomposition\n", rank);
-    if (rank == 0) {
+    if ((rank == 0) && ((dd_method == DD_HILBERT) ||
+			(dd_method == DD_MORTON))) {
+      for (k = 0; k < ndim; k++) {
+	if (periodic[k]) {
+	  printf("Curve decompositions do not support periodic domains. "
+		 "Using a KD tree instead.\n");
+	  dd_method = DD_KDTREE;
+	  break;
+	}
+      }
+    }
+    if ((rank == 0) && ((dd_method == DD_HILBERT) ||
+			(dd_method == DD_MORTON))) {
+      // Cut a space filling curve into exactly size*k chunks
+      nleaves_total = size*dd_nleaves_per_proc;
+      if (limit_mem > 1)
+	nleaves_total *= limit_mem;
+      idx_total = (uint64_t*)my_malloc(npts_total*sizeof(uint64_t));
+      for (j = 0; j < npts_total; j++)
+	idx_total[j] = j;
+      curve = new CurveDecomposition(pts_total, idx_total, npts_total, ndim,
+				     (uint64_t)nleaves_total, le, re, NULL,
+				     (dd_method == DD_MORTON) ?
+				     CURVE_MORTON : CURVE_HILBERT);
+      decomp = CDecompDescriptor(curve);
+      leaf_start = curve->leaf_start;
+    } else if ((rank == 0) && (dd_method == DD_KDTREE_COST)) {
+      // Split into exactly size*k leaves balancing points plus halo
+      nleaves_total = size*dd_nleaves_per_proc;
+      if (limit_mem > 1)
+	nleaves_total *= limit_mem;
+      idx_total = (uint64_t*)my_malloc(npts_total*sizeof(uint64_t));
+      for (j = 0; j < npts_total; j++)
+	idx_total[j] = j;
+      std::vector<double> domain_width(ndim);
+      for (k = 0; k < ndim; k++)
+	domain_width[k] = re[k] - le[k];
+      uint32_t nkd;
+      std::vector<double> kd_le, kd_re;
+      {
+	SplitKDTree split(pts_total, idx_total, npts_total, ndim, 0,
+			  (uint64_t)nleaves_total, le, re, periodic,
+			  SPLIT_COST);
+	nkd = (uint32_t)split.num_leaves();
+	kd_le.swap(split.leaves_le);
+	kd_re.swap(split.leaves_re);
+	leaf_start.swap(split.leaf_start);
+      }
+      nleaves_total = (int)merge_small_leaves(ndim, ndim+1, leaf_start,
+					      kd_le, kd_re, (uint64_t)size);
+      if ((uint32_t)nleaves_total < nkd)
+	printf("Merged %u leaves with fewer than %u points into neighbors.\n",
+	       nkd - (uint32_t)nleaves_total, ndim+1);
+      LeafAdjacency adjacency(nleaves_total, ndim, &kd_le[0], &kd_re[0],
+			      le, re, periodic);
+      decomp = CDecompDescriptor(ndim, kd_le, kd_re, &domain_width[0],
+				 adjacency);
+    } else if (rank == 0) {
       // Create KDtree
       uint32_t leafsize;
       nleaves_total = size;
@@ -1337,19 +2263,57 @@ public:
       tree = new KDTree(pts_total, idx_total, npts_total, ndim,
 		        leafsize, le, re, periodic, false);
       tree->consolidate_edges();
+      // Leaves are in depth first order and own contiguous ranges of
+      // all_idx. Leaves with too few points to triangulate are merged into
+      // a neighbor they form a box with.
+      uint32_t nkd = tree->num_leaves;
+      std::vector<double> kd_le(tree->leaves_le,
+				tree->leaves_le + nkd*ndim);
+      std::vector<double> kd_re(tree->leaves_re,
+				tree->leaves_re + nkd*ndim);
+      leaf_start.resize(nkd + 1);
+      for (k = 0; k < nkd; k++)
+	leaf_start[k] = tree->leaves[k]->left_idx;
+      leaf_start[nkd] = (tree->leaves[nkd-1]->left_idx +
+			 tree->leaves[nkd-1]->children);
+      nleaves_total = (int)merge_small_leaves(ndim, ndim+1, leaf_start,
+					      kd_le, kd_re, (uint64_t)size);
+      if ((uint32_t)nleaves_total < nkd)
+	printf("Merged %u leaves with fewer than %u points into neighbors.\n",
+	       nkd - (uint32_t)nleaves_total, ndim+1);
+      LeafAdjacency adjacency(nleaves_total, ndim, &kd_le[0], &kd_re[0],
+			      le, re, periodic);
+      decomp = CDecompDescriptor(ndim, kd_le, kd_re, tree->domain_width,
+				 adjacency);
       // info_total = (Info*)my_malloc(npts_total*sizeof(Info));
       // for (j = 0; j < npts_total; j++)
       // 	info_total[j] = idx_total[j];
-      nleaves_total = tree->num_leaves;
+    }
+    if ((rank == 0) && leaf_order) {
+      pts_sorted = (double*)my_malloc(ndim*npts_total*sizeof(double));
+      gather_points(ndim, npts_total, pts_total, sorted_idx_array(),
+		    pts_sorted);
+    }
+    if (rank == 0) {
+      decomp.assign_ranks(size);
+      leaf_split.assign(nleaves_total, false);
+      build_locator();
+      uint64_t nmax = 0;
+      for (i = 0; i < nleaves_total; i++)
+	nmax = std::max(nmax, leaf_npts(i));
+      leaf_npts_limit = (uint64_t)(leaf_split_factor*(double)nmax);
     }
     MPI_Bcast(&nleaves_total, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&leaf_npts_limit, 1, MPI_UNSIGNED_LONG, 0, MPI_COMM_WORLD);
+    // Share the decomposition once rather than with every leaf
+    decomp.bcast(0);
     // Send number of leaves
     if (rank == 0) {
       nleaves_per_proc = (int*)my_malloc(sizeof(int)*size);
       for (i = 0; i < size; i++)
 	nleaves_per_proc[i] = 0;
-      for (k = 0; k < tree->num_leaves; k++) {
-	nleaves_per_proc[k % size]++;
+      for (k = 0; k < (uint32_t)nleaves_total; k++) {
+	nleaves_per_proc[decomp.leaf_rank[k]]++;
       }
     }
     MPI_Scatter(nleaves_per_proc, 1, MPI_INT,
@@ -1360,8 +2324,8 @@ public:
     // Make sure leaves meet minimum criteria
     if (rank == 0) {
       for (i = 0; i < nleaves_total; i++) {
-	if (tree->leaves[i]->children < (ndim+1)) {
-	  leafsize_limit = tree->leaves[i]->children;
+	if (leaf_npts(i) < (ndim+1)) {
+	  leafsize_limit = (int)leaf_npts(i);
 	  break;
 	}
       }
@@ -1376,29 +2340,33 @@ public:
       int task;
       int iroot = 0;
       for (i = 0; i < nleaves_total; i++) {
-	task = i % size;
+	task = decomp.leaf_rank[i];
 	if (task == rank) {
 	  // leaves used
-	  leaves.push_back(new CParallelLeaf<Info>(nleaves_total, ndim,
-						   unique_str,
-						   tree, i));
+	  leaves.push_back(new_root_leaf(i));
 	  if (limit_mem > 1)
 	    leaves[iroot]->dump();
 	  map_id2idx[leaves[iroot]->id] = iroot;
 	  iroot++;
 	} else {
-	  CParallelLeaf<Info> ileaf(nleaves_total, ndim, unique_str, tree, i);
-	  ileaf.send(task);
+	  CParallelLeaf<Info> *ileaf = new_root_leaf(i);
+	  ileaf->send(task);
+	  delete(ileaf);
 	}
       }
       tree_exists = 1;
       for (task = 1; task < size; task++)
 	MPI_Send(&tree_exists, 1, MPI_INT, task, 33, MPI_COMM_WORLD);
+      // The sorted copy is only needed to build the leaves
+      if (pts_sorted != NULL) {
+	free(pts_sorted);
+	pts_sorted = NULL;
+      }
     } else {
       for (i = 0; i < nleaves; i++) {
 	// leaves used
-	leaves.push_back(new CParallelLeaf<Info>(nleaves_total, ndim,
-						 unique_str, 0)); // calls recv
+	leaves.push_back(new CParallelLeaf<Info>(&decomp, unique_str,
+						 0)); // calls recv
 	if (limit_mem > 1)
 	  leaves[i]->dump();
 	map_id2idx[leaves[i]->id] = i;
@@ -1487,47 +2455,74 @@ public:
     return tot_ncells_total;
   }
 
+  // Voronoi volumes of the points owned by each leaf, sent to root with
+  // their indices as leaves no longer own a fixed slice of the sorted index
+  // array once they were given later points or split
   void consolidate_vols(double *vols) {
     if (DEBUG)
       printf("%d: Beginning consolidate_vols\n", rank);
-    int i, iroot, task;
+    int i, task;
     double *ivols = NULL;
+    Info *iidx = NULL;
     int j;
     int nvols;
+    CParallelLeaf<Info> *leaf;
     if (rank == 0) {
-      iroot = 0;
       for (i = 0; i < nleaves_total; i++) {
-	nvols = tree->leaves[i]->children;
-	task = i % size;
+	task = decomp.leaf_rank[i];
 	if (task == rank) {
 	  // Local
+	  leaf = leaves[map_id2idx[i]];
 	  if (limit_mem > 1)
-	    leaves[iroot]->load();
-	  leaves[iroot]->voronoi_volumes(&ivols);
+	    leaf->load();
+	  nvols = (int)(leaf->npts_orig);
+	  leaf->voronoi_volumes(&ivols);
+	  iidx = (Info*)my_realloc(iidx, nvols*sizeof(Info),
+				   "indices of volumes");
+	  memcpy(iidx, leaf->idx, nvols*sizeof(Info));
 	  if (limit_mem > 1)
-	    leaves[iroot]->dump();
-	  iroot++;
+	    leaf->dump();
 	} else {
+	  MPI_Recv(&nvols, 1, MPI_INT, task, 0, MPI_COMM_WORLD,
+		   MPI_STATUS_IGNORE);
 	  ivols = (double*)my_realloc(ivols, nvols*sizeof(double),
 				      "volumes being received");
+	  iidx = (Info*)my_realloc(iidx, nvols*sizeof(Info),
+				   "indices of volumes");
 	  MPI_Recv(ivols, nvols, MPI_DOUBLE, task, 0, MPI_COMM_WORLD,
 		   MPI_STATUS_IGNORE);
+	  if (sizeof(Info) == sizeof(uint32_t))
+	    MPI_Recv(iidx, nvols, MPI_UNSIGNED, task, 0, MPI_COMM_WORLD,
+		     MPI_STATUS_IGNORE);
+	  else
+	    MPI_Recv(iidx, nvols, MPI_UNSIGNED_LONG, task, 0, MPI_COMM_WORLD,
+		     MPI_STATUS_IGNORE);
 	}
 	for (j = 0; j < nvols; j++) {
-	  vols[tree->all_idx[tree->leaves[i]->left_idx+j]] = ivols[j];
+	  vols[sorted_idx((uint64_t)iidx[j])] = ivols[j];
 	}
       }
     } else {
       for (i = 0; i < nleaves; i++) {
-	nvols = leaves[i]->npts_orig;
+	nvols = (int)(leaves[i]->npts_orig);
 	if (limit_mem > 1)
 	  leaves[i]->load();
 	leaves[i]->voronoi_volumes(&ivols);
+	MPI_Send(&nvols, 1, MPI_INT, 0, 0, MPI_COMM_WORLD);
+	MPI_Send(ivols, nvols, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD);
+	if (sizeof(Info) == sizeof(uint32_t))
+	  MPI_Send(leaves[i]->idx, nvols, MPI_UNSIGNED, 0, 0, MPI_COMM_WORLD);
+	else
+	  MPI_Send(leaves[i]->idx, nvols, MPI_UNSIGNED_LONG, 0, 0,
+		   MPI_COMM_WORLD);
 	if (limit_mem > 1)
 	  leaves[i]->dump();
-	MPI_Send(ivols, nvols, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD);
       }
     }
+    if (ivols != NULL)
+      free(ivols);
+    if (iidx != NULL)
+      free(iidx);
     if (DEBUG)
       printf("%d: Finished consolidate_vols\n", rank);
   }
@@ -1577,15 +2572,16 @@ public:
 				      allverts, allneigh);
       // Receive other leaves
       for (i = 0; i < nleaves_total; i++) {
-    	task = i % size;
+    	task = decomp.leaf_rank[i];
     	if (task == rank) {
 	  // leaves used
+	  CParallelLeaf<Info> *leaf = leaves[map_id2idx[i]];
 	  if (limit_mem > 1)
-	    leaves[i/size]->load();
-    	  idx_inf = leaves[i/size]->serialize(tn, tm, verts, neigh,
-					      idx_verts, idx_cells);
+	    leaf->load();
+    	  idx_inf = leaf->serialize(tn, tm, verts, neigh,
+				    idx_verts, idx_cells);
 	  if (limit_mem > 1)
-	    leaves[i/size]->dump();
+	    leaf->dump();
     	} else {
     	  s = 0;
 	  if (sizeof(Info) == sizeof(uint32_t))
@@ -1613,8 +2609,7 @@ public:
     	}
     	// Insert serialized leaf
 	// leaves used
-    	idx_start = tree->leaves[i]->left_idx;
-    	idx_stop = idx_start + tree->leaves[i]->children;
+    	leaf_owned_range(i, idx_start, idx_stop);
     	sleaf = SerializedLeaf<Info>(i, ndim, (int64_t)tm, idx_inf,
 				     verts, neigh,
 				     idx_verts, idx_cells,
@@ -1155,9 +1155,13 @@ public:
     return true;
   }
 
+  // Indices of points in cells whose circumcircle intersects each box.
+  // Only cells incident to a vertex with info < max_info are tested (e.g.
+  // the original points of a leaf when only their dual cells are needed).
   std::vector<std::vector<Info>> outgoing_points(uint64_t nbox,
 						 double *left_edges, 
-						 double *right_edges) const {
+						 double *right_edges,
+						 Info max_info = std::numeric_limits<Info>::max()) const {
     std::vector<std::vector<Info>> out;
     uint64_t b;
     for (b = 0; b < nbox; b++) 
@@ -1169,6 +1173,12 @@ public:
     int i;
 
     for (Face_iterator it = T.faces_begin(); it != T.faces_end(); it++) {
+      for (i = 0; i < 3; i++) {
+	if (it->vertex(i)->info() < max_info)
+	  break;
+      }
+      if (i == 3)
+	continue;
       p1 = T.point(it->vertex(0));
       // p1 = it->vertex(0)->point();
       cc = T.circumcenter(it);
@@ -1186,6 +1196,38 @@ public:
     return out;
   }
 
+  // Flag the boxes that intersect the circumcircle of a cell incident to a
+  // vertex with info < max_info, i.e. the boxes a point could be added from
+  // that would change the dual cells of those vertices.
+  std::vector<bool> conflicting_boxes(uint64_t nbox, double *left_edges,
+				      double *right_edges, Info max_info) const {
+    std::vector<bool> out(nbox, false);
+    uint64_t b;
+
+    Point cc, p1;
+    double cr;
+    int i;
+
+    for (Face_iterator it = T.faces_begin(); it != T.faces_end(); it++) {
+      for (i = 0; i < 3; i++) {
+	if (it->vertex(i)->info() < max_info)
+	  break;
+      }
+      if (i == 3)
+	continue;
+      p1 = T.point(it->vertex(0));
+      cc = T.circumcenter(it);
+      cr = std::sqrt(static_cast<double>(CGAL::squared_distance(p1, cc)));
+      for (b = 0; b < nbox; b++) {
+	if ((!out[b]) &&
+	    intersect_sph_box(&cc, cr, left_edges + 2*b, right_edges + 2*b))
+	  out[b] = true;
+      }
+    }
+
+    return out;
+  }
+
   void boundary_points(double *left_edge, double *right_edge, bool periodic,
                        std::vector<Info>& lx, std::vector<Info>& ly,
                        std::vector<Info>& rx, std::vector<Info>& ry,
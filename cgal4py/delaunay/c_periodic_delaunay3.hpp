@@ -1612,9 +1612,13 @@ class PeriodicDelaunay_with_info_3
     return true;
   }
 
+  // Indices of points in cells whose circumsphere intersects each box.
+  // Only cells incident to a vertex with info < max_info are tested (e.g.
+  // the original points of a leaf when only their dual cells are needed).
   std::vector<std::vector<Info>> outgoing_points(uint64_t nbox,
                                                  double *left_edges,
-                                                 double *right_edges) const {
+                                                 double *right_edges,
+                                                 Info max_info = std::numeric_limits<Info>::max()) const {
     std::vector<std::vector<Info>> out;
     uint64_t b;
     for (b = 0; b < nbox; b++)
@@ -1626,6 +1630,12 @@ class PeriodicDelaunay_with_info_3
     int i;
 
     for (Cell_iterator it = T.all_cells_begin(); it != T.all_cells_end(); it++) {
+      for (i = 0; i < 4; i++) {
+	if (it->vertex(i)->info() < max_info)
+	  break;
+      }
+      if (i == 4)
+	continue;
       p1 = T.point(T.periodic_point(it->vertex(0)));
       // p1 = it->vertex(0)->point();
       cc = T.point(T.periodic_circumcenter(it));
@@ -1644,6 +1654,38 @@ class PeriodicDelaunay_with_info_3
     return out;
   }
 
+  // Flag the boxes that intersect the circumsphere of a cell incident to a
+  // vertex with info < max_info, i.e. the boxes a point could be added from
+  // that would change the dual cells of those vertices.
+  std::vector<bool> conflicting_boxes(uint64_t nbox, double *left_edges,
+                                      double *right_edges, Info max_info) const {
+    std::vector<bool> out(nbox, false);
+    uint64_t b;
+
+    Point cc, p1;
+    double cr;
+    int i;
+
+    for (Cell_iterator it = T.all_cells_begin(); it != T.all_cells_end(); it++) {
+      for (i = 0; i < 4; i++) {
+	if (it->vertex(i)->info() < max_info)
+	  break;
+      }
+      if (i == 4)
+	continue;
+      p1 = T.point(T.periodic_point(it->vertex(0)));
+      cc = T.point(T.periodic_circumcenter(it));
+      cr = std::sqrt(static_cast<double>(CGAL::squared_distance(p1, cc)));
+      for (b = 0; b < nbox; b++) {
+	if ((!out[b]) &&
+	    intersect_sph_box(&cc, cr, left_edges + 3*b, right_edges + 3*b))
+	  out[b] = true;
+      }
+    }
+
+    return out;
+  }
+
   void boundary_points(double *left_edge, double *right_edge, bool periodic,
                        std::vector<Info>& lx, std::vector<Info>& ly, std::vector<Info>& lz,
                        std::vector<Info>& rx, std::vector<Info>& ry, std::vector<Info>& rz,
@@ -0,0 +1,139 @@
+// Static floating point filters for the orientation and in-sphere predicates.
+// Each filter evaluates the determinant in double precision and compares it
+// against Shewchuk's a priori error bound. If the sign is certain it is
+// stored in sign and true is returned; otherwise false is returned and the
+// caller should fall back to the exact CGAL predicate.
+#ifndef CGAL4PY_C_PREDICATES_HPP
+#define CGAL4PY_C_PREDICATES_HPP
+
+#include <math.h>
+
+#define PRED_EPS 1.1102230246251565e-16 // 2^-53
+#define PRED_CCWERRBOUND ((3.0 + 16.0*PRED_EPS)*PRED_EPS)
+#define PRED_O3DERRBOUND ((7.0 + 56.0*PRED_EPS)*PRED_EPS)
+#define PRED_ICCERRBOUND ((10.0 + 96.0*PRED_EPS)*PRED_EPS)
+#define PRED_ISPERRBOUND ((16.0 + 224.0*PRED_EPS)*PRED_EPS)
+
+
+inline bool filter_result(double det, double errbound, int &sign) {
+  if (det > errbound) {
+    sign = 1;
+    return true;
+  } else if (-det > errbound) {
+    sign = -1;
+    return true;
+  }
+  return false;
+}
+
+// Sign of the CGAL 2D orientation of (a, b, c). Positive if counterclockwise.
+inline bool static_orientation_2(const double* a, const double* b,
+                                 const double* c, int &sign) {
+  double detleft = (a[0] - c[0]) * (b[1] - c[1]);
+  double detright = (a[1] - c[1]) * (b[0] - c[0]);
+  double det = detleft - detright;
+  double detsum = fabs(detleft) + fabs(detright);
+  return filter_result(det, PRED_CCWERRBOUND * detsum, sign);
+}
+
+// Sign of the CGAL 2D side_of_oriented_circle test for counterclockwise
+// (a, b, c). Positive if d is inside the circle.
+inline bool static_side_of_oriented_circle_2(const double* a, const double* b,
+                                             const double* c, const double* d,
+                                             int &sign) {
+  double adx = a[0] - d[0], ady = a[1] - d[1];
+  double bdx = b[0] - d[0], bdy = b[1] - d[1];
+  double cdx = c[0] - d[0], cdy = c[1] - d[1];
+  double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+  double cdxady = cdx * ady, adxcdy = adx * cdy;
+  double adxbdy = adx * bdy, bdxady = bdx * ady;
+  double alift = adx * adx + ady * ady;
+  double blift = bdx * bdx + bdy * bdy;
+  double clift = cdx * cdx + cdy * cdy;
+  double det = alift * (bdxcdy - cdxbdy)
+    + blift * (cdxady - adxcdy)
+    + clift * (adxbdy - bdxady);
+  double permanent = (fabs(bdxcdy) + fabs(cdxbdy)) * alift
+    + (fabs(cdxady) + fabs(adxcdy)) * blift
+    + (fabs(adxbdy) + fabs(bdxady)) * clift;
+  return filter_result(det, PRED_ICCERRBOUND * permanent, sign);
+}
+
+// Sign of the CGAL 3D orientation of (a, b, c, d). Positive if d is on the
+// positive side of the oriented plane through a, b, c.
+inline bool static_orientation_3(const double* a, const double* b,
+                                 const double* c, const double* d,
+                                 int &sign) {
+  double adx = a[0] - d[0], ady = a[1] - d[1], adz = a[2] - d[2];
+  double bdx = b[0] - d[0], bdy = b[1] - d[1], bdz = b[2] - d[2];
+  double cdx = c[0] - d[0], cdy = c[1] - d[1], cdz = c[2] - d[2];
+  double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+  double cdxady = cdx * ady, adxcdy = adx * cdy;
+  double adxbdy = adx * bdy, bdxady = bdx * ady;
+  double det = adz * (bdxcdy - cdxbdy)
+    + bdz * (cdxady - adxcdy)
+    + cdz * (adxbdy - bdxady);
+  double permanent = (fabs(bdxcdy) + fabs(cdxbdy)) * fabs(adz)
+    + (fabs(cdxady) + fabs(adxcdy)) * fabs(bdz)
+    + (fabs(adxbdy) + fabs(bdxady)) * fabs(cdz);
+  // Shewchuk's orient3d has the opposite sign to CGAL's orientation
+  if (filter_result(det, PRED_O3DERRBOUND * permanent, sign)) {
+    sign = -sign;
+    return true;
+  }
+  return false;
+}
+
+// Sign of the CGAL 3D side_of_oriented_sphere test for positively oriented
+// (a, b, c, d). Positive if e is inside the sphere.
+inline bool static_side_of_oriented_sphere_3(const double* a, const double* b,
+                                             const double* c, const double* d,
+                                             const double* e, int &sign) {
+  double aex = a[0] - e[0], aey = a[1] - e[1], aez = a[2] - e[2];
+  double bex = b[0] - e[0], bey = b[1] - e[1], bez = b[2] - e[2];
+  double cex = c[0] - e[0], cey = c[1] - e[1], cez = c[2] - e[2];
+  double dex = d[0] - e[0], dey = d[1] - e[1], dez = d[2] - e[2];
+  double aexbey = aex * bey, bexaey = bex * aey;
+  double bexcey = bex * cey, cexbey = cex * bey;
+  double cexdey = cex * dey, dexcey = dex * cey;
+  double dexaey = dex * aey, aexdey = aex * dey;
+  double aexcey = aex * cey, cexaey = cex * aey;
+  double bexdey = bex * dey, dexbey = dex * bey;
+  double ab = aexbey - bexaey;
+  double bc = bexcey - cexbey;
+  double cd = cexdey - dexcey;
+  double da = dexaey - aexdey;
+  double ac = aexcey - cexaey;
+  double bd = bexdey - dexbey;
+  double abc = aez * bc - bez * ac + cez * ab;
+  double bcd = bez * cd - cez * bd + dez * bc;
+  double cda = cez * da + dez * ac + aez * cd;
+  double dab = dez * ab + aez * bd + bez * da;
+  double alift = aex * aex + aey * aey + aez * aez;
+  double blift = bex * bex + bey * bey + bez * bez;
+  double clift = cex * cex + cey * cey + cez * cez;
+  double dlift = dex * dex + dey * dey + dez * dez;
+  double det = (dlift * abc - clift * dab) + (blift * cda - alift * bcd);
+  double aezp = fabs(aez), bezp = fabs(bez), cezp = fabs(cez), dezp = fabs(dez);
+  double permanent =
+    ((fabs(cexdey) + fabs(dexcey)) * bezp
+     + (fabs(dexbey) + fabs(bexdey)) * cezp
+     + (fabs(bexcey) + fabs(cexbey)) * dezp) * alift
+    + ((fabs(dexaey) + fabs(aexdey)) * cezp
+       + (fabs(aexcey) + fabs(cexaey)) * dezp
+       + (fabs(cexdey) + fabs(dexcey)) * aezp) * blift
+    + ((fabs(aexbey) + fabs(bexaey)) * dezp
+       + (fabs(bexdey) + fabs(dexbey)) * aezp
+       + (fabs(dexaey) + fabs(aexdey)) * bezp) * clift
+    + ((fabs(bexcey) + fabs(cexbey)) * aezp
+       + (fabs(cexaey) + fabs(aexcey)) * bezp
+       + (fabs(aexbey) + fabs(bexaey)) * cezp) * dlift;
+  // Shewchuk's insphere expects the opposite orientation to CGAL's
+  if (filter_result(det, PRED_ISPERRBOUND * permanent, sign)) {
+    sign = -sign;
+    return true;
+  }
+  return false;
+}
+
+#endif
@@ -0,0 +1,133 @@
+// Minimal std::thread helpers shared by the whole-mesh kernels
+#ifndef CGAL4PY_C_THREADS_HPP
+#define CGAL4PY_C_THREADS_HPP
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+
+
+// Number of worker threads to use for a loop over n items. A non-positive
+// request uses the hardware concurrency. Never more threads than items.
+inline uint32_t choose_nthreads(uint64_t n, int nthreads = 0) {
+  uint32_t nt;
+  if (nthreads > 0)
+    nt = (uint32_t)nthreads;
+  else {
+    nt = std::thread::hardware_concurrency();
+    if (nt == 0) nt = 1;
+  }
+  if ((uint64_t)nt > n)
+    nt = (uint32_t)std::max(n, (uint64_t)1);
+  return nt;
+}
+
+// Call func(start, stop, tid) on contiguous chunks of [0, n), one chunk per
+// thread. The calling thread handles the last chunk itself.
+template <typename Func>
+void parallel_for(uint64_t n, Func func, int nthreads = 0) {
+  uint32_t nt = choose_nthreads(n, nthreads);
+  if (nt <= 1) {
+    func((uint64_t)0, n, (uint32_t)0);
+    return;
+  }
+  uint64_t chunk = n/nt, extra = n%nt, start = 0, stop;
+  std::vector<std::thread> workers;
+  workers.reserve(nt - 1);
+  for (uint32_t t = 0; t < nt; t++) {
+    stop = start + chunk + ((uint64_t)t < extra ? 1 : 0);
+    if (t == (nt - 1))
+      func(start, stop, t);
+    else
+      workers.push_back(std::thread(func, start, stop, t));
+    start = stop;
+  }
+  for (uint32_t t = 0; t < workers.size(); t++)
+    workers[t].join();
+}
+
+// Sort [begin, end) by sorting one chunk per thread and then merging
+// neighbouring chunks in parallel.
+template <typename It, typename Compare>
+void parallel_sort(It begin, It end, Compare cmp, int nthreads = 0) {
+  uint64_t n = (uint64_t)(end - begin);
+  uint32_t nt = choose_nthreads(n, nthreads);
+  if (nt <= 1) {
+    std::sort(begin, end, cmp);
+    return;
+  }
+  std::vector<uint64_t> bounds(nt + 1, 0);
+  for (uint32_t t = 0; t < nt; t++)
+    bounds[t + 1] = bounds[t] + n/nt + ((uint64_t)t < (n%nt) ? 1 : 0);
+  parallel_for(nt, [&](uint64_t start, uint64_t stop, uint32_t) {
+      for (uint64_t t = start; t < stop; t++)
+        std::sort(begin + bounds[t], begin + bounds[t + 1], cmp);
+    }, (int)nt);
+  for (uint64_t width = 1; width < nt; width *= 2) {
+    uint64_t nmerge = (nt + 2*width - 1)/(2*width);
+    parallel_for(nmerge, [&](uint64_t start, uint64_t stop, uint32_t) {
+        for (uint64_t m = start; m < stop; m++) {
+          uint64_t lo = 2*width*m;
+          uint64_t mid = std::min(lo + width, (uint64_t)nt);
+          uint64_t hi = std::min(lo + 2*width, (uint64_t)nt);
+          if (mid < hi)
+            std::inplace_merge(begin + bounds[lo], begin + bounds[mid],
+                               begin + bounds[hi], cmp);
+        }
+      }, (int)nmerge);
+  }
+}
+
+// Group items [0, nitems) by row into CSR arrays with a counting sort. Item
+// i is listed in row r for each slot k < nper where rows(i, k, r) returns
+// true. All threads count into and then scatter through one array of atomic
+// row counters, so the extra memory is one counter per row whatever the
+// number of threads. Each row is sorted afterwards so that its items are in
+// increasing order.
+template <typename Id, typename Rows>
+void parallel_csr(uint64_t nitems, uint64_t nrows, uint32_t nper, Rows rows,
+                  std::vector<uint64_t> &indptr, std::vector<Id> &ids,
+                  int nthreads = 0) {
+  uint32_t nt = choose_nthreads(nitems, nthreads);
+  std::unique_ptr<std::atomic<uint64_t>[]> fill(new std::atomic<uint64_t>[nrows]);
+  parallel_for(nrows, [&](uint64_t start, uint64_t stop, uint32_t) {
+      for (uint64_t r = start; r < stop; r++)
+        fill[r].store(0, std::memory_order_relaxed);
+    }, nthreads);
+  parallel_for(nitems, [&](uint64_t start, uint64_t stop, uint32_t) {
+      uint64_t r;
+      for (uint64_t i = start; i < stop; i++) {
+        for (uint32_t k = 0; k < nper; k++) {
+          if (rows(i, k, r))
+            fill[r].fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+    }, (int)nt);
+  indptr.assign(nrows + 1, 0);
+  for (uint64_t r = 0; r < nrows; r++)
+    indptr[r + 1] = indptr[r] + fill[r].load(std::memory_order_relaxed);
+  // Counters become the next free position in each row
+  parallel_for(nrows, [&](uint64_t start, uint64_t stop, uint32_t) {
+      for (uint64_t r = start; r < stop; r++)
+        fill[r].store(indptr[r], std::memory_order_relaxed);
+    }, nthreads);
+  ids.resize(indptr[nrows]);
+  parallel_for(nitems, [&](uint64_t start, uint64_t stop, uint32_t) {
+      uint64_t r;
+      for (uint64_t i = start; i < stop; i++) {
+        for (uint32_t k = 0; k < nper; k++) {
+          if (rows(i, k, r))
+            ids[fill[r].fetch_add(1, std::memory_order_relaxed)] = (Id)i;
+        }
+      }
+    }, (int)nt);
+  parallel_for(nrows, [&](uint64_t start, uint64_t stop, uint32_t) {
+      for (uint64_t r = start; r < stop; r++)
+        std::sort(ids.begin() + indptr[r], ids.begin() + indptr[r + 1]);
+    }, nthreads);
+}
+
+#endif
@@ -3,10 +3,19 @@
 #include <array>
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
 #include <iostream>
 #include <fstream>
 #include <stdint.h>
 #include <exception>
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <functional>
+#include "c_threads.hpp"
+#include "c_predicates.hpp"
 
 bool intersect_sph_box(uint32_t ndim, double *c, double r, double *le, double *re) {
   uint32_t i;
@@ -373,6 +382,53 @@ public:
   }
 };
 
+template <typename I>
+struct CellKeyHash
+{
+  std::size_t operator()(const std::vector<I> &key) const {
+    uint64_t h = 1469598103934665603ULL;
+    for (std::size_t i = 0; i < key.size(); i++) {
+      h ^= (uint64_t)(key[i]);
+      h *= 1099511628211ULL;
+    }
+    return (std::size_t)h;
+  }
+};
+
+// Map from sorted cell vertices to the (leaf, cell) that first contained
+// them, split into independently locked shards so that many threads can
+// insert at once. "First" is the smallest (leaf, cell) pair so that the
+// result does not depend on the order of insertion.
+template <typename I>
+class ConcurrentCellMap
+{
+public:
+  typedef std::pair<uint64_t, uint64_t> value_type;
+  typedef std::unordered_map<std::vector<I>, value_type, CellKeyHash<I> > shard_type;
+  uint32_t nshards;
+  std::vector<shard_type> shards;
+  std::vector<std::mutex> locks;
+  ConcurrentCellMap(uint32_t _nshards = 64) : nshards(_nshards),
+    shards(_nshards), locks(_nshards) {}
+  uint32_t shard(const std::vector<I> &key) const {
+    return (uint32_t)((CellKeyHash<I>()(key) >> 17) % nshards);
+  }
+  void insert_min(const std::vector<I> &key, value_type val) {
+    uint32_t s = shard(key);
+    std::lock_guard<std::mutex> lock(locks[s]);
+    typename shard_type::iterator it = shards[s].find(key);
+    if (it == shards[s].end())
+      shards[s].insert(std::make_pair(key, val));
+    else if (val < it->second)
+      it->second = val;
+  }
+  // Only safe once all insertions are complete
+  value_type find(const std::vector<I> &key) const {
+    uint32_t s = shard(key);
+    return shards[s].find(key)->second;
+  }
+};
+
 std::size_t findtype_SerializedLeaf(const char* filename) {
   std::ifstream os(filename, std::ios::binary);
   if (!os) std::cerr << "Error cannot open file: " << filename << std::endl;
@@ -689,6 +745,173 @@ public:
     }
   }
 
+  // Add many leaves at once using threads. Gives the same result as calling
+  // add_leaf on each leaf in order. Returns the number of neighbors that
+  // conflicted with ones already set, which is zero for consistent leaves.
+  template <typename leafI>
+  uint64_t add_leaves(std::vector<SerializedLeaf<leafI> > &leaves,
+                      int nthreads = 0) {
+    enum { SKIP, INTERIOR, SPLIT, NEW_SPLIT, DUP_SPLIT };
+    uint64_t nleaves = leaves.size(), l, ntot;
+    uint32_t nv = ndim + 1;
+    std::vector<uint64_t> cell_off(nleaves + 1, 0);
+    for (l = 0; l < nleaves; l++)
+      cell_off[l + 1] = cell_off[l] + (uint64_t)(leaves[l].ncells);
+    ntot = cell_off[nleaves];
+    if (ntot == 0)
+      return 0;
+    std::vector<int8_t> kind(ntot, SKIP);
+    ConcurrentCellMap<I> cmap;
+    // Call func(l, i, g) for leaf l, cell i, & global cell g in [start, stop)
+    auto for_cells = [&](uint64_t start, uint64_t stop,
+                         std::function<void(uint64_t, leafI, uint64_t)> func) {
+      uint64_t ll = (uint64_t)(std::upper_bound(cell_off.begin(), cell_off.end(),
+                                                start) - cell_off.begin()) - 1;
+      for (uint64_t g = start; g < stop; g++) {
+        while (g >= cell_off[ll + 1])
+          ll++;
+        func(ll, (leafI)(g - cell_off[ll]), g);
+      }
+    };
+    auto cell_key = [&](uint64_t ll, leafI i, std::vector<I> &key) {
+      leafI *verts = leaves[ll].verts + i*nv;
+      uint32_t *sort_verts = leaves[ll].sort_verts + i*nv;
+      for (uint32_t j = 0; j < nv; j++)
+        key[j] = (I)(verts[sort_verts[j]]);
+    };
+    // Classify cells & register split cells
+    parallel_for(ntot, [&](uint64_t start, uint64_t stop, uint32_t) {
+        std::vector<I> key(nv);
+        for_cells(start, stop, [&](uint64_t ll, leafI i, uint64_t g) {
+            SerializedLeaf<leafI> &leaf = leaves[ll];
+            if (leaf.visited[i] != -1)
+              return;
+            leafI *verts = leaf.verts + i*nv;
+            uint32_t *sort_verts = leaf.sort_verts + i*nv;
+            leafI vmax = verts[sort_verts[0]];
+            leafI vmin = verts[sort_verts[ndim]];
+            if (vmax == leaf.idx_inf)
+              vmax = verts[sort_verts[1]];
+            if ((vmin >= leaf.idx_start) and (vmax < leaf.idx_stop)) {
+              kind[g] = INTERIOR;
+              return;
+            }
+            cell_key(ll, i, key);
+            typename std::map<std::vector<I>, uint64_t>::const_iterator it;
+            it = split_map._m.find(key);
+            if (it != split_map._m.end()) {
+              leaf.visited[i] = (int64_t)(it->second);
+              return;
+            }
+            kind[g] = SPLIT;
+            cmap.insert_min(key, std::make_pair(ll, (uint64_t)i));
+          });
+      }, nthreads);
+    // Keep only the first copy of each split cell
+    parallel_for(ntot, [&](uint64_t start, uint64_t stop, uint32_t) {
+        std::vector<I> key(nv);
+        for_cells(start, stop, [&](uint64_t ll, leafI i, uint64_t g) {
+            if (kind[g] != SPLIT)
+              return;
+            cell_key(ll, i, key);
+            if (cmap.find(key) == std::make_pair(ll, (uint64_t)i))
+              kind[g] = NEW_SPLIT;
+            else
+              kind[g] = DUP_SPLIT;
+          });
+      }, nthreads);
+    // Offsets of new cells from a prefix sum over fixed chunks
+    uint32_t nt = choose_nthreads(ntot, nthreads);
+    std::vector<uint64_t> chunk(nt + 1, 0), nnew(nt + 1, 0);
+    for (uint32_t t = 0; t < nt; t++)
+      chunk[t + 1] = chunk[t] + ntot/nt + ((uint64_t)t < (ntot%nt) ? 1 : 0);
+    parallel_for(nt, [&](uint64_t start, uint64_t stop, uint32_t) {
+        for (uint64_t t = start; t < stop; t++) {
+          for (uint64_t g = chunk[t]; g < chunk[t + 1]; g++) {
+            if ((kind[g] == INTERIOR) || (kind[g] == NEW_SPLIT))
+              nnew[t + 1]++;
+          }
+        }
+      }, (int)nt);
+    for (uint32_t t = 0; t < nt; t++)
+      nnew[t + 1] += nnew[t];
+    if ((ncells + (int64_t)(nnew[nt])) > max_ncells) {
+      printf("Adding leaves (%ld new cells) will exceed maximum (%ld).\n",
+             (int64_t)(nnew[nt]), max_ncells);
+      return 0;
+    }
+    parallel_for(nt, [&](uint64_t start, uint64_t stop, uint32_t) {
+        for (uint64_t t = start; t < stop; t++) {
+          int64_t idx = ncells + (int64_t)(nnew[t]);
+          for_cells(chunk[t], chunk[t + 1], [&](uint64_t ll, leafI i, uint64_t g) {
+              if ((kind[g] != INTERIOR) && (kind[g] != NEW_SPLIT))
+                return;
+              leafI *verts = leaves[ll].verts + i*nv;
+              for (uint32_t j = 0; j < nv; j++)
+                allverts[idx*nv + j] = (I)(verts[j]);
+              leaves[ll].visited[i] = idx;
+              idx++;
+            });
+        }
+      }, (int)nt);
+    ncells += (int64_t)(nnew[nt]);
+    // Duplicate split cells point to the first copy
+    parallel_for(ntot, [&](uint64_t start, uint64_t stop, uint32_t) {
+        std::vector<I> key(nv);
+        for_cells(start, stop, [&](uint64_t ll, leafI i, uint64_t g) {
+            if (kind[g] != DUP_SPLIT)
+              return;
+            cell_key(ll, i, key);
+            typename ConcurrentCellMap<I>::value_type first = cmap.find(key);
+            leaves[ll].visited[i] = leaves[first.first].visited[first.second];
+          });
+      }, nthreads);
+    // Wire neighbors, each cell setting its own slots
+    std::atomic<uint64_t> nconflict(0);
+    parallel_for(ntot, [&](uint64_t start, uint64_t stop, uint32_t) {
+        for_cells(start, stop, [&](uint64_t ll, leafI i, uint64_t) {
+            SerializedLeaf<leafI> &leaf = leaves[ll];
+            int64_t c_total = leaf.visited[i], c_other;
+            if (c_total < 0)
+              return;
+            leafI *verts = leaf.verts + i*nv;
+            leafI *neigh = leaf.neigh + i*nv;
+            uint32_t n_local, n_total;
+            I v, c_exist;
+            for (n_local = 0; n_local < nv; n_local++) {
+              if (neigh[n_local] == leaf.idx_inf)
+                continue;
+              c_other = leaf.visited[neigh[n_local]];
+              if (c_other < 0)
+                continue;
+              if (verts[n_local] == leaf.idx_inf)
+                v = idx_inf;
+              else
+                v = (I)(verts[n_local]);
+              for (n_total = 0; n_total < nv; n_total++) {
+                if (allverts[c_total*nv + n_total] == v)
+                  break;
+              }
+              if (n_total == nv)
+                continue;
+              c_exist = __sync_val_compare_and_swap(allneigh + c_total*nv + n_total,
+                                                    idx_inf, (I)c_other);
+              if ((c_exist != idx_inf) && (c_exist != (I)c_other))
+                nconflict++;
+            }
+          });
+      }, nthreads);
+    // Record split cells for later calls
+    for (l = 0; l < nleaves; l++) {
+      for (uint64_t i = 0; i < (uint64_t)(leaves[l].ncells); i++) {
+        if (kind[cell_off[l] + i] == NEW_SPLIT)
+          split_map.insert(leaves[l].verts + i*nv, leaves[l].sort_verts + i*nv,
+                           (uint64_t)(leaves[l].visited[i]));
+      }
+    }
+    return (uint64_t)nconflict;
+  }
+
   template <typename leafI>
   int64_t new_cell(leafI *verts) {
     uint32_t j;
@@ -970,3 +1193,1863 @@ public:
   
 };
 
+
+// Uniform grid of points used to find the points near a sphere
+class PointGrid
+{
+public:
+  uint32_t ndim;
+  uint64_t npts;
+  double *pts;
+  std::vector<double> le;
+  std::vector<double> width;
+  std::vector<int64_t> nbin;
+  std::vector<uint64_t> indptr;
+  std::vector<uint64_t> order;
+  PointGrid(uint32_t _ndim, uint64_t _npts, double *_pts) {
+    ndim = _ndim;
+    npts = _npts;
+    pts = _pts;
+    uint32_t d;
+    uint64_t i, b, nbin_tot = 1;
+    std::vector<double> re(ndim, 0.0);
+    le.assign(ndim, 0.0);
+    width.assign(ndim, 1.0);
+    nbin.assign(ndim, 1);
+    if (npts > 0) {
+      for (d = 0; d < ndim; d++) {
+        le[d] = pts[d];
+        re[d] = pts[d];
+      }
+      for (i = 1; i < npts; i++) {
+        for (d = 0; d < ndim; d++) {
+          le[d] = std::min(le[d], pts[ndim*i+d]);
+          re[d] = std::max(re[d], pts[ndim*i+d]);
+        }
+      }
+    }
+    int64_t nper = (int64_t)std::max(1.0, floor(pow((double)npts, 1.0/ndim)));
+    for (d = 0; d < ndim; d++) {
+      nbin[d] = nper;
+      if (re[d] > le[d])
+        width[d] = (re[d] - le[d])/(double)nper;
+      nbin_tot *= (uint64_t)nper;
+    }
+    // Counting sort of points into bins
+    indptr.assign(nbin_tot + 1, 0);
+    order.resize(npts);
+    std::vector<uint64_t> bins(npts);
+    for (i = 0; i < npts; i++) {
+      bins[i] = bin(pts + ndim*i);
+      indptr[bins[i] + 1]++;
+    }
+    for (b = 0; b < nbin_tot; b++)
+      indptr[b + 1] += indptr[b];
+    std::vector<uint64_t> fill(indptr.begin(), indptr.end() - 1);
+    for (i = 0; i < npts; i++)
+      order[fill[bins[i]]++] = i;
+  }
+  int64_t bin_index(uint32_t d, double x) const {
+    int64_t out = (int64_t)floor((x - le[d])/width[d]);
+    return std::min(std::max(out, (int64_t)0), nbin[d] - 1);
+  }
+  uint64_t bin(const double *x) const {
+    uint64_t out = 0;
+    for (uint32_t d = 0; d < ndim; d++)
+      out = out*nbin[d] + bin_index(d, x[d]);
+    return out;
+  }
+  // Call func(i) for every point i in a bin overlapping the sphere's box
+  template <typename Func>
+  void query(const double *c, double r, Func func) const {
+    uint32_t d;
+    uint64_t b, j;
+    std::vector<int64_t> lo(ndim), hi(ndim), cur(ndim);
+    for (d = 0; d < ndim; d++) {
+      lo[d] = bin_index(d, c[d] - r);
+      hi[d] = bin_index(d, c[d] + r);
+      cur[d] = lo[d];
+    }
+    while (true) {
+      b = 0;
+      for (d = 0; d < ndim; d++)
+        b = b*nbin[d] + cur[d];
+      for (j = indptr[b]; j < indptr[b+1]; j++)
+        func(order[j]);
+      for (d = 0; d < ndim; d++) {
+        if (cur[d] < hi[d]) {
+          cur[d]++;
+          break;
+        }
+        cur[d] = lo[d];
+      }
+      if (d == ndim)
+        break;
+    }
+  }
+};
+
+// Codes for the violations reported by validate_tess
+#define TESS_VIOL_VERT_RANGE     1 // vertex index out of range
+#define TESS_VIOL_NEIGH_RANGE    2 // neighbor index out of range
+#define TESS_VIOL_NEIGH_SYMMETRY 3 // neighbor does not point back at the cell
+#define TESS_VIOL_SHARED_FACET   4 // neighbor does not share the facet
+#define TESS_VIOL_ORIENTATION    5 // finite cell is negatively oriented
+#define TESS_VIOL_EMPTY_SPHERE   6 // a point is inside the cell circumsphere
+
+bool circumsphere(uint32_t ndim, double **v, double *c, double &r) {
+  uint32_t d;
+  if (ndim == 2) {
+    double bx = v[1][0] - v[0][0], by = v[1][1] - v[0][1];
+    double cx = v[2][0] - v[0][0], cy = v[2][1] - v[0][1];
+    double den = 2.0*(bx*cy - by*cx);
+    if (den == 0.0)
+      return false;
+    double b2 = bx*bx + by*by, c2 = cx*cx + cy*cy;
+    c[0] = v[0][0] + (cy*b2 - by*c2)/den;
+    c[1] = v[0][1] + (bx*c2 - cx*b2)/den;
+  } else if (ndim == 3) {
+    double b[3], e[3], f[3], ef[3], fb[3], be[3];
+    for (d = 0; d < 3; d++) {
+      b[d] = v[1][d] - v[0][d];
+      e[d] = v[2][d] - v[0][d];
+      f[d] = v[3][d] - v[0][d];
+    }
+    for (d = 0; d < 3; d++) {
+      ef[d] = e[(d+1)%3]*f[(d+2)%3] - e[(d+2)%3]*f[(d+1)%3];
+      fb[d] = f[(d+1)%3]*b[(d+2)%3] - f[(d+2)%3]*b[(d+1)%3];
+      be[d] = b[(d+1)%3]*e[(d+2)%3] - b[(d+2)%3]*e[(d+1)%3];
+    }
+    double den = 2.0*(b[0]*ef[0] + b[1]*ef[1] + b[2]*ef[2]);
+    if (den == 0.0)
+      return false;
+    double b2 = 0, e2 = 0, f2 = 0;
+    for (d = 0; d < 3; d++) {
+      b2 += b[d]*b[d]; e2 += e[d]*e[d]; f2 += f[d]*f[d];
+    }
+    for (d = 0; d < 3; d++)
+      c[d] = v[0][d] + (b2*ef[d] + e2*fb[d] + f2*be[d])/den;
+  } else
+    return false;
+  r = 0.0;
+  for (d = 0; d < ndim; d++)
+    r += (c[d] - v[0][d])*(c[d] - v[0][d]);
+  r = sqrt(r);
+  return true;
+}
+
+// Sign of the orientation of the ndim+1 points in v (2D/3D only)
+bool static_orientation(uint32_t ndim, double **v, int &sign) {
+  if (ndim == 2)
+    return static_orientation_2(v[0], v[1], v[2], sign);
+  else if (ndim == 3)
+    return static_orientation_3(v[0], v[1], v[2], v[3], sign);
+  return false;
+}
+
+// Sign of the in-sphere test for p assuming v is positively oriented
+bool static_side_of_oriented_sphere(uint32_t ndim, double **v, double *p,
+                                    int &sign) {
+  if (ndim == 2)
+    return static_side_of_oriented_circle_2(v[0], v[1], v[2], p, sign);
+  else if (ndim == 3)
+    return static_side_of_oriented_sphere_3(v[0], v[1], v[2], v[3], p, sign);
+  return false;
+}
+
+// Check the connectivity & geometry of a serialized tessellation. ndim is the
+// number of spatial dimensions (2 or 3 for the geometric checks), so cells &
+// neigh have ndim+1 entries per cell. Neighbors equal to idx_inf are treated
+// as missing (e.g. before add_inf). Each violation found is appended to the
+// output vectors as its code, the cell, the facet index (-1 if not specific
+// to a facet), and the other cell/point involved. Geometric checks only
+// report violations whose sign is certain under the static filters.
+template <typename I>
+uint64_t validate_tess(uint32_t ndim, uint64_t npts, double *pts,
+                       uint64_t ncells, I *cells, I *neigh, I idx_inf,
+                       bool check_orientation, bool check_sphere,
+                       std::vector<int8_t> &viol_type,
+                       std::vector<uint64_t> &viol_cell,
+                       std::vector<int32_t> &viol_face,
+                       std::vector<uint64_t> &viol_other,
+                       int nthreads = 0)
+{
+  uint32_t nv = ndim + 1;
+  if ((ndim != 2) && (ndim != 3)) {
+    check_orientation = false;
+    check_sphere = false;
+  }
+  PointGrid *grid = NULL;
+  if (check_sphere)
+    grid = new PointGrid(ndim, npts, pts);
+  uint32_t nt = choose_nthreads(ncells, nthreads);
+  std::vector<std::vector<int8_t> > t_type(nt);
+  std::vector<std::vector<uint64_t> > t_cell(nt), t_other(nt);
+  std::vector<std::vector<int32_t> > t_face(nt);
+  parallel_for(ncells, [&](uint64_t start, uint64_t stop, uint32_t t) {
+      uint64_t c, n;
+      uint32_t i, j, k, m;
+      bool finite, found;
+      int orient, sign;
+      double center[3], r;
+      double *v[4];
+      std::vector<I> verts(nv);
+      for (c = start; c < stop; c++) {
+        finite = true;
+        for (i = 0; i < nv; i++) {
+          verts[i] = cells[c*nv + i];
+          if (verts[i] == idx_inf)
+            finite = false;
+          else if ((uint64_t)(verts[i]) >= npts) {
+            t_type[t].push_back(TESS_VIOL_VERT_RANGE);
+            t_cell[t].push_back(c);
+            t_face[t].push_back((int32_t)i);
+            t_other[t].push_back((uint64_t)(verts[i]));
+            finite = false;
+          }
+        }
+        // Connectivity
+        for (j = 0; j < nv; j++) {
+          if (neigh[c*nv + j] == idx_inf)
+            continue;
+          n = (uint64_t)(neigh[c*nv + j]);
+          if (n >= ncells) {
+            t_type[t].push_back(TESS_VIOL_NEIGH_RANGE);
+            t_cell[t].push_back(c);
+            t_face[t].push_back((int32_t)j);
+            t_other[t].push_back(n);
+            continue;
+          }
+          for (k = 0; k < nv; k++) {
+            if ((uint64_t)(neigh[n*nv + k]) == c)
+              break;
+          }
+          if (k == nv) {
+            t_type[t].push_back(TESS_VIOL_NEIGH_SYMMETRY);
+            t_cell[t].push_back(c);
+            t_face[t].push_back((int32_t)j);
+            t_other[t].push_back(n);
+            continue;
+          }
+          found = true;
+          for (i = 0; (i < nv) && found; i++) {
+            if (i == j)
+              continue;
+            found = false;
+            for (m = 0; m < nv; m++) {
+              if ((m != k) && (cells[n*nv + m] == verts[i])) {
+                found = true;
+                break;
+              }
+            }
+          }
+          if (found && (cells[n*nv + k] == verts[j]))
+            found = false;
+          if (!found) {
+            t_type[t].push_back(TESS_VIOL_SHARED_FACET);
+            t_cell[t].push_back(c);
+            t_face[t].push_back((int32_t)j);
+            t_other[t].push_back(n);
+          }
+        }
+        // Geometry
+        if (!(finite && (check_orientation || check_sphere)))
+          continue;
+        for (i = 0; i < nv; i++)
+          v[i] = pts + ndim*(uint64_t)(verts[i]);
+        if (!static_orientation(ndim, v, orient))
+          continue;
+        if (check_orientation && (orient < 0)) {
+          t_type[t].push_back(TESS_VIOL_ORIENTATION);
+          t_cell[t].push_back(c);
+          t_face[t].push_back(-1);
+          t_other[t].push_back(c);
+        }
+        if (!check_sphere)
+          continue;
+        if (!circumsphere(ndim, v, center, r))
+          continue;
+        r *= (1.0 + 1.0e-8);
+        grid->query(center, r, [&](uint64_t q) {
+            for (i = 0; i < nv; i++) {
+              if ((uint64_t)(verts[i]) == q)
+                return;
+            }
+            if (static_side_of_oriented_sphere(ndim, v, pts + ndim*q, sign) &&
+                ((sign*orient) > 0)) {
+              t_type[t].push_back(TESS_VIOL_EMPTY_SPHERE);
+              t_cell[t].push_back(c);
+              t_face[t].push_back(-1);
+              t_other[t].push_back(q);
+            }
+          });
+      }
+    }, (int)nt);
+  if (grid != NULL)
+    delete grid;
+  for (uint32_t t = 0; t < nt; t++) {
+    viol_type.insert(viol_type.end(), t_type[t].begin(), t_type[t].end());
+    viol_cell.insert(viol_cell.end(), t_cell[t].begin(), t_cell[t].end());
+    viol_face.insert(viol_face.end(), t_face[t].begin(), t_face[t].end());
+    viol_other.insert(viol_other.end(), t_other[t].begin(), t_other[t].end());
+  }
+  return (uint64_t)(viol_type.size());
+}
+
+// Position of each point along a Hilbert curve through the box [le, re]
+// (Skilling's transpose algorithm). Keys use floor(64/ndim) bits per
+// dimension.
+void hilbert_keys(uint32_t ndim, uint64_t npts, double *pts,
+                  double *le, double *re, uint64_t *keys, int nthreads = 0) {
+  uint32_t nbits = std::min((uint32_t)(64/std::max(ndim, (uint32_t)1)),
+                            (uint32_t)32);
+  double maxval = ldexp(1.0, nbits) - 1.0;
+  parallel_for(npts, [&](uint64_t start, uint64_t stop, uint32_t) {
+      std::vector<uint64_t> X(ndim);
+      uint64_t i, M, P, Q, t, key;
+      uint32_t d;
+      int b;
+      double x;
+      M = ((uint64_t)1) << (nbits - 1);
+      for (i = start; i < stop; i++) {
+        for (d = 0; d < ndim; d++) {
+          x = 0.0;
+          if (re[d] > le[d])
+            x = (pts[ndim*i + d] - le[d])/(re[d] - le[d]);
+          x = std::min(std::max(x, 0.0), 1.0);
+          X[d] = (uint64_t)(x*maxval);
+        }
+        // Inverse undo
+        for (Q = M; Q > 1; Q >>= 1) {
+          P = Q - 1;
+          for (d = 0; d < ndim; d++) {
+            if (X[d] & Q)
+              X[0] ^= P;
+            else {
+              t = (X[0] ^ X[d]) & P;
+              X[0] ^= t;
+              X[d] ^= t;
+            }
+          }
+        }
+        // Gray encode
+        for (d = 1; d < ndim; d++)
+          X[d] ^= X[d-1];
+        t = 0;
+        for (Q = M; Q > 1; Q >>= 1) {
+          if (X[ndim-1] & Q)
+            t ^= Q - 1;
+        }
+        for (d = 0; d < ndim; d++)
+          X[d] ^= t;
+        // Interleave the transposed bits
+        key = 0;
+        for (b = (int)nbits - 1; b >= 0; b--) {
+          for (d = 0; d < ndim; d++)
+            key = (key << 1) | ((X[d] >> b) & 1);
+        }
+        keys[i] = key;
+      }
+    }, nthreads);
+}
+
+// Order (new -> old) of the n items with the given keys, ties broken by the
+// original index.
+void argsort_keys(uint64_t n, uint64_t *keys, uint64_t *order,
+                  int nthreads = 0) {
+  for (uint64_t i = 0; i < n; i++)
+    order[i] = i;
+  parallel_sort(order, order + n, [keys](uint64_t a, uint64_t b) {
+      return (keys[a] < keys[b]) || ((keys[a] == keys[b]) && (a < b));
+    }, nthreads);
+}
+
+// Hilbert curve order for the vertices and cells of a serialized
+// tessellation. Cells are placed by the centroid of their finite vertices.
+template <typename I>
+void hilbert_order_tess(uint32_t ndim, uint64_t npts, double *pts,
+                        uint64_t ncells, I *cells, I idx_inf,
+                        uint64_t *vert_order, uint64_t *cell_order,
+                        int nthreads = 0) {
+  uint32_t d, nv = ndim + 1;
+  uint64_t i;
+  std::vector<double> le(ndim, 0.0), re(ndim, 0.0);
+  if (npts > 0) {
+    for (d = 0; d < ndim; d++)
+      le[d] = re[d] = pts[d];
+    for (i = 1; i < npts; i++) {
+      for (d = 0; d < ndim; d++) {
+        le[d] = std::min(le[d], pts[ndim*i + d]);
+        re[d] = std::max(re[d], pts[ndim*i + d]);
+      }
+    }
+  }
+  std::vector<uint64_t> keys(std::max(npts, ncells));
+  hilbert_keys(ndim, npts, pts, &le[0], &re[0], &keys[0], nthreads);
+  argsort_keys(npts, &keys[0], vert_order, nthreads);
+  std::vector<double> cen(ndim*ncells, 0.0);
+  parallel_for(ncells, [&](uint64_t start, uint64_t stop, uint32_t) {
+      uint64_t c;
+      uint32_t j, dd, nfin;
+      for (c = start; c < stop; c++) {
+        nfin = 0;
+        for (j = 0; j < nv; j++) {
+          if (cells[c*nv + j] == idx_inf)
+            continue;
+          for (dd = 0; dd < ndim; dd++)
+            cen[ndim*c + dd] += pts[ndim*(uint64_t)(cells[c*nv + j]) + dd];
+          nfin++;
+        }
+        for (dd = 0; dd < ndim; dd++)
+          cen[ndim*c + dd] /= (double)std::max(nfin, (uint32_t)1);
+      }
+    }, nthreads);
+  if (ncells > 0) {
+    hilbert_keys(ndim, ncells, &cen[0], &le[0], &re[0], &keys[0], nthreads);
+    argsort_keys(ncells, &keys[0], cell_order, nthreads);
+  }
+}
+
+// Reverse Cuthill-McKee order for the cells of a serialized tessellation
+// using the neighbor adjacency. Vertices are then numbered in the order
+// that they are first referenced by the reordered cells.
+template <typename I>
+void rcm_order_tess(uint32_t ndim, uint64_t npts, uint64_t ncells,
+                    I *cells, I *neigh, I idx_inf,
+                    uint64_t *vert_order, uint64_t *cell_order) {
+  uint32_t j, nv = ndim + 1;
+  uint64_t c, n, i, k, head, nout = 0;
+  std::vector<uint32_t> degree(ncells, 0);
+  std::vector<bool> visited(ncells, false);
+  std::vector<uint64_t> nbrs;
+  for (c = 0; c < ncells; c++) {
+    for (j = 0; j < nv; j++) {
+      if ((neigh[c*nv + j] != idx_inf) && ((uint64_t)(neigh[c*nv + j]) < ncells))
+        degree[c]++;
+    }
+  }
+  std::vector<uint64_t> by_degree(ncells);
+  for (c = 0; c < ncells; c++)
+    by_degree[c] = c;
+  std::stable_sort(by_degree.begin(), by_degree.end(),
+                   [&degree](uint64_t a, uint64_t b) {
+                     return degree[a] < degree[b]; });
+  for (i = 0; i < ncells; i++) {
+    if (visited[by_degree[i]])
+      continue;
+    // Breadth first search from the lowest degree unvisited cell
+    head = nout;
+    cell_order[nout++] = by_degree[i];
+    visited[by_degree[i]] = true;
+    while (head < nout) {
+      c = cell_order[head++];
+      nbrs.clear();
+      for (j = 0; j < nv; j++) {
+        if (neigh[c*nv + j] == idx_inf)
+          continue;
+        n = (uint64_t)(neigh[c*nv + j]);
+        if ((n < ncells) && (!visited[n])) {
+          visited[n] = true;
+          nbrs.push_back(n);
+        }
+      }
+      std::stable_sort(nbrs.begin(), nbrs.end(),
+                       [&degree](uint64_t a, uint64_t b) {
+                         return degree[a] < degree[b]; });
+      for (k = 0; k < nbrs.size(); k++)
+        cell_order[nout++] = nbrs[k];
+    }
+  }
+  std::reverse(cell_order, cell_order + ncells);
+  // Vertices by first use
+  std::vector<bool> used(npts, false);
+  nout = 0;
+  for (i = 0; i < ncells; i++) {
+    c = cell_order[i];
+    for (j = 0; j < nv; j++) {
+      if (cells[c*nv + j] == idx_inf)
+        continue;
+      n = (uint64_t)(cells[c*nv + j]);
+      if ((n < npts) && (!used[n])) {
+        used[n] = true;
+        vert_order[nout++] = n;
+      }
+    }
+  }
+  for (n = 0; n < npts; n++) {
+    if (!used[n])
+      vert_order[nout++] = n;
+  }
+}
+
+// Apply vertex & cell orders (new -> old) to a serialized tessellation,
+// writing the renumbered points, cells, and neighbors to the new_ arrays.
+// References to idx_inf are preserved.
+template <typename I>
+void renumber_tess(uint32_t ndim, uint64_t npts, double *pts,
+                   uint64_t ncells, I *cells, I *neigh, I idx_inf,
+                   uint64_t *vert_order, uint64_t *cell_order,
+                   double *new_pts, I *new_cells, I *new_neigh,
+                   int nthreads = 0) {
+  uint32_t nv = ndim + 1;
+  std::vector<I> vert_inv(npts), cell_inv(ncells);
+  parallel_for(std::max(npts, ncells), [&](uint64_t start, uint64_t stop, uint32_t) {
+      uint64_t i;
+      uint32_t d;
+      for (i = start; i < stop; i++) {
+        if (i < npts) {
+          vert_inv[vert_order[i]] = (I)i;
+          for (d = 0; d < ndim; d++)
+            new_pts[ndim*i + d] = pts[ndim*vert_order[i] + d];
+        }
+        if (i < ncells)
+          cell_inv[cell_order[i]] = (I)i;
+      }
+    }, nthreads);
+  parallel_for(ncells, [&](uint64_t start, uint64_t stop, uint32_t) {
+      uint64_t c, old;
+      uint32_t j;
+      I x;
+      for (c = start; c < stop; c++) {
+        old = cell_order[c];
+        for (j = 0; j < nv; j++) {
+          x = cells[old*nv + j];
+          new_cells[c*nv + j] = (x == idx_inf) ? idx_inf : vert_inv[(uint64_t)x];
+          x = neigh[old*nv + j];
+          new_neigh[c*nv + j] = (x == idx_inf) ? idx_inf : cell_inv[(uint64_t)x];
+        }
+      }
+    }, nthreads);
+}
+
+// Quality metrics for every cell of a serialized 2D/3D tessellation: the
+// minimum interior (2D) or dihedral (3D) angle in radians, the ratio of the
+// circumradius to the shortest edge, and the area/volume. Cells containing
+// idx_inf get NaN for all metrics.
+template <typename I>
+void cell_quality(uint32_t ndim, double *pts, uint64_t ncells, I *cells,
+                  I idx_inf, double *min_angle, double *radius_edge,
+                  double *volume, int nthreads = 0) {
+  uint32_t nv = ndim + 1;
+  double nan = std::numeric_limits<double>::quiet_NaN();
+  double inf = std::numeric_limits<double>::infinity();
+  parallel_for(ncells, [&](uint64_t start, uint64_t stop, uint32_t) {
+      uint64_t c;
+      uint32_t i, j, k, d;
+      bool finite;
+      double p[4][3], n[4][3], nn[4], u[3], w[3];
+      double *v[4] = {p[0], p[1], p[2], p[3]};
+      double center[3], R, lmin2, l2, cosmax, cosx, vol;
+      for (c = start; c < stop; c++) {
+        finite = ((ndim == 2) || (ndim == 3));
+        for (i = 0; (i < nv) && finite; i++) {
+          if (cells[c*nv + i] == idx_inf)
+            finite = false;
+          else {
+            for (d = 0; d < ndim; d++)
+              p[i][d] = pts[ndim*(uint64_t)(cells[c*nv + i]) + d];
+          }
+        }
+        if (!finite) {
+          min_angle[c] = nan;
+          radius_edge[c] = nan;
+          volume[c] = nan;
+          continue;
+        }
+        // Shortest edge
+        lmin2 = inf;
+        for (i = 0; i < nv; i++) {
+          for (j = i + 1; j < nv; j++) {
+            l2 = 0.0;
+            for (d = 0; d < ndim; d++)
+              l2 += (p[j][d] - p[i][d])*(p[j][d] - p[i][d]);
+            lmin2 = std::min(lmin2, l2);
+          }
+        }
+        cosmax = -1.0;
+        if (ndim == 2) {
+          for (i = 0; i < 3; i++) {
+            j = (i + 1)%3;
+            k = (i + 2)%3;
+            for (d = 0; d < 2; d++) {
+              u[d] = p[j][d] - p[i][d];
+              w[d] = p[k][d] - p[i][d];
+            }
+            cosx = (u[0]*w[0] + u[1]*w[1])/
+              sqrt((u[0]*u[0] + u[1]*u[1])*(w[0]*w[0] + w[1]*w[1]));
+            cosmax = std::max(cosmax, cosx);
+          }
+          vol = fabs((p[1][0] - p[0][0])*(p[2][1] - p[0][1]) -
+                     (p[1][1] - p[0][1])*(p[2][0] - p[0][0]))/2.0;
+        } else {
+          // Outward facing normal for the face opposite each vertex
+          for (i = 0; i < 4; i++) {
+            uint32_t a = (i + 1)%4, b = (i + 2)%4, e = (i + 3)%4;
+            for (d = 0; d < 3; d++) {
+              u[d] = p[b][d] - p[a][d];
+              w[d] = p[e][d] - p[a][d];
+            }
+            n[i][0] = u[1]*w[2] - u[2]*w[1];
+            n[i][1] = u[2]*w[0] - u[0]*w[2];
+            n[i][2] = u[0]*w[1] - u[1]*w[0];
+            if ((n[i][0]*(p[i][0] - p[a][0]) + n[i][1]*(p[i][1] - p[a][1]) +
+                 n[i][2]*(p[i][2] - p[a][2])) > 0) {
+              for (d = 0; d < 3; d++)
+                n[i][d] = -n[i][d];
+            }
+            nn[i] = sqrt(n[i][0]*n[i][0] + n[i][1]*n[i][1] + n[i][2]*n[i][2]);
+          }
+          for (i = 0; i < 4; i++) {
+            for (j = i + 1; j < 4; j++) {
+              cosx = -(n[i][0]*n[j][0] + n[i][1]*n[j][1] + n[i][2]*n[j][2])/
+                (nn[i]*nn[j]);
+              cosmax = std::max(cosmax, cosx);
+            }
+          }
+          for (d = 0; d < 3; d++)
+            u[d] = p[1][d] - p[0][d];
+          vol = fabs(u[0]*n[1][0] + u[1]*n[1][1] + u[2]*n[1][2])/6.0;
+        }
+        if (cosmax != cosmax)
+          min_angle[c] = 0.0;
+        else
+          min_angle[c] = acos(std::min(std::max(cosmax, -1.0), 1.0));
+        volume[c] = vol;
+        if ((lmin2 > 0) && circumsphere(ndim, v, center, R))
+          radius_edge[c] = R/sqrt(lmin2);
+        else
+          radius_edge[c] = inf;
+      }
+    }, nthreads);
+}
+
+
+// Tolerance used when comparing leaf edges (the same as numpy.isclose)
+inline bool edges_close(double a, double b) {
+  return fabs(a - b) <= (1.0e-8 + 1.0e-5*fabs(b));
+}
+
+// Squared distance from a point to a box (zero if the point is inside it)
+inline double box_dist2(uint32_t ndim, const double *pt,
+                        const double *le, const double *re) {
+  double d, out = 0;
+  for (uint32_t k = 0; k < ndim; k++) {
+    if (pt[k] < le[k])
+      d = le[k] - pt[k];
+    else if (pt[k] > re[k])
+      d = pt[k] - re[k];
+    else
+      continue;
+    out += d*d;
+  }
+  return out;
+}
+
+// True if two boxes overlap or touch
+inline bool boxes_touch(uint32_t ndim, const double *le1, const double *re1,
+                        const double *le2, const double *re2) {
+  for (uint32_t k = 0; k < ndim; k++) {
+    if ((le2[k] > re1[k]) && !edges_close(le2[k], re1[k]))
+      return false;
+    if ((le1[k] > re2[k]) && !edges_close(le1[k], re2[k]))
+      return false;
+  }
+  return true;
+}
+
+// Face adjacency between the leaves of a domain decomposition, including
+// neighbors across periodic boundaries. Faces are sorted along each
+// dimension so that only leaves whose faces lie on the same split plane are
+// compared. Neighbors are stored in CSR format with one row per leaf and
+// dimension (row = leaf*ndim + d), e.g. the leaves touching the left face of
+// leaf i in dimension d are
+// left_ids[left_indptr[i*ndim+d]:left_indptr[i*ndim+d+1]].
+class LeafAdjacency
+{
+public:
+  uint64_t nleaves;
+  uint32_t ndim;
+  std::vector<uint8_t> periodic_left;
+  std::vector<uint8_t> periodic_right;
+  std::vector<uint64_t> left_indptr;
+  std::vector<uint32_t> left_ids;
+  std::vector<uint64_t> right_indptr;
+  std::vector<uint32_t> right_ids;
+
+  LeafAdjacency() : nleaves(0), ndim(0) {}
+  LeafAdjacency(uint64_t _nleaves, uint32_t _ndim,
+                const double *le, const double *re,
+                const double *domain_le, const double *domain_re,
+                const bool *periodic) {
+    nleaves = _nleaves;
+    ndim = _ndim;
+    uint64_t i, j, a, b, nrow = nleaves*ndim;
+    uint32_t d, e;
+    periodic_left.assign(nrow, 0);
+    periodic_right.assign(nrow, 0);
+    for (i = 0; i < nleaves; i++) {
+      for (d = 0; d < ndim; d++) {
+        if (periodic[d]) {
+          periodic_left[i*ndim+d] = edges_close(le[i*ndim+d], domain_le[d]);
+          periodic_right[i*ndim+d] = edges_close(re[i*ndim+d], domain_re[d]);
+        }
+      }
+    }
+    // Leaf a is left of leaf b in dimension d
+    std::vector<std::pair<uint64_t, uint32_t> > lpairs, rpairs;
+    std::vector<std::pair<double, int64_t> > faces(2*nleaves);
+    std::vector<uint64_t> rfaces, lfaces;
+    for (d = 0; d < ndim; d++) {
+      // Right faces (stored as ~i) on the domain edge wrap to the left edge
+      for (i = 0; i < nleaves; i++) {
+        faces[2*i].first = le[i*ndim+d];
+        faces[2*i].second = (int64_t)i;
+        if (periodic_right[i*ndim+d])
+          faces[2*i+1].first = domain_le[d];
+        else
+          faces[2*i+1].first = re[i*ndim+d];
+        faces[2*i+1].second = ~(int64_t)i;
+      }
+      std::sort(faces.begin(), faces.end());
+      i = 0;
+      while (i < faces.size()) {
+        j = i;
+        rfaces.clear();
+        lfaces.clear();
+        while ((j < faces.size()) &&
+               edges_close(faces[j].first, faces[i].first)) {
+          if (faces[j].second < 0)
+            rfaces.push_back((uint64_t)(~faces[j].second));
+          else
+            lfaces.push_back((uint64_t)(faces[j].second));
+          j++;
+        }
+        for (uint64_t ra = 0; ra < rfaces.size(); ra++) {
+          a = rfaces[ra];
+          for (uint64_t lb = 0; lb < lfaces.size(); lb++) {
+            b = lfaces[lb];
+            bool touch = true;
+            for (e = 0; e < ndim; e++) {
+              if (e == d)
+                continue;
+              if (touching(a, b, e, le, re))
+                continue;
+              touch = false;
+              break;
+            }
+            if (touch) {
+              rpairs.push_back(std::make_pair(a*ndim+d, (uint32_t)b));
+              lpairs.push_back(std::make_pair(b*ndim+d, (uint32_t)a));
+            }
+          }
+        }
+        i = j;
+      }
+    }
+    to_csr(nrow, lpairs, left_indptr, left_ids);
+    to_csr(nrow, rpairs, right_indptr, right_ids);
+  }
+
+  // Extents of leaves a & b overlap or touch in dimension e, possibly
+  // across a periodic boundary
+  bool touching(uint64_t a, uint64_t b, uint32_t e,
+                const double *le, const double *re) const {
+    uint64_t ia = a*ndim+e, ib = b*ndim+e;
+    if (((le[ia] <= re[ib]) || edges_close(le[ia], re[ib])) &&
+        ((le[ib] <= re[ia]) || edges_close(le[ib], re[ia])))
+      return true;
+    if (periodic_right[ia] && periodic_left[ib])
+      return true;
+    if (periodic_left[ia] && periodic_right[ib])
+      return true;
+    return false;
+  }
+
+  // Leaves whose boxes overlap or touch, e.g. the overlapping chunks of a
+  // curve decomposition, as CSR lists with one row per leaf. Boxes are swept
+  // in order of their left edge in the first dimension so that only boxes
+  // overlapping there are compared. Empty (inverted) boxes have no
+  // neighbors.
+  static void overlapping(uint64_t nleaves, uint32_t ndim,
+                          const double *le, const double *re,
+                          std::vector<uint64_t> &indptr,
+                          std::vector<uint32_t> &ids) {
+    std::vector<std::pair<uint64_t, uint32_t> > pairs;
+    std::vector<uint64_t> order;
+    uint64_t i, j, a, b;
+    uint32_t d;
+    for (i = 0; i < nleaves; i++) {
+      bool empty = false;
+      for (d = 0; d < ndim; d++) {
+        if (le[i*ndim+d] > re[i*ndim+d])
+          empty = true;
+      }
+      if (!empty)
+        order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [le, ndim](uint64_t x, uint64_t y) {
+        return le[x*ndim] < le[y*ndim]; });
+    for (i = 0; i < order.size(); i++) {
+      a = order[i];
+      for (j = i + 1; j < order.size(); j++) {
+        b = order[j];
+        if ((le[b*ndim] > re[a*ndim]) && !edges_close(le[b*ndim], re[a*ndim]))
+          break;
+        if (boxes_touch(ndim, le + a*ndim, re + a*ndim,
+                        le + b*ndim, re + b*ndim)) {
+          pairs.push_back(std::make_pair(a, (uint32_t)b));
+          pairs.push_back(std::make_pair(b, (uint32_t)a));
+        }
+      }
+    }
+    to_csr(nleaves, pairs, indptr, ids);
+  }
+
+  static void to_csr(uint64_t nrow,
+                     std::vector<std::pair<uint64_t, uint32_t> > &pairs,
+                     std::vector<uint64_t> &indptr,
+                     std::vector<uint32_t> &ids) {
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    indptr.assign(nrow + 1, 0);
+    ids.resize(pairs.size());
+    for (uint64_t k = 0; k < pairs.size(); k++) {
+      indptr[pairs[k].first + 1]++;
+      ids[k] = pairs[k].second;
+    }
+    for (uint64_t k = 0; k < nrow; k++)
+      indptr[k + 1] += indptr[k];
+  }
+
+  uint64_t num_left(uint64_t leaf, uint32_t d) const {
+    return left_indptr[leaf*ndim+d+1] - left_indptr[leaf*ndim+d];
+  }
+  const uint32_t* left(uint64_t leaf, uint32_t d) const {
+    return left_ids.data() + left_indptr[leaf*ndim+d];
+  }
+  uint64_t num_right(uint64_t leaf, uint32_t d) const {
+    return right_indptr[leaf*ndim+d+1] - right_indptr[leaf*ndim+d];
+  }
+  const uint32_t* right(uint64_t leaf, uint32_t d) const {
+    return right_ids.data() + right_indptr[leaf*ndim+d];
+  }
+};
+
+// Leaves a & b are split from one box along a single dimension, so their
+// union is a box
+inline bool leaves_form_box(uint32_t ndim, const double *le, const double *re,
+                            uint64_t a, uint64_t b) {
+  uint32_t d, nsplit = 0;
+  for (d = 0; d < ndim; d++) {
+    if (edges_close(le[a*ndim+d], le[b*ndim+d]) &&
+        edges_close(re[a*ndim+d], re[b*ndim+d]))
+      continue;
+    if (edges_close(re[a*ndim+d], le[b*ndim+d]) ||
+        edges_close(re[b*ndim+d], le[a*ndim+d]))
+      nsplit++;
+    else
+      return false;
+  }
+  return (nsplit == 1);
+}
+
+// Merge leaves with fewer than min_npts points into a neighbor in a depth
+// first decomposition where leaf i owns the points
+// [leaf_start[i], leaf_start[i+1]). Only consecutive leaves whose union is a
+// box are merged (the smaller neighbor is preferred), so the result is still
+// a set of disjoint boxes with contiguous point ranges. Merging stops once
+// min_nleaves leaves are left (e.g. one per process). leaf_start, le and re
+// are updated in place and the number of remaining leaves is returned.
+inline uint64_t merge_small_leaves(uint32_t ndim, uint64_t min_npts,
+                                   std::vector<uint64_t> &leaf_start,
+                                   std::vector<double> &le,
+                                   std::vector<double> &re,
+                                   uint64_t min_nleaves = 1) {
+  uint64_t i, j, n, nleaves = leaf_start.size() - 1;
+  uint32_t d;
+  bool merged = true;
+  min_nleaves = std::max(min_nleaves, (uint64_t)1);
+  while (merged && (nleaves > min_nleaves)) {
+    merged = false;
+    for (i = 0; (i < nleaves) && (nleaves > min_nleaves); i++) {
+      if ((leaf_start[i+1] - leaf_start[i]) >= min_npts)
+        continue;
+      // Candidate to merge with (j = i + 1 after the swap below)
+      n = std::numeric_limits<uint64_t>::max();
+      j = nleaves;
+      if ((i > 0) && leaves_form_box(ndim, &le[0], &re[0], i - 1, i)) {
+        j = i - 1;
+        n = leaf_start[i] - leaf_start[i-1];
+      }
+      if (((i + 1) < nleaves) &&
+          leaves_form_box(ndim, &le[0], &re[0], i, i + 1) &&
+          ((leaf_start[i+2] - leaf_start[i+1]) < n))
+        j = i + 1;
+      if (j == nleaves)
+        continue;
+      if (j < i)
+        std::swap(i, j);
+      for (d = 0; d < ndim; d++) {
+        le[i*ndim+d] = std::min(le[i*ndim+d], le[j*ndim+d]);
+        re[i*ndim+d] = std::max(re[i*ndim+d], re[j*ndim+d]);
+      }
+      leaf_start.erase(leaf_start.begin() + j);
+      le.erase(le.begin() + j*ndim, le.begin() + (j+1)*ndim);
+      re.erase(re.begin() + j*ndim, re.begin() + (j+1)*ndim);
+      nleaves--;
+      merged = true;
+    }
+  }
+  return nleaves;
+}
+
+#define SPLIT_MEDIAN 0 // median of the widest dimension (as in cykdtree)
+#define SPLIT_COST   1 // minimise points plus estimated halo size
+
+// KD decomposition of points with a selectable split policy. Leaves are
+// stored in depth first order so that all_idx sorts the points by leaf and
+// leaf i owns all_idx[leaf_start[i]:leaf_start[i+1]].
+//
+// The SPLIT_COST policy estimates the cost of a leaf with n points in a box
+// of volume V as n plus the expected number of halo points, i.e. the exposed
+// surface area times the density times the mean interparticle spacing
+// (n/V)^(1/ndim). Faces on a non-periodic domain boundary are not exposed.
+// Each split is chosen among quantiles of every dimension to balance the cost
+// per target leaf of the two children, rejecting splits that would make a
+// child's aspect ratio exceed max_aspect.
+class SplitKDTree
+{
+public:
+  double *all_pts;
+  uint64_t *all_idx;
+  uint64_t npts;
+  uint32_t ndim;
+  uint64_t leafsize;
+  int policy;
+  double max_aspect;
+  std::vector<double> domain_le;
+  std::vector<double> domain_re;
+  std::vector<bool> periodic;
+  std::vector<uint64_t> leaf_start;
+  std::vector<double> leaves_le;
+  std::vector<double> leaves_re;
+
+  // Exactly one of leafsize (maximum points per leaf) or nleaves (number of
+  // leaves) should be non-zero.
+  SplitKDTree(double *pts, uint64_t *idx, uint64_t n, uint32_t m,
+              uint64_t leafsize0, uint64_t nleaves,
+              const double *left_edge, const double *right_edge,
+              const bool *periodic0, int policy0 = SPLIT_COST,
+              double max_aspect0 = 4.0) {
+    all_pts = pts;
+    all_idx = idx;
+    npts = n;
+    ndim = m;
+    leafsize = leafsize0;
+    policy = policy0;
+    max_aspect = max_aspect0;
+    domain_le.assign(left_edge, left_edge + m);
+    domain_re.assign(right_edge, right_edge + m);
+    periodic.assign(periodic0, periodic0 + m);
+    if ((nleaves == 0) && (leafsize < 2))
+      leafsize = 2;
+    leaf_start.push_back(0);
+    build(0, n, nleaves, domain_le, domain_re);
+  }
+
+  uint64_t num_leaves() const { return leaf_start.size() - 1; }
+
+  // Estimated triangulation cost of n points in the box [le, re]
+  double cost(uint64_t n, const std::vector<double> &le,
+              const std::vector<double> &re) const {
+    if (n == 0)
+      return 0.0;
+    uint32_t d;
+    double vol = 1.0, area = 0.0, face;
+    for (d = 0; d < ndim; d++)
+      vol *= (re[d] - le[d]);
+    if (!(vol > 0))
+      return (double)n;
+    for (d = 0; d < ndim; d++) {
+      face = vol/(re[d] - le[d]);
+      if (periodic[d] || (le[d] > domain_le[d]))
+        area += face;
+      if (periodic[d] || (re[d] < domain_re[d]))
+        area += face;
+    }
+    return (double)n + area*pow((double)n/vol, (double)(ndim-1)/ndim);
+  }
+
+  double aspect(const std::vector<double> &le,
+                const std::vector<double> &re) const {
+    double wmin = re[0] - le[0], wmax = wmin;
+    for (uint32_t d = 1; d < ndim; d++) {
+      wmin = std::min(wmin, re[d] - le[d]);
+      wmax = std::max(wmax, re[d] - le[d]);
+    }
+    if (!(wmin > 0))
+      return std::numeric_limits<double>::infinity();
+    return wmax/wmin;
+  }
+
+  void add_leaf(uint64_t n, const std::vector<double> &le,
+                const std::vector<double> &re) {
+    leaf_start.push_back(leaf_start.back() + n);
+    leaves_le.insert(leaves_le.end(), le.begin(), le.end());
+    leaves_re.insert(leaves_re.end(), re.begin(), re.end());
+  }
+
+  // Split dimension and number of points in the lesser child using the
+  // median policy. Returns false if the points are all coincident.
+  bool median_split(uint64_t Lidx, uint64_t n, uint64_t ntarget,
+                    uint32_t &dsplit, uint64_t &nless) const {
+    uint64_t j;
+    uint32_t d;
+    double x, wmax = 0;
+    std::vector<double> mins(ndim), maxs(ndim);
+    for (d = 0; d < ndim; d++) {
+      mins[d] = std::numeric_limits<double>::infinity();
+      maxs[d] = -std::numeric_limits<double>::infinity();
+    }
+    for (j = Lidx; j < (Lidx + n); j++) {
+      for (d = 0; d < ndim; d++) {
+        x = all_pts[ndim*all_idx[j]+d];
+        mins[d] = std::min(mins[d], x);
+        maxs[d] = std::max(maxs[d], x);
+      }
+    }
+    dsplit = 0;
+    for (d = 0; d < ndim; d++) {
+      if ((maxs[d] - mins[d]) > wmax) {
+        wmax = maxs[d] - mins[d];
+        dsplit = d;
+      }
+    }
+    nless = (n - 1)/2 + 1;
+    if ((ntarget > 1) && (n >= ntarget))
+      nless = std::min(std::max(nless, ntarget/2),
+                       n - (ntarget - ntarget/2));
+    return (wmax > 0);
+  }
+
+  // Split dimension and number of points in the lesser child using the cost
+  // policy. Children get ntarget/2 and ntarget - ntarget/2 target leaves.
+  bool cost_split(uint64_t Lidx, uint64_t n, uint64_t ntarget,
+                  const std::vector<double> &le,
+                  const std::vector<double> &re,
+                  uint32_t &dsplit, uint64_t &nless) const {
+    const uint64_t ncand = 32;
+    uint64_t j, k, c, kmin, kmax, nmin = (uint64_t)(ndim + 1);
+    uint32_t d;
+    double wless = 1.0, wgreater = 1.0, score, best = 0, split;
+    double limit = std::max(max_aspect, aspect(le, re));
+    bool found = false;
+    std::vector<double> x(n), lre, gle;
+    if (ntarget > 1) {
+      wless = (double)(ntarget/2);
+      wgreater = (double)(ntarget - ntarget/2);
+    }
+    kmin = std::max((uint64_t)1, n/10);
+    kmax = std::max(kmin, n - n/10);
+    if ((n >= 2*nmin) && (kmin < nmin))
+      kmin = nmin;
+    if ((n >= 2*nmin) && (kmax > (n - nmin)))
+      kmax = n - nmin;
+    // Both children keep at least one point per target leaf when possible
+    // and never fewer than one point, so 1 <= k <= n-1
+    uint64_t klo = std::max((uint64_t)1, ntarget/2);
+    uint64_t khi = std::max((uint64_t)1, ntarget - ntarget/2);
+    if ((klo + khi) > n) {
+      klo = 1;
+      khi = 1;
+    }
+    kmin = std::min(std::max(kmin, klo), n - khi);
+    kmax = std::min(std::max(kmax, kmin), n - khi);
+    for (d = 0; d < ndim; d++) {
+      for (j = 0; j < n; j++)
+        x[j] = all_pts[ndim*all_idx[Lidx+j]+d];
+      std::sort(x.begin(), x.end());
+      if (x[n-1] == x[0])
+        continue;
+      for (c = 0; c <= ncand; c++) {
+        k = kmin + ((kmax - kmin)*c)/ncand;
+        split = x[k-1];
+        if ((split <= le[d]) || (split >= re[d]))
+          continue;
+        lre = re;
+        lre[d] = split;
+        gle = le;
+        gle[d] = split;
+        if ((aspect(le, lre) > limit) || (aspect(gle, re) > limit))
+          continue;
+        score = std::max(cost(k, le, lre)/wless,
+                         cost(n - k, gle, re)/wgreater);
+        if ((!found) || (score < best)) {
+          found = true;
+          best = score;
+          dsplit = d;
+          nless = k;
+        }
+      }
+    }
+    return found;
+  }
+
+  void build(uint64_t Lidx, uint64_t n, uint64_t ntarget,
+             const std::vector<double> &le, const std::vector<double> &re) {
+    bool leaf;
+    if (ntarget > 0)
+      leaf = (ntarget == 1);
+    else
+      leaf = (n < leafsize);
+    if (leaf) {
+      add_leaf(n, le, re);
+      return;
+    }
+    uint32_t dsplit = 0;
+    uint64_t nless = 0;
+    bool found = false;
+    if ((policy == SPLIT_COST) && (n > 1))
+      found = cost_split(Lidx, n, ntarget, le, re, dsplit, nless);
+    if (!found)
+      found = median_split(Lidx, n, ntarget, dsplit, nless);
+    if (!found) {
+      // all points singular
+      add_leaf(n, le, re);
+      return;
+    }
+    // Partition so the first nless points are the smallest along dsplit
+    uint32_t d = dsplit;
+    const double *p = all_pts;
+    uint32_t m = ndim;
+    std::nth_element(all_idx + Lidx, all_idx + Lidx + nless - 1,
+                     all_idx + Lidx + n,
+                     [p, m, d](uint64_t a, uint64_t b) {
+                       return p[m*a+d] < p[m*b+d]; });
+    double split = all_pts[ndim*all_idx[Lidx+nless-1]+dsplit];
+    std::vector<double> lre(re), gle(le);
+    lre[dsplit] = split;
+    gle[dsplit] = split;
+    build(Lidx, nless, ntarget/2, le, lre);
+    build(Lidx + nless, n - nless, ntarget - ntarget/2, gle, re);
+  }
+};
+
+// Position of each point along a Morton (Z-order) curve through the box
+// [le, re]. Keys use floor(64/ndim) bits per dimension.
+void morton_keys(uint32_t ndim, uint64_t npts, double *pts,
+                 double *le, double *re, uint64_t *keys, int nthreads = 0) {
+  uint32_t nbits = std::min((uint32_t)(64/std::max(ndim, (uint32_t)1)),
+                            (uint32_t)32);
+  double maxval = ldexp(1.0, nbits) - 1.0;
+  parallel_for(npts, [&](uint64_t start, uint64_t stop, uint32_t) {
+      std::vector<uint64_t> X(ndim);
+      uint64_t i, key;
+      uint32_t d;
+      int b;
+      double x;
+      for (i = start; i < stop; i++) {
+        for (d = 0; d < ndim; d++) {
+          x = 0.0;
+          if (re[d] > le[d])
+            x = (pts[ndim*i + d] - le[d])/(re[d] - le[d]);
+          x = std::min(std::max(x, 0.0), 1.0);
+          X[d] = (uint64_t)(x*maxval);
+        }
+        key = 0;
+        for (b = (int)nbits - 1; b >= 0; b--) {
+          for (d = 0; d < ndim; d++)
+            key = (key << 1) | ((X[d] >> b) & 1);
+        }
+        keys[i] = key;
+      }
+    }, nthreads);
+}
+
+#define CURVE_HILBERT 0
+#define CURVE_MORTON  1
+
+// Domain decomposition that sorts points along a space filling curve and
+// cuts the curve into exactly nchunks pieces of (nearly) equal total weight.
+// all_idx is sorted in place so that chunk i owns
+// all_idx[leaf_start[i]:leaf_start[i+1]]. leaves_le/leaves_re hold the
+// bounding box of the cells of a coarse curve grid that the chunk's section
+// of the curve passes through (and of its points). Every cell lies on some
+// chunk's section, so the boxes cover the domain without gaps. Boxes of
+// different chunks may overlap; empty chunks have inverted (+inf/-inf)
+// boxes.
+class CurveDecomposition
+{
+public:
+  double *all_pts;
+  uint64_t *all_idx;
+  uint64_t npts;
+  uint32_t ndim;
+  uint64_t nchunks;
+  int curve;
+  std::vector<double> domain_le;
+  std::vector<double> domain_re;
+  std::vector<uint64_t> leaf_start;
+  std::vector<uint64_t> key_start;
+  std::vector<double> leaves_le;
+  std::vector<double> leaves_re;
+
+  // weights may be NULL, in which case every point has unit weight.
+  CurveDecomposition(double *pts, uint64_t *idx, uint64_t n, uint32_t m,
+                     uint64_t nchunks0, double *left_edge,
+                     double *right_edge, const double *weights = NULL,
+                     int curve0 = CURVE_HILBERT, int nthreads = 0) {
+    all_pts = pts;
+    all_idx = idx;
+    npts = n;
+    ndim = m;
+    nchunks = std::max(nchunks0, (uint64_t)1);
+    curve = curve0;
+    domain_le.assign(left_edge, left_edge + m);
+    domain_re.assign(right_edge, right_edge + m);
+    uint64_t i, j, c;
+    uint32_t d;
+    // Sort along the curve
+    std::vector<uint64_t> keys(n), order(n), idx0(idx, idx + n);
+    std::vector<double> spts(n*m);
+    for (i = 0; i < n; i++)
+      for (d = 0; d < m; d++)
+        spts[m*i+d] = pts[m*idx0[i]+d];
+    if (curve == CURVE_MORTON)
+      morton_keys(m, n, &spts[0], left_edge, right_edge, &keys[0], nthreads);
+    else
+      hilbert_keys(m, n, &spts[0], left_edge, right_edge, &keys[0], nthreads);
+    argsort_keys(n, &keys[0], &order[0], nthreads);
+    for (i = 0; i < n; i++)
+      all_idx[i] = idx0[order[i]];
+    // Cut where the cumulative weight passes each multiple of W/nchunks
+    std::vector<double> cum(n + 1, 0.0);
+    for (i = 0; i < n; i++)
+      cum[i+1] = cum[i] + ((weights == NULL) ? 1.0 : weights[idx0[order[i]]]);
+    leaf_start.assign(nchunks + 1, n);
+    leaf_start[0] = 0;
+    for (c = 1; c < nchunks; c++) {
+      double target = cum[n]*(double)c/(double)nchunks;
+      j = (uint64_t)(std::lower_bound(cum.begin(), cum.end(), target)
+                     - cum.begin());
+      leaf_start[c] = std::max(std::min(j, n), leaf_start[c-1]);
+    }
+    key_start.assign(nchunks, 0);
+    for (c = 1; c < nchunks; c++) {
+      if (leaf_start[c] < n)
+        key_start[c] = keys[order[leaf_start[c]]];
+      else
+        key_start[c] = std::numeric_limits<uint64_t>::max();
+    }
+    // Bounding boxes
+    leaves_le.assign(nchunks*m, std::numeric_limits<double>::infinity());
+    leaves_re.assign(nchunks*m, -std::numeric_limits<double>::infinity());
+    parallel_for(nchunks, [&](uint64_t start, uint64_t stop, uint32_t) {
+        uint64_t cc, jj;
+        uint32_t dd;
+        double x;
+        for (cc = start; cc < stop; cc++) {
+          for (jj = leaf_start[cc]; jj < leaf_start[cc+1]; jj++) {
+            for (dd = 0; dd < ndim; dd++) {
+              x = all_pts[ndim*all_idx[jj]+dd];
+              leaves_le[ndim*cc+dd] = std::min(leaves_le[ndim*cc+dd], x);
+              leaves_re[ndim*cc+dd] = std::max(leaves_re[ndim*cc+dd], x);
+            }
+          }
+        }
+      }, nthreads);
+    add_cell_boxes();
+  }
+
+  // Grow the box of each non-empty chunk to the curve grid cells on its
+  // section of the curve. Both curves visit each aligned cell of the
+  // 2^l per dimension grid in one contiguous run of keys that share their
+  // top ndim*l bits. Starting from the whole domain, a cell whose run lies
+  // in one chunk's section is added to that chunk; otherwise it is split
+  // into its 2^ndim children, down to max_level where it is added to every
+  // chunk it overlaps. Only the cells around chunk boundaries are split, so
+  // the boxes stay tight where points are dense. Cells before the first
+  // chunk's first point belong to that chunk.
+  void add_cell_boxes(uint32_t max_level = 20) {
+    uint32_t nbits = std::min((uint32_t)(64/std::max(ndim, (uint32_t)1)),
+                              (uint32_t)32);
+    max_level = std::min(max_level, nbits - 1);
+    std::vector<uint64_t> nonempty, lo;
+    for (uint64_t c = 0; c < nchunks; c++) {
+      if (leaf_start[c] < leaf_start[c+1]) {
+        lo.push_back(nonempty.empty() ? 0 : key_start[c]);
+        nonempty.push_back(c);
+      }
+    }
+    if (nonempty.empty() || (ndim == 0) || (ndim > 32))
+      return;
+    // Cell i at level l along a dimension holds the points mapped to
+    // integer coordinates [i*s, (i+1)*s) with s = 2^(nbits-l), i.e.
+    // fractions [i*s, (i+1)*s)/maxval of the domain
+    double maxval = ldexp(1.0, nbits) - 1.0;
+    std::vector<double> cen(ndim), cle(ndim), cre(ndim);
+    std::vector<std::pair<uint32_t, std::vector<uint64_t> > > stack;
+    stack.push_back(std::make_pair((uint32_t)0,
+                                   std::vector<uint64_t>(ndim, 0)));
+    uint32_t d, l;
+    uint64_t key, a, b, j, j0, j1, i, mask, side;
+    while (!stack.empty()) {
+      l = stack.back().first;
+      std::vector<uint64_t> X = stack.back().second;
+      stack.pop_back();
+      double s = ldexp(1.0, nbits - l);
+      side = 1ull << l;
+      for (d = 0; d < ndim; d++) {
+        double w = domain_re[d] - domain_le[d];
+        cen[d] = domain_le[d] + ((X[d] + 0.5)*s/maxval)*w;
+        cle[d] = (X[d] == 0) ? domain_le[d] :
+          domain_le[d] + std::min((double)X[d]*s/maxval, 1.0)*w;
+        cre[d] = (X[d] == (side - 1)) ? domain_re[d] :
+          domain_le[d] + std::min((double)(X[d] + 1)*s/maxval, 1.0)*w;
+      }
+      if (l == 0) {
+        a = 0;
+        b = std::numeric_limits<uint64_t>::max();
+      } else {
+        if (curve == CURVE_MORTON)
+          morton_keys(ndim, 1, &cen[0], &domain_le[0], &domain_re[0],
+                      &key, 1);
+        else
+          hilbert_keys(ndim, 1, &cen[0], &domain_le[0], &domain_re[0],
+                       &key, 1);
+        uint32_t shift = ndim*(nbits - l);
+        mask = (shift >= 64) ? 0 : ((1ull << shift) - 1);
+        a = key & ~mask;
+        b = a | mask;
+      }
+      j0 = (uint64_t)(std::upper_bound(lo.begin(), lo.end(), a)
+                      - lo.begin()) - 1;
+      j1 = (uint64_t)(std::upper_bound(lo.begin(), lo.end(), b)
+                      - lo.begin()) - 1;
+      if ((j0 == j1) || (l == max_level)) {
+        for (j = j0; j <= j1; j++) {
+          uint64_t c = nonempty[j];
+          for (d = 0; d < ndim; d++) {
+            leaves_le[ndim*c+d] = std::min(leaves_le[ndim*c+d], cle[d]);
+            leaves_re[ndim*c+d] = std::max(leaves_re[ndim*c+d], cre[d]);
+          }
+        }
+        continue;
+      }
+      for (i = 0; i < (1ull << ndim); i++) {
+        std::vector<uint64_t> Y(ndim);
+        for (d = 0; d < ndim; d++)
+          Y[d] = 2*X[d] + ((i >> d) & 1);
+        stack.push_back(std::make_pair(l + 1, Y));
+      }
+    }
+  }
+
+  uint64_t num_leaves() const { return nchunks; }
+
+  // Chunk whose section of the curve contains the point
+  uint64_t find(double *pt) const {
+    uint64_t key;
+    double *le = const_cast<double*>(&domain_le[0]);
+    double *re = const_cast<double*>(&domain_re[0]);
+    if (curve == CURVE_MORTON)
+      morton_keys(ndim, 1, pt, le, re, &key, 1);
+    else
+      hilbert_keys(ndim, 1, pt, le, re, &key, 1);
+    // The last chunk starting at or before the key that is not empty
+    uint64_t c = (uint64_t)(std::upper_bound(key_start.begin(),
+                                             key_start.end(), key)
+                            - key_start.begin()) - 1;
+    while ((c > 0) && (leaf_start[c] == leaf_start[c+1]))
+      c--;
+    return c;
+  }
+};
+
+// Copy the points into the order given by idx so that out[j] is
+// pts[idx[j]]. Applied to a tree's sorted index this gives the points of
+// each leaf as one contiguous slice.
+template <typename I>
+void gather_points(uint32_t ndim, uint64_t npts, const double *pts,
+                   const I *idx, double *out, int nthreads = 0) {
+  parallel_for(npts, [&](uint64_t start, uint64_t stop, uint32_t) {
+      for (uint64_t j = start; j < stop; j++)
+        memcpy(out + ndim*j, pts + ndim*(uint64_t)idx[j],
+               ndim*sizeof(double));
+    }, nthreads);
+}
+
+// Batch point location against the leaves of a domain decomposition. The
+// leaf boxes are split recursively by planes that no box crosses, which is
+// always possible for the leaves of a KD tree. Groups of boxes that cannot
+// be separated (e.g. overlapping curve chunks) end in a bucket whose boxes
+// are tested in order. Points are located a block at a time, descending all
+// points in the block one level per pass.
+class LeafLocator
+{
+public:
+  uint32_t ndim;
+  uint64_t nleaves;
+  std::vector<double> leaves_le;
+  std::vector<double> leaves_re;
+  // Inner nodes have split_dim >= 0 and children child[n], child[n]+1;
+  // buckets have split_dim -1 and boxes bucket_ids[child[n]:child_end[n]]
+  std::vector<int32_t> split_dim;
+  std::vector<double> split;
+  std::vector<uint32_t> child;
+  std::vector<uint32_t> child_end;
+  std::vector<uint32_t> bucket_ids;
+  // Bounds of the boxes below each node, used to prune nearest()
+  std::vector<double> node_le;
+  std::vector<double> node_re;
+
+  LeafLocator() : ndim(0), nleaves(0) {}
+  LeafLocator(uint64_t nleaves0, uint32_t ndim0,
+              const double *le, const double *re) {
+    ndim = ndim0;
+    nleaves = nleaves0;
+    leaves_le.assign(le, le + nleaves*ndim);
+    leaves_re.assign(re, re + nleaves*ndim);
+    std::vector<uint32_t> ids;
+    for (uint64_t i = 0; i < nleaves; i++) {
+      // Skip inverted (empty) boxes
+      bool empty = false;
+      for (uint32_t d = 0; d < ndim; d++)
+        if (le[ndim*i+d] > re[ndim*i+d])
+          empty = true;
+      if (!empty)
+        ids.push_back((uint32_t)i);
+    }
+    std::vector<std::pair<uint32_t, std::vector<uint32_t> > > stack;
+    add_node();
+    stack.push_back(std::make_pair(0u, ids));
+    while (!stack.empty()) {
+      uint32_t n = stack.back().first;
+      std::vector<uint32_t> S;
+      S.swap(stack.back().second);
+      stack.pop_back();
+      int32_t dbest = -1;
+      double vbest = 0;
+      uint64_t nbest = 0;
+      if (S.size() > 1)
+        best_cut(S, dbest, vbest, nbest);
+      if (dbest < 0) {
+        child[n] = (uint32_t)bucket_ids.size();
+        bucket_ids.insert(bucket_ids.end(), S.begin(), S.end());
+        child_end[n] = (uint32_t)bucket_ids.size();
+        continue;
+      }
+      std::vector<uint32_t> less, greater;
+      for (uint64_t i = 0; i < S.size(); i++) {
+        if (leaves_re[ndim*S[i]+dbest] <= vbest ||
+            edges_close(leaves_re[ndim*S[i]+dbest], vbest))
+          less.push_back(S[i]);
+        else
+          greater.push_back(S[i]);
+      }
+      uint32_t c = add_node();
+      add_node();
+      split_dim[n] = dbest;
+      split[n] = vbest;
+      child[n] = c;
+      stack.push_back(std::make_pair(c, less));
+      stack.push_back(std::make_pair(c + 1, greater));
+    }
+    set_node_bounds();
+  }
+
+  // Children are added after their parent, so a reverse pass sees every
+  // child before its parent
+  void set_node_bounds() {
+    uint64_t nnodes = split_dim.size();
+    node_le.assign(nnodes*ndim, std::numeric_limits<double>::infinity());
+    node_re.assign(nnodes*ndim, -std::numeric_limits<double>::infinity());
+    for (uint64_t n = nnodes; n > 0; n--) {
+      double *nle = &node_le[ndim*(n-1)], *nre = &node_re[ndim*(n-1)];
+      uint32_t d;
+      if (split_dim[n-1] >= 0) {
+        for (uint32_t c = child[n-1]; c <= (child[n-1] + 1); c++) {
+          for (d = 0; d < ndim; d++) {
+            nle[d] = std::min(nle[d], node_le[ndim*c+d]);
+            nre[d] = std::max(nre[d], node_re[ndim*c+d]);
+          }
+        }
+      } else {
+        for (uint32_t b = child[n-1]; b < child_end[n-1]; b++) {
+          uint64_t i = bucket_ids[b];
+          for (d = 0; d < ndim; d++) {
+            nle[d] = std::min(nle[d], leaves_le[ndim*i+d]);
+            nre[d] = std::max(nre[d], leaves_re[ndim*i+d]);
+          }
+        }
+      }
+    }
+  }
+
+  uint32_t add_node() {
+    split_dim.push_back(-1);
+    split.push_back(0);
+    child.push_back(0);
+    child_end.push_back(0);
+    return (uint32_t)(split_dim.size() - 1);
+  }
+
+  // Most balanced plane that no box in S crosses
+  void best_cut(std::vector<uint32_t> &S, int32_t &dbest, double &vbest,
+                uint64_t &nbest) {
+    uint64_t i, n = S.size();
+    std::vector<uint32_t> order(S);
+    for (uint32_t d = 0; d < ndim; d++) {
+      const double *lle = &leaves_le[0], *lre = &leaves_re[0];
+      uint32_t nd = ndim;
+      std::sort(order.begin(), order.end(), [lle, nd, d](uint32_t a,
+                                                         uint32_t b) {
+          return lle[nd*a+d] < lle[nd*b+d]; });
+      double maxre = -std::numeric_limits<double>::infinity();
+      for (i = 0; i < (n - 1); i++) {
+        maxre = std::max(maxre, lre[nd*order[i]+d]);
+        double v = lle[nd*order[i+1]+d];
+        if ((maxre > v) && !edges_close(maxre, v))
+          continue;
+        if (edges_close(v, lle[nd*order[i]+d]))
+          continue;
+        uint64_t nsmall = std::min(i + 1, n - i - 1);
+        if (nsmall > nbest) {
+          nbest = nsmall;
+          dbest = (int32_t)d;
+          vbest = v;
+        }
+      }
+    }
+  }
+
+  // Leaf containing the point, or -1 if it is not inside any leaf
+  int64_t find(const double *pt) const {
+    uint32_t n = 0;
+    while (split_dim[n] >= 0)
+      n = child[n] + (pt[split_dim[n]] >= split[n] ? 1 : 0);
+    return check_bucket(n, pt);
+  }
+
+  // Leaf whose box is closest to the point, skipping leaves marked in
+  // skip, or -1 if there is none. Ties go to the lowest leaf index, the
+  // same as a scan over all leaves.
+  int64_t nearest(const double *pt,
+                  const std::vector<bool> *skip = NULL) const {
+    int64_t out = -1;
+    double d, dbest = std::numeric_limits<double>::infinity();
+    std::vector<uint32_t> stack;
+    if (!split_dim.empty())
+      stack.push_back(0);
+    while (!stack.empty()) {
+      uint32_t n = stack.back();
+      stack.pop_back();
+      if (box_dist2(ndim, pt, &node_le[ndim*n], &node_re[ndim*n]) > dbest)
+        continue;
+      if (split_dim[n] >= 0) {
+        // Visit the nearer child first
+        uint32_t c = child[n];
+        if (box_dist2(ndim, pt, &node_le[ndim*c], &node_re[ndim*c]) <=
+            box_dist2(ndim, pt, &node_le[ndim*(c+1)], &node_re[ndim*(c+1)])) {
+          stack.push_back(c + 1);
+          stack.push_back(c);
+        } else {
+          stack.push_back(c);
+          stack.push_back(c + 1);
+        }
+        continue;
+      }
+      for (uint32_t b = child[n]; b < child_end[n]; b++) {
+        uint64_t i = bucket_ids[b];
+        if ((skip != NULL) && (*skip)[i])
+          continue;
+        d = box_dist2(ndim, pt, &leaves_le[ndim*i], &leaves_re[ndim*i]);
+        if ((d < dbest) || ((d == dbest) && ((int64_t)i < out))) {
+          dbest = d;
+          out = (int64_t)i;
+        }
+      }
+    }
+    return out;
+  }
+
+  int64_t check_bucket(uint32_t n, const double *pt) const {
+    for (uint32_t b = child[n]; b < child_end[n]; b++) {
+      uint64_t i = bucket_ids[b];
+      uint32_t d;
+      for (d = 0; d < ndim; d++) {
+        if ((pt[d] < leaves_le[ndim*i+d]) || (pt[d] > leaves_re[ndim*i+d]))
+          break;
+      }
+      if (d == ndim)
+        return (int64_t)i;
+    }
+    return -1;
+  }
+
+  // Locate npts points, storing the leaf of each (or -1) in leaf_ids
+  void find_all(uint64_t npts, const double *pts, int64_t *leaf_ids,
+                int nthreads = 0) const {
+    const uint64_t block = 64;
+    parallel_for((npts + block - 1)/block,
+                 [&](uint64_t start, uint64_t stop, uint32_t) {
+        uint32_t node[block];
+        for (uint64_t b = start; b < stop; b++) {
+          uint64_t j0 = b*block;
+          uint64_t nb = std::min(block, npts - j0);
+          uint64_t p;
+          for (p = 0; p < nb; p++)
+            node[p] = 0;
+          bool active = (split_dim[0] >= 0);
+          while (active) {
+            active = false;
+            for (p = 0; p < nb; p++) {
+              uint32_t n = node[p];
+              int32_t d = split_dim[n];
+              if (d < 0)
+                continue;
+              node[p] = child[n] + (pts[ndim*(j0+p)+d] >= split[n] ? 1 : 0);
+              active = true;
+            }
+          }
+          for (p = 0; p < nb; p++)
+            leaf_ids[j0+p] = check_bucket(node[p], pts + ndim*(j0+p));
+        }
+      }, nthreads);
+  }
+
+  // Group point indices by leaf with a counting sort so that the points on
+  // leaf i are order[indptr[i]:indptr[i+1]] (in increasing index order).
+  // Points outside all leaves (-1) are left out. Returns their number.
+  static uint64_t group_by_leaf(uint64_t npts, const int64_t *leaf_ids,
+                                uint64_t nleaves,
+                                std::vector<uint64_t> &indptr,
+                                std::vector<uint64_t> &order,
+                                int nthreads = 0) {
+    uint32_t nt = choose_nthreads(npts, nthreads);
+    std::vector<uint64_t> counts((uint64_t)nt*(nleaves + 1), 0);
+    parallel_for(npts, [&](uint64_t start, uint64_t stop, uint32_t t) {
+        uint64_t *c = &counts[(uint64_t)t*(nleaves + 1)];
+        for (uint64_t j = start; j < stop; j++)
+          if (leaf_ids[j] >= 0)
+            c[leaf_ids[j]]++;
+      }, (int)nt);
+    // Exclusive offsets by leaf then thread so that the sort is stable
+    indptr.assign(nleaves + 1, 0);
+    uint64_t i, t, tot = 0, tmp;
+    for (i = 0; i < nleaves; i++) {
+      indptr[i] = tot;
+      for (t = 0; t < nt; t++) {
+        tmp = counts[t*(nleaves + 1) + i];
+        counts[t*(nleaves + 1) + i] = tot;
+        tot += tmp;
+      }
+    }
+    indptr[nleaves] = tot;
+    order.resize(tot);
+    parallel_for(npts, [&](uint64_t start, uint64_t stop, uint32_t t) {
+        uint64_t *c = &counts[(uint64_t)t*(nleaves + 1)];
+        for (uint64_t j = start; j < stop; j++)
+          if (leaf_ids[j] >= 0)
+            order[c[leaf_ids[j]]++] = j;
+      }, (int)nt);
+    return npts - tot;
+  }
+};
+
+// Lossless codec for groups of exchanged points. Indices are sorted (with
+// their points) and stored as LEB128 varint deltas. The coordinates in each
+// dimension are stored as the bits that differ from the first point's
+// coordinate, packed at the smallest width that holds every difference.
+// Decoding reproduces the (sorted) points and indices bit for bit.
+class BitWriter
+{
+public:
+  std::vector<uint8_t> &buf;
+  uint64_t acc;
+  uint32_t nbit;
+  BitWriter(std::vector<uint8_t> &buf0) : buf(buf0), acc(0), nbit(0) {}
+  void put(uint64_t v, uint32_t w) {
+    if (w > 32) {
+      put(v & 0xFFFFFFFFull, 32);
+      put(v >> 32, w - 32);
+      return;
+    }
+    if (w < 32)
+      v &= ((1ull << w) - 1);
+    acc |= v << nbit;
+    nbit += w;
+    while (nbit >= 8) {
+      buf.push_back((uint8_t)(acc & 0xFF));
+      acc >>= 8;
+      nbit -= 8;
+    }
+  }
+  void flush() {
+    if (nbit > 0)
+      buf.push_back((uint8_t)(acc & 0xFF));
+    acc = 0;
+    nbit = 0;
+  }
+};
+
+class BitReader
+{
+public:
+  const uint8_t *buf;
+  uint64_t pos;
+  uint64_t acc;
+  uint32_t nbit;
+  BitReader(const uint8_t *buf0) : buf(buf0), pos(0), acc(0), nbit(0) {}
+  uint64_t get(uint32_t w) {
+    if (w > 32) {
+      uint64_t lo = get(32);
+      return lo | (get(w - 32) << 32);
+    }
+    while (nbit < w) {
+      acc |= ((uint64_t)buf[pos++]) << nbit;
+      nbit += 8;
+    }
+    uint64_t out = (w < 32) ? (acc & ((1ull << w) - 1)) : (acc & 0xFFFFFFFFull);
+    acc >>= w;
+    nbit -= w;
+    return out;
+  }
+  // Drop the bits left in the current byte
+  void align() {
+    acc = 0;
+    nbit = 0;
+  }
+};
+
+inline void put_varint(std::vector<uint8_t> &buf, uint64_t v) {
+  while (v >= 0x80) {
+    buf.push_back((uint8_t)((v & 0x7F) | 0x80));
+    v >>= 7;
+  }
+  buf.push_back((uint8_t)v);
+}
+
+inline uint64_t get_varint(const uint8_t *buf, uint64_t &pos) {
+  uint64_t v = 0;
+  uint32_t shift = 0;
+  uint8_t b;
+  do {
+    b = buf[pos++];
+    v |= ((uint64_t)(b & 0x7F)) << shift;
+    shift += 7;
+  } while (b & 0x80);
+  return v;
+}
+
+inline uint64_t double_bits(double x) {
+  uint64_t out;
+  memcpy(&out, &x, sizeof(double));
+  return out;
+}
+
+inline double bits_double(uint64_t b) {
+  double out;
+  memcpy(&out, &b, sizeof(double));
+  return out;
+}
+
+// Map a double to an unsigned key with the same order, so that the values
+// in an interval are a contiguous range of keys. The map is a bijection on
+// the bit patterns, so a key gives back the exact double.
+inline uint64_t double_key(double x) {
+  uint64_t b = double_bits(x);
+  return (b >> 63) ? ~b : (b | (1ull << 63));
+}
+
+inline double key_double(uint64_t k) {
+  return bits_double((k >> 63) ? (k & ~(1ull << 63)) : ~k);
+}
+
+// Append n points (sorted in place by index first) to buf. Each coordinate
+// is written as the offset of its key from the smallest key in the group,
+// bit-packed at the width of the group's range in keys. A box around the
+// group can only be wider than that range, so the sending leaf's bounds are
+// not used; halo groups are thin slabs near a leaf face and their range is
+// much narrower than the leaf's. Trailing zero bits shared by all offsets
+// (e.g. coordinates that came from float32 or a grid) are shifted out.
+template <typename I>
+void encode_exchange(uint32_t ndim, uint64_t n, double *pts, I *idx,
+                     std::vector<uint8_t> &buf) {
+  if (n == 0)
+    return;
+  uint64_t j;
+  uint32_t k;
+  // Sort by index
+  std::vector<uint64_t> order(n);
+  for (j = 0; j < n; j++)
+    order[j] = j;
+  std::sort(order.begin(), order.end(), [idx](uint64_t a, uint64_t b) {
+      return idx[a] < idx[b]; });
+  std::vector<double> spts(pts, pts + ndim*n);
+  std::vector<I> sidx(idx, idx + n);
+  for (j = 0; j < n; j++) {
+    idx[j] = sidx[order[j]];
+    memcpy(pts + ndim*j, &spts[ndim*order[j]], ndim*sizeof(double));
+  }
+  // Indices
+  put_varint(buf, (uint64_t)idx[0]);
+  for (j = 1; j < n; j++)
+    put_varint(buf, (uint64_t)(idx[j] - idx[j-1]));
+  // Coordinates
+  for (k = 0; k < ndim; k++) {
+    uint64_t kmin = double_key(pts[k]), kmax = kmin, key, bits = 0;
+    for (j = 1; j < n; j++) {
+      key = double_key(pts[ndim*j+k]);
+      kmin = std::min(kmin, key);
+      kmax = std::max(kmax, key);
+    }
+    for (j = 0; j < n; j++)
+      bits |= double_key(pts[ndim*j+k]) - kmin;
+    uint32_t w = 0, tz = 0;
+    while ((w < 64) && (((kmax - kmin) >> w) != 0))
+      w++;
+    while ((tz < w) && (((bits >> tz) & 1) == 0))
+      tz++;
+    for (uint32_t b = 0; b < 8; b++)
+      buf.push_back((uint8_t)((kmin >> (8*b)) & 0xFF));
+    buf.push_back((uint8_t)w);
+    buf.push_back((uint8_t)tz);
+    if (w == tz)
+      continue;
+    BitWriter bw(buf);
+    for (j = 0; j < n; j++)
+      bw.put((double_key(pts[ndim*j+k]) - kmin) >> tz, w - tz);
+    bw.flush();
+  }
+}
+
+// Decode n points written by encode_exchange. Returns the bytes consumed.
+template <typename I>
+uint64_t decode_exchange(const uint8_t *buf, uint32_t ndim, uint64_t n,
+                         double *pts, I *idx) {
+  if (n == 0)
+    return 0;
+  uint64_t j, pos = 0;
+  uint32_t k;
+  idx[0] = (I)get_varint(buf, pos);
+  for (j = 1; j < n; j++)
+    idx[j] = idx[j-1] + (I)get_varint(buf, pos);
+  for (k = 0; k < ndim; k++) {
+    uint64_t kmin = 0;
+    for (uint32_t b = 0; b < 8; b++)
+      kmin |= ((uint64_t)buf[pos++]) << (8*b);
+    uint32_t w = buf[pos++];
+    uint32_t tz = buf[pos++];
+    if (w == tz) {
+      for (j = 0; j < n; j++)
+        pts[ndim*j+k] = key_double(kmin);
+      continue;
+    }
+    BitReader br(buf + pos);
+    for (j = 0; j < n; j++)
+      pts[ndim*j+k] = key_double(kmin + (br.get(w - tz) << tz));
+    pos += br.pos;
+  }
+  return pos;
+}
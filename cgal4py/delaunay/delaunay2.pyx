@@ -24,12 +24,22 @@ from libcpp cimport bool as cbool
 from cpython cimport bool as pybool
 from cython.operator cimport dereference
 from cython.operator cimport preincrement, predecrement
-from libc.stdint cimport uint32_t, uint64_t, int32_t, int64_t
+from libc.stdint cimport uint32_t, uint64_t, int32_t, int64_t, int8_t
 
 ctypedef uint32_t info_t
 cdef object np_info = np.uint32
 ctypedef np.uint32_t np_info_t
 
+cdef inline int _check_mutable(Delaunay_with_info_2[info_t] *T,
+                               cbool journaled = False) except -1:
+    if T.frozen:
+        raise RuntimeError("Cannot modify a frozen triangulation. " +
+                           "Call thaw first.")
+    if T.in_transaction and not journaled:
+        raise RuntimeError("Only insert can modify the triangulation " +
+                           "while a transaction is open.")
+    return 0
+
 cdef class Delaunay2_vertex:
     r"""Wrapper class for a triangulation vertex.
 
@@ -90,6 +100,7 @@ cdef class Delaunay2_vertex:
             pos (:obj:`ndarray` of float64): new x,y coordinates for this vertex.
 
         """
+        _check_mutable(self.T)
         self.T.updated = <cbool>True
         assert(len(pos) == 2)
         with nogil, cython.boundscheck(False), cython.wraparound(False):
@@ -102,6 +113,7 @@ cdef class Delaunay2_vertex:
             c (Delaunay2_cell): Cell that will be assigned as designated cell.
 
         """
+        _check_mutable(self.T)
         self.T.updated = <cbool>True
         self.x.set_cell(c.x)
 
@@ -126,6 +138,14 @@ cdef class Delaunay2_vertex:
                 out = self.x.info()
             return out
 
+    property id:
+        r"""info_t: Integer id of the vertex. This is the vertex info, i.e.
+        the index used for the vertex in :attr:`Delaunay2.vertices` and in the
+        cells array returned by :meth:`Delaunay2.serialize`. The infinite
+        vertex has the maximum info_t value."""
+        def __get__(self):
+            return self.T.vertex_id(self.x)
+
     property dual_volume:
         r"""float64: The area of the dual Voronoi cell. If the area is 
         infinite, -1.0 is returned."""
@@ -512,6 +532,7 @@ cdef class Delaunay2_edge:
             bool: True if the edge could be flipped, False otherwise.
 
         """
+        _check_mutable(self.T)
         self.T.updated = <cbool>True
         return self.T.flip(self.x)
 
@@ -520,6 +541,7 @@ cdef class Delaunay2_edge:
         the two cells incident to this edge. The edge is assumed flippable to 
         save time.
         """
+        _check_mutable(self.T)
         self.T.updated = <cbool>True
         self.T.flip_flippable(self.x)
 
@@ -881,6 +903,7 @@ cdef class Delaunay2_cell:
             v (Delauany2_vertex): Vertex to set ith vertex of this cell to.
 
         """
+        _check_mutable(self.T)
         self.T.updated = <cbool>True
         self.x.set_vertex(i, v.x)
 
@@ -894,11 +917,13 @@ cdef class Delaunay2_cell:
             v3 (Delaunay2_vertex): 3rd vertex of cell.
 
         """
+        _check_mutable(self.T)
         self.T.updated = <cbool>True
         self.x.set_vertices(v1.x, v2.x, v3.x)
 
     def reset_vertices(self):
         r"""Reset all of this cell's vertices."""
+        _check_mutable(self.T)
         self.T.updated = <cbool>True
         self.x.set_vertices()
 
@@ -910,6 +935,7 @@ cdef class Delaunay2_cell:
             n (Delaunay2_cell): Cell to set ith neighbor of this cell to.
 
         """
+        _check_mutable(self.T)
         self.T.updated = <cbool>True
         self.x.set_neighbor(i, n.x)
 
@@ -923,26 +949,31 @@ cdef class Delaunay2_cell:
             c3 (Delaunay2_cell): 3rd neighboring cell.
 
         """
+        _check_mutable(self.T)
         self.T.updated = <cbool>True
         self.x.set_neighbors(c1.x, c2.x, c3.x)
 
     def reset_neighbors(self):
         r"""Reset all of this cell's neighboring cells."""
+        _check_mutable(self.T)
         self.T.updated = <cbool>True
         self.x.set_neighbors()
 
     def reorient(self):
         r"""Change the vertex order so that ccw and cw are switched."""
+        _check_mutable(self.T)
         self.T.updated = <cbool>True
         self.x.reorient()
 
     def ccw_permute(self):
         r"""Bring the last vertex to the front of the vertex order."""
+        _check_mutable(self.T)
         self.T.updated = <cbool>True
         self.x.ccw_permute()
         
     def cw_permute(self):
         r"""Put the 1st vertex at the end of the vertex order."""
+        _check_mutable(self.T)
         self.T.updated = <cbool>True
         self.x.cw_permute()
 
@@ -973,6 +1004,13 @@ cdef class Delaunay2_cell:
         def __get__(self):
             return self.x.min_angle()
 
+    property id:
+        r"""info_t: Integer id of the cell. This is the row of the cell in
+        the cells array returned by :meth:`Delaunay2.serialize`. Ids are
+        valid until the triangulation is next modified."""
+        def __get__(self):
+            return self.T.cell_id(self.x)
+
     def incident_vertices(self):
         r"""Find vertices that are incident to this cell.
 
@@ -1203,6 +1241,16 @@ cdef class Delaunay2:
         n_per_insert (list of int): The number of points inserted at each 
             insert.
 
+    Args:
+        fast_location (bool, optional): If True, :meth:`Delaunay2.locate`,
+            :meth:`Delaunay2.nearest_vertex`, and
+            :meth:`Delaunay2.locate_ids` start their walks from a Delaunay
+            hierarchy over the vertices. The hierarchy is built on the first
+            query and then follows inserts of fewer points than the
+            triangulation already holds, which are located one at a time
+            from it. Larger inserts, removing or moving vertices rebuild it on
+            the next query. Defaults to False.
+
     """
 
     cdef Delaunay_with_info_2[info_t] *T
@@ -1210,16 +1258,114 @@ cdef class Delaunay2:
     cdef public object n_per_insert
     cdef readonly pybool _locked
     cdef public object _cache_to_clear_on_update
+    cdef object _transaction_start
 
     @cython.boundscheck(False)
     @cython.wraparound(False)
-    def __cinit__(self):
+    def __cinit__(self, pybool fast_location = False):
         with nogil, cython.boundscheck(False), cython.wraparound(False):
             self.T = new Delaunay_with_info_2[info_t]()
+        self.T.fast_location = <cbool>fast_location
         self.n = 0
         self.n_per_insert = []
         self._locked = False
         self._cache_to_clear_on_update = {}
+        self._transaction_start = None
+
+    property fast_location:
+        r"""bool: Whether point location starts from a Delaunay hierarchy.
+        It cannot be changed while the triangulation is frozen."""
+        def __get__(self):
+            return <pybool>self.T.fast_location
+        def __set__(self, pybool value):
+            if self.T.frozen:
+                raise RuntimeError("Cannot change fast_location while " +
+                                   "the triangulation is frozen.")
+            self.T.fast_location = <cbool>value
+
+    def freeze(self, int nthreads = 0):
+        r"""Put the triangulation in a read-only mode so that it can be
+        queried from several Python threads at once. While frozen,
+        :meth:`Delaunay2.locate`, :meth:`Delaunay2.nearest_vertex`,
+        :meth:`Delaunay2.locate_ids`, the incidence queries, and the id based
+        queries and per-cell metrics only read the triangulation and release
+        the GIL. Point location walks from the last face found by the calling
+        thread rather than using CGAL's shared random generator. Any attempt
+        to modify the triangulation raises a RuntimeError until
+        :meth:`Delaunay2.thaw` is called.
+
+        Args:
+            nthreads (int, optional): Number of threads used to fill the
+                caches. If not positive, the number of available cores is
+                used. Defaults to 0.
+
+        Raises:
+            ValueError: If the triangulation is not yet 2D.
+
+        """
+        cdef cbool out
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            out = self.T.freeze(nthreads)
+        if not out:
+            raise ValueError("Freezing needs a 2D triangulation.")
+
+    def thaw(self):
+        r"""Leave the read-only mode entered by :meth:`Delaunay2.freeze`."""
+        self.T.thaw()
+
+    property frozen:
+        r"""bool: Whether the triangulation is in read-only mode."""
+        def __get__(self):
+            return <pybool>self.T.frozen
+
+    def begin(self):
+        r"""Start a transaction. Points inserted before the next call to
+        :meth:`Delaunay2.commit` or :meth:`Delaunay2.rollback` are recorded
+        along with the faces they replaced, so that rolling back takes time
+        proportional to the size of the change rather than the size of the
+        triangulation. Only :meth:`Delaunay2.insert` can modify the
+        triangulation while the transaction is open.
+
+        Raises:
+            RuntimeError: If a transaction is already open.
+            ValueError: If the triangulation is not yet 2D.
+
+        """
+        if self.T.in_transaction:
+            raise RuntimeError("A transaction is already open.")
+        if not self.T.begin():
+            raise ValueError("Transactions need a 2D triangulation.")
+        self._transaction_start = (self.n, len(self.n_per_insert))
+
+    def commit(self):
+        r"""Keep the points inserted since :meth:`Delaunay2.begin` and close
+        the transaction."""
+        if not self.T.in_transaction:
+            raise RuntimeError("No transaction is open.")
+        self.T.commit()
+        self._transaction_start = None
+
+    def rollback(self):
+        r"""Remove the points inserted since :meth:`Delaunay2.begin`,
+        restoring the faces they replaced, and close the transaction."""
+        if not self.T.in_transaction:
+            raise RuntimeError("No transaction is open.")
+        _check_mutable(self.T, True)
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            self.T.rollback()
+        self.n, nins = self._transaction_start
+        del self.n_per_insert[nins:]
+        self._transaction_start = None
+        self._set_updated()
+        self._update_tess()
+
+    property in_transaction:
+        r"""bool: Whether a transaction is open."""
+        def __get__(self):
+            return <pybool>self.T.in_transaction
+
+    def _check_can_modify(self, pybool journaled = False):
+        _check_mutable(self.T, journaled)
 
     def _lock(self):
         self._locked = True
@@ -1238,6 +1384,8 @@ cdef class Delaunay2:
     @staticmethod
     def _update_to_tess(func):
         def wrapped_func(solf, *args, **kwargs):
+            # Insertion is the only change recorded by transactions
+            solf._check_can_modify(func.__name__ == 'insert')
             solf._lock()
             out = func(solf, *args, **kwargs)
             solf._unlock()
@@ -1849,6 +1997,325 @@ cdef class Delaunay2:
         with nogil, cython.boundscheck(False), cython.wraparound(False):
             nout = self.T.minimum_angles(&out[0])
         return out[:nout]
+
+    def cell_quality(self, int nthreads = 0):
+        r"""Compute quality metrics for all cells in one threaded pass.
+
+        Args:
+            nthreads (int, optional): Number of threads to use. If <= 0, the
+                number of hardware threads is used. Defaults to 0.
+
+        Returns:
+            np.ndarray: Structured array with fields 'min_angle', 'radius_edge',
+                and 'volume' for each cell in the order returned by
+                :meth:`Delaunay2.serialize`. See
+                :func:`cgal4py.delaunay.tools.py_cell_quality`.
+
+        """
+        from cgal4py.delaunay.tools import py_cell_quality
+        cells, neigh, idx_inf = self.serialize()
+        return py_cell_quality(self.vertices, cells, idx_inf,
+                               nthreads=nthreads)
+
+    def _check_cell_ids(self, object cells):
+        r"""Get a contiguous array of cell ids, checking that they are in
+        range.
+
+        Args:
+            cells (:obj:`ndarray` of info_t): Cell ids. If None, the ids of
+                all cells are returned.
+
+        Returns:
+            :obj:`ndarray` of info_t: Cell ids.
+
+        """
+        if cells is None:
+            return np.arange(self.num_cells, dtype=np_info)
+        cdef np.ndarray[np_info_t, ndim=1] cids
+        cids = np.ascontiguousarray(cells, dtype=np_info)
+        if (cids.shape[0] > 0) and (cids.max() >= self.num_cells):
+            raise ValueError("Cell id out of range.")
+        return cids
+
+    def cell_from_id(self, np_info_t i):
+        r"""Get the cell with a given id.
+
+        Args:
+            i (info_t): Cell id. See :attr:`Delaunay2_cell.id`.
+
+        Returns:
+            Delaunay2_cell: Cell with the given id.
+
+        """
+        if i >= self.num_cells:
+            raise ValueError("Cell id out of range.")
+        cdef Delaunay2_cell out = Delaunay2_cell()
+        out.assign(self.T, self.T.cell_from_id(i))
+        return out
+
+    def vertex_from_id(self, np_info_t i):
+        r"""Get the vertex with a given id.
+
+        Args:
+            i (info_t): Vertex id. See :attr:`Delaunay2_vertex.id`.
+
+        Returns:
+            Delaunay2_vertex: Vertex with the given id. If there is no such
+                vertex, the infinite vertex is returned.
+
+        """
+        cdef Delaunay2_vertex out = Delaunay2_vertex()
+        out.assign(self.T, self.T.vertex_from_id(i))
+        return out
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def locate_ids(self, np.ndarray[np.float64_t, ndim=2] pos):
+        r"""Get the id of the cell containing each point. Points are located
+        in order starting from the cell containing the previous point, so
+        spatially sorted points are located fastest.
+
+        Args:
+            pos (:obj:`ndarray` of float64): (n, 2) array of x,y coordinates.
+
+        Returns:
+            :obj:`ndarray` of info_t: Id of the cell containing each point.
+
+        """
+        assert(pos.shape[1] == 2)
+        cdef uint64_t n = pos.shape[0]
+        cdef np.ndarray[np_info_t, ndim=1] out = np.empty(n, np_info)
+        if (n == 0) or (self.n == 0):
+            return out
+        pos = np.ascontiguousarray(pos)
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            self.T.locate_ids(n, &pos[0,0], &out[0])
+        return out
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def cell_vertex_ids(self, object cells = None, int nthreads = 0):
+        r"""Get the ids of the vertices of cells.
+
+        Args:
+            cells (:obj:`ndarray` of info_t, optional): Cell ids. Defaults to
+                all cells.
+            nthreads (int, optional): Number of threads to use. If <= 0, the
+                number of hardware threads is used. Defaults to 0.
+
+        Returns:
+            :obj:`ndarray` of info_t: (n, 3) array of vertex ids. The infinite
+                vertex has the maximum info_t value.
+
+        """
+        cdef np.ndarray[np_info_t, ndim=1] cids = self._check_cell_ids(cells)
+        cdef uint64_t n = cids.shape[0]
+        cdef np.ndarray[np_info_t, ndim=2] out = np.empty((n, 3), np_info)
+        if n == 0:
+            return out
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            self.T.cell_vertex_ids(n, &cids[0], &out[0,0], nthreads)
+        return out
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def cell_neighbor_ids(self, object cells = None, int nthreads = 0):
+        r"""Get the ids of the neighbors of cells.
+
+        Args:
+            cells (:obj:`ndarray` of info_t, optional): Cell ids. Defaults to
+                all cells.
+            nthreads (int, optional): Number of threads to use. If <= 0, the
+                number of hardware threads is used. Defaults to 0.
+
+        Returns:
+            :obj:`ndarray` of info_t: (n, 3) array of neighbor ids. Neighbor
+                i is opposite vertex i.
+
+        """
+        cdef np.ndarray[np_info_t, ndim=1] cids = self._check_cell_ids(cells)
+        cdef uint64_t n = cids.shape[0]
+        cdef np.ndarray[np_info_t, ndim=2] out = np.empty((n, 3), np_info)
+        if n == 0:
+            return out
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            self.T.cell_neighbor_ids(n, &cids[0], &out[0,0], nthreads)
+        return out
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def incident_cell_ids(self, object verts):
+        r"""Get the ids of the cells incident to vertices.
+
+        Args:
+            verts (:obj:`ndarray` of info_t): Vertex ids.
+
+        Returns:
+            tuple: :obj:`ndarray` of uint64 indptr and :obj:`ndarray` of
+                info_t cell ids such that the cells incident to vertex
+                verts[i] are ids[indptr[i]:indptr[i+1]]. Ids that no vertex
+                has get an empty row.
+
+        """
+        cdef np.ndarray[np_info_t, ndim=1] vids
+        vids = np.ascontiguousarray(verts, dtype=np_info)
+        cdef uint64_t n = vids.shape[0]
+        cdef vector[uint64_t] indptr
+        cdef vector[info_t] ids
+        if n > 0:
+            with nogil, cython.boundscheck(False), cython.wraparound(False):
+                self.T.incident_cell_ids(n, &vids[0], indptr, ids)
+        else:
+            indptr.push_back(0)
+        cdef np.ndarray[np.uint64_t, ndim=1] out_indptr
+        cdef np.ndarray[np_info_t, ndim=1] out_ids
+        out_indptr = np.empty(indptr.size(), 'uint64')
+        out_ids = np.empty(ids.size(), np_info)
+        cdef uint64_t i
+        for i in range(indptr.size()):
+            out_indptr[i] = indptr[i]
+        for i in range(ids.size()):
+            out_ids[i] = ids[i]
+        return out_indptr, out_ids
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def cell_circumcenters(self, object cells = None, int nthreads = 0):
+        r"""Get the circumcenters of cells.
+
+        Args:
+            cells (:obj:`ndarray` of info_t, optional): Cell ids. Defaults to
+                all cells.
+            nthreads (int, optional): Number of threads to use. If <= 0, the
+                number of hardware threads is used. Defaults to 0.
+
+        Returns:
+            :obj:`ndarray` of float64: (n, 2) array of circumcenters. Infinite
+                cells have infinite circumcenters.
+
+        """
+        cdef np.ndarray[np_info_t, ndim=1] cids = self._check_cell_ids(cells)
+        cdef uint64_t n = cids.shape[0]
+        cdef np.ndarray[np.float64_t, ndim=2] out = np.empty((n, 2), 'float64')
+        if n == 0:
+            return out
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            self.T.cell_circumcenters(n, &cids[0], &out[0,0], nthreads)
+        return out
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def cell_minimum_angles(self, object cells = None, int nthreads = 0):
+        r"""Get the minimum angles of cells.
+
+        Args:
+            cells (:obj:`ndarray` of info_t, optional): Cell ids. Defaults to
+                all cells.
+            nthreads (int, optional): Number of threads to use. If <= 0, the
+                number of hardware threads is used. Defaults to 0.
+
+        Returns:
+            :obj:`ndarray` of float64: Minimum angle of each cell in
+                radians. Infinite cells have a minimum angle of -1.
+
+        """
+        cdef np.ndarray[np_info_t, ndim=1] cids = self._check_cell_ids(cells)
+        cdef uint64_t n = cids.shape[0]
+        cdef np.ndarray[np.float64_t, ndim=1] out = np.empty(n, 'float64')
+        if n == 0:
+            return out
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            self.T.cell_minimum_angles(n, &cids[0], &out[0], nthreads)
+        return out
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def oriented_side_batch(self, np.ndarray[np.float64_t, ndim=2] pos,
+                            object cells, int nthreads = 0):
+        r"""Determine if points are inside, outside, or on cells.
+
+        Args:
+            pos (:obj:`ndarray` of float64): (n, 2) array of x,y coordinates.
+            cells (:obj:`ndarray` of info_t or Delaunay2_cell): Either the id
+                of the cell that each point should be tested against (ids are
+                rows in the cells array returned by
+                :meth:`Delaunay2.serialize`) or a single cell that all of the
+                points should be tested against.
+            nthreads (int, optional): Number of threads to use. If <= 0, the
+                number of hardware threads is used. Defaults to 0.
+
+        Returns:
+            :obj:`ndarray` of int8: Same values as :meth:`Delaunay2_cell.side`
+                for each point.
+
+        """
+        assert(pos.shape[1] == 2)
+        cdef uint64_t n = pos.shape[0]
+        cdef np.ndarray[np.int8_t, ndim=1] out = np.empty(n, 'int8')
+        cdef np.ndarray[np_info_t, ndim=1] cids
+        cdef Delaunay2_cell c
+        if n == 0:
+            return out
+        pos = np.ascontiguousarray(pos)
+        if isinstance(cells, Delaunay2_cell):
+            c = cells
+            with nogil, cython.boundscheck(False), cython.wraparound(False):
+                self.T.oriented_side_batch(c.x, n, &pos[0,0],
+                                           <int8_t*>&out[0], nthreads)
+        else:
+            cids = np.ascontiguousarray(cells, dtype=np_info)
+            assert(cids.shape[0] == n)
+            if cids.max() >= self.num_cells:
+                raise ValueError("Cell id out of range.")
+            with nogil, cython.boundscheck(False), cython.wraparound(False):
+                self.T.oriented_side_batch(n, &cids[0], &pos[0,0],
+                                           <int8_t*>&out[0], nthreads)
+        return out
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def side_of_oriented_circle_batch(self,
+                                      np.ndarray[np.float64_t, ndim=2] pos,
+                                      object cells, int nthreads = 0):
+        r"""Determine where points are with respect to cell circumcircles.
+
+        Args:
+            pos (:obj:`ndarray` of float64): (n, 2) array of x,y coordinates.
+            cells (:obj:`ndarray` of info_t or Delaunay2_cell): Either the id
+                of the cell that each point should be tested against (ids are
+                rows in the cells array returned by
+                :meth:`Delaunay2.serialize`) or a single cell that all of the
+                points should be tested against.
+            nthreads (int, optional): Number of threads to use. If <= 0, the
+                number of hardware threads is used. Defaults to 0.
+
+        Returns:
+            :obj:`ndarray` of int8: Same values as
+                :meth:`Delaunay2_cell.side_of_circle` for each point.
+
+        """
+        assert(pos.shape[1] == 2)
+        cdef uint64_t n = pos.shape[0]
+        cdef np.ndarray[np.int8_t, ndim=1] out = np.empty(n, 'int8')
+        cdef np.ndarray[np_info_t, ndim=1] cids
+        cdef Delaunay2_cell c
+        if n == 0:
+            return out
+        pos = np.ascontiguousarray(pos)
+        if isinstance(cells, Delaunay2_cell):
+            c = cells
+            with nogil, cython.boundscheck(False), cython.wraparound(False):
+                self.T.side_of_oriented_circle_batch(c.x, n, &pos[0,0],
+                    <int8_t*>&out[0], nthreads)
+        else:
+            cids = np.ascontiguousarray(cells, dtype=np_info)
+            assert(cids.shape[0] == n)
+            if cids.max() >= self.num_cells:
+                raise ValueError("Cell id out of range.")
+            with nogil, cython.boundscheck(False), cython.wraparound(False):
+                self.T.side_of_oriented_circle_batch(n, &cids[0], &pos[0,0],
+                    <int8_t*>&out[0], nthreads)
+        return out
         
     @_update_to_tess
     def remove(self, Delaunay2_vertex x):
@@ -3,7 +3,7 @@ from libcpp.vector cimport vector
 from libcpp.set cimport set as cset
 from libcpp.pair cimport pair
 from libcpp cimport bool
-from libc.stdint cimport uint32_t, uint64_t, int32_t, int64_t
+from libc.stdint cimport uint32_t, uint64_t, int32_t, int64_t, int8_t
 
 cdef extern from "c_delaunay3.hpp":
     cdef int VALID
@@ -12,6 +12,14 @@ cdef extern from "c_delaunay3.hpp":
         Delaunay_with_info_3() except +
         Delaunay_with_info_3(double *pts, Info *val, uint32_t n) except +
         bool updated
+        bool fast_location
+        bool frozen
+        bool freeze(int nthreads)
+        void thaw()
+        bool in_transaction
+        bool begin()
+        void commit()
+        void rollback()
         bool is_valid() const
         uint32_t num_finite_verts() const
         uint32_t num_finite_edges() const
@@ -236,8 +244,44 @@ cdef extern from "c_delaunay3.hpp":
         int side_of_facet(const double* pos, const Facet f, int& lt, int& li, int& lj) const 
         # int side_of_circle(const Facet f, const double* pos)
         int side_of_sphere(const Cell c, const double* pos)
+        void update_ids() const
+        Info vertex_id(const Vertex v) const
+        Info cell_id(const Cell c) const
+        Vertex vertex_from_id(Info i) const
+        Cell cell_from_id(Info i) const
+        void locate_ids(uint64_t n, const double* pos, Info* out) const
+        void cell_vertex_ids(uint64_t n, const Info* cells, Info* out,
+                             int nthreads) const
+        void cell_neighbor_ids(uint64_t n, const Info* cells, Info* out,
+                               int nthreads) const
+        void incident_cell_ids(uint64_t n, const Info* verts,
+                               vector[uint64_t]& indptr,
+                               vector[Info]& ids) const
+        void vertex_star_csr(vector[uint64_t]& indptr, vector[Info]& ids,
+                             int nthreads) const
+        void cell_circumcenters(uint64_t n, const Info* cells, double* out,
+                                int nthreads) const
+        void cell_minimum_angles(uint64_t n, const Info* cells, double* out,
+                                 int nthreads) const
+
+        void side_of_sphere_batch(uint64_t n, const Info* cells,
+                                  const double* pos, int8_t* out,
+                                  int nthreads) const
+        void side_of_sphere_batch(const Cell c, uint64_t n, const double* pos,
+                                  int8_t* out, int nthreads) const
+        void side_of_cell_batch(uint64_t n, const Info* cells,
+                                const double* pos, int8_t* out,
+                                int nthreads) const
+        void side_of_cell_batch(const Cell c, uint64_t n, const double* pos,
+                                int8_t* out, int nthreads) const
+        void side_of_facet_batch(const Facet f, uint64_t n, const double* pos,
+                                 int8_t* out, int nthreads) const
+        void side_of_edge_batch(const Edge e, uint64_t n, const double* pos,
+                                int8_t* out, int nthreads) const
         bool is_Gabriel(const Edge e)
         bool is_Gabriel(const Facet f)
+        void edge_gabriel_lengths(bool* gabriel, double* lengths,
+                                  int nthreads) const
 
         vector[vector[Info]] outgoing_points(uint64_t nbox,
                                              double *left_edges, double *right_edges)
@@ -159,6 +159,8 @@ cdef extern from "c_delaunayD.hpp":
         double n_simplex_volume(Facet f) const
         double dual_volume(const Vertex v)
         void dual_volumes(double* vols)
+        void vertex_star_csr(vector[uint64_t]& indptr, vector[Info]& ids,
+                             int nthreads) const
 
         vector[vector[Info]] outgoing_points(uint64_t nbox,
                                              double *left_edges, double *right_edges)
@@ -1923,6 +1923,42 @@ cdef class DelaunayD:
             self.T.dual_volumes(&out[0])
         return out
 
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def vertex_star_csr(self, int nthreads = 0):
+        r"""Get the cells incident to every finite vertex in one pass over
+        the cells.
+
+        Args:
+            nthreads (int, optional): Number of threads to use. If <= 0, the
+                number of hardware threads is used. Defaults to 0.
+
+        Returns:
+            tuple: :obj:`ndarray` of uint64 indptr and :obj:`ndarray` of
+                info_t cell ids such that the cells incident to the vertex
+                with index i are ids[indptr[i]:indptr[i+1]] in increasing
+                order. Cell ids are rows in the cells array returned by
+                :meth:`DelaunayD.serialize`. There is a row for every index
+                up to the largest, and indices without a vertex (e.g. after
+                :meth:`DelaunayD.remove`) have empty rows.
+
+        """
+        cdef vector[uint64_t] indptr
+        cdef vector[info_t] ids
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            self.T.vertex_star_csr(indptr, ids, nthreads)
+        cdef np.ndarray[np.uint64_t, ndim=1] out_indptr
+        cdef np.ndarray[np_info_t, ndim=1] out_ids
+        out_indptr = np.empty(indptr.size(), 'uint64')
+        out_ids = np.empty(ids.size(), np_info)
+        cdef uint64_t i
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            for i in range(indptr.size()):
+                out_indptr[i] = indptr[i]
+            for i in range(ids.size()):
+                out_ids[i] = ids[i]
+        return out_indptr, out_ids
+
     @_update_to_tess
     def remove(self, DelaunayD_vertex x):
         r"""Remove a vertex from the triangulation. 
@@ -68,6 +68,17 @@ enum  Sign
     return x;
   }
 
+  template <class K>
+  Orientation orientation(const K& p1, const K& p2, const K& p3) {
+    return COLLINEAR;
+  }
+
+  template <class K>
+  Orientation orientation(const K& p1, const K& p2, const K& p3,
+			  const K& p4) {
+    return COPLANAR;
+  }
+
   class Exact_predicates_inexact_constructions_kernel {
   public:
     class Offset {
@@ -24,11 +24,21 @@ cdef extern from "c_parallel_delaunayD.hpp":
         uint32_t ndim
         int limit_mem
         uint64_t npts_total
+        int nleaves_total
+        uint64_t leaf_npts_limit
+        uint64_t exchange_bytes
         uint64_t *idx_total
         Info *info_total
         double *pts_total
 
+        void set_decomposition(int method, int nleaves_per_proc)
+        void set_leaf_order(cbool leaf_order)
+        void set_compress_exchange(cbool compress)
+        void set_volumes_only(cbool volumes_only)
         void insert(uint64_t npts, double *pts) except +
+        void leaf_sizes(uint64_t *out)
+        cbool outside_periodic(uint64_t n, const double *pts)
+        void wrap_periodic(uint64_t n, double *pts)
 
         uint64_t num_cells()
         void consolidate_vols(double *vols) except +
@@ -16,10 +16,15 @@ cdef object np_info = np.uint32
 ctypedef np.uint32_t np_info_t
 
 
+# Domain decompositions accepted by ParallelDelaunayD
+_dd_methods = {'kdtree': 0, 'hilbert': 1, 'morton': 2, 'kdtree_cost': 3}
+
+
 cdef class ParallelDelaunayD:
 
     cdef ParallelDelaunay_with_info_D[info_t] *T
-    cdef object pts_total
+    cdef readonly object pts_total
+    cdef object pts_first
     cdef int rank
     cdef int size
 
@@ -27,7 +32,14 @@ cdef class ParallelDelaunayD:
     @cython.wraparound(False)
     def __cinit__(self, np.ndarray[np.float64_t, ndim=1] le = None,
                   np.ndarray[np.float64_t, ndim=1] re = None,
-                  object periodic=False, str unique_str="", int limit_mem=0):
+                  object periodic=False, str unique_str="", int limit_mem=0,
+                  str dd_method='kdtree', int nleaves_per_proc=1,
+                  cbool leaf_order=True, cbool compress_exchange=False,
+                  cbool volumes_only=False):
+        if dd_method not in _dd_methods:
+            raise ValueError("'{}' is not a supported ".format(dd_method) +
+                             "domain decomposition.")
+        cdef int method = _dd_methods[dd_method]
         cdef np.uint32_t ndim = 0
         cdef cbool* per = NULL
         cdef double* ptr_le = NULL
@@ -54,23 +66,90 @@ cdef class ParallelDelaunayD:
         with nogil, cython.boundscheck(False), cython.wraparound(False):
             self.T = new ParallelDelaunay_with_info_D[info_t](
                 ndim, ptr_le, ptr_re, per, limit_mem, c_unique_str)
+            self.T.set_decomposition(method, nleaves_per_proc)
+            self.T.set_leaf_order(leaf_order)
+            self.T.set_compress_exchange(compress_exchange)
+            self.T.set_volumes_only(volumes_only)
+
+    property exchange_bytes:
+        r"""int: Bytes of exchanged points and indices sent by this rank,
+        whether raw or through the exchange codec."""
+        def __get__(self):
+            return self.T.exchange_bytes
+
+    property leaf_npts_limit:
+        r"""int: Number of points a leaf may own after a later insert before
+        it is split."""
+        def __get__(self):
+            return self.T.leaf_npts_limit
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def leaf_sizes(self):
+        r"""Number of points owned by each leaf. Must be called on every
+        process.
+
+        Returns:
+            np.ndarray of uint64: Points owned by each leaf, indexed by leaf
+                id, on the root process. None on the other processes.
+
+        """
+        cdef np.ndarray[np.uint64_t, ndim=1] sizes
+        sizes = np.zeros(max(self.T.nleaves_total, 1), 'uint64')
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            self.T.leaf_sizes(&sizes[0])
+        if self.rank != 0:
+            return None
+        return sizes[:self.T.nleaves_total]
 
     @cython.boundscheck(False)
     @cython.wraparound(False)
     def insert(self, np.ndarray[np.float64_t, ndim=2] pts = None):
+        r"""Insert points into the parallel triangulation. The first call
+        sets up the domain decomposition. Points from later calls that are
+        outside the domain are wrapped across periodic boundaries, and any
+        that are still outside every leaf extend the bounds of the nearest
+        leaf. Leaves that then own more than leaf_npts_limit points are
+        split on their own process. Leaves are not moved to another
+        process, so after a lot of growth, build a new triangulation to
+        rebalance the work between processes.
+
+        Args:
+            pts (np.ndarray of float64, optional): (n, m) array of n
+                m-dimensional coordinates on the root process. None on
+                the other processes. Defaults to None.
+
+        """
         cdef np.uint32_t ndim = 0
         cdef np.uint64_t npts = 0
         cdef double *ptr_pts = NULL
+        cdef cbool wrap = False
         if self.rank == 0:
             ndim = pts.shape[1]
             assert(ndim == self.T.ndim)
             npts = pts.shape[0]
             ptr_pts = &pts[0,0]
+            # Later points are wrapped across periodic boundaries, so keep
+            # the wrapped coordinates that the leaves receive
+            if self.pts_total is not None:
+                with nogil, cython.boundscheck(False), cython.wraparound(False):
+                    wrap = self.T.outside_periodic(npts, ptr_pts)
+                if wrap:
+                    pts = pts.copy()
+                    ptr_pts = &pts[0,0]
+                    with nogil, cython.boundscheck(False), cython.wraparound(False):
+                        self.T.wrap_periodic(npts, ptr_pts)
         else:
             assert(pts == None)
         with nogil, cython.boundscheck(False), cython.wraparound(False):
             self.T.insert(npts, ptr_pts)
-        self.pts_total = pts
+        # The tree on the root keeps pointers into the first batch
+        if self.pts_first is None:
+            self.pts_first = pts
+        if (self.pts_total is None) or (pts is None):
+            self.pts_total = pts
+        else:
+            self.pts_total = np.concatenate([self.pts_total, pts])
 
     @cython.boundscheck(False)
     @cython.wraparound(False)
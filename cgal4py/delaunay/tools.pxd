@@ -2,7 +2,7 @@ cimport numpy as np
 from libcpp.vector cimport vector
 from libcpp.pair cimport pair
 from libcpp cimport bool
-from libc.stdint cimport uint32_t, uint64_t, int64_t, int32_t
+from libc.stdint cimport uint32_t, uint64_t, int64_t, int32_t, int8_t, uint8_t
 
 cdef extern from "c_tools.hpp":
     bool intersect_sph_box(uint32_t ndim, double *c, double r, double *le, double *re) nogil
@@ -29,6 +29,46 @@ cdef extern from "c_tools.hpp":
     void arg_sortSerializedTess[I](I *cells, uint64_t ncells, uint32_t ndim,
                                    uint32_t *idx_verts, uint64_t *idx_cells) nogil
     void swap_cells[I](I *verts, I *neigh, uint32_t ndim, uint64_t i1, uint64_t i2) nogil
+    uint64_t validate_tess[I](uint32_t ndim, uint64_t npts, double *pts,
+                              uint64_t ncells, I *cells, I *neigh, I idx_inf,
+                              bool check_orientation, bool check_sphere,
+                              vector[int8_t] &viol_type,
+                              vector[uint64_t] &viol_cell,
+                              vector[int32_t] &viol_face,
+                              vector[uint64_t] &viol_other,
+                              int nthreads) nogil
+    void hilbert_keys(uint32_t ndim, uint64_t npts, double *pts,
+                      double *le, double *re, uint64_t *keys,
+                      int nthreads) nogil
+    void morton_keys(uint32_t ndim, uint64_t npts, double *pts,
+                     double *le, double *re, uint64_t *keys,
+                     int nthreads) nogil
+    uint64_t merge_small_leaves(uint32_t ndim, uint64_t min_npts,
+                                vector[uint64_t] &leaf_start,
+                                vector[double] &le,
+                                vector[double] &re,
+                                uint64_t min_nleaves) nogil
+    void gather_points[I](uint32_t ndim, uint64_t npts, const double *pts,
+                          const I *idx, double *out, int nthreads) nogil
+    void encode_exchange[I](uint32_t ndim, uint64_t n, double *pts, I *idx,
+                            vector[uint8_t] &buf) nogil
+    uint64_t decode_exchange[I](const uint8_t *buf, uint32_t ndim,
+                                uint64_t n, double *pts, I *idx) nogil
+    void hilbert_order_tess[I](uint32_t ndim, uint64_t npts, double *pts,
+                               uint64_t ncells, I *cells, I idx_inf,
+                               uint64_t *vert_order, uint64_t *cell_order,
+                               int nthreads) nogil
+    void rcm_order_tess[I](uint32_t ndim, uint64_t npts, uint64_t ncells,
+                           I *cells, I *neigh, I idx_inf,
+                           uint64_t *vert_order, uint64_t *cell_order) nogil
+    void renumber_tess[I](uint32_t ndim, uint64_t npts, double *pts,
+                          uint64_t ncells, I *cells, I *neigh, I idx_inf,
+                          uint64_t *vert_order, uint64_t *cell_order,
+                          double *new_pts, I *new_cells, I *new_neigh,
+                          int nthreads) nogil
+    void cell_quality[I](uint32_t ndim, double *pts, uint64_t ncells, I *cells,
+                         I idx_inf, double *min_angle, double *radius_edge,
+                         double *volume, int nthreads) nogil
     cdef cppclass SerializedLeaf[I] nogil:
         SerializedLeaf() except +
         SerializedLeaf(int _id, uint32_t _ndim, int64_t _ncells, I _idx_inf,
@@ -69,10 +109,65 @@ cdef extern from "c_tools.hpp":
         void get_inf_map(I *keys, uint64_t *vals)
         void cleanup()
         void add_leaf[leafI](SerializedLeaf[leafI] leaf)
+        uint64_t add_leaves[leafI](vector[SerializedLeaf[leafI]] &leaves,
+                                   int nthreads)
         void add_leaf_fromfile(const char *filename)
         int64_t count_inf()
         void add_inf()
 
+    cdef cppclass LeafAdjacency nogil:
+        LeafAdjacency() except +
+        LeafAdjacency(uint64_t _nleaves, uint32_t _ndim,
+                      const double *le, const double *re,
+                      const double *domain_le, const double *domain_re,
+                      const bool *periodic) except +
+        uint64_t nleaves
+        uint32_t ndim
+        vector[uint8_t] periodic_left
+        vector[uint8_t] periodic_right
+        vector[uint64_t] left_indptr
+        vector[uint32_t] left_ids
+        vector[uint64_t] right_indptr
+        vector[uint32_t] right_ids
+        @staticmethod
+        void overlapping(uint64_t nleaves, uint32_t ndim, const double *le,
+                         const double *re, vector[uint64_t] &indptr,
+                         vector[uint32_t] &ids)
+
+    cdef cppclass SplitKDTree nogil:
+        SplitKDTree(double *pts, uint64_t *idx, uint64_t n, uint32_t m,
+                    uint64_t leafsize0, uint64_t nleaves,
+                    const double *left_edge, const double *right_edge,
+                    const bool *periodic0, int policy0,
+                    double max_aspect0) except +
+        vector[uint64_t] leaf_start
+        vector[double] leaves_le
+        vector[double] leaves_re
+        uint64_t num_leaves()
+
+    cdef cppclass CurveDecomposition nogil:
+        CurveDecomposition(double *pts, uint64_t *idx, uint64_t n, uint32_t m,
+                           uint64_t nchunks0, double *left_edge,
+                           double *right_edge, const double *weights,
+                           int curve0, int nthreads) except +
+        vector[uint64_t] leaf_start
+        vector[double] leaves_le
+        vector[double] leaves_re
+        uint64_t num_leaves()
+        uint64_t find(double *pt)
+
+    cdef cppclass LeafLocator nogil:
+        LeafLocator(uint64_t nleaves0, uint32_t ndim0, const double *le,
+                    const double *re) except +
+        int64_t find(const double *pt)
+        int64_t nearest(const double *pt)
+        void find_all(uint64_t npts, const double *pts, int64_t *leaf_ids,
+                      int nthreads)
+    uint64_t LeafLocator_group_by_leaf "LeafLocator::group_by_leaf" (
+        uint64_t npts, const int64_t *leaf_ids, uint64_t nleaves,
+        vector[uint64_t] &indptr, vector[uint64_t] &order,
+        int nthreads) nogil
+
 ctypedef SerializedLeaf[uint32_t] sLeaf32
 ctypedef SerializedLeaf[uint64_t] sLeaf64
 ctypedef vector[sLeaf32] sLeaves32
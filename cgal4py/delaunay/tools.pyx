@@ -2,10 +2,11 @@ import numpy as np
 cimport numpy as np
 import copy
 import time
+import warnings
 cimport cython
 from libcpp.vector cimport vector
 from libcpp.pair cimport pair
-from libc.stdint cimport uint32_t, uint64_t, int64_t, int32_t
+from libc.stdint cimport uint32_t, uint64_t, int64_t, int32_t, int8_t, uint8_t
 from libcpp cimport bool as cbool
 from cpython cimport bool as pybool
 from cython.operator cimport dereference
@@ -631,6 +632,1010 @@ def py_swap_cells(verts, neigh, i1, i2):
     else:
         raise TypeError
 
+# Codes for the violations returned by py_validate_tess
+TESS_VIOL_VERT_RANGE = 1
+TESS_VIOL_NEIGH_RANGE = 2
+TESS_VIOL_NEIGH_SYMMETRY = 3
+TESS_VIOL_SHARED_FACET = 4
+TESS_VIOL_ORIENTATION = 5
+TESS_VIOL_EMPTY_SPHERE = 6
+tess_violation_dtype = np.dtype([('type', 'int8'), ('cell', 'uint64'),
+                                 ('face', 'int32'), ('other', 'uint64')])
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef object _validate_tess_int32(np.ndarray[np.float64_t, ndim=2] pts,
+                                 np.ndarray[np.int32_t, ndim=2] cells,
+                                 np.ndarray[np.int32_t, ndim=2] neigh,
+                                 np.int32_t idx_inf, cbool check_orientation,
+                                 cbool check_sphere, int nthreads):
+    cdef uint32_t ndim = <uint32_t>pts.shape[1]
+    cdef uint64_t npts = <uint64_t>pts.shape[0]
+    cdef uint64_t ncells = <uint64_t>cells.shape[0]
+    cdef vector[int8_t] vtype
+    cdef vector[uint64_t] vcell, vother
+    cdef vector[int32_t] vface
+    cdef uint64_t i, nviol = 0
+    if ncells > 0:
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            nviol = validate_tess[int32_t](ndim, npts, &pts[0,0], ncells,
+                                           &cells[0,0], &neigh[0,0], idx_inf,
+                                           check_orientation, check_sphere,
+                                           vtype, vcell, vface, vother, nthreads)
+    out = np.empty(nviol, dtype=tess_violation_dtype)
+    for i in range(nviol):
+        out[i] = (vtype[i], vcell[i], vface[i], vother[i])
+    return out
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef object _validate_tess_uint32(np.ndarray[np.float64_t, ndim=2] pts,
+                                  np.ndarray[np.uint32_t, ndim=2] cells,
+                                  np.ndarray[np.uint32_t, ndim=2] neigh,
+                                  np.uint32_t idx_inf, cbool check_orientation,
+                                  cbool check_sphere, int nthreads):
+    cdef uint32_t ndim = <uint32_t>pts.shape[1]
+    cdef uint64_t npts = <uint64_t>pts.shape[0]
+    cdef uint64_t ncells = <uint64_t>cells.shape[0]
+    cdef vector[int8_t] vtype
+    cdef vector[uint64_t] vcell, vother
+    cdef vector[int32_t] vface
+    cdef uint64_t i, nviol = 0
+    if ncells > 0:
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            nviol = validate_tess[uint32_t](ndim, npts, &pts[0,0], ncells,
+                                            &cells[0,0], &neigh[0,0], idx_inf,
+                                            check_orientation, check_sphere,
+                                            vtype, vcell, vface, vother, nthreads)
+    out = np.empty(nviol, dtype=tess_violation_dtype)
+    for i in range(nviol):
+        out[i] = (vtype[i], vcell[i], vface[i], vother[i])
+    return out
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef object _validate_tess_int64(np.ndarray[np.float64_t, ndim=2] pts,
+                                 np.ndarray[np.int64_t, ndim=2] cells,
+                                 np.ndarray[np.int64_t, ndim=2] neigh,
+                                 np.int64_t idx_inf, cbool check_orientation,
+                                 cbool check_sphere, int nthreads):
+    cdef uint32_t ndim = <uint32_t>pts.shape[1]
+    cdef uint64_t npts = <uint64_t>pts.shape[0]
+    cdef uint64_t ncells = <uint64_t>cells.shape[0]
+    cdef vector[int8_t] vtype
+    cdef vector[uint64_t] vcell, vother
+    cdef vector[int32_t] vface
+    cdef uint64_t i, nviol = 0
+    if ncells > 0:
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            nviol = validate_tess[int64_t](ndim, npts, &pts[0,0], ncells,
+                                           &cells[0,0], &neigh[0,0], idx_inf,
+                                           check_orientation, check_sphere,
+                                           vtype, vcell, vface, vother, nthreads)
+    out = np.empty(nviol, dtype=tess_violation_dtype)
+    for i in range(nviol):
+        out[i] = (vtype[i], vcell[i], vface[i], vother[i])
+    return out
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef object _validate_tess_uint64(np.ndarray[np.float64_t, ndim=2] pts,
+                                  np.ndarray[np.uint64_t, ndim=2] cells,
+                                  np.ndarray[np.uint64_t, ndim=2] neigh,
+                                  np.uint64_t idx_inf, cbool check_orientation,
+                                  cbool check_sphere, int nthreads):
+    cdef uint32_t ndim = <uint32_t>pts.shape[1]
+    cdef uint64_t npts = <uint64_t>pts.shape[0]
+    cdef uint64_t ncells = <uint64_t>cells.shape[0]
+    cdef vector[int8_t] vtype
+    cdef vector[uint64_t] vcell, vother
+    cdef vector[int32_t] vface
+    cdef uint64_t i, nviol = 0
+    if ncells > 0:
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            nviol = validate_tess[uint64_t](ndim, npts, &pts[0,0], ncells,
+                                            &cells[0,0], &neigh[0,0], idx_inf,
+                                            check_orientation, check_sphere,
+                                            vtype, vcell, vface, vother, nthreads)
+    out = np.empty(nviol, dtype=tess_violation_dtype)
+    for i in range(nviol):
+        out[i] = (vtype[i], vcell[i], vface[i], vother[i])
+    return out
+
+def py_validate_tess(pts, cells, neigh, idx_inf, check_orientation=True,
+                     check_sphere=True, nthreads=0):
+    r"""Check the connectivity and geometry of a serialized tessellation in 
+    parallel.
+
+    Args:
+        pts (np.ndarray of float64): (n, m) array of the coordinates of the 
+            vertices referenced by `cells`.
+        cells (np.ndarray of int): (n, m+1) array of vertex indices 
+            for the n cells in a m-dimensional triangulation.
+        neigh (np.ndarray of int): (n, m+1) array of neighboring cells.
+        idx_inf (int): Index used for the infinite vertex in `cells` and for 
+            missing neighbors in `neigh`.
+        check_orientation (bool, optional): If True, finite cells are checked 
+            for positive orientation. This should be False for cells whose 
+            vertices have been sorted (e.g. by :func:`py_sortSerializedTess`). 
+            Defaults to True.
+        check_sphere (bool, optional): If True, the circumsphere of each 
+            finite cell is checked for points inside it. Defaults to True.
+        nthreads (int, optional): Number of threads to use. If <= 0, the 
+            number of hardware threads is used. Defaults to 0.
+
+    Returns:
+        np.ndarray: Structured array with one entry per violation and fields 
+            'type' (one of the TESS_VIOL_* codes), 'cell', 'face' (-1 if not 
+            specific to a facet), and 'other' (the neighbor, vertex, or point 
+            involved). Empty if the tessellation is valid.
+
+    """
+    pts = np.ascontiguousarray(pts, dtype='float64')
+    assert(cells.shape == neigh.shape)
+    assert(cells.shape[1] == (pts.shape[1] + 1))
+    if cells.dtype == np.int32:
+        return _validate_tess_int32(pts, cells, neigh, idx_inf,
+                                    check_orientation, check_sphere, nthreads)
+    elif cells.dtype == np.uint32:
+        return _validate_tess_uint32(pts, cells, neigh, idx_inf,
+                                     check_orientation, check_sphere, nthreads)
+    elif cells.dtype == np.int64:
+        return _validate_tess_int64(pts, cells, neigh, idx_inf,
+                                    check_orientation, check_sphere, nthreads)
+    elif cells.dtype == np.uint64:
+        return _validate_tess_uint64(pts, cells, neigh, idx_inf,
+                                     check_orientation, check_sphere, nthreads)
+    else:
+        raise TypeError("Type {} not supported.".format(cells.dtype))
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def _renumber_tess_int32(np.ndarray[np.float64_t, ndim=2] pts,
+                         np.ndarray[np.int32_t, ndim=2] cells,
+                         np.ndarray[np.int32_t, ndim=2] neigh,
+                         np.int32_t idx_inf, str method, int nthreads):
+    cdef uint32_t ndim = <uint32_t>pts.shape[1]
+    cdef uint64_t npts = <uint64_t>pts.shape[0]
+    cdef uint64_t ncells = <uint64_t>cells.shape[0]
+    cdef np.ndarray[np.uint64_t, ndim=1] vert_order = np.arange(npts, dtype='uint64')
+    cdef np.ndarray[np.uint64_t, ndim=1] cell_order = np.arange(ncells, dtype='uint64')
+    cdef np.ndarray[np.float64_t, ndim=2] new_pts = np.empty_like(pts)
+    cdef np.ndarray[np.int32_t, ndim=2] new_cells = np.empty_like(cells)
+    cdef np.ndarray[np.int32_t, ndim=2] new_neigh = np.empty_like(neigh)
+    if (npts == 0) or (ncells == 0):
+        return pts.copy(), cells.copy(), neigh.copy(), vert_order, cell_order
+    if method == 'hilbert':
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            hilbert_order_tess[int32_t](ndim, npts, &pts[0,0], ncells,
+                                        &cells[0,0], idx_inf, &vert_order[0],
+                                        &cell_order[0], nthreads)
+    elif method == 'rcm':
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            rcm_order_tess[int32_t](ndim, npts, ncells, &cells[0,0],
+                                    &neigh[0,0], idx_inf, &vert_order[0],
+                                    &cell_order[0])
+    else:
+        raise ValueError("Unsupported renumbering method '{}'.".format(method))
+    with nogil, cython.boundscheck(False), cython.wraparound(False):
+        renumber_tess[int32_t](ndim, npts, &pts[0,0], ncells, &cells[0,0],
+                               &neigh[0,0], idx_inf, &vert_order[0], &cell_order[0],
+                               &new_pts[0,0], &new_cells[0,0], &new_neigh[0,0],
+                               nthreads)
+    return new_pts, new_cells, new_neigh, vert_order, cell_order
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def _renumber_tess_uint32(np.ndarray[np.float64_t, ndim=2] pts,
+                          np.ndarray[np.uint32_t, ndim=2] cells,
+                          np.ndarray[np.uint32_t, ndim=2] neigh,
+                          np.uint32_t idx_inf, str method, int nthreads):
+    cdef uint32_t ndim = <uint32_t>pts.shape[1]
+    cdef uint64_t npts = <uint64_t>pts.shape[0]
+    cdef uint64_t ncells = <uint64_t>cells.shape[0]
+    cdef np.ndarray[np.uint64_t, ndim=1] vert_order = np.arange(npts, dtype='uint64')
+    cdef np.ndarray[np.uint64_t, ndim=1] cell_order = np.arange(ncells, dtype='uint64')
+    cdef np.ndarray[np.float64_t, ndim=2] new_pts = np.empty_like(pts)
+    cdef np.ndarray[np.uint32_t, ndim=2] new_cells = np.empty_like(cells)
+    cdef np.ndarray[np.uint32_t, ndim=2] new_neigh = np.empty_like(neigh)
+    if (npts == 0) or (ncells == 0):
+        return pts.copy(), cells.copy(), neigh.copy(), vert_order, cell_order
+    if method == 'hilbert':
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            hilbert_order_tess[uint32_t](ndim, npts, &pts[0,0], ncells,
+                                         &cells[0,0], idx_inf, &vert_order[0],
+                                         &cell_order[0], nthreads)
+    elif method == 'rcm':
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            rcm_order_tess[uint32_t](ndim, npts, ncells, &cells[0,0],
+                                     &neigh[0,0], idx_inf, &vert_order[0],
+                                     &cell_order[0])
+    else:
+        raise ValueError("Unsupported renumbering method '{}'.".format(method))
+    with nogil, cython.boundscheck(False), cython.wraparound(False):
+        renumber_tess[uint32_t](ndim, npts, &pts[0,0], ncells, &cells[0,0],
+                                &neigh[0,0], idx_inf, &vert_order[0], &cell_order[0],
+                                &new_pts[0,0], &new_cells[0,0], &new_neigh[0,0],
+                                nthreads)
+    return new_pts, new_cells, new_neigh, vert_order, cell_order
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def _renumber_tess_int64(np.ndarray[np.float64_t, ndim=2] pts,
+                         np.ndarray[np.int64_t, ndim=2] cells,
+                         np.ndarray[np.int64_t, ndim=2] neigh,
+                         np.int64_t idx_inf, str method, int nthreads):
+    cdef uint32_t ndim = <uint32_t>pts.shape[1]
+    cdef uint64_t npts = <uint64_t>pts.shape[0]
+    cdef uint64_t ncells = <uint64_t>cells.shape[0]
+    cdef np.ndarray[np.uint64_t, ndim=1] vert_order = np.arange(npts, dtype='uint64')
+    cdef np.ndarray[np.uint64_t, ndim=1] cell_order = np.arange(ncells, dtype='uint64')
+    cdef np.ndarray[np.float64_t, ndim=2] new_pts = np.empty_like(pts)
+    cdef np.ndarray[np.int64_t, ndim=2] new_cells = np.empty_like(cells)
+    cdef np.ndarray[np.int64_t, ndim=2] new_neigh = np.empty_like(neigh)
+    if (npts == 0) or (ncells == 0):
+        return pts.copy(), cells.copy(), neigh.copy(), vert_order, cell_order
+    if method == 'hilbert':
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            hilbert_order_tess[int64_t](ndim, npts, &pts[0,0], ncells,
+                                        &cells[0,0], idx_inf, &vert_order[0],
+                                        &cell_order[0], nthreads)
+    elif method == 'rcm':
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            rcm_order_tess[int64_t](ndim, npts, ncells, &cells[0,0],
+                                    &neigh[0,0], idx_inf, &vert_order[0],
+                                    &cell_order[0])
+    else:
+        raise ValueError("Unsupported renumbering method '{}'.".format(method))
+    with nogil, cython.boundscheck(False), cython.wraparound(False):
+        renumber_tess[int64_t](ndim, npts, &pts[0,0], ncells, &cells[0,0],
+                               &neigh[0,0], idx_inf, &vert_order[0], &cell_order[0],
+                               &new_pts[0,0], &new_cells[0,0], &new_neigh[0,0],
+                               nthreads)
+    return new_pts, new_cells, new_neigh, vert_order, cell_order
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def _renumber_tess_uint64(np.ndarray[np.float64_t, ndim=2] pts,
+                          np.ndarray[np.uint64_t, ndim=2] cells,
+                          np.ndarray[np.uint64_t, ndim=2] neigh,
+                          np.uint64_t idx_inf, str method, int nthreads):
+    cdef uint32_t ndim = <uint32_t>pts.shape[1]
+    cdef uint64_t npts = <uint64_t>pts.shape[0]
+    cdef uint64_t ncells = <uint64_t>cells.shape[0]
+    cdef np.ndarray[np.uint64_t, ndim=1] vert_order = np.arange(npts, dtype='uint64')
+    cdef np.ndarray[np.uint64_t, ndim=1] cell_order = np.arange(ncells, dtype='uint64')
+    cdef np.ndarray[np.float64_t, ndim=2] new_pts = np.empty_like(pts)
+    cdef np.ndarray[np.uint64_t, ndim=2] new_cells = np.empty_like(cells)
+    cdef np.ndarray[np.uint64_t, ndim=2] new_neigh = np.empty_like(neigh)
+    if (npts == 0) or (ncells == 0):
+        return pts.copy(), cells.copy(), neigh.copy(), vert_order, cell_order
+    if method == 'hilbert':
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            hilbert_order_tess[uint64_t](ndim, npts, &pts[0,0], ncells,
+                                         &cells[0,0], idx_inf, &vert_order[0],
+                                         &cell_order[0], nthreads)
+    elif method == 'rcm':
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            rcm_order_tess[uint64_t](ndim, npts, ncells, &cells[0,0],
+                                     &neigh[0,0], idx_inf, &vert_order[0],
+                                     &cell_order[0])
+    else:
+        raise ValueError("Unsupported renumbering method '{}'.".format(method))
+    with nogil, cython.boundscheck(False), cython.wraparound(False):
+        renumber_tess[uint64_t](ndim, npts, &pts[0,0], ncells, &cells[0,0],
+                                &neigh[0,0], idx_inf, &vert_order[0], &cell_order[0],
+                                &new_pts[0,0], &new_cells[0,0], &new_neigh[0,0],
+                                nthreads)
+    return new_pts, new_cells, new_neigh, vert_order, cell_order
+
+def py_renumber_tess(pts, cells, neigh, idx_inf, method='hilbert', nthreads=0):
+    r"""Renumber the vertices and cells of a serialized tessellation so that 
+    nearby vertices/cells are close in memory.
+
+    Args:
+        pts (np.ndarray of float64): (n, m) array of the coordinates of the 
+            vertices referenced by `cells`.
+        cells (np.ndarray of int): (n, m+1) array of vertex indices 
+            for the n cells in a m-dimensional triangulation.
+        neigh (np.ndarray of int): (n, m+1) array of neighboring cells.
+        idx_inf (int): Index used for the infinite vertex in `cells` and for 
+            missing neighbors in `neigh`.
+        method (str, optional): 'hilbert' to order vertices and cell 
+            centroids along a Hilbert curve, or 'rcm' to order cells by 
+            reverse Cuthill-McKee on the neighbor graph and vertices by their 
+            first use in the reordered cells. Defaults to 'hilbert'.
+        nthreads (int, optional): Number of threads to use. If <= 0, the 
+            number of hardware threads is used. Defaults to 0.
+
+    Returns:
+        tuple: The renumbered points, cells, and neighbors, followed by the 
+            vertex and cell permutations (uint64). The permutations give the 
+            old index for each new index (e.g. `new_pts = pts[vert_order]`).
+
+    """
+    pts = np.ascontiguousarray(pts, dtype='float64')
+    assert(cells.shape == neigh.shape)
+    assert(cells.shape[1] == (pts.shape[1] + 1))
+    if cells.dtype == np.int32:
+        return _renumber_tess_int32(pts, cells, neigh, idx_inf, method,
+                                    nthreads)
+    elif cells.dtype == np.uint32:
+        return _renumber_tess_uint32(pts, cells, neigh, idx_inf, method,
+                                     nthreads)
+    elif cells.dtype == np.int64:
+        return _renumber_tess_int64(pts, cells, neigh, idx_inf, method,
+                                    nthreads)
+    elif cells.dtype == np.uint64:
+        return _renumber_tess_uint64(pts, cells, neigh, idx_inf, method,
+                                     nthreads)
+    else:
+        raise TypeError("Type {} not supported.".format(cells.dtype))
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def py_hilbert_keys(np.ndarray[np.float64_t, ndim=2] pts,
+                    np.ndarray[np.float64_t, ndim=1] le = None,
+                    np.ndarray[np.float64_t, ndim=1] re = None,
+                    int nthreads = 0):
+    r"""Get the position of points along a Hilbert curve.
+
+    Args:
+        pts (np.ndarray of float64): (n, m) array of point coordinates.
+        le (np.ndarray of float64, optional): Minimum of the box the curve 
+            fills. Defaults to the minimum of `pts`.
+        re (np.ndarray of float64, optional): Maximum of the box the curve 
+            fills. Defaults to the maximum of `pts`.
+        nthreads (int, optional): Number of threads to use. If <= 0, the 
+            number of hardware threads is used. Defaults to 0.
+
+    Returns:
+        np.ndarray of uint64: Hilbert key for each point.
+
+    """
+    cdef uint32_t ndim = <uint32_t>pts.shape[1]
+    cdef uint64_t npts = <uint64_t>pts.shape[0]
+    cdef np.ndarray[np.uint64_t, ndim=1] keys = np.empty(npts, 'uint64')
+    if npts == 0:
+        return keys
+    pts = np.ascontiguousarray(pts)
+    if le is None:
+        le = pts.min(axis=0)
+    if re is None:
+        re = pts.max(axis=0)
+    with nogil, cython.boundscheck(False), cython.wraparound(False):
+        hilbert_keys(ndim, npts, &pts[0,0], &le[0], &re[0], &keys[0],
+                     nthreads)
+    return keys
+
+
+cell_quality_dtype = np.dtype([('min_angle', 'float64'),
+                               ('radius_edge', 'float64'),
+                               ('volume', 'float64')])
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def _cell_quality_int32(np.ndarray[np.float64_t, ndim=2] pts,
+                        np.ndarray[np.int32_t, ndim=2] cells,
+                        np.int32_t idx_inf, int nthreads):
+    cdef uint32_t ndim = <uint32_t>pts.shape[1]
+    cdef uint64_t ncells = <uint64_t>cells.shape[0]
+    cdef np.ndarray[np.float64_t, ndim=1] min_angle = np.empty(ncells, 'float64')
+    cdef np.ndarray[np.float64_t, ndim=1] radius_edge = np.empty(ncells, 'float64')
+    cdef np.ndarray[np.float64_t, ndim=1] volume = np.empty(ncells, 'float64')
+    if ncells > 0:
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            cell_quality[int32_t](ndim, &pts[0,0], ncells, &cells[0,0], idx_inf,
+                                  &min_angle[0], &radius_edge[0], &volume[0],
+                                  nthreads)
+    return min_angle, radius_edge, volume
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def _cell_quality_uint32(np.ndarray[np.float64_t, ndim=2] pts,
+                         np.ndarray[np.uint32_t, ndim=2] cells,
+                         np.uint32_t idx_inf, int nthreads):
+    cdef uint32_t ndim = <uint32_t>pts.shape[1]
+    cdef uint64_t ncells = <uint64_t>cells.shape[0]
+    cdef np.ndarray[np.float64_t, ndim=1] min_angle = np.empty(ncells, 'float64')
+    cdef np.ndarray[np.float64_t, ndim=1] radius_edge = np.empty(ncells, 'float64')
+    cdef np.ndarray[np.float64_t, ndim=1] volume = np.empty(ncells, 'float64')
+    if ncells > 0:
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            cell_quality[uint32_t](ndim, &pts[0,0], ncells, &cells[0,0], idx_inf,
+                                   &min_angle[0], &radius_edge[0], &volume[0],
+                                   nthreads)
+    return min_angle, radius_edge, volume
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def _cell_quality_int64(np.ndarray[np.float64_t, ndim=2] pts,
+                        np.ndarray[np.int64_t, ndim=2] cells,
+                        np.int64_t idx_inf, int nthreads):
+    cdef uint32_t ndim = <uint32_t>pts.shape[1]
+    cdef uint64_t ncells = <uint64_t>cells.shape[0]
+    cdef np.ndarray[np.float64_t, ndim=1] min_angle = np.empty(ncells, 'float64')
+    cdef np.ndarray[np.float64_t, ndim=1] radius_edge = np.empty(ncells, 'float64')
+    cdef np.ndarray[np.float64_t, ndim=1] volume = np.empty(ncells, 'float64')
+    if ncells > 0:
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            cell_quality[int64_t](ndim, &pts[0,0], ncells, &cells[0,0], idx_inf,
+                                  &min_angle[0], &radius_edge[0], &volume[0],
+                                  nthreads)
+    return min_angle, radius_edge, volume
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def _cell_quality_uint64(np.ndarray[np.float64_t, ndim=2] pts,
+                         np.ndarray[np.uint64_t, ndim=2] cells,
+                         np.uint64_t idx_inf, int nthreads):
+    cdef uint32_t ndim = <uint32_t>pts.shape[1]
+    cdef uint64_t ncells = <uint64_t>cells.shape[0]
+    cdef np.ndarray[np.float64_t, ndim=1] min_angle = np.empty(ncells, 'float64')
+    cdef np.ndarray[np.float64_t, ndim=1] radius_edge = np.empty(ncells, 'float64')
+    cdef np.ndarray[np.float64_t, ndim=1] volume = np.empty(ncells, 'float64')
+    if ncells > 0:
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            cell_quality[uint64_t](ndim, &pts[0,0], ncells, &cells[0,0], idx_inf,
+                                   &min_angle[0], &radius_edge[0], &volume[0],
+                                   nthreads)
+    return min_angle, radius_edge, volume
+
+def py_cell_quality(pts, cells, idx_inf, nthreads=0):
+    r"""Compute quality metrics for every cell in a serialized 2D or 3D 
+    tessellation in parallel.
+
+    Args:
+        pts (np.ndarray of float64): (n, m) array of the coordinates of the 
+            vertices referenced by `cells`.
+        cells (np.ndarray of int): (n, m+1) array of vertex indices 
+            for the n cells in a m-dimensional triangulation.
+        idx_inf (int): Index used for the infinite vertex in `cells`.
+        nthreads (int, optional): Number of threads to use. If <= 0, the 
+            number of hardware threads is used. Defaults to 0.
+
+    Returns:
+        np.ndarray: Structured array with an entry for each cell and fields 
+            'min_angle' (minimum interior angle in 2D or dihedral angle in 3D, 
+            in radians), 'radius_edge' (ratio of the circumradius to the 
+            shortest edge), and 'volume' (area in 2D). Infinite cells are NaN.
+
+    """
+    pts = np.ascontiguousarray(pts, dtype='float64')
+    assert(cells.shape[1] == (pts.shape[1] + 1))
+    if cells.dtype == np.int32:
+        x = _cell_quality_int32(pts, cells, idx_inf, nthreads)
+    elif cells.dtype == np.uint32:
+        x = _cell_quality_uint32(pts, cells, idx_inf, nthreads)
+    elif cells.dtype == np.int64:
+        x = _cell_quality_int64(pts, cells, idx_inf, nthreads)
+    elif cells.dtype == np.uint64:
+        x = _cell_quality_uint64(pts, cells, idx_inf, nthreads)
+    else:
+        raise TypeError("Type {} not supported.".format(cells.dtype))
+    out = np.empty(cells.shape[0], dtype=cell_quality_dtype)
+    out['min_angle'], out['radius_edge'], out['volume'] = x
+    return out
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def py_leaf_adjacency(np.ndarray[np.float64_t, ndim=2] left_edges,
+                      np.ndarray[np.float64_t, ndim=2] right_edges,
+                      np.ndarray[np.float64_t, ndim=1] domain_left_edge,
+                      np.ndarray[np.float64_t, ndim=1] domain_right_edge,
+                      object periodic=False):
+    r"""Determine which leaves in a domain decomposition share a face,
+    including across periodic boundaries.
+
+    Args:
+        left_edges (np.ndarray of float64): (n, m) minimums of the n leaves
+            in each dimension.
+        right_edges (np.ndarray of float64): (n, m) maximums of the n leaves
+            in each dimension.
+        domain_left_edge (np.ndarray of float64): (m,) domain minimum in each
+            dimension.
+        domain_right_edge (np.ndarray of float64): (m,) domain maximum in each
+            dimension.
+        periodic (bool or np.ndarray of bool, optional): True if the domain is
+            periodic, either in all dimensions or in each of the m dimensions.
+            Defaults to False.
+
+    Returns:
+        tuple: Containing
+
+            * periodic_left (np.ndarray of bool): (n, m) True if the leaf is
+              on the periodic left edge of the domain in each dimension.
+            * periodic_right (np.ndarray of bool): (n, m) True if the leaf is
+              on the periodic right edge of the domain in each dimension.
+            * left_indptr (np.ndarray of uint64): (n*m+1,) start of the left
+              neighbors for leaf i in dimension d at index i*m+d of
+              `left_ids`.
+            * left_ids (np.ndarray of uint32): Left neighbors of each leaf.
+            * right_indptr (np.ndarray of uint64): (n*m+1,) start of the right
+              neighbors for leaf i in dimension d at index i*m+d of
+              `right_ids`.
+            * right_ids (np.ndarray of uint32): Right neighbors of each leaf.
+
+    """
+    cdef uint64_t nleaves = <uint64_t>left_edges.shape[0]
+    cdef uint32_t ndim = <uint32_t>left_edges.shape[1]
+    assert(right_edges.shape[0] == nleaves)
+    assert(right_edges.shape[1] == ndim)
+    left_edges = np.ascontiguousarray(left_edges)
+    right_edges = np.ascontiguousarray(right_edges)
+    cdef np.ndarray[np.uint8_t, ndim=1] per = np.empty(ndim, 'uint8')
+    per[:] = periodic
+    cdef LeafAdjacency adj
+    cdef double *ptr_le = NULL
+    cdef double *ptr_re = NULL
+    if nleaves > 0:
+        ptr_le = &left_edges[0,0]
+        ptr_re = &right_edges[0,0]
+    with nogil, cython.boundscheck(False), cython.wraparound(False):
+        adj = LeafAdjacency(nleaves, ndim, ptr_le, ptr_re,
+                            &domain_left_edge[0], &domain_right_edge[0],
+                            <cbool*>(&per[0]))
+    cdef uint64_t nrow = nleaves*ndim
+    periodic_left = np.empty(nrow, 'bool')
+    periodic_right = np.empty(nrow, 'bool')
+    left_indptr = np.empty(nrow + 1, 'uint64')
+    right_indptr = np.empty(nrow + 1, 'uint64')
+    left_ids = np.empty(adj.left_ids.size(), 'uint32')
+    right_ids = np.empty(adj.right_ids.size(), 'uint32')
+    cdef uint64_t i
+    for i in range(nrow):
+        periodic_left[i] = adj.periodic_left[i]
+        periodic_right[i] = adj.periodic_right[i]
+    for i in range(nrow + 1):
+        left_indptr[i] = adj.left_indptr[i]
+        right_indptr[i] = adj.right_indptr[i]
+    for i in range(adj.left_ids.size()):
+        left_ids[i] = adj.left_ids[i]
+    for i in range(adj.right_ids.size()):
+        right_ids[i] = adj.right_ids[i]
+    return (periodic_left.reshape(nleaves, ndim),
+            periodic_right.reshape(nleaves, ndim),
+            left_indptr, left_ids, right_indptr, right_ids)
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def py_overlapping_leaves(np.ndarray[np.float64_t, ndim=2] left_edges,
+                          np.ndarray[np.float64_t, ndim=2] right_edges):
+    r"""Determine which leaves in a domain decomposition have boxes that
+    overlap or touch, e.g. the chunks of a curve decomposition.
+
+    Args:
+        left_edges (np.ndarray of float64): (n, m) minimums of the n leaves
+            in each dimension.
+        right_edges (np.ndarray of float64): (n, m) maximums of the n leaves
+            in each dimension.
+
+    Returns:
+        tuple: Containing
+
+            * indptr (np.ndarray of uint64): (n+1,) start of the neighbors of
+              leaf i in `ids`.
+            * ids (np.ndarray of uint32): Neighbors of each leaf, not
+              including the leaf itself. Leaves with inverted (empty) boxes
+              have none.
+
+    """
+    cdef uint64_t nleaves = <uint64_t>left_edges.shape[0]
+    cdef uint32_t ndim = <uint32_t>left_edges.shape[1]
+    assert(right_edges.shape[0] == nleaves)
+    assert(right_edges.shape[1] == ndim)
+    left_edges = np.ascontiguousarray(left_edges)
+    right_edges = np.ascontiguousarray(right_edges)
+    cdef vector[uint64_t] c_indptr
+    cdef vector[uint32_t] c_ids
+    cdef double *ptr_le = NULL
+    cdef double *ptr_re = NULL
+    if nleaves > 0:
+        ptr_le = &left_edges[0,0]
+        ptr_re = &right_edges[0,0]
+    with nogil, cython.boundscheck(False), cython.wraparound(False):
+        LeafAdjacency.overlapping(nleaves, ndim, ptr_le, ptr_re,
+                                  c_indptr, c_ids)
+    indptr = np.empty(c_indptr.size(), 'uint64')
+    ids = np.empty(c_ids.size(), 'uint32')
+    cdef uint64_t i
+    for i in range(c_indptr.size()):
+        indptr[i] = c_indptr[i]
+    for i in range(c_ids.size()):
+        ids[i] = c_ids[i]
+    return indptr, ids
+
+# Split policies accepted by py_split_kdtree
+SPLIT_MEDIAN = 0
+SPLIT_COST = 1
+_split_policies = {'median': SPLIT_MEDIAN, 'cost': SPLIT_COST}
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def py_split_kdtree(np.ndarray[np.float64_t, ndim=2] pts,
+                    np.ndarray[np.float64_t, ndim=1] left_edge,
+                    np.ndarray[np.float64_t, ndim=1] right_edge,
+                    object periodic=False, uint64_t leafsize=0,
+                    uint64_t nleaves=0, object split='cost',
+                    double max_aspect=4.0):
+    r"""Decompose a domain into KD tree leaves using the selected split policy.
+
+    Args:
+        pts (np.ndarray of float64): (n, m) array of n coordinates in a
+            m-dimensional domain.
+        left_edge (np.ndarray of float64): (m,) domain minimum in each
+            dimension.
+        right_edge (np.ndarray of float64): (m,) domain maximum in each
+            dimension.
+        periodic (bool or np.ndarray of bool, optional): True if the domain is
+            periodic, either in all dimensions or in each of the m dimensions.
+            Defaults to False.
+        leafsize (int, optional): Nodes with fewer than this many points are
+            not split. Ignored if `nleaves` is non-zero. Defaults to 0.
+        nleaves (int, optional): Number of leaves that should be created.
+            Defaults to 0.
+        split (str, optional): Split policy. 'median' splits at the median of
+            the widest dimension. 'cost' chooses the split that balances the
+            number of points plus the estimated number of halo points
+            (exposed surface area times density) between the children.
+            Defaults to 'cost'.
+        max_aspect (float, optional): Largest ratio of the widest to the
+            narrowest side of a leaf allowed by the 'cost' policy. Defaults to
+            4.0.
+
+    Returns:
+        tuple: Containing
+
+            * idx (np.ndarray of uint64): (n,) indices sorting the points by
+              the leaf that contains them.
+            * leaf_start (np.ndarray of uint64): (nleaves+1,) leaf i contains
+              points idx[leaf_start[i]:leaf_start[i+1]].
+            * leaves_le (np.ndarray of float64): (nleaves, m) leaf minimums.
+            * leaves_re (np.ndarray of float64): (nleaves, m) leaf maximums.
+
+    Raises:
+        ValueError: If `split` is not a supported policy or neither `leafsize`
+            nor `nleaves` is provided.
+
+    """
+    if split not in _split_policies:
+        raise ValueError("'{}' is not a supported split policy.".format(split))
+    if (leafsize == 0) and (nleaves == 0):
+        raise ValueError("Either 'leafsize' or 'nleaves' must be provided.")
+    cdef int policy = _split_policies[split]
+    cdef uint64_t npts = <uint64_t>pts.shape[0]
+    cdef uint32_t ndim = <uint32_t>pts.shape[1]
+    assert(left_edge.shape[0] == ndim)
+    assert(right_edge.shape[0] == ndim)
+    pts = np.ascontiguousarray(pts)
+    cdef np.ndarray[np.uint64_t, ndim=1] idx = np.arange(npts, dtype='uint64')
+    cdef np.ndarray[np.uint8_t, ndim=1] per = np.empty(ndim, 'uint8')
+    per[:] = periodic
+    cdef double *ptr_pts = NULL
+    cdef uint64_t *ptr_idx = NULL
+    if npts > 0:
+        ptr_pts = &pts[0,0]
+        ptr_idx = &idx[0]
+    cdef SplitKDTree *tree
+    with nogil, cython.boundscheck(False), cython.wraparound(False):
+        tree = new SplitKDTree(ptr_pts, ptr_idx, npts, ndim, leafsize,
+                               nleaves, &left_edge[0], &right_edge[0],
+                               <cbool*>(&per[0]), policy, max_aspect)
+    cdef uint64_t i, n = tree.num_leaves()
+    leaf_start = np.empty(n + 1, 'uint64')
+    leaves_le = np.empty(n*ndim, 'float64')
+    leaves_re = np.empty(n*ndim, 'float64')
+    for i in range(n + 1):
+        leaf_start[i] = tree.leaf_start[i]
+    for i in range(n*ndim):
+        leaves_le[i] = tree.leaves_le[i]
+        leaves_re[i] = tree.leaves_re[i]
+    del tree
+    return (idx, leaf_start, leaves_le.reshape(n, ndim),
+            leaves_re.reshape(n, ndim))
+
+# Space filling curves accepted by py_curve_decomposition
+CURVE_HILBERT = 0
+CURVE_MORTON = 1
+_curves = {'hilbert': CURVE_HILBERT, 'morton': CURVE_MORTON}
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def py_curve_decomposition(np.ndarray[np.float64_t, ndim=2] pts,
+                           np.ndarray[np.float64_t, ndim=1] left_edge,
+                           np.ndarray[np.float64_t, ndim=1] right_edge,
+                           uint64_t nchunks, object weights=None,
+                           object curve='hilbert', int nthreads=0):
+    r"""Decompose a domain by cutting a space filling curve through the points
+    into chunks of equal total weight.
+
+    Args:
+        pts (np.ndarray of float64): (n, m) array of n coordinates in a
+            m-dimensional domain.
+        left_edge (np.ndarray of float64): (m,) domain minimum in each
+            dimension.
+        right_edge (np.ndarray of float64): (m,) domain maximum in each
+            dimension.
+        nchunks (int): Number of chunks to cut the curve into. Unlike a KD
+            tree, this does not need to be a power of two.
+        weights (np.ndarray of float64, optional): (n,) weight of each point.
+            Defaults to None and every point has the same weight.
+        curve (str, optional): 'hilbert' or 'morton'. Defaults to 'hilbert'.
+        nthreads (int, optional): Number of threads to use. Defaults to 0 and
+            the hardware concurrency is used.
+
+    Returns:
+        tuple: Containing
+
+            * idx (np.ndarray of uint64): (n,) indices sorting the points along
+              the curve.
+            * leaf_start (np.ndarray of uint64): (nchunks+1,) chunk i contains
+              points idx[leaf_start[i]:leaf_start[i+1]].
+            * leaves_le (np.ndarray of float64): (nchunks, m) minimums of the
+              box of each chunk. Boxes are made of the curve grid cells that
+              the chunk's section of the curve passes through, so together
+              they cover the domain, and may overlap.
+            * leaves_re (np.ndarray of float64): (nchunks, m) maximums of the
+              box of each chunk.
+
+    Raises:
+        ValueError: If `curve` is not a supported curve.
+
+    """
+    if curve not in _curves:
+        raise ValueError("'{}' is not a supported curve.".format(curve))
+    cdef int icurve = _curves[curve]
+    cdef uint64_t npts = <uint64_t>pts.shape[0]
+    cdef uint32_t ndim = <uint32_t>pts.shape[1]
+    assert(left_edge.shape[0] == ndim)
+    assert(right_edge.shape[0] == ndim)
+    pts = np.ascontiguousarray(pts)
+    cdef np.ndarray[np.uint64_t, ndim=1] idx = np.arange(npts, dtype='uint64')
+    cdef np.ndarray[np.float64_t, ndim=1] w
+    cdef double *ptr_w = NULL
+    if weights is not None:
+        w = np.ascontiguousarray(weights, dtype='float64')
+        assert(w.shape[0] == npts)
+        if npts > 0:
+            ptr_w = &w[0]
+    cdef double *ptr_pts = NULL
+    cdef uint64_t *ptr_idx = NULL
+    if npts > 0:
+        ptr_pts = &pts[0,0]
+        ptr_idx = &idx[0]
+    cdef CurveDecomposition *dd
+    with nogil, cython.boundscheck(False), cython.wraparound(False):
+        dd = new CurveDecomposition(ptr_pts, ptr_idx, npts, ndim, nchunks,
+                                    &left_edge[0], &right_edge[0], ptr_w,
+                                    icurve, nthreads)
+    cdef uint64_t i, n = dd.num_leaves()
+    leaf_start = np.empty(n + 1, 'uint64')
+    leaves_le = np.empty(n*ndim, 'float64')
+    leaves_re = np.empty(n*ndim, 'float64')
+    for i in range(n + 1):
+        leaf_start[i] = dd.leaf_start[i]
+    for i in range(n*ndim):
+        leaves_le[i] = dd.leaves_le[i]
+        leaves_re[i] = dd.leaves_re[i]
+    del dd
+    return (idx, leaf_start, leaves_le.reshape(n, ndim),
+            leaves_re.reshape(n, ndim))
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def py_merge_small_leaves(np.ndarray[np.uint64_t, ndim=1] leaf_start,
+                          np.ndarray[np.float64_t, ndim=2] left_edges,
+                          np.ndarray[np.float64_t, ndim=2] right_edges,
+                          uint64_t min_npts, uint64_t min_nleaves=1):
+    r"""Merge leaves with too few points into a neighboring leaf of a depth
+    first decomposition. Only consecutive leaves whose union is a box are
+    merged.
+
+    Args:
+        leaf_start (np.ndarray of uint64): (n+1,) leaf i owns the sorted
+            points leaf_start[i]:leaf_start[i+1].
+        left_edges (np.ndarray of float64): (n, m) minimums of the n leaves in
+            each dimension.
+        right_edges (np.ndarray of float64): (n, m) maximums of the n leaves in
+            each dimension.
+        min_npts (int): Minimum number of points on a leaf.
+        min_nleaves (int, optional): Merging stops once this many leaves are
+            left, e.g. the number of processes. Defaults to 1.
+
+    Returns:
+        tuple: leaf_start, left_edges & right_edges for the merged leaves.
+
+    """
+    cdef uint64_t nleaves = <uint64_t>left_edges.shape[0]
+    cdef uint32_t ndim = <uint32_t>left_edges.shape[1]
+    assert(leaf_start.size == (nleaves + 1))
+    assert(right_edges.shape[0] == nleaves)
+    assert(right_edges.shape[1] == ndim)
+    cdef vector[uint64_t] c_start = leaf_start
+    cdef vector[double] c_le = left_edges.ravel()
+    cdef vector[double] c_re = right_edges.ravel()
+    with nogil, cython.boundscheck(False), cython.wraparound(False):
+        nleaves = merge_small_leaves(ndim, min_npts, c_start, c_le, c_re,
+                                     min_nleaves)
+    return (np.array(c_start, 'uint64'),
+            np.array(c_le, 'float64').reshape(nleaves, ndim),
+            np.array(c_re, 'float64').reshape(nleaves, ndim))
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def py_find_leaves(np.ndarray[np.float64_t, ndim=2] pts,
+                   np.ndarray[np.float64_t, ndim=2] left_edges,
+                   np.ndarray[np.float64_t, ndim=2] right_edges, nthreads=0,
+                   nearest=False):
+    r"""Locate the leaf containing each point and group the points by leaf.
+
+    Args:
+        pts (np.ndarray of float64): (n, m) array of n m-dimensional
+            coordinates.
+        left_edges (np.ndarray of float64): (k, m) minimums of the k leaves in
+            each dimension.
+        right_edges (np.ndarray of float64): (k, m) maximums of the k leaves in
+            each dimension.
+        nthreads (int, optional): Number of threads to use. Defaults to 0 and
+            the hardware concurrency is used.
+        nearest (bool, optional): If True, points that are not inside any
+            leaf are given the leaf whose box is closest to them. Defaults to
+            False.
+
+    Returns:
+        tuple: Containing
+
+            * leaf_ids (np.ndarray of int64): (n,) leaf containing each point
+              or -1 if the point is not inside any leaf (and `nearest` is
+              False).
+            * indptr (np.ndarray of uint64): (k+1,) the points on leaf i are
+              order[indptr[i]:indptr[i+1]].
+            * order (np.ndarray of uint64): Indices of the points inside a
+              leaf, grouped by leaf and in increasing order within a leaf.
+
+    """
+    cdef uint64_t npts = <uint64_t>pts.shape[0]
+    cdef uint64_t nleaves = <uint64_t>left_edges.shape[0]
+    cdef uint32_t ndim = <uint32_t>pts.shape[1]
+    assert(left_edges.shape[1] == ndim)
+    assert(right_edges.shape[0] == nleaves)
+    assert(right_edges.shape[1] == ndim)
+    pts = np.ascontiguousarray(pts)
+    left_edges = np.ascontiguousarray(left_edges)
+    right_edges = np.ascontiguousarray(right_edges)
+    cdef int c_nthreads = nthreads
+    cdef cbool c_nearest = <cbool>nearest
+    cdef uint64_t j
+    cdef np.ndarray[np.int64_t, ndim=1] leaf_ids = -np.ones(npts, 'int64')
+    cdef vector[uint64_t] c_indptr
+    cdef vector[uint64_t] c_order
+    cdef LeafLocator *loc = NULL
+    cdef double *ptr_le = NULL
+    cdef double *ptr_re = NULL
+    cdef int64_t *ptr_ids = NULL
+    if nleaves > 0:
+        ptr_le = &left_edges[0,0]
+        ptr_re = &right_edges[0,0]
+    loc = new LeafLocator(nleaves, ndim, ptr_le, ptr_re)
+    with nogil, cython.boundscheck(False), cython.wraparound(False):
+        if npts > 0:
+            ptr_ids = &leaf_ids[0]
+            loc.find_all(npts, &pts[0,0], ptr_ids, c_nthreads)
+            if c_nearest:
+                for j in range(npts):
+                    if ptr_ids[j] < 0:
+                        ptr_ids[j] = loc.nearest(&pts[j,0])
+        LeafLocator_group_by_leaf(npts, ptr_ids, nleaves, c_indptr, c_order,
+                                  c_nthreads)
+    del loc
+    indptr = np.empty(nleaves + 1, 'uint64')
+    order = np.empty(c_order.size(), 'uint64')
+    cdef uint64_t i
+    for i in range(nleaves + 1):
+        indptr[i] = c_indptr[i]
+    for i in range(c_order.size()):
+        order[i] = c_order[i]
+    return leaf_ids, indptr, order
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def py_encode_exchange(np.ndarray[np.float64_t, ndim=2] pts,
+                       np.ndarray[np.uint64_t, ndim=1] idx):
+    r"""Losslessly encode a group of points and their indices as they are
+    sent between leaves during a parallel exchange. Indices are delta coded
+    and coordinates are stored as bit-packed offsets from the smallest
+    coordinate in the group.
+
+    Args:
+        pts (np.ndarray of float64): (n, m) array of n m-dimensional
+            coordinates.
+        idx (np.ndarray of uint64): (n,) indices of the points.
+
+    Returns:
+        tuple: Containing
+
+            * buf (bytes): Encoded points.
+            * pts (np.ndarray of float64): The points sorted by index, as they
+              will be decoded.
+            * idx (np.ndarray of uint64): The sorted indices.
+
+    """
+    cdef uint64_t n = <uint64_t>pts.shape[0]
+    cdef uint32_t ndim = <uint32_t>pts.shape[1]
+    assert(idx.shape[0] == n)
+    pts = np.array(pts, order='C', copy=True)
+    idx = np.array(idx, copy=True)
+    cdef vector[uint8_t] c_buf
+    if n > 0:
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            encode_exchange[uint64_t](ndim, n, &pts[0,0], &idx[0], c_buf)
+    cdef bytes buf = b''
+    if c_buf.size() > 0:
+        buf = (<char*>&c_buf[0])[:c_buf.size()]
+    return buf, pts, idx
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def py_decode_exchange(bytes buf, uint64_t n, uint32_t ndim):
+    r"""Decode a group of points encoded by
+    :func:`cgal4py.delaunay.tools.py_encode_exchange`.
+
+    Args:
+        buf (bytes): Encoded points.
+        n (int): Number of points.
+        ndim (int): Number of dimensions.
+
+    Returns:
+        tuple: Containing
+
+            * pts (np.ndarray of float64): (n, m) decoded coordinates.
+            * idx (np.ndarray of uint64): (n,) decoded indices.
+
+    """
+    cdef np.ndarray[np.float64_t, ndim=2] pts = np.empty((n, ndim), 'float64')
+    cdef np.ndarray[np.uint64_t, ndim=1] idx = np.empty(n, 'uint64')
+    cdef const uint8_t *ptr = <const uint8_t*><char*>buf
+    if n > 0:
+        with nogil, cython.boundscheck(False), cython.wraparound(False):
+            decode_exchange[uint64_t](ptr, ndim, n, &pts[0,0], &idx[0])
+    return pts, idx
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+def py_gather_points(np.ndarray[np.float64_t, ndim=2] pts, idx, nthreads=0):
+    r"""Copy points into the order given by an index, e.g. the sorted index
+    of a domain decomposition tree so that the points on each leaf form one
+    contiguous slice.
+
+    Args:
+        pts (np.ndarray of float64): (n, m) array of n m-dimensional
+            coordinates.
+        idx (np.ndarray of int): (k,) indices of the points to copy.
+        nthreads (int, optional): Number of threads to use. Defaults to 0 and
+            the hardware concurrency is used.
+
+    Returns:
+        np.ndarray of float64: (k, m) array where row j is pts[idx[j], :].
+
+    """
+    pts = np.ascontiguousarray(pts)
+    cdef np.ndarray[np.uint64_t, ndim=1] c_idx
+    c_idx = np.ascontiguousarray(idx, dtype='uint64')
+    cdef uint32_t ndim = <uint32_t>pts.shape[1]
+    cdef uint64_t n = <uint64_t>c_idx.shape[0]
+    cdef int c_nthreads = nthreads
+    if n > 0:
+        assert(c_idx.max() < <uint64_t>pts.shape[0])
+    cdef np.ndarray[np.float64_t, ndim=2] out = np.empty((n, ndim), 'float64')
+    if n == 0:
+        return out
+    with nogil, cython.boundscheck(False), cython.wraparound(False):
+        gather_points[uint64_t](ndim, n, &pts[0,0], &c_idx[0], &out[0,0],
+                                c_nthreads)
+    return out
+
 @cython.boundscheck(False)
 @cython.wraparound(False)
 cdef sLeaves32 _vectorize_leaves_uint32(np.uint32_t ndim, object serial,
@@ -694,20 +1699,18 @@ cdef np.int64_t _consolidate_uint32_uint64(np.uint32_t ndim, np.uint64_t idx_inf
                                            np.ndarray[np.uint64_t] leaf_start,
                                            np.ndarray[np.uint64_t] leaf_stop,
                                            np.ndarray[np.uint64_t, ndim=2] verts, 
-                                           np.ndarray[np.uint64_t, ndim=2] cells):
+                                           np.ndarray[np.uint64_t, ndim=2] cells,
+                                           int nthreads, uint64_t *nconflict):
     cdef sLeaves32 leaves = _vectorize_leaves_uint32(ndim, serial, leaf_start, leaf_stop)
-    cdef uint64_t num_leaves = <uint64_t>leaves.size()
     cdef int64_t max_ncells = <int64_t>verts.shape[0]
     if max_ncells == 0:
         return max_ncells
     assert(cells.shape[0] == max_ncells)
     cdef ConsolidatedLeaves[uint64_t] obj
-    cdef uint64_t i
     with nogil, cython.boundscheck(False), cython.wraparound(False):
         obj = ConsolidatedLeaves[uint64_t](ndim, idx_inf, max_ncells,
                                            &verts[0,0], &cells[0,0])
-        for i in range(num_leaves):
-            obj.add_leaf[uint32_t](leaves[i])
+        nconflict[0] = obj.add_leaves[uint32_t](leaves, nthreads)
         obj.add_inf()
         obj.cleanup()
     cdef np.int64_t ncells = obj.ncells
@@ -720,20 +1723,18 @@ cdef np.int64_t _consolidate_uint32_uint32(np.uint32_t ndim, np.uint32_t idx_inf
                                            np.ndarray[np.uint64_t] leaf_start,
                                            np.ndarray[np.uint64_t] leaf_stop,
                                            np.ndarray[np.uint32_t, ndim=2] verts, 
-                                           np.ndarray[np.uint32_t, ndim=2] cells):
+                                           np.ndarray[np.uint32_t, ndim=2] cells,
+                                           int nthreads, uint64_t *nconflict):
     cdef sLeaves32 leaves = _vectorize_leaves_uint32(ndim, serial, leaf_start, leaf_stop)
-    cdef uint64_t num_leaves = <uint64_t>leaves.size()
     cdef int64_t max_ncells = <int64_t>verts.shape[0]
     if max_ncells == 0:
         return max_ncells
     assert(cells.shape[0] == max_ncells)
     cdef ConsolidatedLeaves[uint32_t] obj
-    cdef uint64_t i
     with nogil, cython.boundscheck(False), cython.wraparound(False):
         obj = ConsolidatedLeaves[uint32_t](ndim, idx_inf, max_ncells,
                                            &verts[0,0], &cells[0,0])
-        for i in range(num_leaves):
-            obj.add_leaf[uint32_t](leaves[i])
+        nconflict[0] = obj.add_leaves[uint32_t](leaves, nthreads)
         obj.add_inf()
         obj.cleanup()
     cdef np.int64_t ncells = obj.ncells
@@ -746,26 +1747,26 @@ cdef np.int64_t _consolidate_uint64_uint64(np.uint32_t ndim, np.uint64_t idx_inf
                                            np.ndarray[np.uint64_t] leaf_start,
                                            np.ndarray[np.uint64_t] leaf_stop,
                                            np.ndarray[np.uint64_t, ndim=2] verts, 
-                                           np.ndarray[np.uint64_t, ndim=2] cells):
+                                           np.ndarray[np.uint64_t, ndim=2] cells,
+                                           int nthreads, uint64_t *nconflict):
     cdef sLeaves64 leaves = _vectorize_leaves_uint64(ndim, serial, leaf_start, leaf_stop)
-    cdef uint64_t num_leaves = <uint64_t>leaves.size()
     cdef int64_t max_ncells = <int64_t>verts.shape[0]
     if max_ncells == 0:
         return max_ncells
     assert(cells.shape[0] == max_ncells)
     cdef ConsolidatedLeaves[uint64_t] obj
-    cdef uint64_t i
     with nogil, cython.boundscheck(False), cython.wraparound(False):
         obj = ConsolidatedLeaves[uint64_t](ndim, idx_inf, max_ncells,
                                            &verts[0,0], &cells[0,0])
-        for i in range(num_leaves):
-            obj.add_leaf[uint64_t](leaves[i])
+        nconflict[0] = obj.add_leaves[uint64_t](leaves, nthreads)
         obj.add_inf()
         obj.cleanup()
     cdef np.int64_t ncells = obj.ncells
     return ncells
 
-def consolidate_leaves(ndim, idx_inf, serial, leaf_start, leaf_stop):
+def consolidate_leaves(ndim, idx_inf, serial, leaf_start, leaf_stop,
+                       nthreads=0):
+    cdef uint64_t nconflict = 0
     dtype_comb = type(idx_inf)
     dtype_leaf = serial[0][0].dtype
     ncells = 0
@@ -785,7 +1786,8 @@ def consolidate_leaves(ndim, idx_inf, serial, leaf_start, leaf_stop):
         if dtype_leaf == np.uint32:
             ncells = _consolidate_uint32_uint32(ndim, idx_inf, serial, 
                                                 leaf_start, leaf_stop,
-                                                verts, neigh)
+                                                verts, neigh, nthreads,
+                                                &nconflict)
         # This case makes no sense so it is not currently supported
         # elif dtype_leaf == np.uint64:
         #     ncells = _consolidate_uint64_uint32(ndim, idx_inf, serial, 
@@ -797,17 +1799,22 @@ def consolidate_leaves(ndim, idx_inf, serial, leaf_start, leaf_stop):
         if dtype_leaf == np.uint32:
             ncells = _consolidate_uint32_uint64(ndim, idx_inf, serial, 
                                                 leaf_start, leaf_stop,
-                                                verts, neigh)
+                                                verts, neigh, nthreads,
+                                                &nconflict)
         elif dtype_leaf == np.uint64:
             ncells = _consolidate_uint64_uint64(ndim, idx_inf, serial, 
                                                 leaf_start, leaf_stop,
-                                                verts, neigh)
+                                                verts, neigh, nthreads,
+                                                &nconflict)
         else:
             raise TypeError("Leaf type {} not supported.".format(dtype_leaf))
     else:
         raise TypeError("Combined type {} not supported.".format(dtype_comb))
     t1 = time.time()
     print("Consolidation (cython) took {}s".format(t1-t0))
+    if nconflict > 0:
+        warnings.warn("{} conflicting neighbors ".format(nconflict) +
+                      "while consolidating leaves.")
     verts.resize((ncells, ndim+1))
     neigh.resize((ncells, ndim+1))
     return verts, neigh
@@ -1251,6 +2258,44 @@ cdef class ConsolidatedLeaves32:
         else:
             raise Exception("Unrecognized leaf type: {}".format(type(leaf)))
 
+    def add_leaves(self, leaves, nthreads=0):
+        r"""Add several serialized leaves to the consolidated tessellation
+        using threads. The result is the same as calling :meth:`add_leaf` on
+        each leaf in order.
+
+        Args:
+            leaves (list): SerializedLeaf32 or SerializedLeaf64 leaves that
+                should be added to the tessellation. All leaves must be of
+                the same type.
+            nthreads (int, optional): Number of threads to use. Defaults to 0
+                and the hardware concurrency is used.
+
+        Returns:
+            int: Number of neighbors that conflicted with ones already set.
+                This is zero unless the leaves are inconsistent.
+
+        """
+        cdef sLeaves32 leaves32
+        cdef sLeaves64 leaves64
+        cdef SerializedLeaf32 leaf32
+        cdef SerializedLeaf64 leaf64
+        cdef int c_nthreads = nthreads
+        cdef uint64_t nconflict = 0
+        if all([isinstance(leaf, SerializedLeaf32) for leaf in leaves]):
+            for leaf32 in leaves:
+                leaves32.push_back(dereference(leaf32.SL))
+            with nogil, cython.boundscheck(False), cython.wraparound(False):
+                nconflict = self.CL.add_leaves[uint32_t](leaves32, c_nthreads)
+        elif all([isinstance(leaf, SerializedLeaf64) for leaf in leaves]):
+            for leaf64 in leaves:
+                leaves64.push_back(dereference(leaf64.SL))
+            with nogil, cython.boundscheck(False), cython.wraparound(False):
+                nconflict = self.CL.add_leaves[uint64_t](leaves64, c_nthreads)
+        else:
+            raise TypeError("Leaves must all be SerializedLeaf32 or all " +
+                            "SerializedLeaf64.")
+        return nconflict
+
     def add_leaf_fromfile(self, fname):
         r"""Add a serialized leaf from a file to the consolidated tessellation.
 
@@ -1351,6 +2396,44 @@ cdef class ConsolidatedLeaves64:
         else:
             raise Exception("Unrecognized leaf type: {}".format(type(leaf)))
 
+    def add_leaves(self, leaves, nthreads=0):
+        r"""Add several serialized leaves to the consolidated tessellation
+        using threads. The result is the same as calling :meth:`add_leaf` on
+        each leaf in order.
+
+        Args:
+            leaves (list): SerializedLeaf32 or SerializedLeaf64 leaves that
+                should be added to the tessellation. All leaves must be of
+                the same type.
+            nthreads (int, optional): Number of threads to use. Defaults to 0
+                and the hardware concurrency is used.
+
+        Returns:
+            int: Number of neighbors that conflicted with ones already set.
+                This is zero unless the leaves are inconsistent.
+
+        """
+        cdef sLeaves32 leaves32
+        cdef sLeaves64 leaves64
+        cdef SerializedLeaf32 leaf32
+        cdef SerializedLeaf64 leaf64
+        cdef int c_nthreads = nthreads
+        cdef uint64_t nconflict = 0
+        if all([isinstance(leaf, SerializedLeaf32) for leaf in leaves]):
+            for leaf32 in leaves:
+                leaves32.push_back(dereference(leaf32.SL))
+            with nogil, cython.boundscheck(False), cython.wraparound(False):
+                nconflict = self.CL.add_leaves[uint32_t](leaves32, c_nthreads)
+        elif all([isinstance(leaf, SerializedLeaf64) for leaf in leaves]):
+            for leaf64 in leaves:
+                leaves64.push_back(dereference(leaf64.SL))
+            with nogil, cython.boundscheck(False), cython.wraparound(False):
+                nconflict = self.CL.add_leaves[uint64_t](leaves64, c_nthreads)
+        else:
+            raise TypeError("Leaves must all be SerializedLeaf32 or all " +
+                            "SerializedLeaf64.")
+        return nconflict
+
     def add_leaf_fromfile(self, fname):
         r"""Add a serialized leaf from a file to the consolidated tessellation.
 
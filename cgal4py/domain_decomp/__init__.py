@@ -10,7 +10,14 @@ def tree(method, pts, left_edge, right_edge, periodic, *args, **kwargs):
             'kdtree': KDTree based on median position along the dimension
                 with the greatest domain width. See
                 :meth:`cgal4py.domain_decomp.kdtree` for details on
-                accepted keyword arguments.
+                accepted keyword arguments. If the keyword argument `split`
+                is provided and is not 'median', the tree is instead built by
+                :meth:`cgal4py.domain_decomp.split_kdtree`.
+            'kdtree_cost': KDTree split with the 'cost' policy. Equivalent to
+                'kdtree' with `split='cost'`.
+            'hilbert', 'morton': Chunks of a space filling curve through the
+                points. See :meth:`cgal4py.domain_decomp.curve_tree` for
+                details on accepted keyword arguments.
         pts (np.ndarray of float64): (n, m) array of n coordinates in a
             m-dimensional domain.
         left_edge (np.ndarray of float64): (m,) domain minimum in each
@@ -32,7 +39,18 @@ def tree(method, pts, left_edge, right_edge, periodic, *args, **kwargs):
     """
     # Get leaves
     if method.lower() == 'kdtree':
-        tree = kdtree.PyKDTree(pts, left_edge, right_edge, *args, **kwargs)
+        split = kwargs.pop('split', 'median')
+        if split == 'median':
+            tree = kdtree.PyKDTree(pts, left_edge, right_edge, *args, **kwargs)
+        else:
+            tree = split_kdtree(pts, left_edge, right_edge, periodic, *args,
+                                split=split, **kwargs)
+    elif method.lower() == 'kdtree_cost':
+        tree = split_kdtree(pts, left_edge, right_edge, periodic, *args,
+                            split='cost', **kwargs)
+    elif method.lower() in ['hilbert', 'morton']:
+        tree = curve_tree(pts, left_edge, right_edge, periodic, *args,
+                          curve=method.lower(), **kwargs)
     else:
         raise ValueError("'{}' is not a supported ".format(method) +
                          "domain decomposition.")
@@ -40,6 +58,120 @@ def tree(method, pts, left_edge, right_edge, periodic, *args, **kwargs):
     return tree
 
 
+def split_kdtree(pts, left_edge, right_edge, periodic, leafsize=10000,
+                 nleaves=0, split='cost', max_aspect=4.0):
+    r"""Get a KDTree built with a selectable split policy.
+
+    Args:
+        pts (np.ndarray of float64): (n, m) array of n coordinates in a
+            m-dimensional domain.
+        left_edge (np.ndarray of float64): (m,) domain minimum in each
+            dimension.
+        right_edge (np.ndarray of float64): (m,) domain maximum in each
+            dimension.
+        periodic (bool): True if domain is periodic, False otherwise.
+        leafsize (int, optional): Nodes with fewer than this many points are
+            not split. Ignored if `nleaves` is non-zero. Defaults to 10000.
+        nleaves (int, optional): Number of leaves that should be created.
+            Defaults to 0.
+        split (str, optional): Split policy. 'median' splits at the median of
+            the widest dimension. 'cost' balances the number of points plus
+            the estimated halo size between children. See
+            :meth:`cgal4py.delaunay.tools.py_split_kdtree`. Defaults to
+            'cost'.
+        max_aspect (float, optional): Largest leaf aspect ratio allowed by the
+            'cost' policy. Defaults to 4.0.
+
+    Returns:
+        :class:`cgal4py.domain_decomp.GenericTree`: Tree with leaves ordered
+            so that `idx` sorts the points by leaf.
+
+    """
+    from cgal4py.delaunay import tools
+    out = tools.py_split_kdtree(pts, left_edge, right_edge,
+                                periodic=periodic, leafsize=leafsize,
+                                nleaves=nleaves, split=split,
+                                max_aspect=max_aspect)
+    idx, leaf_start, leaves_le, leaves_re = out
+    leaves = []
+    for i in range(len(leaf_start) - 1):
+        leaf = GenericLeaf(leaf_start[i+1] - leaf_start[i],
+                           leaves_le[i, :].copy(), leaves_re[i, :].copy())
+        leaf.id = i
+        leaf.start_idx = int(leaf_start[i])
+        leaf.stop_idx = int(leaf_start[i+1])
+        leaf.slice = slice(leaf.start_idx, leaf.stop_idx)
+        leaves.append(leaf)
+    return GenericTree(idx, leaves, left_edge, right_edge, periodic)
+
+
+def curve_tree(pts, left_edge, right_edge, periodic, leafsize=10000,
+               nleaves=0, curve='hilbert', weights=None):
+    r"""Get a tree whose leaves are consecutive chunks of a space filling
+    curve through the points. Leaves are the boxes of the curve grid cells
+    that their section of the curve passes through, so together they cover
+    the domain without gaps but may overlap. The neighbors of a leaf are the
+    leaves whose boxes overlap or touch its own.
+
+    Args:
+        pts (np.ndarray of float64): (n, m) array of n coordinates in a
+            m-dimensional domain.
+        left_edge (np.ndarray of float64): (m,) domain minimum in each
+            dimension.
+        right_edge (np.ndarray of float64): (m,) domain maximum in each
+            dimension.
+        periodic (bool): True if domain is periodic, False otherwise.
+        leafsize (int, optional): Approximate number of points per leaf. Only
+            used if `nleaves` is not provided. Defaults to 10000.
+        nleaves (int, optional): Exact number of leaves, e.g. the number of
+            processes times the number of leaves per process. Defaults to 0.
+        curve (str, optional): 'hilbert' or 'morton'. Defaults to 'hilbert'.
+        weights (np.ndarray of float64, optional): (n,) weight of each point.
+            Leaves have (nearly) equal total weight. Defaults to None and all
+            points have the same weight.
+
+    Returns:
+        :class:`cgal4py.domain_decomp.GenericTree`: Tree with leaves ordered
+            along the curve.
+
+    Raises:
+        ValueError: If `periodic` is True. Periodic boundaries require leaves
+            that tile the domain.
+
+    """
+    if np.any(periodic):
+        raise ValueError("Curve decompositions do not support periodic " +
+                         "domains.")
+    from cgal4py.delaunay import tools
+    npts, ndim = pts.shape
+    if left_edge is None:
+        left_edge = pts.min(axis=0)
+    if right_edge is None:
+        right_edge = pts.max(axis=0)
+    if nleaves <= 0:
+        nleaves = max(int(np.ceil(float(npts)/leafsize)), 1)
+    out = tools.py_curve_decomposition(pts, left_edge, right_edge, nleaves,
+                                       weights=weights, curve=curve)
+    idx, leaf_start, leaves_le, leaves_re = out
+    indptr, neigh = tools.py_overlapping_leaves(leaves_le, leaves_re)
+    neigh = neigh.tolist()
+    leaves = []
+    for i in range(nleaves):
+        leaf = GenericLeaf(leaf_start[i+1] - leaf_start[i],
+                           leaves_le[i, :].copy(), leaves_re[i, :].copy())
+        leaf.id = i
+        leaf.start_idx = int(leaf_start[i])
+        leaf.stop_idx = int(leaf_start[i+1])
+        leaf.slice = slice(leaf.start_idx, leaf.stop_idx)
+        leaf.periodic_left = np.zeros(ndim, 'bool')
+        leaf.periodic_right = np.zeros(ndim, 'bool')
+        leaf.left_neighbors = [[] for _ in range(ndim)]
+        leaf.right_neighbors = [[] for _ in range(ndim)]
+        leaf.neighbors = [i] + neigh[indptr[i]:indptr[i+1]]
+        leaves.append(leaf)
+    return GenericTree(idx, leaves, left_edge, right_edge, periodic)
+
+
 class GenericLeaf(object):
     def __init__(self, npts, left_edge, right_edge):
         r"""A generic container for leaf info with the minimum required info.
@@ -128,6 +260,48 @@ class GenericTree(object):
         self.num_leaves = len(leaves)
         self.leaves = process_leaves(leaves, left_edge, right_edge, periodic)
 
+    def find_leaves(self, pts, nthreads=0, nearest=False):
+        r"""Locate the leaf containing each of a set of points, e.g. new
+        points that should be added to an existing decomposition. Points are
+        wrapped into the domain along periodic dimensions first.
+
+        Args:
+            pts (np.ndarray of float64): (n, m) array of n m-dimensional
+                coordinates.
+            nthreads (int, optional): Number of threads to use. Defaults to 0
+                and the hardware concurrency is used.
+            nearest (bool, optional): If True, points that are not inside any
+                leaf are given the leaf whose box is closest to them. Defaults
+                to False.
+
+        Returns:
+            tuple: Containing
+
+                * leaf_ids (np.ndarray of int64): (n,) position in `leaves` of
+                  the leaf containing each point or -1 if the point is not
+                  inside any leaf (and `nearest` is False).
+                * indptr (np.ndarray of uint64): (num_leaves+1,) the points on
+                  leaves[i] are order[indptr[i]:indptr[i+1]].
+                * order (np.ndarray of uint64): Indices of the located points
+                  grouped by leaf.
+
+        """
+        from cgal4py.delaunay import tools
+        pts = np.asarray(pts, 'float64')
+        periodic = np.zeros(pts.shape[1], 'bool') | self.periodic
+        if np.any(periodic):
+            pts = pts.copy()
+            le = np.asarray(self.left_edge, 'float64')
+            width = np.asarray(self.domain_width, 'float64')
+            pts[:, periodic] = (le[periodic] +
+                                np.mod(pts[:, periodic] - le[periodic],
+                                       width[periodic]))
+        left_edges = np.vstack([leaf.left_edge for leaf in self.leaves])
+        right_edges = np.vstack([leaf.right_edge for leaf in self.leaves])
+        return tools.py_find_leaves(pts, left_edges.astype('float64'),
+                                    right_edges.astype('float64'),
+                                    nthreads=nthreads, nearest=nearest)
+
     @classmethod
     def from_tree(cls, tree):
         r"""Construct a GenericTree from a non-generic tree.
@@ -247,51 +421,34 @@ def process_leaves(leaves, left_edge, right_edge, periodic):
         domain_width = right_edge - left_edge
         for leaf in leaves:
             leaf.domain_width = domain_width
-    # Determine if leaves are on periodic boundaries
-    if getattr(leaves[0], 'periodic_left', None) is None:
-        if periodic:
-            for leaf in leaves:
-                leaf.periodic_left = np.isclose(leaf.left_edge, left_edge)
-                leaf.periodic_right = np.isclose(leaf.right_edge, right_edge)
-        else:
-            for leaf in leaves:
-                leaf.periodic_left = np.zeros(leaf.ndim, 'bool')
-                leaf.periodic_right = np.zeros(leaf.ndim, 'bool')
-    # Add neighbors
-    if getattr(leaves[0], 'left_neighbors', None) is None:
+    # Determine if leaves are on periodic boundaries & add neighbors
+    need_periodic = (getattr(leaves[0], 'periodic_left', None) is None)
+    need_neighbors = (getattr(leaves[0], 'left_neighbors', None) is None)
+    if need_periodic or need_neighbors:
+        from cgal4py.delaunay import tools
+        left_edges = np.vstack([leaf.left_edge for leaf in leaves])
+        right_edges = np.vstack([leaf.right_edge for leaf in leaves])
+        adj = tools.py_leaf_adjacency(
+            left_edges.astype('float64'), right_edges.astype('float64'),
+            np.asarray(left_edge, 'float64'),
+            np.asarray(right_edge, 'float64'), periodic)
+        per_left, per_right, lptr, lids, rptr, rids = adj
+        leaf_ids = np.array([leaf.id for leaf in leaves])
+        lids = leaf_ids[lids].tolist()
+        rids = leaf_ids[rids].tolist()
+        lptr = lptr.tolist()
+        rptr = rptr.tolist()
+    if need_periodic:
+        for j, leaf in enumerate(leaves):
+            leaf.periodic_left = per_left[j, :]
+            leaf.periodic_right = per_right[j, :]
+    if need_neighbors:
         for j, leaf in enumerate(leaves):
-            leaf.left_neighbors = [[] for _ in range(ndim)]
-            leaf.right_neighbors = [[] for _ in range(ndim)]
-            for prev in leaves[:(j+1)]:
-                match = True
-                for i in range(ndim):
-                    if leaf.left_edge[i] > prev.right_edge[i]:
-                        if not (leaf.periodic_right[i] and
-                                prev.periodic_left[i]):
-                            match = False
-                            break
-                    if leaf.right_edge[i] < prev.left_edge[i]:
-                        if not (prev.periodic_right[i] and
-                                leaf.periodic_left[i]):
-                            match = False
-                            break
-                if match:
-                    for i in range(ndim):
-                        if np.isclose(leaf.left_edge[i], prev.right_edge[i]):
-                            leaf.left_neighbors[i].append(prev.id)
-                            prev.right_neighbors[i].append(leaf.id)
-                        elif np.isclose(leaf.right_edge[i], prev.left_edge[i]):
-                            leaf.right_neighbors[i].append(prev.id)
-                            prev.left_neighbors[i].append(leaf.id)
-                        if periodic:
-                            if (leaf.periodic_right[i] and
-                                    prev.periodic_left[i]):
-                                leaf.right_neighbors[i].append(prev.id)
-                                prev.left_neighbors[i].append(leaf.id)
-                            if (prev.periodic_right[i] and
-                                    leaf.periodic_left[i]):
-                                leaf.left_neighbors[i].append(prev.id)
-                                prev.right_neighbors[i].append(leaf.id)
+            r = j*ndim
+            leaf.left_neighbors = [lids[lptr[r+i]:lptr[r+i+1]]
+                                   for i in range(ndim)]
+            leaf.right_neighbors = [rids[rptr[r+i]:rptr[r+i+1]]
+                                    for i in range(ndim)]
     if getattr(leaves[0], 'neighbors', None) is None:
         for leaf in leaves:
             neighbors = [leaf.id]
@@ -303,4 +460,5 @@ def process_leaves(leaves, left_edge, right_edge, periodic):
     return leaves
 
 
-__all__ = ["tree", "kdtree", "GenericLeaf", "GenericTree", "process_leaves"]
+__all__ = ["tree", "kdtree", "split_kdtree", "curve_tree", "GenericLeaf",
+           "GenericTree", "process_leaves"]
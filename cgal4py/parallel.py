@@ -34,6 +34,11 @@ except:
     mpi_loaded = False
     warnings.warn("mpi4py could not be imported.")
 import ctypes
+import io
+import tempfile
+import socket
+import subprocess
+from multiprocessing.connection import Listener, Client
 
 
 def _get_mpi_type(np_type):
@@ -94,10 +99,144 @@ def _final_leaf_tess_filename(leaf_id, unique_str=None):
                               unique_str=unique_str, ext='.dat')
 
 
+def _shm_filename(taskname, unique_str=None):
+    if os.path.isdir('/dev/shm') and os.access('/dev/shm', os.W_OK):
+        shm_dir = '/dev/shm'
+    else:
+        shm_dir = tempfile.gettempdir()
+    return os.path.join(shm_dir, _generate_filename(
+        'cgal4py_{}'.format(taskname), unique_str=unique_str, ext='.shm'))
+
+
+_shm_magic = b'C4PYSHM\x00'
+_shm_header = '<8sIIIIQQQ'
+_shm_align = 64
+_shm_kinds = ['triangulate', 'volumes']
+
+
+def _shm_padded(nbytes):
+    return _shm_align*((nbytes + _shm_align - 1)//_shm_align)
+
+
+def write_shared_result(fname, pts=None, cells=None, neigh=None, idx_inf=0,
+                        vols=None):
+    r"""Write the result of a parallel run to a file (normally in /dev/shm)
+    so that it can be mapped by :class:`cgal4py.parallel.SharedResult`
+    without copying. The file starts with a small header followed by the
+    raw arrays, each aligned to 64 bytes.
+
+    Args:
+        fname (str): Full path to the file that should be created.
+        pts (np.ndarray of float64, optional): (n,m) array of n m-dimensional
+            coordinates. Required for a triangulation. Defaults to None.
+        cells (np.ndarray of info_t, optional): (l,m+1) array of vertex
+            indices for each cell in a triangulation. Defaults to None.
+        neigh (np.ndarray of info_t, optional): (l,m+1) array of neighbor
+            indices for each cell in a triangulation. Defaults to None.
+        idx_inf (int, optional): Index of the infinite vertex in `cells`.
+            Defaults to 0.
+        vols (np.ndarray of float64, optional): Voronoi volumes. If provided,
+            the other arrays are ignored. Defaults to None.
+
+    """
+    if vols is not None:
+        kind = _shm_kinds.index('volumes')
+        arrays = [np.ascontiguousarray(vols, 'float64')]
+        ndim, isiz, nx, ncells = 0, 0, vols.size, 0
+    else:
+        kind = _shm_kinds.index('triangulate')
+        arrays = [np.ascontiguousarray(pts, 'float64'),
+                  np.ascontiguousarray(cells),
+                  np.ascontiguousarray(neigh, cells.dtype)]
+        ndim, isiz = pts.shape[1], cells.dtype.itemsize
+        nx, ncells = pts.shape[0], cells.shape[0]
+    # Write to a temporary name so readers never see a partial file
+    ftemp = fname + '.tmp'
+    with open(ftemp, 'wb') as fd:
+        fd.write(struct.pack(_shm_header, _shm_magic, 1, kind, ndim, isiz,
+                             nx, ncells, int(idx_inf)))
+        off = _shm_align
+        for x in arrays:
+            fd.seek(off)
+            x.tofile(fd)
+            off += _shm_padded(x.nbytes)
+        fd.truncate(off)
+    os.rename(ftemp, fname)
+
+
+class SharedResult(object):
+    r"""Result of a parallel run mapped from a file written by
+    :func:`cgal4py.parallel.write_shared_result`. Arrays are views into the
+    mapping (copy-on-write) so no data is read until it is used, and the
+    triangulation is only deserialized when it is requested.
+
+    Args:
+        fname (str): Full path to the file.
+        unlink (bool, optional): If True, the file is removed once it is
+            mapped. The mapping remains valid. Defaults to True.
+
+    Attributes:
+        task (str): 'triangulate' or 'volumes'.
+        pts (np.ndarray of float64): Coordinates (triangulations only).
+        cells (np.ndarray of info_t): Cell vertices (triangulations only).
+        neigh (np.ndarray of info_t): Cell neighbors (triangulations only).
+        idx_inf (int): Index of the infinite vertex (triangulations only).
+        vols (np.ndarray of float64): Voronoi volumes (volumes only).
+
+    Raises:
+        ValueError: If the file does not start with a valid header.
+
+    """
+    def __init__(self, fname, unlink=True):
+        mm = np.memmap(fname, dtype='uint8', mode='c')
+        if unlink:
+            os.remove(fname)
+        hsiz = struct.calcsize(_shm_header)
+        (magic, version, kind, ndim, isiz,
+         nx, ncells, idx_inf) = struct.unpack(_shm_header, mm[:hsiz].tobytes())
+        if (magic != _shm_magic) or (version != 1):
+            raise ValueError("{} is not a shared result file.".format(fname))
+        self._mm = mm
+        self._T = None
+        self.task = _shm_kinds[kind]
+        self.pts = self.cells = self.neigh = self.vols = None
+        self.idx_inf = None
+        if self.task == 'volumes':
+            self.vols = self._view(_shm_align, 'float64', (nx,))
+        else:
+            itype = np.dtype('uint{}'.format(8*isiz))
+            self.ndim = ndim
+            self.pts = self._view(_shm_align, 'float64', (nx, ndim))
+            off = _shm_align + _shm_padded(self.pts.nbytes)
+            self.cells = self._view(off, itype, (ncells, ndim+1))
+            off += _shm_padded(self.cells.nbytes)
+            self.neigh = self._view(off, itype, (ncells, ndim+1))
+            self.idx_inf = itype.type(idx_inf)
+
+    def _view(self, offset, dtype, shape):
+        return np.ndarray(shape, dtype=dtype, buffer=self._mm, offset=offset)
+
+    @property
+    def triangulation(self):
+        r""":class:`cgal4py.delaunay.Delaunay2` or
+        :class:`cgal4py.delaunay.Delaunay3`: Triangulation deserialized from
+        the mapped arrays on first access."""
+        if self.task != 'triangulate':
+            raise AttributeError("Volumes results have no triangulation.")
+        if self._T is None:
+            bit64 = (self.cells.dtype == np.uint64)
+            self._T = _get_Delaunay(ndim=self.ndim, bit64=bit64)()
+            self._T.deserialize(self.pts, self.cells, self.neigh,
+                                self.idx_inf)
+        return self._T
+
+
 def write_mpi_script(fname, read_func, taskname, unique_str=None,
                      use_double=False, use_python=False, use_buffer=False,
                      overwrite=False, profile=False, limit_mem=False,
-                     suppress_final_output=False):
+                     suppress_final_output=False, use_shm=False,
+                     dd_method='kdtree', nleaves_per_proc=1,
+                     compress_exchange=False):
     r"""Write an MPI script for calling MPI parallelized triangulation.
 
     Args:
@@ -141,6 +280,20 @@ def write_mpi_script(fname, read_func, taskname, unique_str=None,
         suppress_final_output (bool, optional): If True, output of the result
             to file is suppressed. This is mainly for testing purposes.
             Defaults to False.
+        use_shm (bool, optional): If True, the result is written with
+            :func:`cgal4py.parallel.write_shared_result` to a file in
+            /dev/shm instead of the working directory. Defaults to False.
+        dd_method (str, optional): Domain decomposition method. 'kdtree' uses
+            a power of two number of leaves, while 'hilbert' and 'morton' cut
+            a space filling curve into exactly `nproc*nleaves_per_proc`
+            leaves. 'kdtree_cost' also creates `nproc*nleaves_per_proc`
+            leaves, splitting a KD tree with the 'cost' policy of
+            :meth:`cgal4py.domain_decomp.split_kdtree`. Defaults to 'kdtree'.
+        nleaves_per_proc (int, optional): Number of leaves per process for
+            the curve and 'kdtree_cost' decompositions. Defaults to 1.
+        compress_exchange (bool, optional): If True and `use_python` is
+            False, exchanged points are sent through the lossless exchange
+            codec. Defaults to False.
 
     """
     if not mpi_loaded:
@@ -177,6 +330,10 @@ def write_mpi_script(fname, read_func, taskname, unique_str=None,
         "use_python = {}".format(use_python),
         "use_buffer = {}".format(use_buffer),
         "suppress_final_output = {}".format(suppress_final_output),
+        "use_shm = {}".format(use_shm),
+        "dd_method = '{}'".format(dd_method),
+        "nleaves_per_proc = {}".format(nleaves_per_proc),
+        "compress_exchange = {}".format(compress_exchange),
         ""]
     # Commands to read in data
     lines += [
@@ -211,7 +368,9 @@ def write_mpi_script(fname, read_func, taskname, unique_str=None,
         "    pts, tree, left_edge=left_edge, right_edge=right_edge,",
         "    periodic=periodic, use_double=use_double, unique_str=unique_str,",
         "    limit_mem=limit_mem, use_python=use_python,",
-        "    use_buffer=use_buffer,",
+        "    use_buffer=use_buffer, use_shm=use_shm,",
+        "    dd_method=dd_method, nleaves_per_proc=nleaves_per_proc,",
+        "    compress_exchange=compress_exchange,",
         "    suppress_final_output=suppress_final_output)",
         "p.run()"]
     if profile:
@@ -360,7 +519,9 @@ def ParallelVoronoiVolumesMPI(*args, **kwargs):
 
 def ParallelMPI(task, read_func, ndim, nproc, use_double=False,
                 limit_mem=False, use_python=False, use_buffer=False,
-                profile=False, suppress_final_output=False):
+                profile=False, suppress_final_output=False, use_shm=False,
+                dd_method='kdtree', nleaves_per_proc=1,
+                compress_exchange=False):
     r"""Return results form a triangulation that is constructed in parallel
     using MPI.
 
@@ -406,6 +567,18 @@ def ParallelMPI(task, read_func, ndim, nproc, use_double=False,
         suppress_final_output (bool, optional): If True, output of the result
             to file is suppressed. This is mainly for testing purposes.
             Defaults to False.
+        use_shm (bool, optional): If True, the result is handed back through
+            a file in /dev/shm that is mapped without copying. For
+            'triangulate', a :class:`cgal4py.parallel.SharedResult` is
+            returned instead of the triangulation, which is only deserialized
+            when its `triangulation` attribute is accessed. Defaults to False.
+        dd_method (str, optional): Domain decomposition method. See
+            :func:`cgal4py.parallel.write_mpi_script`. Defaults to 'kdtree'.
+        nleaves_per_proc (int, optional): Number of leaves per process for
+            the curve decompositions. Defaults to 1.
+        compress_exchange (bool, optional): If True, exchanged points are
+            sent through the lossless exchange codec. See
+            :func:`cgal4py.parallel.write_mpi_script`. Defaults to False.
 
     Returns:
         Dependent on task. For 'triangulate', a Delaunay triangulation class
@@ -428,12 +601,25 @@ def ParallelMPI(task, read_func, ndim, nproc, use_double=False,
                      unique_str=unique_str, use_double=use_double,
                      use_python=use_python, use_buffer=use_buffer,
                      profile=profile,
-                     suppress_final_output=suppress_final_output)
+                     suppress_final_output=suppress_final_output,
+                     use_shm=use_shm, dd_method=dd_method,
+                     nleaves_per_proc=nleaves_per_proc,
+                     compress_exchange=compress_exchange)
     cmd = 'mpiexec -np {} python {}'.format(nproc, fscript)
     os.system(cmd)
     os.remove(fscript)
     if suppress_final_output:
         return
+    if use_shm:
+        fres = _shm_filename(task, unique_str=unique_str)
+        if not os.path.isfile(fres):
+            raise RuntimeError("The shared result file does not exist. " +
+                               "There must have been an error while " +
+                               "running the parallel script.")
+        out = SharedResult(fres)
+        if task == 'volumes':
+            out = out.vols
+        return out
     if task == 'triangulate':
         fres = _tess_filename(unique_str=unique_str)
     elif task == 'volumes':
@@ -452,6 +638,297 @@ def ParallelMPI(task, read_func, ndim, nproc, use_double=False,
                            "parallel script.")
     
 
+
+def write_mpi_pool_script(fname, address, authkey, overwrite=False):
+    r"""Write an MPI script that runs a persistent pool of workers. See
+    :class:`cgal4py.parallel.MPIWorkerPool`.
+
+    Args:
+        fname (str): Full path to file where MPI script will be saved.
+        address (str, tuple): Address of the listener that the root process
+            should connect to for jobs.
+        authkey (bytes): Authentication key for the connection.
+        overwrite (bool): If True, any existing script with the same name is
+            overwritten. Defaults to False.
+
+    """
+    if not mpi_loaded:
+        raise Exception("mpi4py could not be imported.")
+    if os.path.isfile(fname):
+        if overwrite:
+            os.remove(fname)
+        else:
+            return
+    # The script may live outside the working directory, so make the
+    # cgal4py package in use here importable by the workers
+    pkg_dir = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    lines = [
+        "import sys",
+        "sys.path.insert(0, {})".format(repr(pkg_dir)),
+        "from cgal4py import parallel",
+        "parallel.MPIWorkerPool.serve({}, {})".format(repr(address),
+                                                      repr(authkey))]
+    with open(fname, 'w') as f:
+        f.write("\n".join(lines))
+
+
+class MPIWorkerPool(object):
+    r"""Persistent pool of MPI processes that triangulations can be submitted
+    to. The processes are launched once with `mpiexec` and keep cgal4py and
+    the compiled extensions loaded between jobs, avoiding the startup cost
+    paid by :func:`cgal4py.parallel.ParallelMPI` on every call. Jobs are sent
+    to the root process over a local socket.
+
+    Args:
+        nproc (int): Number of processors that should be used.
+        authkey (bytes, optional): Authentication key for the connection to
+            the workers. If not provided, a random key is generated.
+
+    Attributes:
+        nproc (int): Number of processors in the pool.
+        proc (subprocess.Popen): Process running `mpiexec`.
+        conn (multiprocessing.connection.Connection): Connection to the root
+            worker process.
+
+    """
+    def __init__(self, nproc, authkey=None):
+        if not mpi_loaded:
+            raise Exception("mpi4py could not be imported.")
+        if authkey is None:
+            authkey = os.urandom(16)
+        if hasattr(socket, 'AF_UNIX'):
+            family = 'AF_UNIX'
+        else:
+            family = 'AF_INET'
+        listener = Listener(family=family, authkey=authkey)
+        fd, self._fscript = tempfile.mkstemp(prefix='cgal4py_',
+                                             suffix='_mpipool.py')
+        os.close(fd)
+        write_mpi_pool_script(self._fscript, listener.address, authkey,
+                              overwrite=True)
+        self.nproc = nproc
+        self.proc = subprocess.Popen(['mpiexec', '-np', str(nproc),
+                                      sys.executable, self._fscript])
+        self.conn = listener.accept()
+        listener.close()
+        self._sessions = {}
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def _request(self, msg):
+        if self.conn is None:
+            raise RuntimeError("The worker pool has been closed.")
+        self.conn.send(msg)
+        status, out = self.conn.recv()
+        if status != 'ok':
+            raise RuntimeError("Error in MPI worker pool:\n{}".format(out))
+        return out
+
+    def submit(self, task, pts, left_edge=None, right_edge=None,
+               periodic=False, use_double=False, limit_mem=False,
+               session=None):
+        r"""Run a parallel triangulation on the pool and return the result.
+
+        Args:
+            task (str): Task for which results should be returned. See
+                :func:`cgal4py.parallel.ParallelMPI` for values.
+            pts (np.ndarray of float64): (n,m) array of n m-dimensional
+                coordinates.
+            left_edge (np.ndarray of float64, optional): Array of domain mins
+                in each dimension. If not provided, they are determined from
+                the points. Defaults to None.
+            right_edge (np.ndarray of float64, optional): Array of domain maxes
+                in each dimension. If not provided, they are determined from
+                the points. Defaults to None.
+            periodic (bool, optional): If True, the domain is assumed to be
+                periodic at its left/right edges in each dimension. Defaults to
+                False.
+            use_double (bool, optional): If True, 64 bit integers will be used
+                for the triangulation. Defaults to False.
+            limit_mem (bool, optional): If True, leaves are written to/read
+                from files as each process cycles through its subset. Defaults
+                to False.
+            session (str, optional): If provided, the parallel triangulation
+                is kept by the workers under this key and the points from
+                later jobs in the same session are inserted into it rather
+                than starting over. The domain and type options are only used
+                by the first job in a session. Defaults to None.
+
+        Returns:
+            Dependent on task. See :func:`cgal4py.parallel.ParallelMPI`.
+
+        Raises:
+            ValueError: If the task is not one of the accepted values.
+            RuntimeError: If the job raised an error on the workers.
+
+        """
+        if task not in ['triangulate', 'volumes']:
+            raise ValueError("Unsupported task: {}".format(task))
+        ndim = pts.shape[1]
+        if session is not None:
+            ndim, use_double = self._sessions.setdefault(
+                session, (ndim, use_double))
+        kws = dict(task=task, ndim=ndim, left_edge=left_edge,
+                   right_edge=right_edge, periodic=periodic,
+                   use_double=use_double, limit_mem=limit_mem,
+                   session=session)
+        out = self._request(('run', kws, pts))
+        if task == 'triangulate':
+            out = _get_Delaunay(ndim=ndim).from_serial_buffer(io.BytesIO(out))
+        return out
+
+    def triangulate(self, pts, **kwargs):
+        r"""Return a triangulation constructed by the pool. See
+        :meth:`cgal4py.parallel.MPIWorkerPool.submit` for arguments."""
+        return self.submit('triangulate', pts, **kwargs)
+
+    def volumes(self, pts, **kwargs):
+        r"""Return the Voronoi volumes computed by the pool. See
+        :meth:`cgal4py.parallel.MPIWorkerPool.submit` for arguments."""
+        return self.submit('volumes', pts, **kwargs)
+
+    def release(self, session):
+        r"""Discard the triangulation kept by the workers for a session.
+
+        Args:
+            session (str): Key of the session.
+
+        """
+        self._sessions.pop(session, None)
+        self._request(('release', session))
+
+    def close(self):
+        r"""Stop the worker processes."""
+        if self.conn is not None:
+            self.conn.send(('close', None))
+            self.conn.close()
+            self.conn = None
+            self.proc.wait()
+        if os.path.isfile(self._fscript):
+            os.remove(self._fscript)
+
+    @staticmethod
+    def serve(address, authkey):
+        r"""Loop run by each MPI process in the pool. The root process
+        receives jobs from the host and broadcasts them to the other
+        processes. Points are only held by the root process.
+
+        Args:
+            address (str, tuple): Address of the host listener.
+            authkey (bytes): Authentication key for the connection.
+
+        """
+        import traceback
+        comm = MPI.COMM_WORLD
+        rank = comm.Get_rank()
+        conn = None
+        if rank == 0:
+            conn = Client(address, authkey=authkey)
+        sessions = {}
+        while True:
+            pts = None
+            if rank == 0:
+                msg = conn.recv()
+                cmd, kws = msg[0], msg[1]
+                if cmd == 'run':
+                    pts = msg[2]
+            else:
+                cmd, kws = None, None
+            cmd, kws = comm.bcast((cmd, kws), root=0)
+            if cmd == 'close':
+                break
+            elif cmd == 'release':
+                sessions.pop(kws, None)
+                out = ('ok', None)
+            else:
+                try:
+                    out = ('ok', MPIWorkerPool._run_job(comm, kws, pts,
+                                                        sessions))
+                except Exception:
+                    out = ('error', traceback.format_exc())
+            if rank == 0:
+                conn.send(out)
+        if rank == 0:
+            conn.close()
+
+    @staticmethod
+    def _sync_error(comm, err):
+        r"""Raise the same error on every process if any process failed.
+        Must be called by all processes so that none is left waiting in a
+        collective operation.
+
+        Args:
+            comm (mpi4py.MPI.Comm): Communicator shared by the processes.
+            err (str): Traceback of the error on this process or None.
+
+        Raises:
+            RuntimeError: If `err` is not None on any process.
+
+        """
+        if not comm.allreduce(err is not None, op=MPI.LOR):
+            return
+        errors = comm.allgather(err)
+        msg = "\n".join("Rank {}:\n{}".format(i, e)
+                        for i, e in enumerate(errors) if e is not None)
+        raise RuntimeError(msg)
+
+    @staticmethod
+    def _run_job(comm, kws, pts, sessions):
+        import traceback
+        rank = comm.Get_rank()
+        session = kws['session']
+        PT = sessions.get(session, None)
+        le = re = None
+        # Checks and setup local to a process are synchronized before any
+        # collective call so that an error on one rank is seen by all
+        err = None
+        try:
+            if (PT is None) and (rank == 0):
+                le = kws['left_edge']
+                re = kws['right_edge']
+                if le is None:
+                    le = pts.min(axis=0)
+                if re is None:
+                    re = pts.max(axis=0)
+                le = np.asarray(le, 'float64')
+                re = np.asarray(re, 'float64')
+            if (rank == 0) and ((pts.ndim != 2) or
+                                (pts.shape[1] != kws['ndim'])):
+                raise ValueError("Points must be a (n, {}) array.".format(
+                    kws['ndim']))
+            Delaunay = _get_Delaunay(kws['ndim'], parallel=True,
+                                     bit64=kws['use_double'], comm=comm)
+        except Exception:
+            err = traceback.format_exc()
+        MPIWorkerPool._sync_error(comm, err)
+        out = None
+        err = None
+        try:
+            if PT is None:
+                PT = Delaunay(le, re, periodic=kws['periodic'],
+                              limit_mem=kws['limit_mem'])
+                if session is not None:
+                    sessions[session] = PT
+            PT.insert(pts)
+            if kws['task'] == 'triangulate':
+                T = PT.consolidate_tess()
+                if rank == 0:
+                    buf = io.BytesIO()
+                    T.serialize_to_buffer(buf, PT.pts_total)
+                    out = buf.getvalue()
+            elif kws['task'] == 'volumes':
+                out = PT.consolidate_vols()
+        except Exception:
+            err = traceback.format_exc()
+            # The kept triangulation may be partially updated
+            sessions.pop(session, None)
+        MPIWorkerPool._sync_error(comm, err)
+        return out
+
 if _use_multiprocessing:
     def ParallelDelaunayMulti(*args, **kwargs):
         r"""Return a triangulation that is constructed in parallel using the
@@ -514,10 +991,11 @@ if _use_multiprocessing:
                 less than zero indicate infinite volumes.
 
         """
-        idxArray = mp.RawArray(ctypes.c_ulonglong, tree.idx.size)
+        # Points are shared in leaf order so that each leaf is a contiguous
+        # slice and no process has to gather through the index
         ptsArray = mp.RawArray('d', pts.size)
-        memoryview(idxArray)[:] = tree.idx
-        memoryview(ptsArray)[:] = pts
+        np.frombuffer(ptsArray, dtype='float64').reshape(pts.shape)[:] = \
+            tools.py_gather_points(pts, tree.idx)
         # Split leaves
         task2leaves = [[] for _ in range(nproc)]
         for leaf in tree.leaves:
@@ -535,7 +1013,7 @@ if _use_multiprocessing:
             out_pipes[i], in_pipes[i] = mp.Pipe(True)
         unique_str = datetime.today().strftime("%Y%j%H%M%S")
         processes = [DelaunayProcessMulti(
-            task, _, task2leaves[_], ptsArray, idxArray,
+            task, _, task2leaves[_], ptsArray, None,
             left_edges, right_edges, queues, lock, count, in_pipes[_],
             unique_str=unique_str, limit_mem=limit_mem) for _ in range(nproc)]
         for p in processes:
@@ -679,7 +1157,9 @@ def DelaunayProcessMPI(taskname, pts, tree=None,
                        left_edge=None, right_edge=None,
                        periodic=False, unique_str=None, use_double=False,
                        use_python=False, use_buffer=False, limit_mem=False,
-                       suppress_final_output=False):
+                       suppress_final_output=False, use_shm=False,
+                       dd_method='kdtree', nleaves_per_proc=1,
+                       compress_exchange=False):
     r"""Get object for coordinating MPI operations.
 
     Args:
@@ -701,13 +1181,17 @@ def DelaunayProcessMPI(taskname, pts, tree=None,
             taskname, pts, tree=tree, left_edge=left_edge,
             right_edge=right_edge, periodic=periodic, unique_str=unique_str,
             use_double=use_double, use_buffer=use_buffer,
-            limit_mem=limit_mem, suppress_final_output=suppress_final_output)
+            limit_mem=limit_mem, suppress_final_output=suppress_final_output,
+            use_shm=use_shm, dd_method=dd_method,
+            nleaves_per_proc=nleaves_per_proc)
     else:
         out = DelaunayProcessMPI_C(
             taskname, pts, left_edge=left_edge,
             right_edge=right_edge, periodic=periodic, unique_str=unique_str,
             use_double=use_double, limit_mem=limit_mem,
-            suppress_final_output=suppress_final_output)
+            suppress_final_output=suppress_final_output, use_shm=use_shm,
+            dd_method=dd_method, nleaves_per_proc=nleaves_per_proc,
+            compress_exchange=compress_exchange)
     return out
 
 
@@ -746,6 +1230,20 @@ class DelaunayProcessMPI_C(object):
         suppress_final_output (bool, optional): If True, output of the result
             to file is suppressed. This is mainly for testing purposes.
             Defaults to False.
+        use_shm (bool, optional): If True, the result is written to a file in
+            /dev/shm using :func:`cgal4py.parallel.write_shared_result`.
+            Defaults to False.
+        dd_method (str, optional): Domain decomposition method. 'kdtree' uses
+            a power of two number of leaves, while 'hilbert' and 'morton' cut
+            a space filling curve into exactly `size*nleaves_per_proc`
+            leaves. 'kdtree_cost' also creates `size*nleaves_per_proc`
+            leaves, splitting a KD tree with the 'cost' policy of
+            :meth:`cgal4py.domain_decomp.split_kdtree`. Defaults to 'kdtree'.
+        nleaves_per_proc (int, optional): Number of leaves per process for
+            the curve and 'kdtree_cost' decompositions. Defaults to 1.
+        compress_exchange (bool, optional): If True, exchanged points are
+            sent through the lossless exchange codec instead of as raw
+            indices and coordinates. Defaults to False.
 
     Raises:
         ValueError: if `task` is not one of the accepted values listed above.
@@ -753,7 +1251,9 @@ class DelaunayProcessMPI_C(object):
     """
     def __init__(self, taskname, pts, left_edge=None, right_edge=None,
                  periodic=False, unique_str=None, use_double=False,
-                 limit_mem=False, suppress_final_output=False):
+                 limit_mem=False, suppress_final_output=False, use_shm=False,
+                 dd_method='kdtree', nleaves_per_proc=1,
+                 compress_exchange=False):
         if not mpi_loaded:
             raise Exception("mpi4py could not be imported.")
         task_list = ['triangulate', 'volumes']
@@ -772,7 +1272,10 @@ class DelaunayProcessMPI_C(object):
         ndim = comm.bcast(ndim, root=0)
         Delaunay = _get_Delaunay(ndim, parallel=True, bit64=use_double)
         self.PT = Delaunay(left_edge, right_edge, periodic=periodic,
-                           limit_mem=limit_mem)
+                           limit_mem=limit_mem, dd_method=dd_method,
+                           nleaves_per_proc=nleaves_per_proc,
+                           compress_exchange=compress_exchange,
+                           volumes_only=(taskname == 'volumes'))
         self.size = size
         self.rank = rank
         self.comm = comm
@@ -780,8 +1283,11 @@ class DelaunayProcessMPI_C(object):
         self.taskname = taskname
         self.unique_str = unique_str
         self.suppress_final_output = suppress_final_output
+        self.use_shm = use_shm
 
     def output_filename(self):
+        if self.use_shm:
+            return _shm_filename(self.taskname, unique_str=self.unique_str)
         if self.taskname == 'triangulate':
             fname = _tess_filename(unique_str=self.unique_str)
         elif self.taskname == 'volumes':
@@ -796,15 +1302,23 @@ class DelaunayProcessMPI_C(object):
             if (self.rank == 0):
                 if not self.suppress_final_output:
                     ftess = self.output_filename()
-                    with open(ftess, 'wb') as fd:
-                         T.serialize_to_buffer(fd, pts)
+                    if self.use_shm:
+                        cells, neigh, idx_inf = T.serialize()
+                        write_shared_result(ftess, self.pts, cells, neigh,
+                                            idx_inf)
+                    else:
+                        with open(ftess, 'wb') as fd:
+                            T.serialize_to_buffer(fd, self.pts)
         elif self.taskname == 'volumes':
             vols = self.PT.consolidate_vols()
             if (self.rank == 0):
                 if not self.suppress_final_output:
                     fvols = self.output_filename()
-                    with open(fvols, 'wb') as fd:
-                        fd.write(vols.tobytes())
+                    if self.use_shm:
+                        write_shared_result(fvols, vols=vols)
+                    else:
+                        with open(fvols, 'wb') as fd:
+                            vols.tofile(fd)
 
 
 class DelaunayProcessMPI_Python(object):
@@ -847,6 +1361,17 @@ class DelaunayProcessMPI_Python(object):
         suppress_final_output (bool, optional): If True, output of the result
             to file is suppressed. This is mainly for testing purposes.
             Defaults to False.
+        use_shm (bool, optional): If True, the result is written to a file in
+            /dev/shm using :func:`cgal4py.parallel.write_shared_result`.
+            Defaults to False.
+        dd_method (str, optional): Domain decomposition method. 'kdtree' uses
+            a power of two number of leaves, while 'hilbert' and 'morton' cut
+            a space filling curve into exactly `size*nleaves_per_proc`
+            leaves. 'kdtree_cost' also creates `size*nleaves_per_proc`
+            leaves, splitting a KD tree with the 'cost' policy of
+            :meth:`cgal4py.domain_decomp.split_kdtree`. Defaults to 'kdtree'.
+        nleaves_per_proc (int, optional): Number of leaves per process for
+            the curve and 'kdtree_cost' decompositions. Defaults to 1.
 
     Raises:
         ValueError: if `task` is not one of the accepted values listed above.
@@ -856,7 +1381,8 @@ class DelaunayProcessMPI_Python(object):
                  left_edge=None, right_edge=None,
                  periodic=False, unique_str=None, use_double=False,
                  use_buffer=False, limit_mem=False,
-                 suppress_final_output=False):
+                 suppress_final_output=False, use_shm=False,
+                 dd_method='kdtree', nleaves_per_proc=1):
         if not mpi_loaded:
             raise Exception("mpi4py could not be imported.")
         task_list = ['triangulate', 'volumes']
@@ -871,8 +1397,12 @@ class DelaunayProcessMPI_Python(object):
         right_edges = None
         if rank == 0:
             if tree is None:
-                tree = domain_decomp.tree('kdtree', pts, left_edge, right_edge,
-                                          periodic=periodic, nleaves=size)
+                nleaves = size
+                if dd_method != 'kdtree':
+                    nleaves *= nleaves_per_proc
+                tree = domain_decomp.tree(dd_method, pts, left_edge,
+                                          right_edge, periodic=periodic,
+                                          nleaves=nleaves)
             if not isinstance(tree, GenericTree):
                 tree = GenericTree.from_tree(tree)
             task2leaves = [[] for _ in range(size)]
@@ -896,7 +1426,9 @@ class DelaunayProcessMPI_Python(object):
         self._limit_mem = limit_mem
         self._use_double = use_double
         self._use_buffer = use_buffer
+        self._buffers = {}
         self._suppress_final_output = suppress_final_output
+        self._use_shm = use_shm
         self._comm = comm
         self._num_proc = size
         self._proc_idx = rank
@@ -917,6 +1449,8 @@ class DelaunayProcessMPI_Python(object):
             self._task2leaf[task].append(i)
                 
     def output_filename(self):
+        if self._use_shm:
+            return _shm_filename(self._task, unique_str=self._unique_str)
         if self._task == 'triangulate':
             fname = _tess_filename(unique_str=self._unique_str)
         elif self._task == 'volumes':
@@ -1010,143 +1544,113 @@ class DelaunayProcessMPI_Python(object):
                     total_arr.update(x)
         return total_arr
 
-    def alltoall_leaf_arrays(self, local_arr, dtype=None, return_counts=False,
-                             leaf_counts=None, array_counts=None):
-        r"""Exchange arrays between leaves.
+    def _buffer(self, name, size, dtype):
+        r"""Return a reusable array for communications. The array is only
+        reallocated when a larger size or different type is requested.
 
         Args:
-            local_arr (dict): Arrays to be exchanged with other leaves. Keys
-                are 2-element tuples. The first element is the leaf the array
-                came from, the second element is the leaf the array should be 
-                send to.
+            name (str): Key identifying the buffer.
+            size (int): Number of elements required.
+            dtype (str, np.dtype): Data type of the elements.
 
         Returns:
-            dict: Incoming arrays where the keys are 2-element tuples as
-                described above.
-        
+            np.ndarray: View of the first `size` elements of the buffer.
+
         """
-        total_arr = {}
-        if self._use_buffer:  # pragma: no cover
-            local_leaf_ids = list(local_arr.keys())
-            leaf_ids = [[] for i in range(self._num_proc)]
-            local_array_count = 0
-            for k in local_leaf_ids:
-                task = k[1] % self._num_proc
-                leaf_ids[task].append(k)
-                local_array_count += local_arr[k].size
-            # Get data type
-            if len(local_leaf_ids) == 0:
-                if dtype is None:
-                    raise Exception("Nothing being sent from this process. " +
-                                    "Cannot determine type to be recieved.")
-                np_dtype = dtype
-            else:
-                np_dtype = local_arr[local_leaf_ids[0]].dtype
-            mpi_dtype = _get_mpi_type(np_dtype)
-            # Compute things to send
-            scnt = np.array([len(x) for x in leaf_ids], 'int64')
-            nleaves_send = scnt.sum()
-            array_counts_send = np.zeros(self._num_proc, 'int64')
-            sids = np.empty(3*nleaves_send, 'int64')
-            sarr = np.empty(local_array_count, np_dtype)
-            pl = pa = 0  # Entry for previous leaf/array entry
-            for i, x in enumerate(leaf_ids):
-                for k in x:
-                    array_counts_send[i] += local_arr[k].size
-                    sids[pl:(pl+2)] = k
-                    sids[pl+2] = local_arr[k].size
-                    sarr[pa:(pa+local_arr[k].size)] = local_arr[k]
-                    pa += local_arr[k].size
-                    pl += 3
-            # Send the number of leaves on each processor
-            if leaf_counts is None:
-                rcnt = np.empty(self._num_proc, scnt.dtype)
-                self._comm.Alltoall(
-                    (scnt, _get_mpi_type(scnt.dtype)),
-                    (rcnt, 1, _get_mpi_type(rcnt.dtype)))
-            else:
-                assert(len(leaf_counts) == self._num_proc)
-                rcnt = leaf_counts
-            nleaves_recv = rcnt.sum()
-            # Send the ids of leaves for each leaf source/destination
-            rids = np.empty(3*nleaves_recv, sids.dtype)
-            send_buf = (sids, 3*scnt,
-                        _get_mpi_type(sids.dtype))
-            recv_buf = (rids, 3*rcnt,
-                        _get_mpi_type(rids.dtype))
-            self._comm.Alltoallv(send_buf, recv_buf)
-            # Send the size of arrays for each leaf
-            array_counts_recv = np.zeros(self._num_proc, 'int64')
-            j = 0
-            for i in range(self._num_proc):
-                for _ in range(rcnt[i]):
-                    array_counts_recv[i] += rids[3*j + 2]
-                    j += 1
-            # Send the arrays for each leaf
-            rarr = np.empty(array_counts_recv.sum(), sarr.dtype)
-            send_buf = (sarr, array_counts_send, _get_mpi_type(sarr.dtype))
-            recv_buf = (rarr, array_counts_recv, _get_mpi_type(rarr.dtype))
-            self._comm.Alltoallv(send_buf, recv_buf)
-            # Parse out info for each leaf
-            curr = 0
-            for i in range(nleaves_recv):
-                src = rids[3*i]
-                dst = rids[3*i+1]
-                siz = rids[3*i+2]
-                total_arr[(src, dst)] = rarr[curr:(curr+siz)]
-                curr += siz
-            assert(curr == rarr.size)
-        else:
-            return_counts = False
-            local_leaf_ids = list(local_arr.keys())
-            send_data = [{} for i in range(self._num_proc)]
-            for k in local_leaf_ids:
-                task = k[1] % self._num_proc
-                send_data[task][k] = local_arr[k]
-            recv_data = self._comm.alltoall(send_data)
-            for x in recv_data:
-                total_arr.update(**x)
-        if return_counts:
-            return total_arr, rcnt, array_counts_recv
-        return total_arr
+        size = int(size)
+        buf = self._buffers.get(name, None)
+        if (buf is None) or (buf.dtype != np.dtype(dtype)):
+            buf = np.empty(size, dtype)
+            self._buffers[name] = buf
+        elif buf.size < size:
+            buf = np.empty(max(size, 2*buf.size), dtype)
+            self._buffers[name] = buf
+        return buf[:size]
+
+    def _alltoallv(self, name, scnt, sbufs):
+        r"""Exchange packed arrays with all processes using a single Alltoall
+        for the counts followed by one Alltoallv for each array.
+
+        Args:
+            name (str): Prefix for the reused receive buffers.
+            scnt (np.ndarray of int64): (nproc, k) number of elements of each
+                of the k arrays that are sent to each process.
+            sbufs (list of np.ndarray): k arrays with elements packed in order
+                of the destination process.
+
+        Returns:
+            tuple: (nproc, k) array of counts received from each process and
+                list of the k received arrays. The received arrays are views
+                into buffers that are reused by the next call with the same
+                name.
+
+        """
+        nproc = self._num_proc
+        k = len(sbufs)
+        scnt = np.ascontiguousarray(scnt, 'int64')
+        rcnt = self._buffer(name + '_cnt', nproc*k, 'int64').reshape(nproc, k)
+        mpi_int = _get_mpi_type('int64')
+        self._comm.Alltoall((scnt, mpi_int), (rcnt, mpi_int))
+        rbufs = []
+        for j in range(k):
+            mpi_dtype = _get_mpi_type(sbufs[j].dtype)
+            rbuf = self._buffer('{}_{}'.format(name, j), rcnt[:, j].sum(),
+                                sbufs[j].dtype)
+            self._comm.Alltoallv((sbufs[j], scnt[:, j], mpi_dtype),
+                                 (rbuf, rcnt[:, j], mpi_dtype))
+            rbufs.append(rbuf)
+        return rcnt, rbufs
 
     def outgoing_points(self):
         r"""Enqueues points at edges of each leaf's boundaries."""
         if self._use_buffer:  # pragma: no cover
-            send_int = {}
-            send_flt = {}
+            nproc = self._num_proc
+            ndim = self._ndim
+            msgs = [[] for _ in range(nproc)]
             for leaf in self._leaves:
-                src = leaf.id
                 hvall, n, le, re, ptall = leaf.outgoing_points(return_pts=True)
                 for dst in range(self._total_leaves):
-                    task = dst % self._num_proc
                     if hvall[dst] is not None:
-                        k = (src, dst)
-                        send_int[k] = np.concatenate(
-                            [np.array([hvall[dst].shape[0]], 'int64'),
-                             hvall[dst], n]).astype('int64')
-                        send_flt[k] = np.concatenate(
-                            [ptall[dst].flatten(),
-                             le.flatten(), re.flatten()]).astype('float64')
-            out_int = self.alltoall_leaf_arrays(send_int, dtype='int64',
-                                                return_counts=True)
-            recv_int, leaf_counts, array_counts_int = out_int
-            recv_flt = self.alltoall_leaf_arrays(send_flt, dtype='float64',
-                                                 return_counts=False,
-                                                 leaf_counts=leaf_counts)
+                        msgs[dst % nproc].append(
+                            (leaf.id, dst, hvall[dst], n, le, re, ptall[dst]))
+            # Each message has a header (src, dst, npts, nneigh), integers
+            # (point indices then neighbors), and floats (positions then
+            # neighbor left & right edges).
+            scnt = np.zeros((nproc, 3), 'int64')
+            for i, x in enumerate(msgs):
+                for m in x:
+                    npts, nn = m[2].size, len(m[3])
+                    scnt[i, :] += (4, npts + nn, ndim*(npts + 2*nn))
+            shdr = self._buffer('send_hdr', scnt[:, 0].sum(), 'int64')
+            sint = self._buffer('send_int', scnt[:, 1].sum(), 'int64')
+            sflt = self._buffer('send_flt', scnt[:, 2].sum(), 'float64')
+            ph = pi = pf = 0
+            for x in msgs:
+                for src, dst, idx, n, le, re, pts in x:
+                    npts, nn = idx.size, len(n)
+                    shdr[ph:(ph+4)] = (src, dst, npts, nn)
+                    sint[pi:(pi+npts)] = idx
+                    sint[(pi+npts):(pi+npts+nn)] = n
+                    for arr in (pts, le, re):
+                        sflt[pf:(pf+arr.size)] = arr.ravel()
+                        pf += arr.size
+                    ph += 4
+                    pi += npts + nn
+            rcnt, (rhdr, rint, rflt) = self._alltoallv(
+                'exchange', scnt, [shdr, sint, sflt])
+            # Views into the receive buffers are consumed by incoming_points
+            # before the next exchange
             tot_recv = {}
-            for k in recv_int.keys():
-                npts = int(recv_int[k][0])
-                ndim = self._ndim
-                nn = recv_int[k].size - (npts+1)
-                tot_recv[k] = {
-                    'idx': recv_int[k][1:(npts+1)],
-                    'n': recv_int[k][(npts+1):],
-                    'pts': recv_flt[k][:(ndim*npts)].reshape(npts, ndim),
-                    'le': recv_flt[k][
-                        (ndim*npts):(ndim*(npts+nn))].reshape(nn, ndim),
-                    're': recv_flt[k][
-                        (ndim*(npts+nn)):(ndim*(npts+2*nn))].reshape(nn, ndim)}
+            pi = pf = 0
+            for i in range(rhdr.size // 4):
+                src, dst, npts, nn = [int(v) for v in rhdr[(4*i):(4*i+4)]]
+                v = {'idx': rint[pi:(pi+npts)],
+                     'n': rint[(pi+npts):(pi+npts+nn)]}
+                for key, nrow in (('pts', npts), ('le', nn), ('re', nn)):
+                    v[key] = rflt[pf:(pf+ndim*nrow)].reshape(nrow, ndim)
+                    pf += ndim*nrow
+                tot_recv[(src, dst)] = v
+                pi += npts + nn
             self._tot_recv = tot_recv
         else:
             tot_send = [{k:{} for k in self._task2leaf[i]} for
@@ -1238,10 +1742,15 @@ class DelaunayProcessMPI_Python(object):
                                  unique_str=self._unique_str)
                                  # limit_mem=limit_mem)
             if not self._suppress_final_output:
-                ftess = _tess_filename(unique_str=self._unique_str)
-                # T.write_to_file(ftess)
-                with open(ftess, 'wb') as fd:
-                    T.serialize_to_buffer(fd, self._pts)
+                ftess = self.output_filename()
+                if self._use_shm:
+                    cells, neigh, idx_inf = T.serialize()
+                    write_shared_result(ftess, self._pts, cells, neigh,
+                                        idx_inf)
+                else:
+                    # T.write_to_file(ftess)
+                    with open(ftess, 'wb') as fd:
+                        T.serialize_to_buffer(fd, self._pts)
 
     def enqueue_volumes(self):
         r"""Enqueue resulting voronoi volumes."""
@@ -1279,10 +1788,13 @@ class DelaunayProcessMPI_Python(object):
         if self._proc_idx == 0:
             if not self._suppress_final_output:
                 # Save volumes
-                fvols = _vols_filename(unique_str=self._unique_str)
-                # np.save(fvols, vol)
-                with open(fvols, 'wb') as fd:
-                    fd.write(vol.tobytes())
+                fvols = self.output_filename()
+                if self._use_shm:
+                    write_shared_result(fvols, vols=vol)
+                else:
+                    # np.save(fvols, vol)
+                    with open(fvols, 'wb') as fd:
+                        vol.tofile(fd)
 
     def run(self):
         r"""Performs tessellation and communication for each leaf on this
@@ -1295,27 +1807,18 @@ class DelaunayProcessMPI_Python(object):
             # Continue exchanges until there are not any particles that need to
             # be exchanged.
             nrecv = -1
+            nrecv_local = np.zeros(1, np_dtype)
+            nrecv_total = np.zeros(1, np_dtype)
             while nrecv != 0:
                 self.outgoing_points()
                 nrecv0 = self.incoming_points()
                 if self._use_buffer:  # pragma: no cover
-                    nrecv_local = np.array([nrecv0], np_dtype)
-                    nrecv_total = None
-                    if self._proc_idx == 0:
-                        nrecv_total = np.empty(self._num_proc, np_dtype)
-                    self._comm.Gather((nrecv_local, mpi_dtype),
-                                      (nrecv_total, mpi_dtype), root=0)
-                    nrecv_tot = np.empty(1, np_dtype)
-                    if self._proc_idx == 0:
-                        nrecv_tot[0] = sum(nrecv_total)
-                    self._comm.Bcast(nrecv_tot, root=0)
-                    nrecv = nrecv_tot[0]
+                    nrecv_local[0] = nrecv0
+                    self._comm.Allreduce((nrecv_local, mpi_dtype),
+                                         (nrecv_total, mpi_dtype), op=MPI.SUM)
+                    nrecv = nrecv_total[0]
                 else:
-                    nrecv_total = self._comm.gather(nrecv0, root=0)
-                    nrecv_tot = None
-                    if self._proc_idx == 0:
-                        nrecv_tot = sum(nrecv_total)
-                    nrecv = self._comm.bcast(nrecv_tot, root=0)
+                    nrecv = self._comm.allreduce(nrecv0, op=MPI.SUM)
             if self._task == 'triangulate':
                 self.enqueue_triangulation()
             elif self._task == 'volumes':
@@ -1347,6 +1850,9 @@ if _use_multiprocessing:
             pts (np.ndarray of float64): (n,m) array of n m-dimensional
                 coordinates. Each leaf has a set of indices identifying coordinates
                 within `pts` that belong to that leaf.
+            idx (multiprocessing.RawArray of uint64): Sorted index mapping leaf
+                positions to rows of `pts`. If None, `pts` is already in leaf
+                order and each leaf is a contiguous slice.
             left_edges (np.ndarray float64): Array of mins for all leaves in the
                 domain decomposition.
             right_edges (np.ndarray float64): Array of maxes for all leaves in the
@@ -1386,7 +1892,10 @@ if _use_multiprocessing:
                                          unique_str=unique_str,
                                          limit_mem=limit_mem) for leaf in leaves]
             self._leafid2idx = {leaf.id:i for i,leaf in enumerate(leaves)}
-            self._idx = np.frombuffer(idx, dtype='uint64')
+            if idx is None:
+                self._idx = None
+            else:
+                self._idx = np.frombuffer(idx, dtype='uint64')
             self._ptsFlt = np.frombuffer(pts, dtype='float64')
             ndim = left_edges.shape[1]
             npts = len(self._ptsFlt)/ndim
@@ -1450,7 +1959,10 @@ if _use_multiprocessing:
                         if leaf.id == i:
                             break
                     # Add points to leaves
-                    new_pts = np.copy(self._pts[self._idx[arr], :])
+                    if self._idx is None:
+                        new_pts = np.copy(self._pts[arr, :])
+                    else:
+                        new_pts = np.copy(self._pts[self._idx[arr], :])
                     leaf.incoming_points(j, arr, n, le, re, new_pts)
                     nrecv += arr.shape[0]
             with self._count[1].get_lock():
@@ -1700,19 +2212,23 @@ class ParallelLeaf(object):
             self.neighbors.remove(leaf.id)
         self.left_neighbors = copy.deepcopy(leaf.left_neighbors)
         self.right_neighbors = copy.deepcopy(leaf.right_neighbors)
-        le = copy.deepcopy(left_edges)
-        re = copy.deepcopy(right_edges)
+        # Only the rows for neighboring leaves are copied and shifted
+        row = {k: j for j, k in enumerate(self.neighbors)}
+        le = left_edges[self.neighbors, :]
+        re = right_edges[self.neighbors, :]
         for i in range(self.ndim):
             if self.periodic_left[i]:
                 for k in leaf.left_neighbors[i]:
-                    le[k, i] -= self.domain_width[i]
-                    re[k, i] -= self.domain_width[i]
+                    if k in row:
+                        le[row[k], i] -= self.domain_width[i]
+                        re[row[k], i] -= self.domain_width[i]
             if self.periodic_right[i]:
                 for k in leaf.right_neighbors[i]:
-                    le[k, i] += self.domain_width[i]
-                    re[k, i] += self.domain_width[i]
-        self.left_edges = le[self.neighbors, :]
-        self.right_edges = re[self.neighbors, :]
+                    if k in row:
+                        le[row[k], i] += self.domain_width[i]
+                        re[row[k], i] += self.domain_width[i]
+        self.left_edges = le
+        self.right_edges = re
         self.unique_str = unique_str
         self.limit_mem = limit_mem
 
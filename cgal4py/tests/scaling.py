@@ -4,8 +4,8 @@ import time
 import os
 import cProfile
 import pstats
-from cgal4py import parallel, delaunay
-from test_cgal4py import run_test
+from cgal4py import parallel, delaunay, domain_decomp
+from test_cgal4py import run_test, make_points
 import matplotlib.pyplot as plt
 np.random.seed(10)
 
@@ -261,3 +261,149 @@ def weak_scaling(func, npart=1e4, nrep=1, periodic=False, use_mpi=False,
     axs.legend()
     fig.savefig(fname_plot)
     print('    '+fname_plot)
+
+
+def exchange_volume(pts, tree, periodic=False):
+    r"""Count the points that must be exchanged between leaves so that each
+    leaf has every point sharing a Delaunay cell with one of its own points.
+
+    Args:
+        pts (np.ndarray of float64): (n, m) array of n coordinates in a
+            m-dimensional domain.
+        tree (object): Domain decomposition tree.
+        periodic (bool, optional): If True, the domain is assumed to be
+            periodic. Defaults to False.
+
+    Returns:
+        int: Number of (point, leaf) pairs where the point is on another leaf.
+
+    """
+    T = delaunay.Delaunay(pts, periodic=periodic,
+                          left_edge=tree.left_edge, right_edge=tree.right_edge)
+    cells, neigh, idx_inf = T.serialize()
+    cells = cells[~np.any(cells == idx_inf, axis=1)].astype('int64')
+    owner = np.empty(pts.shape[0], 'int64')
+    for i, leaf in enumerate(tree.leaves):
+        owner[tree.idx[leaf.start_idx:leaf.stop_idx]] = i
+    nleaves = len(tree.leaves)
+    pairs = []
+    for j in range(cells.shape[1]):
+        for k in range(cells.shape[1]):
+            if j == k:
+                continue
+            v = cells[:, j]
+            l = owner[cells[:, k]]
+            mask = (owner[v] != l)
+            pairs.append(v[mask]*nleaves + l[mask])
+    return np.unique(np.concatenate(pairs)).size
+
+
+def compare_split_policies(func, npart=1e5, nproc=8, ndim=3,
+                           distrib='gaussian', nrep=1, periodic=False,
+                           policies=['median', 'cost'], max_aspect=4.0):
+    r"""Compare KDTree split policies on exchange volume and run time.
+
+    Args:
+        func (str): Name of the function that should be run. Values include:
+            'Delaunay': Full triangulation.
+            'VoronoiVolumes': Cell volumes from triangulation.
+        npart (int, optional): Number of particles. Defaults to 1e5.
+        nproc (int, optional): Number of processors. Defaults to 8.
+        ndim (int, optional): Number of dimensions. Defaults to 3.
+        distrib (str, optional): Distribution of points. See
+            :func:`cgal4py.tests.test_cgal4py.make_points`. Defaults to
+            'gaussian'.
+        nrep (int, optional): Number of times the run should be performed to
+            get an average. Defaults to 1.
+        periodic (bool, optional): If True, the domain is assumed to be
+            periodic. Defaults to False.
+        policies (list, optional): Split policies to compare. Defaults to
+            ['median', 'cost'].
+        max_aspect (float, optional): Largest leaf aspect ratio allowed by the
+            'cost' policy. Defaults to 4.0.
+
+    Returns:
+        dict: Exchange volume and mean/std of the run time for each policy.
+
+    """
+    npart = int(npart)
+    pts, left_edge, right_edge = make_points(npart, ndim, distrib=distrib)
+    out = {}
+    for split in policies:
+        dd_kwargs = {'nleaves': nproc, 'split': split}
+        if split != 'median':
+            dd_kwargs['max_aspect'] = max_aspect
+        tree = domain_decomp.tree('kdtree', pts, left_edge, right_edge,
+                                  periodic, **dict(dd_kwargs))
+        nexch = exchange_volume(pts, tree, periodic=periodic)
+        times = np.empty(nrep, 'float')
+        for i in range(nrep):
+            t1 = time.time()
+            run_test(npart, ndim, nproc=nproc, func_name=func,
+                     distrib=distrib, periodic=periodic,
+                     dd_kwargs=dict(dd_kwargs))
+            t2 = time.time()
+            times[i] = t2 - t1
+        out[split] = (nexch, np.mean(times), np.std(times))
+        print("{:>8s}: {} exchanged, {:f} +/- {:f} s".format(
+            split, nexch, np.mean(times), np.std(times)))
+    return out
+
+
+
+def compare_locate(npart=1e5, nquery=1e4, ndim=3, distrib='uniform', nrep=1):
+    r"""Compare point location with and without the Delaunay hierarchy for
+    cold (random order) and coherent (sorted order) queries, and for
+    queries interleaved with single point inserts.
+
+    Args:
+        npart (int, optional): Number of particles. Defaults to 1e5.
+        nquery (int, optional): Number of query points. Defaults to 1e4.
+        ndim (int, optional): Number of dimensions (2 or 3). Defaults to 3.
+        distrib (str, optional): Distribution of points. See
+            :func:`cgal4py.tests.test_cgal4py.make_points`. Defaults to
+            'uniform'.
+        nrep (int, optional): Number of times each query set should be run to
+            get an average. Defaults to 1.
+
+    Returns:
+        dict: Mean/std of the query time for each (fast_location, pattern)
+            pair.
+
+    """
+    npart = int(npart)
+    nquery = int(nquery)
+    pts, left_edge, right_edge = make_points(npart, ndim, distrib=distrib)
+    query = left_edge + (right_edge - left_edge)*np.random.random(
+        (nquery, ndim))
+    patterns = {'cold': query,
+                'coherent': query[np.lexsort(query.T[::-1]), :]}
+    out = {}
+    for fast in [False, True]:
+        T = delaunay.Delaunay(pts, fast_location=fast)
+        T.locate_ids(query[:1, :])  # Build the hierarchy outside the timing
+        for name in ['cold', 'coherent']:
+            times = np.empty(nrep, 'float')
+            for i in range(nrep):
+                t1 = time.time()
+                T.locate_ids(patterns[name])
+                t2 = time.time()
+                times[i] = t2 - t1
+            out[(fast, name)] = (np.mean(times), np.std(times))
+            print("fast_location={:d} {:>11s}: {:f} +/- {:f} s".format(
+                fast, name, np.mean(times), np.std(times)))
+        name = 'interleaved'
+        times = np.empty(nrep, 'float')
+        for i in range(nrep):
+            T = delaunay.Delaunay(pts, fast_location=fast)
+            T.locate_ids(query[:1, :])
+            t1 = time.time()
+            for j in range(nquery):
+                T.insert(query[j:(j+1), :])
+                T.locate(query[nquery-j-1, :])
+            t2 = time.time()
+            times[i] = t2 - t1
+        out[(fast, name)] = (np.mean(times), np.std(times))
+        print("fast_location={:d} {:>11s}: {:f} +/- {:f} s".format(
+            fast, name, np.mean(times), np.std(times)))
+    return out
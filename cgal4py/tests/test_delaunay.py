@@ -275,6 +275,53 @@ def test_sortSerializedTess():
         assert(cells[i, d] >= cells[i-1, d])
 
 
+def test_validate_tess():
+    for pts, ndim in [(pts2, 2), (pts3, 3)]:
+        T = Delaunay(pts)
+        cells, neigh, idx_inf = T.serialize()
+        viol = tools.py_validate_tess(pts, cells, neigh, idx_inf, nthreads=2)
+        assert(viol.shape[0] == 0)
+        viol = tools.py_validate_tess(pts, cells, neigh, idx_inf,
+                                      check_orientation=False)
+        assert(viol.shape[0] == 0)
+        # Break neighbor symmetry
+        neigh[0, 0] = neigh[0, 1]
+        viol = tools.py_validate_tess(pts, cells, neigh, idx_inf)
+        assert(viol.shape[0] > 0)
+        assert(tools.TESS_VIOL_NEIGH_SYMMETRY in viol['type'] or
+               tools.TESS_VIOL_SHARED_FACET in viol['type'])
+        # Move a point into the middle of a cell it is not part of
+        cells, neigh, idx_inf = T.serialize()
+        pts_bad = copy.copy(pts)
+        c = np.where(np.all(cells != idx_inf, axis=1))[0][0]
+        v = [i for i in range(pts.shape[0]) if i not in cells[c, :]][0]
+        pts_bad[v, :] = pts[cells[c, :], :].mean(axis=0)
+        viol = tools.py_validate_tess(pts_bad, cells, neigh, idx_inf,
+                                      check_orientation=False)
+        assert(tools.TESS_VIOL_EMPTY_SPHERE in viol['type'])
+
+
+def test_renumber_tess():
+    for pts, ndim in [(pts2, 2), (pts3, 3)]:
+        T = Delaunay(pts)
+        cells, neigh, idx_inf = T.serialize()
+        for method in ['hilbert', 'rcm']:
+            x = tools.py_renumber_tess(pts, cells, neigh, idx_inf,
+                                       method=method, nthreads=2)
+            new_pts, new_cells, new_neigh, vert_order, cell_order = x
+            assert(np.all(np.sort(vert_order) == np.arange(pts.shape[0])))
+            assert(np.all(np.sort(cell_order) == np.arange(cells.shape[0])))
+            assert(np.allclose(new_pts, pts[vert_order]))
+            fin = (new_cells != idx_inf)
+            assert(np.all(vert_order[new_cells[fin]] ==
+                          cells[cell_order][fin]))
+            viol = tools.py_validate_tess(new_pts, new_cells, new_neigh,
+                                          idx_inf)
+            assert(viol.shape[0] == 0)
+    assert_raises(ValueError, tools.py_renumber_tess, pts, cells, neigh,
+                  idx_inf, method='invalid')
+
+
 # argsort
 def test_arg_sortCellVerts():
     npts = 20
@@ -355,3 +402,215 @@ def test_arg_sortSerializedTess():
         i_new = idx_cells[i]
         assert(cells[i_new, idx_verts[i_new, d]] >=
                cells[i_old, idx_verts[i_old, d]])
+
+
+def test_leaf_adjacency():
+    # 2x2 grid of leaves on the unit square
+    le = np.array([[0, 0], [0.5, 0], [0, 0.5], [0.5, 0.5]], 'float64')
+    re = le + 0.5
+    dle = np.zeros(2, 'float64')
+    dre = np.ones(2, 'float64')
+    pl, pr, lptr, lids, rptr, rids = tools.py_leaf_adjacency(le, re, dle, dre)
+    assert(not np.any(pl))
+    assert(not np.any(pr))
+    # Row i*ndim+d holds the neighbors of leaf i in dimension d
+    assert_equal(sorted(rids[rptr[0]:rptr[1]]), [1, 3])
+    assert_equal(list(lids[lptr[4]:lptr[5]]), [])
+    assert_equal(sorted(rids[rptr[3]:rptr[4]]), [2, 3])
+    pl, pr, lptr, lids, rptr, rids = tools.py_leaf_adjacency(
+        le, re, dle, dre, periodic=True)
+    assert(np.all(pl[0, :]))
+    assert(np.all(pr[3, :]))
+    assert_equal(sorted(lids[lptr[0]:lptr[1]]), [1, 3])
+
+
+def test_overlapping_leaves():
+    # Two overlapping boxes, one touching the second, one apart & one empty
+    le = np.array([[0, 0], [0.5, 0.5], [1.5, 0], [3, 3], [np.inf, np.inf]],
+                  'float64')
+    re = np.array([[1, 1], [1.5, 1.5], [2, 1], [4, 4], [-np.inf, -np.inf]],
+                  'float64')
+    indptr, ids = tools.py_overlapping_leaves(le, re)
+    assert_equal(indptr.shape[0], 6)
+    neigh = [sorted(ids[indptr[i]:indptr[i+1]]) for i in range(5)]
+    assert_equal(neigh, [[1], [0, 2], [1], [], []])
+
+
+def test_curve_decomposition_boxes():
+    # Chunk boxes cover the domain and each holds its own points
+    np.random.seed(10)
+    for ndim in [2, 3]:
+        pts = np.vstack([0.05*np.random.rand(500, ndim),
+                         np.random.rand(100, ndim)])
+        le = np.zeros(ndim, 'float64')
+        re = np.ones(ndim, 'float64')
+        for curve in ['hilbert', 'morton']:
+            idx, start, lle, lre = tools.py_curve_decomposition(
+                pts, le, re, 32, curve=curve)
+            for i in range(32):
+                p = pts[idx[start[i]:start[i+1]].astype('int64'), :]
+                assert(np.all(p >= lle[i, :]))
+                assert(np.all(p <= lre[i, :]))
+            q = np.vstack([np.random.rand(2000, ndim), le, re])
+            inside = np.all((q[:, None, :] >= lle[None, :, :]) &
+                            (q[:, None, :] <= lre[None, :, :]), axis=2)
+            assert(np.all(inside.any(axis=1)))
+            indptr, ids = tools.py_overlapping_leaves(lle, lre)
+            print("{} {}D: {:.1f} neighbors per chunk".format(
+                curve, ndim, float(ids.shape[0])/32))
+            assert(ids.shape[0] < 32*31)
+
+
+def test_gather_points():
+    idx = np.arange(pts3.shape[0])[::-1]
+    out = tools.py_gather_points(pts3, idx)
+    assert(np.all(out == pts3[idx, :]))
+    out = tools.py_gather_points(pts3, idx.astype('uint32'), nthreads=2)
+    assert(np.all(out == pts3[idx, :]))
+    assert_equal(tools.py_gather_points(pts3, []).shape, (0, 3))
+
+
+def test_merge_small_leaves():
+    # Four slabs with 5, 1, 5 & 5 points; the second is merged into the first
+    start = np.array([0, 5, 6, 11, 16], 'uint64')
+    le = np.array([[0, 0], [1, 0], [2, 0], [3, 0]], 'float64')
+    re = np.array([[1, 1], [2, 1], [3, 1], [4, 1]], 'float64')
+    start, le, re = tools.py_merge_small_leaves(start, le, re, 3)
+    assert(np.all(start == [0, 6, 11, 16]))
+    assert(np.all(le[0] == [0, 0]))
+    assert(np.all(re[0] == [2, 1]))
+    # Leaves whose union is not a box are kept
+    start = np.array([0, 1, 10], 'uint64')
+    le = np.array([[0, 0], [1, 0]], 'float64')
+    re = np.array([[1, 1], [2, 2]], 'float64')
+    start, le, re = tools.py_merge_small_leaves(start, le, re, 3)
+    assert(start.size == 3)
+    # Merging stops at the minimum number of leaves
+    start = np.array([0, 1, 2, 3, 4], 'uint64')
+    le = np.array([[0, 0], [1, 0], [2, 0], [3, 0]], 'float64')
+    re = np.array([[1, 1], [2, 1], [3, 1], [4, 1]], 'float64')
+    out = tools.py_merge_small_leaves(start, le, re, 3)
+    assert(out[0].size == 2)
+    start, le, re = tools.py_merge_small_leaves(start, le, re, 3,
+                                                min_nleaves=3)
+    assert(start.size == 4)
+    assert(start[-1] == 4)
+    assert(le.shape == (3, 2))
+
+
+def make_grid_leaves(nx, nleaves, leaf_type):
+    # Leaves of a structured triangulation of an nx by nx grid. Each leaf
+    # owns a range of vertices and holds every cell touching them, like the
+    # partial triangulations produced in parallel.
+    idx = np.arange(nx*nx).reshape(nx, nx)
+    cells = []
+    for i in range(nx - 1):
+        for j in range(nx - 1):
+            cells.append([idx[i, j], idx[i+1, j], idx[i+1, j+1]])
+            cells.append([idx[i, j], idx[i+1, j+1], idx[i, j+1]])
+    cells = np.array(cells, 'int64')
+    faces = {}
+    for c in range(cells.shape[0]):
+        for k in range(3):
+            faces.setdefault(tuple(sorted(np.delete(cells[c], k))),
+                             []).append(c)
+    neigh = -np.ones(cells.shape, 'int64')
+    for c in range(cells.shape[0]):
+        for k in range(3):
+            other = [x for x in faces[tuple(sorted(np.delete(cells[c], k)))]
+                     if x != c]
+            if other:
+                neigh[c, k] = other[0]
+    if leaf_type == 'uint32':
+        idx_inf = np.iinfo('uint32').max
+        SerializedLeaf = tools.SerializedLeaf32
+    else:
+        idx_inf = np.iinfo('uint64').max
+        SerializedLeaf = tools.SerializedLeaf64
+    bounds = np.linspace(0, nx*nx, nleaves + 1).astype('int64')
+    leaves = []
+    for l in range(nleaves):
+        start, stop = bounds[l], bounds[l+1]
+        local = np.where(np.any((cells >= start) & (cells < stop),
+                                axis=1))[0]
+        g2l = dict((g, i) for i, g in enumerate(local))
+        lverts = cells[local].astype(leaf_type)
+        lneigh = np.empty(lverts.shape, leaf_type)
+        lneigh.fill(idx_inf)
+        for i, g in enumerate(local):
+            for k in range(3):
+                if neigh[g, k] in g2l:
+                    lneigh[i, k] = g2l[neigh[g, k]]
+        sort_verts, sort_cells = tools.py_arg_sortSerializedTess(lverts)
+        leaves.append(SerializedLeaf(l, 2, lverts.shape[0], idx_inf, lverts,
+                                     lneigh, sort_verts, sort_cells,
+                                     start, stop))
+    return leaves
+
+
+def test_ConsolidatedLeaves_add_leaves():
+    # The threaded merge gives the same result as adding leaves in order
+    for leaf_type, Consolidated in [
+            ('uint32', tools.ConsolidatedLeaves32),
+            ('uint32', tools.ConsolidatedLeaves64),
+            ('uint64', tools.ConsolidatedLeaves64)]:
+        if Consolidated is tools.ConsolidatedLeaves32:
+            idx_inf = np.uint32(np.iinfo('uint32').max)
+        else:
+            idx_inf = np.uint64(np.iinfo('uint64').max)
+        leaves = make_grid_leaves(8, 3, leaf_type)
+        ncells = sum(leaf.ncells for leaf in leaves)
+        cons_seri = Consolidated(2, idx_inf, ncells)
+        for leaf in leaves:
+            cons_seri.add_leaf(leaf)
+        cons_seri.finalize()
+        for nthreads in [1, 4]:
+            leaves = make_grid_leaves(8, 3, leaf_type)
+            cons_para = Consolidated(2, idx_inf, ncells)
+            assert_equal(cons_para.add_leaves(leaves, nthreads=nthreads), 0)
+            cons_para.finalize()
+            assert_equal(cons_para.ncells, cons_seri.ncells)
+            assert(np.all(cons_para.verts == cons_seri.verts))
+            assert(np.all(cons_para.neigh == cons_seri.neigh))
+    leaves = (make_grid_leaves(4, 1, 'uint32') +
+              make_grid_leaves(4, 1, 'uint64'))
+    cons = tools.ConsolidatedLeaves64(2, np.uint64(np.iinfo('uint64').max),
+                                      sum(leaf.ncells for leaf in leaves))
+    assert_raises(TypeError, cons.add_leaves, leaves)
+
+
+def test_exchange_codec():
+    def check(pts, idx):
+        buf, spts, sidx = tools.py_encode_exchange(pts, idx)
+        assert(np.all(sidx == np.sort(idx)))
+        assert(np.all(spts == pts[np.argsort(idx), :]))
+        dpts, didx = tools.py_decode_exchange(buf, pts.shape[0],
+                                              pts.shape[1])
+        assert(np.all(didx == sidx))
+        assert(np.all(dpts.view('uint64') == spts.view('uint64')))
+        return float(len(buf))/(spts.nbytes + sidx.nbytes)
+    idx = np.arange(pts3.shape[0], dtype='uint64')[::-1].copy()
+    assert(check(pts3, idx) < 1.0)
+    # Full precision doubles keep ~52 bits per coordinate
+    np.random.seed(10)
+    pts = np.random.rand(1000, 3)
+    idx = np.random.permutation(1000).astype('uint64')
+    ratio = check(pts, idx)
+    print("Full precision payload: {:.2f} of raw".format(ratio))
+    assert(ratio < 0.75)
+    # A thin slab, as sent to a neighboring leaf, narrows one coordinate
+    pts[:, 0] = 0.5 + 1.0e-3*pts[:, 0]
+    ratio_slab = check(pts, idx)
+    print("Full precision slab payload: {:.2f} of raw".format(ratio_slab))
+    assert(ratio_slab < ratio)
+    # Coordinates with float32 precision shed the zero low bits
+    pts = np.random.rand(1000, 3).astype('float32').astype('float64')
+    ratio = check(pts, idx)
+    print("Float32 precision payload: {:.2f} of raw".format(ratio))
+    assert(ratio < 0.5)
+    # Signed values, signed zeros and a constant coordinate
+    pts = np.random.rand(100, 3) - 0.5
+    pts[:2, 0] = [0.0, -0.0]
+    pts[:, 2] = -2.0
+    check(pts, np.arange(100, dtype='uint64'))
+    check(pts[:1, :], np.zeros(1, 'uint64'))
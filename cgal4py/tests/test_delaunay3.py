@@ -8,6 +8,8 @@ r"""Tests for 3D Delaunay Triangulation.
 """
 import numpy as np
 import os
+import threading
+from nose.tools import assert_raises
 from cgal4py.delaunay import Delaunay3
 from cgal4py.tests.test_cgal4py import MyTestCase, make_points
 
@@ -762,6 +764,135 @@ def test_nearest_vertex():
     assert(v.index == idx_test)
 
 
+def test_fast_location():
+    pts2, le2, re2 = make_points(2000, 3)
+    q = 0.5*(pts2[:100, :] + pts2[100:200, :])
+    T1 = Delaunay3()
+    T1.insert(pts2)
+    T2 = Delaunay3(fast_location=True)
+    T2.insert(pts2)
+    assert(T2.fast_location)
+    for i in range(q.shape[0]):
+        assert(T1.nearest_vertex(q[i, :]).index ==
+               T2.nearest_vertex(q[i, :]).index)
+    c1 = T1.serialize()[0][T1.locate_ids(q)]
+    c2 = T2.serialize()[0][T2.locate_ids(q)]
+    assert(np.all(np.sort(c1, axis=1) == np.sort(c2, axis=1)))
+    # Queries interleaved with inserts and a remove
+    new = 0.5*(pts2[200:300, :] + pts2[300:400, :])
+    for i in range(new.shape[0]):
+        T1.insert(new[i:(i+1), :])
+        T2.insert(new[i:(i+1), :])
+        assert(T1.nearest_vertex(q[i, :]).index ==
+               T2.nearest_vertex(q[i, :]).index)
+    T1.remove(T1.get_vertex(0))
+    T2.remove(T2.get_vertex(0))
+    for i in range(q.shape[0]):
+        assert(T1.nearest_vertex(q[i, :]).index ==
+               T2.nearest_vertex(q[i, :]).index)
+    assert(T2.is_valid())
+
+
+def test_freeze():
+    pts2, le2, re2 = make_points(2000, 3)
+    q = 0.5*(pts2[:100, :] + pts2[100:200, :])
+    T = Delaunay3()
+    T.insert(pts2)
+    v0 = [T.nearest_vertex(q[i, :]).index for i in range(q.shape[0])]
+    c0 = T.locate_ids(q)
+    vids = np.arange(50)
+    i0 = T.incident_cell_ids(vids)
+    T.freeze()
+    assert(T.frozen)
+    out = [None for j in range(4)]
+
+    def query(j):
+        v = [T.nearest_vertex(q[i, :]).index for i in range(q.shape[0])]
+        out[j] = (v, T.locate_ids(q))
+    threads = [threading.Thread(target=query, args=(j,)) for j in range(4)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    for v, c in out:
+        assert(v == v0)
+        assert(np.all(c == c0))
+    i1 = T.incident_cell_ids(vids)
+    for k in vids:
+        assert(np.all(np.sort(i0[1][i0[0][k]:i0[0][k+1]]) ==
+                      np.sort(i1[1][i1[0][k]:i1[0][k+1]])))
+    assert_raises(RuntimeError, T.insert, pts)
+    assert_raises(RuntimeError, setattr, T, 'fast_location', True)
+    T.thaw()
+    assert(not T.frozen)
+    T.insert(pts)
+
+    # Below full dimension CGAL's thread-unsafe queries would be used
+    T = Delaunay3()
+    T.insert(np.array([[0.0, 0.0, 0.0], [1.0, 0.0, 0.0], [0.0, 1.0, 0.0]]))
+    assert_raises(ValueError, T.freeze)
+    assert(not T.frozen)
+
+
+def test_transaction():
+    pts2, le2, re2 = make_points(200, 3)
+    q = np.vstack([0.5*(pts2[:50, :] + pts2[50:100, :]), pts2[:2, :],
+                   np.array([[10.0, 10.0, 10.0]])])
+
+    def sorted_cells(T):
+        c = np.sort(T.serialize()[0], axis=1)
+        return c[np.lexsort(c.T[::-1])]
+    T = Delaunay3()
+    T.insert(pts2)
+    c0 = sorted_cells(T)
+    T.begin()
+    assert(T.in_transaction)
+    assert_raises(RuntimeError, T.begin)
+    T.insert(q)
+    assert(T.num_finite_verts == pts2.shape[0] + q.shape[0] - 2)
+    assert_raises(RuntimeError, T.remove, T.get_vertex(0))
+    T.rollback()
+    assert(not T.in_transaction)
+    assert(T.is_valid())
+    assert(T.n == pts2.shape[0])
+    assert(T.num_finite_verts == pts2.shape[0])
+    assert(np.all(sorted_cells(T) == c0))
+    T.begin()
+    T.insert(q)
+    T.commit()
+    assert(not T.in_transaction)
+    assert(T.is_valid())
+    assert(T.num_finite_verts == pts2.shape[0] + q.shape[0] - 2)
+    assert_raises(RuntimeError, T.rollback)
+
+
+def test_transaction_clustered():
+    # Later holes overlap the stars of earlier points in the batch
+    pts3, le3, re3 = make_points(200, 3)
+    np.random.seed(10)
+    q = pts3[0, :] + 1e-3*np.random.rand(100, 3)
+
+    def sorted_cells(T):
+        c = np.sort(T.serialize()[0], axis=1)
+        return c[np.lexsort(c.T[::-1])]
+    T = Delaunay3()
+    T.insert(pts3)
+    c0 = sorted_cells(T)
+    T.begin()
+    T.insert(q)
+    assert(T.is_valid())
+    T.rollback()
+    assert(T.is_valid())
+    assert(T.num_finite_verts == pts3.shape[0])
+    assert(np.all(sorted_cells(T) == c0))
+    T.begin()
+    for i in range(q.shape[0]):
+        T.insert(q[i:(i+1), :])
+    T.rollback()
+    assert(T.is_valid())
+    assert(np.all(sorted_cells(T) == c0))
+
+
 def test_mirror():
     T = Delaunay3()
     T.insert(pts)
@@ -834,3 +965,129 @@ def test_minimum_angles():
     T.insert(pts)
     v = T.minimum_angles()
     assert(v.shape[0] < T.num_finite_cells)
+
+def test_edge_gabriel_lengths():
+    T = Delaunay3()
+    T.insert(pts)
+    gab, elen = T.edge_gabriel_lengths(nthreads=2)
+    assert(gab.shape[0] == T.num_finite_edges)
+    assert(elen.shape[0] == T.num_finite_edges)
+    for i, e in enumerate(T.finite_edges):
+        assert(gab[i] == e.is_Gabriel())
+        assert(np.isclose(elen[i], e.length))
+    assert(np.all(T.gabriel_edges == gab))
+    assert(np.allclose(T.edge_lengths, elen))
+
+def test_side_batch():
+    T = Delaunay3()
+    T.insert(pts)
+    cells = list(T.all_cells)
+    cids = np.arange(len(cells)).astype('uint32')
+    pos = np.array([c.circumcenter for c in cells])
+    pos[np.logical_not(np.isfinite(pos))] = 0.0
+    sph = T.side_of_sphere_batch(pos, cids, nthreads=2)
+    side = T.side_of_cell_batch(pos, cids, nthreads=2)
+    assert(sph.dtype == np.int8)
+    for i, c in enumerate(cells):
+        assert(sph[i] == c.side_of_sphere(pos[i]))
+        assert(side[i] == c.side(pos[i]))
+    c = cells[0]
+    assert(np.all(T.side_of_sphere_batch(pts, c) ==
+                  [c.side_of_sphere(p) for p in pts]))
+    assert(np.all(T.side_of_cell_batch(pts, c) == [c.side(p) for p in pts]))
+
+def test_side_batch_degenerate():
+    # Coplanar points give cells without a fourth vertex
+    np.random.seed(10)
+    pts2 = np.zeros((20, 3), 'float64')
+    pts2[:, :2] = np.random.rand(20, 2)
+    T = Delaunay3()
+    T.insert(pts2)
+    q = pts2[:3, :].mean(axis=0)
+    c = T.locate(q).cell
+    pos = np.zeros((50, 3), 'float64')
+    pos[:, :2] = 2.0*np.random.rand(50, 2) - 0.5
+    pos = np.vstack([pos, pts2, q])
+    sph = T.side_of_sphere_batch(pos, c, nthreads=2)
+    side = T.side_of_cell_batch(pos, c, nthreads=2)
+    assert(np.all(sph == [c.side_of_sphere(p) for p in pos]))
+    assert(np.all(side == [c.side(p) for p in pos]))
+    assert(np.any(side == -1) and np.any(side == 1))
+
+def test_ids():
+    T = Delaunay3()
+    T.insert(pts)
+    cells = list(T.all_cells)
+    assert([c.id for c in cells] == list(range(T.num_cells)))
+    for c in cells:
+        assert(T.cell_from_id(c.id) == c)
+    for v in T.all_verts:
+        assert(T.vertex_from_id(v.id) == v)
+    ser_cells, ser_neigh, idx_inf = T.serialize()
+    assert(np.all(T.cell_neighbor_ids(nthreads=2) == ser_neigh))
+    vids = T.cell_vertex_ids(nthreads=2)
+    assert(np.all(vids == ser_cells))
+    assert(np.allclose(T.vertices[vids[vids != idx_inf]],
+                       pts[ser_cells[ser_cells != idx_inf]]))
+    for c in cells:
+        assert(list(vids[c.id]) == [c.vertex(i).id for i in range(4)])
+    for v in T.all_verts:
+        if not v.is_infinite():
+            assert(v.id == v.index)
+    cc = T.cell_circumcenters(nthreads=2)
+    ma = T.cell_minimum_angles(nthreads=2)
+    for c in cells:
+        assert(np.allclose(cc[c.id], c.circumcenter))
+        if c.is_infinite():
+            assert(ma[c.id] == -1)
+        else:
+            assert(np.isclose(ma[c.id], c.min_angle))
+    loc = T.locate_ids(pts)
+    for i in range(pts.shape[0]):
+        c = T.cell_from_id(loc[i])
+        assert(i in [c.vertex(j).index for j in range(4)])
+    verts = np.arange(T.num_finite_verts)
+    indptr, ids = T.incident_cell_ids(verts)
+    for i in verts:
+        v = T.vertex_from_id(i)
+        assert(sorted(ids[indptr[i]:indptr[i+1]]) ==
+               sorted([c.id for c in v.incident_cells()]))
+    T.insert(np.array([[0.1, 0.2, 0.3]]))
+    assert([c.id for c in T.all_cells] == list(range(T.num_cells)))
+    # Ids follow the info after a removal leaves a gap
+    T.remove(T.get_vertex(0))
+    assert(T.vertex_from_id(0).is_infinite())
+    indptr, ids = T.incident_cell_ids([0, 1])
+    assert(indptr[1] == 0)
+    assert(np.all(T.cell_vertex_ids() == T.serialize()[0]))
+
+def test_vertex_star_csr():
+    T = Delaunay3()
+    T.insert(pts)
+    indptr, ids = T.vertex_star_csr(nthreads=2)
+    cells, neigh, idx_inf = T.serialize()
+    assert(indptr[-1] == np.sum(cells != idx_inf))
+    for i in range(T.num_finite_verts):
+        star = ids[indptr[i]:indptr[i+1]]
+        assert(np.all(star == np.where(np.any(cells == i, axis=1))[0]))
+    # Removed vertices leave empty rows rather than dropping the last stars
+    T.remove(T.get_vertex(0))
+    indptr, ids = T.vertex_star_csr(nthreads=2)
+    cells, neigh, idx_inf = T.serialize()
+    assert(indptr.size == T.num_finite_verts + 2)
+    assert(indptr[1] == 0)
+    assert(indptr[-1] == np.sum(cells != idx_inf))
+    for i in range(indptr.size - 1):
+        star = ids[indptr[i]:indptr[i+1]]
+        assert(np.all(star == np.where(np.any(cells == i, axis=1))[0]))
+
+def test_cell_quality():
+    T = Delaunay3()
+    T.insert(pts)
+    q = T.cell_quality(nthreads=2)
+    assert(q.shape[0] == T.num_cells)
+    fin = np.isfinite(q['volume'])
+    assert(fin.sum() == T.num_finite_cells)
+    assert(np.all(q['volume'][fin] > 0))
+    assert(np.all((q['min_angle'][fin] > 0) & (q['min_angle'][fin] < np.pi)))
+    assert(np.all(q['radius_edge'][fin] >= 0.5))
@@ -440,6 +440,27 @@ def test_vert_incident_cells():
     assert(count == expected)
 
 
+def test_vertex_star_csr():
+    T = DelaunayD()
+    T.insert(pts)
+    indptr, ids = T.vertex_star_csr(nthreads=2)
+    cells, neigh, idx_inf = T.serialize()
+    assert(indptr[-1] == np.sum(cells != idx_inf))
+    for i in range(T.num_finite_verts):
+        star = ids[indptr[i]:indptr[i+1]]
+        assert(np.all(star == np.where(np.any(cells == i, axis=1))[0]))
+    # Removed vertices leave empty rows rather than dropping the last stars
+    T.remove(T.get_vertex(0))
+    indptr, ids = T.vertex_star_csr(nthreads=2)
+    cells, neigh, idx_inf = T.serialize()
+    assert(indptr.size == T.num_finite_verts + 2)
+    assert(indptr[1] == 0)
+    assert(indptr[-1] == np.sum(cells != idx_inf))
+    for i in range(indptr.size - 1):
+        star = ids[indptr[i]:indptr[i+1]]
+        assert(np.all(star == np.where(np.any(cells == i, axis=1))[0]))
+
+
 # def test_edge_incident_verts():
 #     T = DelaunayD()
 #     T.insert(pts)
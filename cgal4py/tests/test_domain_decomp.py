@@ -24,6 +24,94 @@ def test_tree():
     del tree2, tree3
 
 
+def test_split_kdtree():
+    for split in ['median', 'cost']:
+        for pts, le, re in [(pts2, left_edge2, right_edge2),
+                            (pts3, left_edge3, right_edge3)]:
+            tree = domain_decomp.tree('kdtree', pts, le, re, periodic=False,
+                                      nleaves=4, split=split)
+            assert(tree.num_leaves == 4)
+            assert(np.all(np.sort(tree.idx) == np.arange(N)))
+            for leaf in tree.leaves:
+                lpts = pts[tree.idx[leaf.start_idx:leaf.stop_idx], :]
+                assert(np.all(lpts >= leaf.left_edge))
+                assert(np.all(lpts <= leaf.right_edge))
+    assert_raises(ValueError, domain_decomp.split_kdtree, pts2, left_edge2,
+                  right_edge2, False, split='invalid')
+
+
+def test_split_kdtree_small():
+    # Splits must leave points on both sides even for a handful of points
+    np.random.seed(10)
+    for ndim in [2, 3]:
+        for npts in range(1, 12):
+            pts = np.random.rand(npts, ndim)
+            nleaves = min(npts, 4)
+            tree = domain_decomp.tree('kdtree_cost', pts, np.zeros(ndim),
+                                      np.ones(ndim), periodic=False,
+                                      nleaves=nleaves)
+            assert(tree.num_leaves == nleaves)
+            for leaf in tree.leaves:
+                assert(leaf.npts > 0)
+
+
+def test_curve_tree():
+    for method in ['hilbert', 'morton']:
+        tree = domain_decomp.tree(method, pts3, left_edge3, right_edge3,
+                                  periodic=False, nleaves=3)
+        assert(tree.num_leaves == 3)
+        assert(np.all(np.sort(tree.idx) == np.arange(N)))
+        for leaf in tree.leaves:
+            assert(leaf.npts in [33, 34])
+            assert(leaf.id in leaf.neighbors)
+            lpts = pts3[tree.idx[leaf.start_idx:leaf.stop_idx], :]
+            assert(np.all(lpts >= leaf.left_edge))
+            assert(np.all(lpts <= leaf.right_edge))
+            for k in leaf.neighbors:
+                assert(leaf.id in tree.leaves[k].neighbors)
+        # Neighbors are the leaves with overlapping or touching boxes
+        tree = domain_decomp.tree(method, pts3, left_edge3, right_edge3,
+                                  periodic=False, nleaves=16)
+        for leaf in tree.leaves:
+            for k in range(tree.num_leaves):
+                other = tree.leaves[k]
+                touch = (np.all(leaf.left_edge <= other.right_edge) and
+                         np.all(other.left_edge <= leaf.right_edge))
+                assert((k in leaf.neighbors) == touch)
+    assert_raises(ValueError, domain_decomp.tree, 'hilbert', pts3,
+                  left_edge3, right_edge3, True, nleaves=3)
+
+
+def test_find_leaves():
+    tree = domain_decomp.tree('kdtree', pts2, left_edge2, right_edge2,
+                              periodic=False, nleaves=4, split='cost')
+    new_pts = np.vstack([np.random.rand(20, 2), [[1.5, 0.5]]])
+    leaf_ids, indptr, order = tree.find_leaves(new_pts)
+    assert(leaf_ids[-1] == -1)
+    assert(np.all(leaf_ids[:-1] >= 0))
+    assert(indptr[-1] == 20)
+    for i, leaf in enumerate(tree.leaves):
+        lpts = new_pts[order[indptr[i]:indptr[i+1]].astype('int64'), :]
+        assert(np.all(leaf_ids[order[indptr[i]:indptr[i+1]]] == i))
+        assert(np.all(lpts >= leaf.left_edge))
+        assert(np.all(lpts <= leaf.right_edge))
+    tree = domain_decomp.tree('kdtree', pts2, left_edge2, right_edge2,
+                              periodic=True, nleaves=4, split='cost')
+    leaf_ids, indptr, order = tree.find_leaves(new_pts)
+    assert(np.all(leaf_ids >= 0))
+    # Points outside every leaf go to the leaf with the closest box
+    tree = domain_decomp.tree('kdtree', pts2, left_edge2, right_edge2,
+                              periodic=False, nleaves=8, split='cost')
+    far_pts = 3*np.random.rand(50, 2) - 1
+    leaf_ids, indptr, order = tree.find_leaves(far_pts, nearest=True)
+    assert(indptr[-1] == 50)
+    for j in range(50):
+        dist = [np.sum(np.clip(np.maximum(leaf.left_edge - far_pts[j],
+                                          far_pts[j] - leaf.right_edge),
+                               0, None)**2) for leaf in tree.leaves]
+        assert(leaf_ids[j] == np.argmin(dist))
+
+
 def test_GenericLeaf():
     leaf2 = domain_decomp.GenericLeaf(N, left_edge2, right_edge2)
     leaf3 = domain_decomp.GenericLeaf(N, left_edge3, right_edge3)
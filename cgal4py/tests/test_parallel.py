@@ -4,7 +4,7 @@ import numpy as np
 import os
 import time
 from cgal4py import _use_multiprocessing
-from cgal4py import parallel, delaunay
+from cgal4py import parallel, delaunay, domain_decomp
 from cgal4py.domain_decomp import GenericTree
 from cgal4py.tests.test_cgal4py import make_points, make_test, MyTestCase
 if _use_multiprocessing:
@@ -45,7 +45,10 @@ class TestWriteMPIScript(MyTestCase):
             ((fname, read_lines, 'triangulate'), {}),
             ((fname, read_lines, 'triangulate'), dict(use_double=True)),
             ((fname, read_lines, 'triangulate'), dict(use_buffer=True)),
-            ((fname, read_lines, 'triangulate'), dict(profile=True))]
+            ((fname, read_lines, 'triangulate'), dict(profile=True)),
+            ((fname, read_lines, 'triangulate'), dict(use_shm=True)),
+            ((fname, read_lines, 'triangulate'),
+             dict(dd_method='hilbert', nleaves_per_proc=2))]
         self._fname = fname
         self._read_lines = read_lines
 
@@ -68,6 +71,47 @@ class TestWriteMPIScript(MyTestCase):
         os.remove(self._fname)
 
 
+
+def test_SharedResult():
+    pts, tree = make_test(100, 2)
+    T = delaunay.Delaunay(pts)
+    cells, neigh, idx_inf = T.serialize()
+    fname = parallel._shm_filename('triangulate', 'test')
+    parallel.write_shared_result(fname, pts, cells, neigh, idx_inf)
+    res = parallel.SharedResult(fname)
+    assert(not os.path.isfile(fname))
+    np.testing.assert_array_equal(res.pts, pts)
+    np.testing.assert_array_equal(res.cells, cells)
+    nt.eq_(res.idx_inf, idx_inf)
+    assert(res.triangulation.is_equivalent(T))
+    vols = np.arange(10, dtype='float64')
+    parallel.write_shared_result(fname, vols=vols)
+    res = parallel.SharedResult(fname)
+    np.testing.assert_array_equal(res.vols, vols)
+    nt.assert_raises(AttributeError, getattr, res, 'triangulation')
+
+def test_MPIWorkerPool():
+    pts, tree = make_test(100, 2)
+    T_seri = delaunay.Delaunay(pts)
+    v_seri = delaunay.VoronoiVolumes(pts)
+    with parallel.MPIWorkerPool(2) as pool:
+        T_para = pool.triangulate(pts)
+        assert(T_para.is_equivalent(T_seri))
+        assert(np.allclose(pool.volumes(pts), v_seri))
+        # Modules & objects are reused for later jobs
+        T_para = pool.triangulate(pts)
+        assert(T_para.is_equivalent(T_seri))
+        nt.assert_raises(ValueError, pool.submit, 'invalid', pts)
+        assert(not os.path.isfile(os.path.basename(pool._fscript)))
+        # An error on the root is raised on every rank and the pool
+        # keeps serving jobs
+        pool.triangulate(pts, session='s')
+        nt.assert_raises(RuntimeError, pool.triangulate,
+                         np.random.rand(10, 3), session='s')
+        T_para = pool.triangulate(pts)
+        assert(T_para.is_equivalent(T_seri))
+    nt.assert_raises(RuntimeError, pool.triangulate, pts)
+
 class TestParallelLeaf(MyTestCase):
 
     def setup_param(self):
@@ -177,6 +221,7 @@ class TestDelaunayProcessMPI(MyTestCase):
             # ((taskname2, pts), {'limit_mem':True}),
             # Using Python communications
             ((taskname1, pts), {'use_python':True}),
+            ((taskname1, pts), {'use_python':True, 'dd_method':'hilbert'}),
             ((taskname1, pts, tree), {'use_python':True}),
             ((taskname1, pts, GenericTree.from_tree(tree)),
                  {'use_python':True}),
@@ -360,6 +405,134 @@ class TestParallelDelaunay(MyTestCase):
             os.remove(self._fprof)
 
 
+def test_ParallelDelaunay_curve():
+    # Clusters with gaps between them, so that the bounding boxes of the
+    # clustered points: circumspheres reach past the overlapping neighbors
+    np.random.seed(10)
+    for ndim in [2, 3]:
+        pts = np.vstack([0.05*np.random.rand(100, ndim),
+                         0.9 + 0.05*np.random.rand(100, ndim),
+                         np.random.rand(20, ndim)])
+        le = np.zeros(ndim, 'float64')
+        re = np.ones(ndim, 'float64')
+        T_seri = delaunay.Delaunay(pts)
+        for method in ['hilbert', 'morton']:
+            tree = domain_decomp.tree(method, pts, le, re, False, nleaves=8)
+            T_para = parallel.ParallelDelaunay(pts, tree, 4, use_python=True)
+            assert(T_para.is_equivalent(T_seri))
+            T_para = parallel.ParallelDelaunay(pts, tree, 4, use_python=False,
+                                               dd_method=method,
+                                               nleaves_per_proc=2)
+            assert(T_para.is_equivalent(T_seri))
+
+
+def test_ParallelDelaunay_cost():
+    np.random.seed(10)
+    for ndim in [2, 3]:
+        pts = np.vstack([0.05*np.random.rand(100, ndim),
+                         np.random.rand(100, ndim)])
+        le = np.zeros(ndim, 'float64')
+        re = np.ones(ndim, 'float64')
+        T_seri = delaunay.Delaunay(pts)
+        tree = domain_decomp.tree('kdtree_cost', pts, le, re, False,
+                                  nleaves=6)
+        T_para = parallel.ParallelDelaunay(pts, tree, 3, use_python=True)
+        assert(T_para.is_equivalent(T_seri))
+        T_para = parallel.ParallelDelaunay(pts, tree, 3, use_python=False,
+                                           dd_method='kdtree_cost',
+                                           nleaves_per_proc=2)
+        assert(T_para.is_equivalent(T_seri))
+
+
+def test_insert_outside_domain():
+    np.random.seed(10)
+    for ndim in [2, 3]:
+        le = np.zeros(ndim, 'float64')
+        re = np.ones(ndim, 'float64')
+        pts = np.random.rand(200, ndim)
+        new = np.random.rand(50, ndim) + 0.5
+        # Nearest leaves grow to hold the new points
+        p = parallel.DelaunayProcessMPI(
+            'triangulate', pts, left_edge=le, right_edge=re,
+            use_python=False, dd_method='hilbert', nleaves_per_proc=4)
+        p.PT.insert(pts)
+        p.PT.insert(new)
+        T_para = p.PT.consolidate_tess()
+        assert(T_para.is_equivalent(delaunay.Delaunay(np.vstack([pts, new]))))
+        # Periodic points are wrapped and kept wrapped in pts_total
+        p = parallel.DelaunayProcessMPI(
+            'triangulate', pts, left_edge=le, right_edge=re, periodic=True,
+            use_python=False)
+        p.PT.insert(pts)
+        p.PT.insert(new)
+        assert(np.all(p.PT.pts_total >= le))
+        assert(np.all(p.PT.pts_total < re))
+        assert(np.allclose(p.PT.pts_total[200:], np.mod(new, 1.0)))
+        # The caller's points are left as they were
+        assert(np.all(new > 0.5))
+
+
+def test_insert_split_leaves():
+    # Leaves that grow to hold points far outside the domain are split
+    np.random.seed(10)
+    for ndim in [2, 3]:
+        le = np.zeros(ndim, 'float64')
+        re = np.ones(ndim, 'float64')
+        pts = np.random.rand(200, ndim)
+        new = 3.0 + 2.0*np.random.rand(1000, ndim)
+        for dd_method in ['kdtree', 'hilbert']:
+            p = parallel.DelaunayProcessMPI(
+                'triangulate', pts, left_edge=le, right_edge=re,
+                use_python=False, dd_method=dd_method, nleaves_per_proc=4)
+            p.PT.insert(pts)
+            nleaves0 = p.PT.leaf_sizes().size
+            p.PT.insert(new)
+            sizes = p.PT.leaf_sizes()
+            assert(sizes.size > nleaves0)
+            assert(sizes.sum() == 1200)
+            assert(sizes.max() <= p.PT.leaf_npts_limit)
+            vols = p.PT.consolidate_vols()
+            assert(vols.size == 1200)
+
+
+def test_exchange_codec():
+    # One rank with several leaves still sends its halo points through
+    # MPI, so this drives both the raw and the encoded exchange
+    np.random.seed(10)
+    for ndim in [2, 3]:
+        pts = np.random.rand(1000, ndim)
+        T_seri = delaunay.Delaunay(pts)
+        nbytes = []
+        for compress in [False, True]:
+            p = parallel.DelaunayProcessMPI(
+                'triangulate', pts, use_python=False, dd_method='hilbert',
+                nleaves_per_proc=4, compress_exchange=compress)
+            p.PT.insert(pts)
+            T_para = p.PT.consolidate_tess()
+            assert(T_para.is_equivalent(T_seri))
+            nbytes.append(p.PT.exchange_bytes)
+        assert(nbytes[0] > 0)
+        assert(nbytes[1] < nbytes[0])
+
+
+def test_volumes_only():
+    # Leaves ask for points until the dual cells of their own points are
+    # final, which must give the same volumes as a full exchange
+    np.random.seed(10)
+    for ndim in [2, 3]:
+        pts = np.vstack([0.05*np.random.rand(100, ndim),
+                         np.random.rand(400, ndim)])
+        for dd_method in ['kdtree', 'hilbert']:
+            vols = []
+            for task in ['triangulate', 'volumes']:
+                p = parallel.DelaunayProcessMPI(
+                    task, pts, use_python=False, dd_method=dd_method,
+                    nleaves_per_proc=4)
+                p.PT.insert(pts)
+                vols.append(p.PT.consolidate_vols())
+            assert(np.allclose(vols[1], vols[0]))
+
+
 class TestParallelVoronoiVolumes(MyTestCase):
 
     def setup_param(self):
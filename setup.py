@@ -61,8 +61,8 @@ if not RTDFLAG and not release and use_cython:
 ext_options = dict(language="c++",
                    include_dirs=include_dirs,#[numpy.get_include()],
                    libraries=[],
-                   extra_link_args=[],
-                   extra_compile_args=["-std=gnu++11"],
+                   extra_link_args=["-pthread"],
+                   extra_compile_args=["-std=gnu++11", "-pthread"],
                    define_macros=[("NPY_NO_DEPRECATED_API", None)])
 # CYTHON_TRACE required for coverage and line_profiler.  Remove for release.
 if not release:
@@ -205,7 +205,9 @@ ext_modules += [
 src_include += [
     "cgal4py/delaunay/tools.pyx",
     "cgal4py/delaunay/tools.pxd",
-    "cgal4py/delaunay/c_tools.hpp"]
+    "cgal4py/delaunay/c_tools.hpp",
+    "cgal4py/delaunay/c_threads.hpp",
+    "cgal4py/delaunay/c_predicates.hpp"]
 
 
 if use_cython: